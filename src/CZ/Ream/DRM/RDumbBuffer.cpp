@@ -101,6 +101,7 @@ RDumbBuffer::~RDumbBuffer() noexcept
     munmap(m_data, m_mapSize);
     drmModeDestroyDumbBuffer(allocator()->drmFd(), m_handle);
     RResourceTrackerSub(RDumbBufferRes);
+    RResourceTrackerSubBytes(RDumbMem, m_allocator, m_mapSize);
 }
 
 std::shared_ptr<RDRMFramebuffer> RDumbBuffer::fb() const noexcept
@@ -112,4 +113,5 @@ RDumbBuffer::RDumbBuffer(std::shared_ptr<RCore> core, std::shared_ptr<RDRMFrameb
     m_core(core), m_fb(fb), m_size(size), m_formatInfo(formatInfo), m_allocator(allocator), m_handle(handle), m_stride(stride), m_mapSize(mapSize), m_data(data)
 {
     RResourceTrackerAdd(RDumbBufferRes);
+    RResourceTrackerAddBytes(RDumbMem, m_allocator, m_mapSize);
 }
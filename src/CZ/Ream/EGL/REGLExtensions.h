@@ -17,6 +17,7 @@ namespace CZ
         bool MESA_platform_gbm;
         bool KHR_platform_gbm;
         bool KHR_platform_wayland;
+        bool MESA_platform_surfaceless;
         bool EXT_device_base;
         bool EXT_device_query;
         bool KHR_debug;
@@ -32,6 +33,7 @@ namespace CZ
         bool EXT_image_dma_buf_import;
         bool EXT_image_dma_buf_import_modifiers;
         bool KHR_swap_buffers_with_damage;
+        bool KHR_partial_update;
         bool KHR_image_pixmap;
         bool KHR_gl_texture_2D_image;
         bool KHR_gl_renderbuffer_image;
@@ -76,12 +78,18 @@ namespace CZ
         PFNGLEGLIMAGETARGETTEXTURE2DOESPROC glEGLImageTargetTexture2DOES;
         PFNGLEGLIMAGETARGETRENDERBUFFERSTORAGEOESPROC glEGLImageTargetRenderbufferStorageOES;
         PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC eglSwapBuffersWithDamageKHR;
+        PFNEGLSETDAMAGEREGIONKHRPROC eglSetDamageRegionKHR;
         PFNEGLCREATESYNCKHRPROC eglCreateSyncKHR;
         PFNEGLDESTROYSYNCKHRPROC eglDestroySyncKHR;
         PFNEGLWAITSYNCKHRPROC eglWaitSyncKHR;
         PFNEGLCLIENTWAITSYNCKHRPROC eglClientWaitSyncKHR;
         PFNEGLGETSYNCATTRIBKHRPROC eglGetSyncAttribKHR;
         PFNEGLDUPNATIVEFENCEFDANDROIDPROC eglDupNativeFenceFDANDROID;
+        PFNGLGENQUERIESEXTPROC glGenQueriesEXT;
+        PFNGLDELETEQUERIESEXTPROC glDeleteQueriesEXT;
+        PFNGLQUERYCOUNTEREXTPROC glQueryCounterEXT;
+        PFNGLGETQUERYOBJECTUIVEXTPROC glGetQueryObjectuivEXT;
+        PFNGLGETQUERYOBJECTUI64VEXTPROC glGetQueryObjectui64vEXT;
     };
 };
 
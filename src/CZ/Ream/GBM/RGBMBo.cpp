@@ -307,6 +307,7 @@ std::optional<RDMABufferInfo> RGBMBo::dmaExport() const noexcept
 RGBMBo::~RGBMBo() noexcept
 {
     RResourceTrackerSub(RGBMBoRes);
+    RResourceTrackerSubBytes(RGBMMem, m_memory, m_allocationSize);
     if (m_ownership == CZOwn::Own)
         gbm_bo_destroy(m_bo);
 }
@@ -315,4 +316,18 @@ RGBMBo::RGBMBo(std::shared_ptr<RCore> core, RDevice *allocator, gbm_bo *bo, CZOw
     m_bo(bo), m_ownership(ownership), m_allocator(allocator), m_core(core), m_hasModifier(hasModifier)
 {
     RResourceTrackerAdd(RGBMBoRes);
+
+    if (ownership == CZOwn::Own)
+    {
+        // Estimated, planes are assumed to span the full height
+        const UInt64 height { gbm_bo_get_height(bo) };
+
+        for (int i = 0; i < planeCount(); i++)
+            m_allocationSize += UInt64(planeStride(i)) * height;
+
+        RResourceTrackerAddBytes(RGBMMem, allocator, m_allocationSize);
+
+        if (allocator)
+            m_memory = allocator->memoryCounters();
+    }
 }
@@ -173,6 +173,8 @@ private:
     mutable UInt8 m_supportsMapRead { 2 };
     mutable UInt8 m_supportsMapWrite { 2 };
     bool m_hasModifier;
+    UInt64 m_allocationSize { 0 }; // Accounted in RResourceTracker, 0 if not owned
+    std::shared_ptr<RDeviceMemory> m_memory; // Counters of m_allocator, the bo may outlive it
 };
 
 #endif // RGBMBO_H
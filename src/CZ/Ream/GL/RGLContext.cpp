@@ -1,5 +1,6 @@
 #include <CZ/Ream/RLog.h>
 #include <CZ/Ream/RLockGuard.h>
+#include <CZ/Ream/RResourceTracker.h>
 #include <CZ/Ream/GL/RGLContext.h>
 #include <CZ/Ream/GL/RGLCore.h>
 #include <CZ/Ream/GL/RGLDevice.h>
@@ -134,11 +135,12 @@ struct CZ::RGLThreadDataManager
         while (!devicesData.empty())
         {
             auto it { devicesData.begin() };
+            RResourceTrackerSetSkiaCacheBytes(it->first, it->second.skContext.get(), 0);
             it->second.skContext.reset();
 
             if (threads.threadDataManagers.size() != 1)
             {
-                eglMakeCurrent(it->first->eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+                RGLMakeCurrent::MakeCurrent(it->first->eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
                 eglDestroyContext(it->first->eglDisplay(), it->second.context);
                 it->first->log(CZTrace, "GL context destroyed for thread {}", pthread_self());
             }
@@ -157,7 +159,7 @@ struct CZ::RGLThreadDataManager
             RLog(CZTrace, "The main GL thread has changed to: {}", mainThreadId);
             for (auto &deviceData : nextAliveThread.second->devicesData)
             {
-                eglMakeCurrent(deviceData.first->eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+                RGLMakeCurrent::MakeCurrent(deviceData.first->eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
                 deviceData.first->m_eglContext = deviceData.second.context;
                 deviceData.first->m_skContext = deviceData.second.skContext;
             }
@@ -208,9 +210,9 @@ struct CZ::RGLThreadDataManager
                 device->log(CZError, CZLN, "Failed to create shared GL context for thread {}", pthread_self());
             else
             {
-                eglMakeCurrent(device->eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, data.context);
+                RGLMakeCurrent::MakeCurrent(device->eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, data.context);
                 device->log(CZTrace, "Shared GL context created for thread {}", pthread_self());
-                data.skContext = GrDirectContexts::MakeGL(skInterface, CZ::GetSKContextOptions());
+                data.skContext = GrDirectContexts::MakeGL(skInterface, CZ::MakeSKContextOptions(device->m_skCacheKey));
 
                 if (!data.skContext)
                     device->log(CZError, CZLN, "Failed to create GL GrDirectContext for thread {}", pthread_self());
@@ -95,6 +95,14 @@ bool RGLCore::initClientEGLExtensions() noexcept
         return false;
     }
 
+    exts.MESA_platform_surfaceless = CZStringUtils::CheckExtension(extensions, "EGL_MESA_platform_surfaceless");
+
+    if (m_options.platformHandle->platform() == RPlatform::Offscreen && !exts.MESA_platform_surfaceless)
+    {
+        RLog(CZError, CZLN, "EGL_MESA_platform_surfaceless not supported and is required by the Offscreen platform");
+        return false;
+    }
+
     exts.EXT_device_base = CZStringUtils::CheckExtension(extensions, "EGL_EXT_device_base");
     exts.EXT_device_query = CZStringUtils::CheckExtension(extensions, "EGL_EXT_device_query");
 
@@ -130,7 +138,7 @@ bool RGLCore::initClientEGLExtensions() noexcept
 
 bool RGLCore::initDevices() noexcept
 {
-    if (platform() == RPlatform::Wayland)
+    if (platform() == RPlatform::Wayland || platform() == RPlatform::Offscreen)
     {
         m_mainDevice = RGLDevice::Make(*this, -1, nullptr);
 
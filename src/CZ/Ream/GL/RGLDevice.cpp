@@ -3,6 +3,9 @@
 #include <CZ/Ream/GL/RGLDevice.h>
 #include <CZ/Ream/GL/RGLCore.h>
 #include <CZ/Ream/GL/RGLPainter.h>
+#include <CZ/Ream/GL/RGLMakeCurrent.h>
+#include <CZ/Ream/RResourceTracker.h>
+#include <CZ/Ream/RProfiler.h>
 #include <CZ/Ream/RLog.h>
 
 #include <CZ/skia/gpu/ganesh/gl/GrGLAssembleInterface.h>
@@ -15,6 +18,8 @@
 #include <xf86drm.h>
 #include <drm_fourcc.h>
 #include <sys/stat.h>
+#include <cstring>
+#include <format>
 
 using namespace CZ;
 
@@ -56,9 +61,11 @@ RGLDevice::RGLDevice(RGLCore &core, int drmFd, void *userData) noexcept :
 
 RGLDevice::~RGLDevice() noexcept
 {
+    RResourceTrackerSetSkiaCacheBytes(this, m_skContext.get(), 0);
+
     if (m_eglContext != EGL_NO_CONTEXT)
     {
-        eglMakeCurrent(eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        RGLMakeCurrent::MakeCurrent(eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
         eglDestroyContext(eglDisplay(), m_eglContext);
         m_eglContext = EGL_NO_CONTEXT;
     }
@@ -74,6 +81,8 @@ bool RGLDevice::init() noexcept
 {
     if (core().platform() == RPlatform::Wayland)
         return initWL();
+    else if (core().platform() == RPlatform::Offscreen)
+        return initOF();
     else
         return initDRM();
 
@@ -115,7 +124,50 @@ bool RGLDevice::initEGLDisplayWL() noexcept
         return false;
     }
 
-    /* Below this point everything is optional (for GBM allocator support) */
+    return initEGLDeviceGBM();
+}
+
+bool RGLDevice::initOF() noexcept
+{
+    if (initEGLDisplayOF() &&
+        initEGLDisplayExtensions() &&
+        initEGLContext() &&
+        initGLExtensions() &&
+        initEGLDisplayProcs() &&
+        initDMAFormats() &&
+        initFormats() &&
+        initPainter())
+        return true;
+
+    return false;
+}
+
+bool RGLDevice::initEGLDisplayOF() noexcept
+{
+    // MESA_platform_surfaceless already validated
+    m_eglDisplay = core().clientEGLProcs().eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+    if (eglDisplay() == EGL_NO_DISPLAY)
+    {
+        log(CZError, CZLN, "Failed to get surfaceless EGL display");
+        return false;
+    }
+
+    EGLint minor, major;
+
+    if (!eglInitialize(eglDisplay(), &minor, &major))
+    {
+        log(CZError, CZLN, "Failed to initialize surfaceless EGL display");
+        m_eglDisplay = EGL_NO_DISPLAY;
+        return false;
+    }
+
+    return initEGLDeviceGBM();
+}
+
+bool RGLDevice::initEGLDeviceGBM() noexcept
+{
+    /* Everything is optional here (for GBM allocator support) */
 
     if (!core().clientEGLExtensions().EXT_device_query)
     {
@@ -309,6 +361,7 @@ bool RGLDevice::initEGLDisplayExtensions() noexcept
     exts.KHR_gl_texture_2D_image = CZStringUtils::CheckExtension(extensions, "EGL_KHR_gl_texture_2D_image");
     exts.KHR_gl_renderbuffer_image = CZStringUtils::CheckExtension(extensions, "EGL_KHR_gl_renderbuffer_image");
     exts.KHR_swap_buffers_with_damage = CZStringUtils::CheckExtension(extensions, "EGL_KHR_swap_buffers_with_damage");
+    exts.KHR_partial_update = CZStringUtils::CheckExtension(extensions, "EGL_KHR_partial_update");
 
     m_caps.SyncCPU = exts.KHR_fence_sync = CZStringUtils::CheckExtension(extensions, "EGL_KHR_fence_sync");
 
@@ -359,9 +412,14 @@ bool RGLDevice::initEGLContext() noexcept
         return 0;
     }
 
-    eglMakeCurrent(eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, m_eglContext);
+    RGLMakeCurrent::MakeCurrent(eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, m_eglContext);
 
-    m_skContext = GrDirectContexts::MakeGL(skInterface, CZ::GetSKContextOptions());
+    // Program binaries are only valid for the same driver
+    m_skCacheKey = std::format("GL|{}|{}|{}",
+        (const char*)glGetString(GL_VENDOR),
+        (const char*)glGetString(GL_RENDERER),
+        (const char*)glGetString(GL_VERSION));
+    m_skContext = GrDirectContexts::MakeGL(skInterface, CZ::MakeSKContextOptions(m_skCacheKey));
 
     if (!m_skContext)
         log(CZError, CZLN, "Failed to create GL GrDirectContext");
@@ -380,6 +438,12 @@ bool RGLDevice::initGLExtensions() noexcept
     glExts.OES_EGL_image_base = CZStringUtils::CheckExtension(extensions, "GL_OES_EGL_image_base");
     glExts.OES_surfaceless_context = CZStringUtils::CheckExtension(extensions, "GL_OES_surfaceless_context");
     glExts.OES_EGL_sync = CZStringUtils::CheckExtension(extensions, "GL_OES_EGL_sync");
+    glExts.EXT_disjoint_timer_query = CZStringUtils::CheckExtension(extensions, "GL_EXT_disjoint_timer_query");
+
+    // Drivers usually return an ES 3 context even if 2 is requested
+    const char *version { (const char*)glGetString(GL_VERSION) };
+    glExts.OES_texture_npot = CZStringUtils::CheckExtension(extensions, "GL_OES_texture_npot") ||
+        (version && strncmp(version, "OpenGL ES 3", 11) == 0);
     return true;
 }
 
@@ -407,6 +471,9 @@ bool RGLDevice::initEGLDisplayProcs() noexcept
     if (exts.KHR_swap_buffers_with_damage)
         procs.eglSwapBuffersWithDamageKHR = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageKHR");
 
+    if (exts.KHR_partial_update)
+        procs.eglSetDamageRegionKHR = (PFNEGLSETDAMAGEREGIONKHRPROC)eglGetProcAddress("eglSetDamageRegionKHR");
+
     if (glExts.OES_EGL_sync)
     {
         if (exts.KHR_fence_sync)
@@ -434,6 +501,17 @@ bool RGLDevice::initEGLDisplayProcs() noexcept
         procs.eglQueryDmaBufModifiersEXT = (PFNEGLQUERYDMABUFMODIFIERSEXTPROC) eglGetProcAddress("eglQueryDmaBufModifiersEXT");
     }
 
+    if (glExts.EXT_disjoint_timer_query)
+    {
+        procs.glGenQueriesEXT = (PFNGLGENQUERIESEXTPROC)eglGetProcAddress("glGenQueriesEXT");
+        procs.glDeleteQueriesEXT = (PFNGLDELETEQUERIESEXTPROC)eglGetProcAddress("glDeleteQueriesEXT");
+        procs.glQueryCounterEXT = (PFNGLQUERYCOUNTEREXTPROC)eglGetProcAddress("glQueryCounterEXT");
+        procs.glGetQueryObjectuivEXT = (PFNGLGETQUERYOBJECTUIVEXTPROC)eglGetProcAddress("glGetQueryObjectuivEXT");
+        procs.glGetQueryObjectui64vEXT = (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+        m_caps.TimestampQuery = procs.glGenQueriesEXT && procs.glDeleteQueriesEXT && procs.glQueryCounterEXT &&
+                                procs.glGetQueryObjectuivEXT && procs.glGetQueryObjectui64vEXT;
+    }
+
     return true;
 }
 
@@ -541,7 +619,118 @@ std::shared_ptr<RPainter> RGLDevice::makePainter(std::shared_ptr<RSurface> surfa
     return std::shared_ptr<RPainter>(new RGLPainter(surface, this));
 }
 
-RGLDevice::ThreadData::ThreadData(RGLDevice *device) noexcept
+RGLDevice::ThreadData::ThreadData(RGLDevice *device) noexcept : device(device) {}
+
+RGLDevice::ThreadData::~ThreadData() noexcept
+{
+    if (!device->caps().TimestampQuery)
+        return;
+
+    // The context is current during destruction (see RGLContextDataManager)
+    for (const auto &query : timerQueries)
+    {
+        RProfiler::SetGPUTime(query.event, -1);
+        freeQueries.emplace_back(query.begin);
+        freeQueries.emplace_back(query.end);
+    }
+
+    for (const auto &[event, query] : openTimerQueries)
+    {
+        RProfiler::SetGPUTime(event, -1);
+        freeQueries.emplace_back(query);
+    }
+
+    if (!freeQueries.empty())
+        device->eglDisplayProcs().glDeleteQueriesEXT(freeQueries.size(), freeQueries.data());
+}
+
+GLuint RGLDevice::ThreadData::allocQuery() noexcept
+{
+    GLuint query { 0 };
+
+    if (freeQueries.empty())
+        device->eglDisplayProcs().glGenQueriesEXT(1, &query);
+    else
+    {
+        query = freeQueries.back();
+        freeQueries.pop_back();
+    }
+
+    return query;
+}
+
+void RGLDevice::writeTimestamp(UInt64 event, bool end) noexcept
+{
+    if (event == 0 || !caps().TimestampQuery)
+        return;
+
+    auto *data { (ThreadData*)m_threadData->getData(this) };
+
+    if (!data)
+        return;
+
+    if (!end)
+    {
+        if (data->openTimerQueries.contains(event))
+            return;
+
+        const GLuint query { data->allocQuery() };
+        m_eglDisplayProcs.glQueryCounterEXT(query, GL_TIMESTAMP_EXT);
+        data->openTimerQueries[event] = query;
+        RProfiler::ExpectGPUTime(event);
+        return;
+    }
+
+    auto it { data->openTimerQueries.find(event) };
+
+    if (it == data->openTimerQueries.end())
+        return;
+
+    const GLuint query { data->allocQuery() };
+    m_eglDisplayProcs.glQueryCounterEXT(query, GL_TIMESTAMP_EXT);
+    data->timerQueries.push_back({ event, it->second, query });
+    data->openTimerQueries.erase(it);
+}
+
+RGLState &RGLDevice::glState() noexcept
+{
+    return ((ThreadData*)m_threadData->getData(this))->state;
+}
+
+void RGLDevice::resolveTimestamps() noexcept
 {
-    CZ_UNUSED(device)
+    if (!caps().TimestampQuery)
+        return;
+
+    auto *data { (ThreadData*)m_threadData->getData(this) };
+
+    if (!data || data->timerQueries.empty())
+        return;
+
+    // Reading GL_GPU_DISJOINT_EXT clears it, results made available before that are unreliable
+    GLint disjoint { 0 };
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+    const auto &procs { m_eglDisplayProcs };
+    size_t resolved { 0 };
+
+    for (const auto &query : data->timerQueries)
+    {
+        GLuint available { 0 };
+        procs.glGetQueryObjectuivEXT(query.end, GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+
+        // Timestamps complete in order
+        if (!available)
+            break;
+
+        GLuint64 begin { 0 }, end { 0 };
+        procs.glGetQueryObjectui64vEXT(query.begin, GL_QUERY_RESULT_EXT, &begin);
+        procs.glGetQueryObjectui64vEXT(query.end, GL_QUERY_RESULT_EXT, &end);
+        RProfiler::SetGPUTime(query.event, disjoint || end < begin ? -1 : Int64(end - begin));
+        data->freeQueries.emplace_back(query.begin);
+        data->freeQueries.emplace_back(query.end);
+        resolved++;
+    }
+
+    data->timerQueries.erase(data->timerQueries.begin(), data->timerQueries.begin() + resolved);
 }
@@ -5,6 +5,7 @@
 #include <CZ/Ream/EGL/REGLExtensions.h>
 #include <CZ/Ream/GL/RGLExtensions.h>
 #include <CZ/Ream/GL/RGLContext.h>
+#include <CZ/Ream/GL/RGLState.h>
 #include <CZ/Ream/RDevice.h>
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -84,6 +85,8 @@ private:
     friend struct RGLThreadDataManager;
     friend class RGLProgram;
     friend class RGLShader;
+    friend class RGLPainter;
+    friend class RGLPass;
     static RGLDevice *Make(RGLCore &core, int drmFd, void *userData) noexcept;
     RGLDevice(RGLCore &core, int drmFd, void *userData) noexcept;
     ~RGLDevice() noexcept;
@@ -92,6 +95,12 @@ private:
     bool initWL() noexcept;
     bool initEGLDisplayWL() noexcept;
 
+    bool initOF() noexcept;
+    bool initEGLDisplayOF() noexcept;
+
+    // Wayland and Offscreen: finds the DRM render node of the display, if any
+    bool initEGLDeviceGBM() noexcept;
+
     bool initDRM() noexcept;
     bool initEGLDisplayDRM() noexcept;
 
@@ -105,14 +114,38 @@ private:
 
     std::shared_ptr<RPainter> makePainter(std::shared_ptr<RSurface> surface) noexcept override;
 
+    /* RProfiler GPU timestamps (GL_EXT_disjoint_timer_query), the device context must be current */
+    void writeTimestamp(UInt64 event, bool end) noexcept;
+    void resolveTimestamps() noexcept;
+
+    // Shadow GL state of the context bound to the calling thread
+    RGLState &glState() noexcept;
+
     class ThreadData : public RGLContextData
     {
     public:
         ThreadData(RGLDevice *device) noexcept;
+        ~ThreadData() noexcept;
+        RGLDevice *device;
         // Features => Shader/Program
         std::unordered_map<UInt32, std::shared_ptr<RGLShader>> vertShaders;
         std::unordered_map<UInt32, std::shared_ptr<RGLShader>> fragShaders;
         std::unordered_map<UInt32, std::shared_ptr<RGLProgram>> programs;
+        RGLState state;
+
+        struct TimerQuery
+        {
+            UInt64 event;
+            GLuint begin;
+            GLuint end;
+        };
+
+        // Event => begin query, waiting for the end timestamp
+        std::unordered_map<UInt64, GLuint> openTimerQueries;
+        // Issued in order, waiting for results
+        std::vector<TimerQuery> timerQueries;
+        std::vector<GLuint> freeQueries;
+        GLuint allocQuery() noexcept;
     };
 
     mutable std::shared_ptr<RGLContextDataManager> m_threadData;
@@ -120,6 +153,7 @@ private:
     EGLDeviceEXT m_eglDevice { EGL_NO_DEVICE_EXT };
     EGLContext m_eglContext { EGL_NO_CONTEXT };
     sk_sp<GrDirectContext> m_skContext;
+    std::string m_skCacheKey;
     REGLDisplayProcs m_eglDisplayProcs {};
     REGLDisplayExtensions m_eglDisplayExtensions {};
     REGLDeviceExtensions m_eglDeviceExtensions {};
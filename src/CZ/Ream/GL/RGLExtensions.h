@@ -18,6 +18,8 @@ namespace CZ
         bool OES_EGL_image_external;        ///< GL_OES_EGL_image_external: sample EGLImages via GL_TEXTURE_EXTERNAL_OES.
         bool OES_EGL_sync;                  ///< GL_OES_EGL_sync: EGL fence sync objects.
         bool OES_surfaceless_context;       ///< GL_OES_surfaceless_context: make a context current without a surface.
+        bool EXT_disjoint_timer_query;      ///< GL_EXT_disjoint_timer_query: GPU timestamp queries, used by RProfiler.
+        bool OES_texture_npot;              ///< GL_OES_texture_npot (core in ES 3.0): mipmaps for non-power-of-two textures.
     };
 };
 
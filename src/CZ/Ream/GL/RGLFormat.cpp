@@ -17,6 +17,9 @@ public:
         emplace(DRM_FORMAT_ABGR8888,      RGLFormat{ .format = GL_RGBA,     .internalFormat = GL_RGBA8_OES,         .type = GL_UNSIGNED_BYTE });
         emplace(DRM_FORMAT_BGR888,        RGLFormat{ .format = GL_RGB,      .internalFormat = GL_RGB8_OES,          .type = GL_UNSIGNED_BYTE });
 
+        emplace(DRM_FORMAT_R8,            RGLFormat{ .format = GL_RED_EXT,  .internalFormat = GL_R8_EXT,            .type = GL_UNSIGNED_BYTE });
+        emplace(DRM_FORMAT_GR88,          RGLFormat{ .format = GL_RG_EXT,   .internalFormat = GL_RG8_EXT,           .type = GL_UNSIGNED_BYTE });
+
         emplace(DRM_FORMAT_A8,            RGLFormat{ .format = GL_ALPHA,    .internalFormat = GL_ALPHA,             .type = GL_UNSIGNED_BYTE }); // Fake
 
         if (std::endian::native == std::endian::little)
@@ -32,6 +35,8 @@ public:
             emplace(DRM_FORMAT_ABGR16161616F, RGLFormat{ .format = GL_RGBA,     .internalFormat = GL_RGBA16F_EXT,       .type = GL_HALF_FLOAT_OES });
             emplace(DRM_FORMAT_XBGR16161616,  RGLFormat{ .format = GL_RGBA,     .internalFormat = GL_RGBA16_EXT,        .type = GL_UNSIGNED_SHORT });
             emplace(DRM_FORMAT_ABGR16161616,  RGLFormat{ .format = GL_RGBA,     .internalFormat = GL_RGBA16_EXT,        .type = GL_UNSIGNED_SHORT });
+            emplace(DRM_FORMAT_R16,           RGLFormat{ .format = GL_RED_EXT,  .internalFormat = GL_R16_EXT,           .type = GL_UNSIGNED_SHORT });
+            emplace(DRM_FORMAT_GR1616,        RGLFormat{ .format = GL_RG_EXT,   .internalFormat = GL_RG16_EXT,          .type = GL_UNSIGNED_SHORT });
         }
     }
 };
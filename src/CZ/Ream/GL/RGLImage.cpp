@@ -7,6 +7,7 @@
 #include <CZ/Ream/GBM/RGBMBo.h>
 #include <CZ/Ream/DRM/RDRMFramebuffer.h>
 #include <CZ/Ream/RLockGuard.h>
+#include <CZ/Ream/RResourceTracker.h>
 #include <CZ/Ream/RSync.h>
 #include <CZ/Ream/RLog.h>
 
@@ -25,11 +26,105 @@
 #include <fcntl.h>
 #include <linux/dma-buf.h>
 #include <linux/dma-heap.h>
+#include <poll.h>
+#include <cerrno>
+#include <mutex>
 
 static auto skSRGB { SkColorSpace::MakeSRGB() };
 
 using namespace CZ;
 
+/* gbm_bo_map/unmap go through the gbm_device's shared DRI context (Mesa), only the calls are serialized, not the copies */
+static std::mutex GBMMapMutex;
+
+static void *MapBo(RGBMBo *bo, UInt32 flags, UInt32 *stride, void **mapData) noexcept
+{
+    std::lock_guard<std::mutex> lock { GBMMapMutex };
+    return gbm_bo_map(bo->bo(), 0, 0, bo->size().width(), bo->size().height(), flags, stride, mapData);
+}
+
+static void UnmapBo(RGBMBo *bo, void *mapData) noexcept
+{
+    std::lock_guard<std::mutex> lock { GBMMapMutex };
+    gbm_bo_unmap(bo->bo(), mapData);
+}
+
+/* Blocks until the sync is signalled, without holding the global lock if it can be exported */
+static void WaitSync(const std::shared_ptr<RSync> &sync) noexcept
+{
+    auto fd { sync->fd() };
+
+    if (fd.get() < 0)
+    {
+        sync->cpuWait();
+        return;
+    }
+
+    pollfd pfd { .fd = fd.get(), .events = POLLIN, .revents = 0 };
+    while (poll(&pfd, 1, -1) < 0 && (errno == EINTR || errno == EAGAIN)) {}
+}
+
+static bool CopyToBo(RGBMBo *bo, const RPixelBufferRegion &region, UInt32 bpb) noexcept
+{
+    UInt32 stride;
+    void *mapData {};
+    auto *dst { static_cast<UInt8*>(MapBo(bo, GBM_BO_TRANSFER_WRITE, &stride, &mapData)) };
+
+    if (!dst) return false;
+
+    SkRegion::Iterator iter(region.region);
+
+    while (!iter.done())
+    {
+        const SkIRect &rect { iter.rect() };
+
+        // Source starting point in pixels (apply offset)
+        const auto srcX { rect.left() + region.offset.x() };
+        const auto srcY { rect.top() + region.offset.y() };
+
+        // Destination starting point in pixels
+        const auto dstX { rect.left() };
+        const auto dstY { rect.top() };
+
+        const auto width { rect.width() };
+        const auto height { rect.height() };
+
+        for (int row = 0; row < height; row++)
+        {
+            auto *srcPtr = region.pixels + ((srcY + row) * region.stride) + (srcX * bpb);
+            auto *dstPtr = dst + ((dstY + row) * stride) + (dstX * bpb);
+            std::memcpy(dstPtr, srcPtr, width * bpb);
+        }
+
+        iter.next();
+    }
+
+    UnmapBo(bo, mapData);
+    return true;
+}
+
+static bool CopyBoToBo(RGBMBo *src, RGBMBo *dst, const SkRegion &region, UInt32 bpb) noexcept
+{
+    UInt32 srcStride;
+    void *srcMapData {};
+    auto *srcPixels { static_cast<UInt8*>(MapBo(src, GBM_BO_TRANSFER_READ, &srcStride, &srcMapData)) };
+
+    if (!srcPixels) return false;
+
+    const RPixelBufferRegion copy
+    {
+        .offset = { 0, 0 },
+        .stride = srcStride,
+        .pixels = srcPixels,
+        .region = region,
+        .format = src->format()
+    };
+
+    const bool ret { CopyToBo(dst, copy, bpb) };
+    UnmapBo(src, srcMapData);
+    return ret;
+}
+
 /* Validates common parameters during allocation */
 static std::shared_ptr<RGLCore> ValidateMake(SkISize size, RFormat format, SkAlphaType alphaType, RGLDevice **allocator, const RFormatInfo **formatInfo, SkAlphaType *outAlphaType) noexcept
 {
@@ -158,6 +253,84 @@ RGLTexture RGLImage::texture(RGLDevice *device) const noexcept
     return deviceData.texture;
 }
 
+/* Formats whose framebuffer can be copied without loss into the 8 bit per channel mip texture
+ * (glCopyTexSubImage2D), 10 bit and float ones would be truncated or rejected */
+static GLenum MipTextureFormat(RFormat format) noexcept
+{
+    switch (format)
+    {
+    case DRM_FORMAT_ARGB8888:
+    case DRM_FORMAT_ABGR8888:
+        return GL_RGBA;
+    case DRM_FORMAT_XRGB8888:
+    case DRM_FORMAT_XBGR8888:
+    case DRM_FORMAT_BGR888:
+        return GL_RGB; // The framebuffer has no alpha to copy
+    default:
+        return GL_NONE;
+    }
+}
+
+RGLTexture RGLImage::mipmapTexture(RGLDevice *device) const noexcept
+{
+    RLockGuard lock {};
+
+    if (!device)
+        device = core()->asGL()->mainDevice();
+
+    const GLenum mipFormat { MipTextureFormat(formatInfo().format) };
+
+    if (!mipmaps() || !device->glExtensions().OES_texture_npot || mipFormat == GL_NONE)
+        return {};
+
+    auto &deviceData { m_devicesMap[device] };
+
+    if (deviceData.unsupportedCaps.has(NoMipmaps))
+        return {};
+
+    if (deviceData.mipTexture != 0 && deviceData.mipSerial == writeSerial())
+        return { deviceData.mipTexture, GL_TEXTURE_2D };
+
+    // The base level is copied from the image's framebuffer
+    const auto fb { glFb(device) };
+
+    if (!fb.has_value() || fb.value() == 0)
+    {
+        deviceData.unsupportedCaps.add(NoMipmaps);
+        return {};
+    }
+
+    if (deviceData.mipTexture == 0)
+    {
+        glGenTextures(1, &deviceData.mipTexture);
+        glBindTexture(GL_TEXTURE_2D, deviceData.mipTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, mipFormat, size().width(), size().height(), 0, mipFormat, GL_UNSIGNED_BYTE, nullptr);
+
+        // Mip chain adds ~1/3 of the base level
+        deviceData.mipBytes = (UInt64(size().width()) * size().height() * 4 * 4) / 3;
+        RResourceTrackerAddBytes(RNativeMem, device, deviceData.mipBytes);
+    }
+    else
+        glBindTexture(GL_TEXTURE_2D, deviceData.mipTexture);
+
+    while (glGetError() != GL_NO_ERROR) {}
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fb.value());
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, size().width(), size().height());
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // Broken levels are never sampled, the image falls back to its base texture from now on
+    if (const GLenum error { glGetError() }; error != GL_NO_ERROR)
+    {
+        device->log(CZError, CZLN, "Failed to generate mipmaps (GL error {:#x}), disabling them for this image", error);
+        deviceData.unsupportedCaps.add(NoMipmaps);
+        return {};
+    }
+
+    deviceData.mipSerial = writeSerial();
+    return { deviceData.mipTexture, GL_TEXTURE_2D };
+}
+
 std::optional<GLuint> RGLImage::glFb(RGLDevice *device) const noexcept
 {
     RLockGuard lock {};
@@ -403,6 +576,15 @@ std::shared_ptr<RGBMBo> RGLImage::gbmBo(RDevice *device) const noexcept
 {
     RLockGuard lock {};
 
+    /* The caller may keep the buffer, it must no longer be swapped */
+    m_pf.add(PFNoGBMBackBuffer);
+    return deviceGBMBo(device);
+}
+
+std::shared_ptr<RGBMBo> RGLImage::deviceGBMBo(RDevice *device) const noexcept
+{
+    RLockGuard lock {};
+
     if (!device)
         device = core()->mainDevice();
 
@@ -415,6 +597,15 @@ std::shared_ptr<RDRMFramebuffer> RGLImage::drmFb(RDevice *device) const noexcept
 {
     RLockGuard lock {};
 
+    /* May be scanned out, it must no longer be swapped */
+    m_pf.add(PFNoGBMBackBuffer);
+    return deviceDRMFb(device);
+}
+
+std::shared_ptr<RDRMFramebuffer> RGLImage::deviceDRMFb(RDevice *device) const noexcept
+{
+    RLockGuard lock {};
+
     if (!device)
         device = core()->mainDevice();
 
@@ -432,7 +623,7 @@ std::shared_ptr<RDRMFramebuffer> RGLImage::drmFb(RDevice *device) const noexcept
 
     /* Attempt to create one */
 
-    data.drmFb = RDRMFramebuffer::MakeFromGBMBo(gbmBo(device));
+    data.drmFb = RDRMFramebuffer::MakeFromGBMBo(deviceGBMBo(device));
 
     if (!data.drmFb && m_bo)
     {
@@ -623,18 +814,24 @@ CZBitset<RImageCap> RGLImage::checkDeviceCaps(CZBitset<RImageCap> caps, RDevice
         out.setFlag(RImageCap_SkSurface, skSurface(device->asGL()) != nullptr);
 
     if (caps.has(RImageCap_DRMFb))
-        out.setFlag(RImageCap_DRMFb, drmFb(device) != nullptr);
+        out.setFlag(RImageCap_DRMFb, deviceDRMFb(device) != nullptr);
 
     if (caps.has(RImageCap_GBMBo))
-        out.setFlag(RImageCap_GBMBo, gbmBo(device) != nullptr);
+        out.setFlag(RImageCap_GBMBo, deviceGBMBo(device) != nullptr);
+
+    // The base level is copied from the framebuffer, generated lazily by mipmapTexture()
+    if (caps.has(RImageCap_Mipmaps))
+    {
+        const auto fb { glFb(device->asGL()) };
+        out.setFlag(RImageCap_Mipmaps, device->asGL()->glExtensions().OES_texture_npot && fb.has_value() && fb.value() != 0 &&
+            MipTextureFormat(formatInfo().format) != GL_NONE);
+    }
 
     return out;
 }
 
 bool RGLImage::writePixels(const RPixelBufferRegion &region) noexcept
 {
-    RLockGuard lock {};
-
     // TODO: Implement blitting as fallback
 
     if (!region.pixels)
@@ -646,14 +843,12 @@ bool RGLImage::writePixels(const RPixelBufferRegion &region) noexcept
     if (!writeFormats().contains(region.format))
         return false;
 
-    if (writePixelsNative(region))
-    {
-        m_writeSerial++;
-        return true;
-    }
+    /* The global lock is taken by writePixelsNative() only, GBM map writes just serialize on m_writeMutex */
 
-    if (writePixelsGBMMapWrite(region))
+    if (writePixelsNative(region) || writePixelsGBMMapWrite(region))
     {
+        profileUpload(region);
+        RLockGuard lock {};
         m_writeSerial++;
         return true;
     }
@@ -725,6 +920,9 @@ std::shared_ptr<RGLImage> RGLImage::MakeWithGBMStorage(SkISize size, const RDRMF
 
     image->m_bo = data.gbmBo;
     image->m_pf.add(PFStorageGBM);
+
+    if (!constraints || !constraints->gbmWriteDoubleBuffer)
+        image->m_pf.add(PFNoGBMBackBuffer);
     image->m_self = image;
     image->m_devicesMap.emplace(allocator, data);
     image->assignReadWriteFormats();
@@ -793,6 +991,8 @@ std::shared_ptr<RGLImage> RGLImage::MakeWithNativeStorage(SkISize size, const RD
     glBindTexture(data.texture.target, data.texture.id);
     glTexImage2D(data.texture.target, 0, glFormat->internalFormat, size.width(), size.height(), 0, glFormat->format, glFormat->type, NULL);
     glBindTexture(data.texture.target, 0);
+    data.textureBytes = UInt64(size.width()) * size.height() * formatInfo->bytesPerBlock;
+    RResourceTrackerAddBytes(RNativeMem, allocator, data.textureBytes);
     image->assignReadWriteFormats();
 
     if (!ValidateConstraints(image, constraints))
@@ -803,86 +1003,174 @@ std::shared_ptr<RGLImage> RGLImage::MakeWithNativeStorage(SkISize size, const RD
 
 bool RGLImage::writePixelsGBMMapWrite(const RPixelBufferRegion &region) noexcept
 {
-    RLockGuard lock {};
-
     if (region.format != formatInfo().format)
         return false;
 
-    /* Try map write with the allocator first */
-
-    auto *dev { allocator() };
-    auto bo { gbmBo(dev) };
+    std::lock_guard<std::mutex> imageLock { m_writeMutex };
+    std::shared_ptr<RGBMBo> bo;
+    std::shared_ptr<RSync> frontReadSync;
+    bool isFront { false };
 
-    if (!bo || !bo->supportsMapWrite())
     {
-        bo.reset();
+        RLockGuard lock {};
+
+        /* Try map write with the allocator first */
 
-        /* Check if another device supports it */
+        auto *dev { allocator() };
+        bo = deviceGBMBo(dev);
 
-        for (auto *device : m_core->devices())
+        if (!bo || !bo->supportsMapWrite())
         {
-            if (device == dev)
-                continue;
+            bo.reset();
 
-            auto found = gbmBo(device);
+            /* Check if another device supports it */
 
-            if (found && found->supportsMapWrite())
+            for (auto *device : m_core->devices())
             {
-                bo = found;
-                break;
+                if (device == dev)
+                    continue;
+
+                auto found = deviceGBMBo(device);
+
+                if (found && found->supportsMapWrite())
+                {
+                    bo = found;
+                    break;
+                }
+            }
+
+            if (!bo)
+            {
+                RLog(CZError, CZLN, "Failed to write pixels using gbm_bo_map");
+                return false;
             }
         }
 
-        if (!bo)
+        isFront = m_pf.has(PFStorageGBM) && bo == m_bo;
+        frontReadSync = readSync();
+    }
+
+    /* The front buffer may still be sampled by the GPU, write into the back buffer and swap instead of waiting */
+
+    if (frontReadSync && frontReadSync->cpuWait(0) != 1)
+    {
+        if (isFront && writePixelsGBMBackBuffer(region))
+            return true;
+
+        WaitSync(frontReadSync);
+    }
+
+    if (!CopyToBo(bo.get(), region, formatInfo().bytesPerBlock))
+        return false;
+
+    RLockGuard lock {};
+
+    if (isFront && m_gbmBack.bo)
+        m_gbmBack.damage.op(region.region, SkRegion::kUnion_Op);
+
+    const auto current { RGLMakeCurrent::FromDevice(bo->allocator()->asGL(), false) };
+    setWriteSync(RSync::Make(bo->allocator()));
+    return true;
+}
+
+bool RGLImage::writePixelsGBMBackBuffer(const RPixelBufferRegion &region) noexcept
+{
+    {
+        RLockGuard lock {};
+
+        if (m_pf.has(PFNoGBMBackBuffer))
         {
-            RLog(CZError, CZLN, "Failed to write pixels using gbm_bo_map");
+            /* Not needed anymore if the buffer was exported */
+            m_gbmBack = {};
             return false;
         }
     }
 
-    UInt32 stride;
-    void *mapData {};
+    if (!m_gbmBack.bo)
+    {
+        const RDRMFormat format { formatInfo().format, { m_bo->hasModifier() ? m_bo->modifier() : DRM_FORMAT_MOD_INVALID } };
+        m_gbmBack.bo = RGBMBo::Make(size(), format, m_bo->allocator());
 
-    const auto current { RGLMakeCurrent::FromDevice(bo->allocator()->asGL(), false) };
+        if (!m_gbmBack.bo || !m_gbmBack.bo->supportsMapWrite() || !m_bo->supportsMapRead())
+        {
+            allocator()->log(CZDebug, CZLN, "GBM back buffer unavailable, map writes will wait for pending reads");
+            m_gbmBack.bo.reset();
+            RLockGuard lock {};
+            m_pf.add(PFNoGBMBackBuffer);
+            return false;
+        }
 
-    if (readSync())
-        readSync()->cpuWait();
+        m_gbmBack.damage.setRect(SkIRect::MakeSize(size()));
+    }
 
-    auto *dst { static_cast<UInt8*>(gbm_bo_map(bo->bo(), 0, 0, size().width(), size().height(), GBM_BO_TRANSFER_WRITE, &stride, &mapData)) };
+    /* Both buffers are busy, let the caller wait for the front one */
 
-    if (!dst) return false;
+    if (m_gbmBack.readSync && m_gbmBack.readSync->cpuWait(0) != 1)
+        return false;
 
-    const auto bpb { formatInfo().bytesPerBlock };
+    /* Bring the back buffer up to date, excluding what's about to be overwritten */
 
-    SkRegion::Iterator iter(region.region);
+    m_gbmBack.damage.op(region.region, SkRegion::kDifference_Op);
 
-    while (!iter.done())
+    if (!m_gbmBack.damage.isEmpty())
     {
-        const SkIRect &rect { iter.rect() };
+        std::shared_ptr<RSync> frontWriteSync;
 
-        // Source starting point in pixels (apply offset)
-        const auto srcX { rect.left() + region.offset.x() };
-        const auto srcY { rect.top() + region.offset.y() };
+        {
+            RLockGuard lock {};
+            frontWriteSync = writeSync();
+        }
 
-        // Destination starting point in pixels
-        const auto dstX { rect.left() };
-        const auto dstY { rect.top() };
+        /* The GPU is rendering into the front buffer, a CPU copy would have to wait anyway */
 
-        const auto width { rect.width() };
-        const auto height { rect.height() };
+        if (frontWriteSync && frontWriteSync->cpuWait(0) != 1)
+            return false;
 
-        for (int row = 0; row < height; row++)
-        {
-            auto *srcPtr = region.pixels + ((srcY + row) * region.stride) + (srcX * bpb);
-            auto *dstPtr = dst + ((dstY + row) * stride) + (dstX * bpb);
-            std::memcpy(dstPtr, srcPtr, width * bpb);
-        }
+        if (!CopyBoToBo(m_bo.get(), m_gbmBack.bo.get(), m_gbmBack.damage, formatInfo().bytesPerBlock))
+            return false;
 
-        iter.next();
+        m_gbmBack.damage.setEmpty();
     }
 
-    gbm_bo_unmap(bo->bo(), mapData);
-    setWriteSync(RSync::Make(bo->allocator()));
+    if (!CopyToBo(m_gbmBack.bo.get(), region, formatInfo().bytesPerBlock))
+        return false;
+
+    /* Exported meanwhile, the caller writes into the front buffer too */
+    return swapGBMBuffers(region.region);
+}
+
+bool RGLImage::swapGBMBuffers(const SkRegion &damage) noexcept
+{
+    RLockGuard lock {};
+
+    if (m_pf.has(PFNoGBMBackBuffer))
+        return false;
+
+    const auto oldFront { m_bo };
+    m_bo = m_gbmBack.bo;
+    m_gbmBack.bo = oldFront;
+    m_gbmBack.readSync = m_readSync;
+    m_gbmBack.damage = damage;
+    m_readSync.reset();
+
+    /* Every view of the old buffer is stale, they are lazily recreated from m_bo */
+
+    for (auto &it : m_devicesMap)
+    {
+        auto &data { it.second };
+
+        if (data.gbmBo == oldFront)
+            data.gbmBo = m_bo;
+
+        data.texture = {};
+        data.eglImage.reset();
+        data.drmFb.reset();
+        data.unsupportedCaps = {};
+        m_contextDataManager->freeData(it.first);
+    }
+
+    const auto current { RGLMakeCurrent::FromDevice(m_bo->allocator()->asGL(), false) };
+    setWriteSync(RSync::Make(m_bo->allocator()));
     return true;
 }
 
@@ -963,7 +1251,7 @@ bool RGLImage::readPixelsGBMmapRead(const RPixelBufferRegion &region) noexcept
     if (region.format != formatInfo().format)
         return false;
 
-    auto bo { gbmBo(allocator()) };
+    auto bo { deviceGBMBo(allocator()) };
 
     if (!bo || !bo->supportsMapRead())
     {
@@ -972,7 +1260,7 @@ bool RGLImage::readPixelsGBMmapRead(const RPixelBufferRegion &region) noexcept
             if (dev == allocator())
                 continue;
 
-            bo = gbmBo(dev);
+            bo = deviceGBMBo(dev);
 
             if (bo && bo->supportsMapRead())
                 break;
@@ -993,7 +1281,7 @@ bool RGLImage::readPixelsGBMmapRead(const RPixelBufferRegion &region) noexcept
     const auto bpb { formatInfo().bytesPerBlock };
     UInt32 srcStride;
     void *mapData {};
-    UInt8 *src = (UInt8*)gbm_bo_map(bo->bo(), 0, 0, size().width(), size().height(), GBM_BO_TRANSFER_READ, &srcStride, &mapData);
+    UInt8 *src = (UInt8*)MapBo(bo.get(), GBM_BO_TRANSFER_READ, &srcStride, &mapData);
 
     if (!src)
         return false;
@@ -1024,7 +1312,7 @@ bool RGLImage::readPixelsGBMmapRead(const RPixelBufferRegion &region) noexcept
         iter.next();
     }
 
-    gbm_bo_unmap(bo->bo(), mapData);
+    UnmapBo(bo.get(), mapData);
     return true;
 }
 
@@ -1162,7 +1450,7 @@ void RGLImage::assignReadWriteFormats() noexcept
             }
         }
 
-        auto bo { gbmBo(glDev) };
+        auto bo { deviceGBMBo(glDev) };
 
         if (bo)
         {
@@ -1194,6 +1482,14 @@ RGLImage::GlobalDeviceDataMap::~GlobalDeviceDataMap() noexcept
         {
             auto current { RGLMakeCurrent::FromDevice(data.device, false) };
             glDeleteTextures(1, &data.texture.id);
+            RResourceTrackerSubBytes(RNativeMem, data.device, data.textureBytes);
+        }
+
+        if (data.mipTexture != 0)
+        {
+            auto current { RGLMakeCurrent::FromDevice(it->first, false) };
+            glDeleteTextures(1, &data.mipTexture);
+            RResourceTrackerSubBytes(RNativeMem, it->first, data.mipBytes);
         }
 
         if (data.eglSurfaceOwn == CZOwn::Own && data.eglSurface != EGL_NO_SURFACE)
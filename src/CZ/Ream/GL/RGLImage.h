@@ -8,6 +8,7 @@
 #include <CZ/Ream/GL/RGLContext.h>
 #include <EGL/egl.h>
 #include <unordered_map>
+#include <mutex>
 
 namespace CZ
 {
@@ -64,6 +65,18 @@ public:
      */
     RGLTexture texture(RGLDevice *device = nullptr) const noexcept;
 
+    /**
+     * @brief Returns a mipmapped `GL_TEXTURE_2D` copy of this image, for the given device.
+     *
+     * Only available for images created with RImageCap_Mipmaps. The copy is created lazily, and its
+     * contents and mip levels are regenerated when writeSerial() changes. The calling thread must
+     * have the device's context current.
+     *
+     * @param device Target device, or `nullptr` for the main device.
+     * @returns {0, 0} if mipmaps are not supported for this image on the device.
+     */
+    RGLTexture mipmapTexture(RGLDevice *device = nullptr) const noexcept;
+
     /**
      * @brief Returns a GL framebuffer object that renders into this image, for the given device.
      *
@@ -161,6 +174,10 @@ private:
     [[nodiscard]] static std::shared_ptr<RGLImage> MakeWithNativeStorage(SkISize size, const RDRMFormat &format, const RImageConstraints *constraints) noexcept;
 
     bool writePixelsGBMMapWrite(const RPixelBufferRegion &region) noexcept;
+    bool writePixelsGBMBackBuffer(const RPixelBufferRegion &region) noexcept;
+    bool swapGBMBuffers(const SkRegion &damage) noexcept;
+    std::shared_ptr<RGBMBo> deviceGBMBo(RDevice *device) const noexcept;
+    std::shared_ptr<RDRMFramebuffer> deviceDRMFb(RDevice *device) const noexcept;
     bool writePixelsNative(const RPixelBufferRegion &region) noexcept;
     bool readPixelsGBMmapRead(const RPixelBufferRegion &region) noexcept;
     bool readPixelsNative(const RPixelBufferRegion &region) noexcept;
@@ -177,13 +194,23 @@ private:
         NoDRMFb         = 1 << 4,
         NoSkImage       = 1 << 5,
         NoSkSurface     = 1 << 6,
+        NoMipmaps       = 1 << 7,
     };
 
     /* Private flags */
     enum PF
     {
         PFStorageGBM        = 1 << 0,
-        PFStorageNative     = 1 << 1
+        PFStorageNative     = 1 << 1,
+        PFNoGBMBackBuffer   = 1 << 2  // Not requested, unavailable or the buffer was exported
+    };
+
+    /* Spare GBM buffer used by writePixelsGBMMapWrite() while the front one is still being sampled */
+    struct GBMBackBuffer
+    {
+        std::shared_ptr<RGBMBo> bo;
+        std::shared_ptr<RSync> readSync; // Pending reads from when bo was the front buffer
+        SkRegion damage;                 // Written into the front buffer but not into bo yet
     };
 
     /* Device data shared across GL contexts */
@@ -193,6 +220,11 @@ private:
 
         RGLTexture texture {};
         CZOwn textureOwnership { CZOwn::Borrow };
+        UInt64 textureBytes { 0 }; // Accounted in RResourceTracker if allocated with glTexImage2D
+
+        GLuint mipTexture { 0 };
+        std::optional<UInt32> mipSerial; // writeSerial() the mip levels were generated from
+        UInt64 mipBytes { 0 };
 
         EGLSurface eglSurface { EGL_NO_SURFACE };
         CZOwn eglSurfaceOwn { CZOwn::Borrow };
@@ -224,8 +256,12 @@ private:
 
     RGLImage(std::shared_ptr<RCore> core, RDevice *device, SkISize size, const RFormatInfo *formatInfo, SkAlphaType alphaType, RModifier modifier) noexcept;
 
-    CZBitset<PF> m_pf {};
+    mutable CZBitset<PF> m_pf {};
     RGLFormat m_glFormat;
+
+    /* Serializes pixel uploads to this image only. Must be acquired before the global lock (never while holding it) */
+    std::mutex m_writeMutex;
+    GBMBackBuffer m_gbmBack;
     mutable GlobalDeviceDataMap m_devicesMap;
     std::shared_ptr<RGLContextDataManager> m_contextDataManager;
 };
@@ -1,6 +1,7 @@
 #include <CZ/Ream/RCore.h>
 #include <CZ/Ream/GL/RGLMakeCurrent.h>
 #include <CZ/Ream/GL/RGLDevice.h>
+#include <CZ/Ream/RProfiler.h>
 #include <CZ/Ream/RLog.h>
 
 using namespace CZ;
@@ -14,9 +15,10 @@ RGLMakeCurrent RGLMakeCurrent::FromDevice(RGLDevice *device, bool keepSurfaces)
     }
 
     auto ctx { device->eglContext() };
+    const auto &current { Current() };
 
-    if (keepSurfaces && eglGetCurrentDisplay() == device->eglDisplay() && ctx != EGL_NO_CONTEXT)
-        return { device->eglDisplay(), eglGetCurrentSurface(EGL_DRAW), eglGetCurrentSurface(EGL_READ), ctx };
+    if (keepSurfaces && current.display == device->eglDisplay() && ctx != EGL_NO_CONTEXT)
+        return { device->eglDisplay(), current.draw, current.read, ctx };
     else
         return { device->eglDisplay(), EGL_NO_SURFACE, EGL_NO_SURFACE, ctx };
 }
@@ -25,7 +27,60 @@ bool RGLMakeCurrent::restore() noexcept
 {
     if (restored) return false;
     restored = true;
-    if (prevDisplay != EGL_NO_DISPLAY)
-        eglMakeCurrent(prevDisplay, prevDraw, prevRead, prevContext);
+    MakeCurrent(prev.display, prev.draw, prev.read, prev.context);
     return true;
 }
+
+static thread_local RGLMakeCurrent::State t_current { EGL_NO_DISPLAY, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT };
+static thread_local bool t_currentValid { false };
+
+static void LoadCurrent() noexcept
+{
+    t_current.display = eglGetCurrentDisplay();
+    t_current.draw = eglGetCurrentSurface(EGL_DRAW);
+    t_current.read = eglGetCurrentSurface(EGL_READ);
+    t_current.context = eglGetCurrentContext();
+    t_currentValid = true;
+}
+
+const RGLMakeCurrent::State &RGLMakeCurrent::Current() noexcept
+{
+    // In case the context or its surfaces were switched by someone else (e.g. eglMakeCurrent() called
+    // directly by the application or by an EGL platform that keeps the context but swaps the surfaces)
+    if (!t_currentValid ||
+        t_current.context != eglGetCurrentContext() ||
+        t_current.draw != eglGetCurrentSurface(EGL_DRAW) ||
+        t_current.read != eglGetCurrentSurface(EGL_READ) ||
+        t_current.display != eglGetCurrentDisplay())
+        LoadCurrent();
+
+    return t_current;
+}
+
+bool RGLMakeCurrent::MakeCurrent(EGLDisplay display, EGLSurface draw, EGLSurface read, EGLContext context) noexcept
+{
+    if (display == EGL_NO_DISPLAY)
+        return true;
+
+    const auto &current { Current() };
+
+    if (current.context == context && (context == EGL_NO_CONTEXT ||
+        (current.display == display && current.draw == draw && current.read == read)))
+        return true;
+
+    RProfiler::Count(RProfiler::MakeCurrentCalls);
+
+    if (eglMakeCurrent(display, draw, read, context) == EGL_TRUE)
+    {
+        t_current = { display, draw, read, context };
+
+        // Releasing the context also releases the display
+        if (context == EGL_NO_CONTEXT)
+            t_current.display = EGL_NO_DISPLAY;
+
+        return true;
+    }
+
+    t_currentValid = false;
+    return false;
+}
@@ -11,6 +11,10 @@
  * then optionally binds a new context. On destruction (or an explicit restore()) it re-binds the
  * previously captured state. This is used throughout the GL backend to temporarily make a device's
  * context current on the calling thread without disturbing the caller's own binding.
+ *
+ * The binding of each thread is tracked, so binding the state that is already current (e.g. a painter
+ * draw within a pass) or restoring an unchanged one does not call `eglMakeCurrent()`. The tracker is
+ * revalidated against `eglGetCurrentContext()`, so contexts switched outside Ream are detected.
  */
 class CZ::RGLMakeCurrent
 {
@@ -33,12 +37,7 @@ public:
      *
      * Useful to snapshot and later restore() the current context.
      */
-    RGLMakeCurrent() noexcept :
-        prevDisplay(eglGetCurrentDisplay()),
-        prevDraw(eglGetCurrentSurface(EGL_DRAW)),
-        prevRead(eglGetCurrentSurface(EGL_READ)),
-        prevContext(eglGetCurrentContext())
-    {}
+    RGLMakeCurrent() noexcept : prev(Current()) {}
 
     /**
      * @brief Captures the current EGL binding and makes the given one current.
@@ -48,13 +47,9 @@ public:
      * @param read    The read surface to bind.
      * @param context The context to make current.
      */
-    RGLMakeCurrent(EGLDisplay display, EGLSurface draw, EGLSurface read, EGLContext context) noexcept :
-        prevDisplay(eglGetCurrentDisplay()),
-        prevDraw(eglGetCurrentSurface(EGL_DRAW)),
-        prevRead(eglGetCurrentSurface(EGL_READ)),
-        prevContext(eglGetCurrentContext())
+    RGLMakeCurrent(EGLDisplay display, EGLSurface draw, EGLSurface read, EGLContext context) noexcept : prev(Current())
     {
-        eglMakeCurrent(display, draw, read, context);
+        MakeCurrent(display, draw, read, context);
     }
 
     /**
@@ -74,11 +69,33 @@ public:
      */
     bool restore() noexcept;
 
+    /**
+     * @brief An EGL binding.
+     */
+    struct State
+    {
+        EGLDisplay display;
+        EGLSurface draw;
+        EGLSurface read;
+        EGLContext context;
+    };
+
+    /**
+     * @brief Returns the binding of the calling thread.
+     */
+    static const State &Current() noexcept;
+
+    /**
+     * @brief Binds the given state on the calling thread.
+     *
+     * Calls `eglMakeCurrent()` only if the state is not already current. Calls with EGL_NO_DISPLAY are ignored.
+     *
+     * @return `false` if `eglMakeCurrent()` failed, `true` otherwise.
+     */
+    static bool MakeCurrent(EGLDisplay display, EGLSurface draw, EGLSurface read, EGLContext context) noexcept;
+
 private:
-    EGLDisplay prevDisplay;
-    EGLSurface prevDraw;
-    EGLSurface prevRead;
-    EGLContext prevContext;
+    State prev;
     bool restored { false };
 };
 
@@ -8,6 +8,8 @@
 #include <CZ/Ream/RSurface.h>
 #include <CZ/Ream/RSync.h>
 #include <CZ/Ream/RMatrixUtils.h>
+#include <CZ/Ream/RProfiler.h>
+#include <CZ/Ream/RGammaLUT.h>
 #include <CZ/skia/core/SkMatrix.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
@@ -15,14 +17,14 @@
 
 using namespace CZ;
 
+void RGLPainter::writeTimestamp(UInt64 event, bool end) noexcept
+{
+    device()->writeTimestamp(event, end);
+}
+
 void RGLPainter::calcPosProj(RSurface *surface, bool flipY, SkScalar *outMat) const noexcept
 {
-    SkMatrix mat { RMatrixUtils::VirtualToNDC(
-        geometry().transform,
-        geometry().viewport,
-        geometry().dst,
-        surface->image()->size(),
-        flipY) };
+    const SkMatrix mat { RMatrixUtils::ImageToNDC(virtualToImage(), surface->image()->size(), flipY) };
     mat.get9(outMat);
 }
 
@@ -32,56 +34,92 @@ void RGLPainter::calcImageProj(const RDrawImageInfo &info, SkScalar *outMat) con
     mat.get9(outMat);
 }
 
-void RGLPainter::setScissors(RSurface *surface, bool flipY, const SkRegion &region) const noexcept
+bool RGLPainter::mapToFb(RSurface *surface, bool flipY, const SkIRect &rect, SkIRect *out) const noexcept
+{
+    SkRect mapped { virtualToImage().mapRect(SkRect::Make(rect)) };
+    const SkISize fbSize { surface->image()->size() };
+
+    if (flipY)
+        mapped.setLTRB(mapped.left(), fbSize.height() - mapped.bottom(), mapped.right(), fbSize.height() - mapped.top());
+
+    // Floor min, ceil max to ensure we cover the entire rect
+    const SkIRect covered { mapped.roundOut() };
+
+    if (!out->intersect(covered, SkIRect::MakeSize(fbSize)))
+        out->setEmpty();
+
+    constexpr SkScalar epsilon { 1.f / 256.f };
+    return std::abs(mapped.left() - covered.left()) < epsilon && std::abs(mapped.top() - covered.top()) < epsilon &&
+           std::abs(mapped.right() - covered.right()) < epsilon && std::abs(mapped.bottom() - covered.bottom()) < epsilon;
+}
+
+void RGLPainter::setScissors(RSurface *surface, bool flipY, const SkIRect &bounds) const noexcept
 {
-    SkRect virtualBounds { SkRect::Make(region.getBounds()) };
-
-    SkMatrix toFB = RMatrixUtils::VirtualToImage(
-        geometry().transform, geometry().viewport, geometry().dst);
-
-    SkRect mapped;
-    toFB.mapRect(&mapped, virtualBounds);
-
-    if (flipY) {
-        SkScalar top = mapped.top();
-        SkScalar bottom = mapped.bottom();
-
-        SkScalar flippedTop = surface->image()->size().height() - bottom;
-        SkScalar flippedBottom = surface->image()->size().height() - top;
-        mapped.setLTRB(
-            mapped.left(),
-            flippedTop,
-            mapped.right(),
-            flippedBottom
-            );
-    }
-
-    // Integerize: floor min, ceil max to ensure we cover the entire region.
-    int x0 = static_cast<int>(std::floor(mapped.left()));
-    int y0 = static_cast<int>(std::floor(mapped.top()));
-    int x1 = static_cast<int>(std::ceil(mapped.right()));
-    int y1 = static_cast<int>(std::ceil(mapped.bottom()));
-
-    // Clip to framebuffer bounds [0, fbWidth) x [0, fbHeight)
-    x0 = std::clamp(x0, 0, surface->image()->size().width());
-    y0 = std::clamp(y0, 0, surface->image()->size().height());
-    x1 = std::clamp(x1, 0, surface->image()->size().width());
-    y1 = std::clamp(y1, 0, surface->image()->size().height());
-
-    int w = x1 - x0;
-    int h = y1 - y0;
-    if (w <= 0 || h <= 0)
-        return; // nothing to draw
-
-    glScissor(x0, y0, w, h);
+    SkIRect box;
+    mapToFb(surface, flipY, bounds, &box);
+
+    // An empty box discards everything
+    device()->glState().scissor(box.x(), box.y(), box.width(), box.height());
 }
 
-void RGLPainter::bindTexture(RGLTexture tex, GLuint uniform, const RDrawImageInfo &info, GLuint slot) const noexcept
+void RGLPainter::drawRegion(RSurface *surface, bool flipY, const SkRegion &region, GLuint posLoc) const noexcept
+{
+    auto &state { device()->glState() };
+    const auto size { surface->image()->size() };
+    state.viewport(0, 0, size.width(), size.height());
+    state.enableVertexAttrib(posLoc);
+
+    if (pickRegionStrategy(region) == RegionStrategy::Scissor)
+    {
+        SkIRect box;
+        bool exact { true };
+
+        for (SkRegion::Iterator it(region); !it.done() && exact; it.next())
+            exact = mapToFb(surface, flipY, it.rect(), &box);
+
+        if (exact)
+        {
+            // The same bounds quad for all rects, the scissor does the clipping
+            const std::vector<GLfloat> quad { genVBO(SkRegion(region.getBounds())) };
+            glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 0, quad.data());
+            GLsizei vertices { 0 };
+
+            for (SkRegion::Iterator it(region); !it.done(); it.next())
+            {
+                mapToFb(surface, flipY, it.rect(), &box);
+
+                if (box.isEmpty())
+                    continue;
+
+                state.scissor(box.x(), box.y(), box.width(), box.height());
+                glDrawArrays(GL_TRIANGLES, 0, 6);
+                vertices += 6;
+            }
+
+            RProfiler::Count(RProfiler::Vertices, vertices);
+            return;
+        }
+    }
+
+    const std::vector<GLfloat> vbo { genVBO(region) };
+    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 0, vbo.data());
+    setScissors(surface, flipY, region.getBounds());
+    const GLsizei vertices { region.computeRegionComplexity() * 6 };
+    RProfiler::Count(RProfiler::Vertices, vertices);
+    glDrawArrays(GL_TRIANGLES, 0, vertices);
+}
+
+void RGLPainter::bindTexture(RGLTexture tex, GLuint uniform, const RDrawImageInfo &info, GLuint slot, bool mipmapped) const noexcept
 {
     glActiveTexture(GL_TEXTURE0 + slot);
     glBindSampler(slot, 0); // Skia messes with this...
     glBindTexture(tex.target, tex.id);
-    glTexParameteri(tex.target, GL_TEXTURE_MIN_FILTER, info.minFilter == RImageFilter::Linear ? GL_LINEAR : GL_NEAREST);
+
+    if (mipmapped)
+        glTexParameteri(tex.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    else
+        glTexParameteri(tex.target, GL_TEXTURE_MIN_FILTER, info.minFilter == RImageFilter::Linear ? GL_LINEAR : GL_NEAREST);
+
     glTexParameteri(tex.target, GL_TEXTURE_MAG_FILTER, info.magFilter == RImageFilter::Linear ? GL_LINEAR : GL_NEAREST);
     glTexParameteri(tex.target, GL_TEXTURE_WRAP_S, RImageWrapToGL(info.wrapS));
     glTexParameteri(tex.target, GL_TEXTURE_WRAP_T, RImageWrapToGL(info.wrapT));
@@ -90,6 +128,9 @@ void RGLPainter::bindTexture(RGLTexture tex, GLuint uniform, const RDrawImageInf
 
 bool RGLPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip, const RDrawImageInfo *maskInfo) noexcept
 {
+    if (deferDrawImage(imageInfo, clip, maskInfo))
+        return true;
+
     if (blendMode() == RBlendMode::SrcOver && (factor().fA <= 0.f || opacity() <= 0.f))
         return true;
 
@@ -173,7 +214,51 @@ skipMask:
         RGLMakeCurrent::FromDevice(device(), true) :
         RGLMakeCurrent(device()->eglDisplay(), eglSurface, eglSurface, device()->eglContext())
     };
-    const auto features { calcDrawImageFeatures(image, &tex, mask ? &maskTex : nullptr) };
+
+    // Both timestamps are written with the draw's context bound (destroyed before current)
+    const ProfiledDraw profile { this, "drawImage" };
+
+    // Trilinear sampling when scaled down
+    bool mipmapped { false };
+
+    if (image->mipmaps() && imageInfo.minFilter == RImageFilter::Linear && isMinified(imageInfo))
+    {
+        if (const auto mipTex { image->asGL()->mipmapTexture(device()) }; mipTex.id != 0)
+        {
+            tex = mipTex;
+            mipmapped = true;
+        }
+    }
+
+    auto features { calcDrawImageFeatures(image, &tex, mask ? &maskTex : nullptr) };
+
+    // The curves are applied by the shader (DstIn only writes the alpha)
+    std::shared_ptr<RImage> lut;
+    RGLTexture lutTex {};
+
+    if (gammaLUT() && gammaLUT()->size() > 0 && blendMode() != RBlendMode::DstIn)
+    {
+        lut = gammaLUT()->image(device());
+
+        if (lut)
+            lutTex = lut->asGL()->texture(device());
+
+        if (lutTex.id == 0)
+        {
+            device()->log(CZError, CZLN, "Failed to get GL texture from the gamma LUT");
+            return false;
+        }
+
+        if (lut->writeSync())
+            lut->writeSync()->gpuWait(device());
+
+        features.add(RGLShader::HasGammaLUT);
+    }
+
+    // The samples are converted into the destination encoding before anything else
+    if (blendMode() != RBlendMode::DstIn && !features.has(RGLShader::ReplaceImageColor))
+        features.add(RGLShader::ColorTransform(image->colorDescription(), surface->image()->colorDescription()).get());
+
     const auto prog { RGLProgram::GetOrMake(device(), features) };
 
     if (!prog)
@@ -187,7 +272,8 @@ skipMask:
 
     if (blendMode() != RBlendMode::DstIn && features.has(RGLShader::ReplaceImageColor))
     {
-        const SkColor4f replaceColorF { SkColor4f::FromColor(color()) };        
+        // sRGB, the gamma LUT is applied by the shader
+        const SkColor4f replaceColorF { RColorDescription::Convert(SkColor4f::FromColor(color()), {}, surface->image()->colorDescription(), false) };
         colorF.fA *= m_state.opacity;
         colorF.fR *= replaceColorF.fR;
         colorF.fG *= replaceColorF.fG;
@@ -198,8 +284,10 @@ skipMask:
         colorF.fA *= m_state.opacity;
     }
 
+    const bool clipped { features.has(RGLShader::HasClip) };
+
     /* Skip dummy user operations */
-    if (image->alphaType() == kOpaque_SkAlphaType && !mask)
+    if (image->alphaType() == kOpaque_SkAlphaType && !mask && !clipped)
     {
         if (blendMode() == RBlendMode::DstIn)
         {
@@ -233,13 +321,19 @@ skipMask:
         }
     }
 
+    auto &state { device()->glState() };
+    state.prepare();
+    state.unbindArrayBuffer();
     prog->bind();
     glBindFramebuffer(GL_FRAMEBUFFER, fb.value());
-    bindTexture(tex, prog->loc().image, imageInfo, 0);
+    bindTexture(tex, prog->loc().image, imageInfo, 0, mipmapped);
 
     if (features.has(RGLShader::HasMask))
         bindTexture(maskTex, prog->loc().mask, *maskInfo, 1);
 
+    if (lut)
+        bindTexture(lutTex, prog->loc().gammaLUT, RDrawImageInfo { .image = lut }, 2); // Linear, ClampToEdge
+
     if (features.has(RGLShader::HasFactorA))
         glUniform1f(prog->loc().factorA, colorF.fA);
 
@@ -268,27 +362,27 @@ skipMask:
         glUniformMatrix3fv(prog->loc().maskProj, 1, GL_FALSE, mat);
     }
 
+    if (clipped)
+        setClipUniforms(prog);
+
     if (blendMode() == RBlendMode::Src)
     {
         if (features.has(RGLShader::ReplaceImageColor))
         {
             // The color is premult and HasFactorA is not set
             // but RGB must be multiplied by image.a and/or mask.a
-            glEnable(GL_BLEND);
-            glBlendEquation(GL_FUNC_ADD);
-            glBlendFuncSeparate(GL_SRC_ALPHA, GL_ZERO, GL_ONE, GL_ZERO);
+            state.blendFunc(GL_SRC_ALPHA, GL_ZERO, GL_ONE, GL_ZERO);
         }
         else
         {
-            /* Even in this mode, we need to enable blending and convert the image to premultiplied */
-            if (image->alphaType() == kUnpremul_SkAlphaType)
+            /* Even in this mode, we need to enable blending and convert the image to premultiplied
+             * (opaque images too if the clip coverage is applied to the alpha) */
+            if (image->alphaType() == kUnpremul_SkAlphaType || (clipped && image->alphaType() == kOpaque_SkAlphaType))
             {
-                glEnable(GL_BLEND);
-                glBlendEquation(GL_FUNC_ADD);
-                glBlendFuncSeparate(GL_SRC_ALPHA, GL_ZERO, GL_ONE, GL_ZERO);
+                state.blendFunc(GL_SRC_ALPHA, GL_ZERO, GL_ONE, GL_ZERO);
             }
             else
-                glDisable(GL_BLEND);
+                state.setBlend(false);
         }
     }
     else if (blendMode() == RBlendMode::SrcOver)
@@ -297,34 +391,26 @@ skipMask:
         {
             // The color is premult and HasFactorA is not set
             // but RGB must be multiplied by image.a and/or mask.a
-            glEnable(GL_BLEND);
-            glBlendEquation(GL_FUNC_ADD);
-            glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
         }
         else
         {
             if (image->alphaType() == kOpaque_SkAlphaType)
             {
-                if (colorF.fA >= 1.f && !mask)
-                    glDisable(GL_BLEND);
+                if (colorF.fA >= 1.f && !mask && !clipped)
+                    state.setBlend(false);
                 else
                 {
-                    glEnable(GL_BLEND);
-                    glBlendEquation(GL_FUNC_ADD);
-                    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                    state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
                 }
             }
             else if (image->alphaType() == kUnpremul_SkAlphaType)
             {
-                glEnable(GL_BLEND);
-                glBlendEquation(GL_FUNC_ADD);
-                glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
             }
             else // Premult
             {
-                glEnable(GL_BLEND);
-                glBlendEquation(GL_FUNC_ADD);
-                glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                state.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
             }
         }
     }
@@ -333,30 +419,24 @@ skipMask:
         /* We only care about A so the alphaType() doesn't matter.
          * This function exits earlier if the alpha type is Opaque
          * finalAlpha = 1.f and there is no mask */
-        glEnable(GL_BLEND);
-        glBlendEquation(GL_FUNC_ADD);
-        glBlendFunc(GL_ZERO, GL_SRC_ALPHA);
+        state.blendFunc(GL_ZERO, GL_SRC_ALPHA);
     }
 
-    std::vector<GLfloat> vbo { genVBO(region) };
-    glEnableVertexAttribArray(prog->loc().pos);
-    glVertexAttribPointer(prog->loc().pos, 2, GL_FLOAT, GL_FALSE, 0, vbo.data());
-    const auto size { surface->image()->size() };
-    glViewport(0, 0, size.width(), size.height());
-    setScissors(surface.get(), fb == 0, region);
-    glBlendEquation(GL_FUNC_ADD);
-    glDrawArrays(GL_TRIANGLES, 0, region.computeRegionComplexity() * 6);
-    glDisableVertexAttribArray(prog->loc().pos);
-    glUseProgram(0);
+    drawRegion(surface.get(), fb == 0, region, prog->loc().pos);
     auto sync { RSync::Make(device()) };
     image->setReadSync(sync);
     if (mask)
         mask->setReadSync(sync);
+    if (lut)
+        lut->setReadSync(sync);
     return true;
 }
 
 bool RGLPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect effect, const SkRegion *clip) noexcept
 {
+    if (deferDrawImageEffect(imageInfo, effect, clip))
+        return true;
+
     auto surface { m_surface };
 
     if (!surface || !surface->image())
@@ -404,11 +484,18 @@ bool RGLPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect ef
             RGLMakeCurrent(device()->eglDisplay(), eglSurface, eglSurface, device()->eglContext())
     };
 
+    const ProfiledDraw profile { this, "drawImageEffect" };
+
     UInt32 features { RGLShader::HasImage  | RGLShader::HasPixelSize | (effect << 28) };
 
     if (tex.target == GL_TEXTURE_EXTERNAL_OES)
         features |= RGLShader::ImageExternal;
 
+    // P010 planes
+    if ((effect == YUVLuma || effect == YUVChroma) &&
+        (surface->image()->formatInfo().format == DRM_FORMAT_R16 || surface->image()->formatInfo().format == DRM_FORMAT_GR1616))
+        features |= RGLShader::YUV10Bit;
+
     const auto prog { RGLProgram::GetOrMake(device(), features) };
 
     if (!prog)
@@ -417,6 +504,9 @@ bool RGLPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect ef
         return false;
     }
 
+    auto &state { device()->glState() };
+    state.prepare();
+    state.unbindArrayBuffer();
     prog->bind();
     glBindFramebuffer(GL_FRAMEBUFFER, fb.value());
     bindTexture(tex, prog->loc().image, imageInfo, 0);
@@ -435,18 +525,9 @@ bool RGLPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect ef
     else
         glUniform1f(prog->loc().pixelSize, imageInfo.srcScale/SkScalar(imageInfo.src.height()));
 
-    glDisable(GL_BLEND);
+    state.setBlend(false);
 
-    std::vector<GLfloat> vbo { genVBO(region) };
-    glEnableVertexAttribArray(prog->loc().pos);
-    glVertexAttribPointer(prog->loc().pos, 2, GL_FLOAT, GL_FALSE, 0, vbo.data());
-    const auto size { surface->image()->size() };
-    glViewport(0, 0, size.width(), size.height());
-    setScissors(surface.get(), fb == 0, region);
-    glBlendEquation(GL_FUNC_ADD);
-    glDrawArrays(GL_TRIANGLES, 0, region.computeRegionComplexity() * 6);
-    glDisableVertexAttribArray(prog->loc().pos);
-    glUseProgram(0);
+    drawRegion(surface.get(), fb == 0, region, prog->loc().pos);
     auto sync { RSync::Make(device()) };
     image->setReadSync(sync);
     return true;
@@ -497,7 +578,7 @@ std::vector<GLfloat> RGLPainter::genVBO(const SkRegion &region) const noexcept
 
 SkRegion RGLPainter::calcDrawImageRegion(RSurface */*surface*/, const RDrawImageInfo &imageInfo, const SkRegion *clip, const RDrawImageInfo *maskInfo) const noexcept
 {
-    SkRegion region { geometry().viewport.roundOut() };
+    SkRegion region { viewportClip() };
     region.op(imageInfo.dst, SkRegion::Op::kIntersect_Op);
 
     if (maskInfo)
@@ -511,6 +592,9 @@ SkRegion RGLPainter::calcDrawImageRegion(RSurface */*surface*/, const RDrawImage
 
 bool RGLPainter::drawColor(const SkRegion &userRegion) noexcept
 {
+    if (deferDrawColor(userRegion))
+        return true;
+
     if (blendMode() == RBlendMode::SrcOver && (SkColorGetA(color()) == 0 || factor().fA <= 0.f || opacity() <= 0.f))
         return true;
 
@@ -519,11 +603,9 @@ bool RGLPainter::drawColor(const SkRegion &userRegion) noexcept
     if (!surface || !surface->image())
         return false;
 
-    const SkIRect clipRect { geometry().viewport.roundOut() };
+    SkRegion region { viewportClip() };
 
-    SkRegion region;
-
-    if (!region.op(clipRect, userRegion, SkRegion::kIntersect_Op))
+    if (!region.op(userRegion, SkRegion::kIntersect_Op))
         return true; // Empty
 
     const auto fb { surface->image()->asGL()->glFb(device()) };
@@ -541,15 +623,38 @@ bool RGLPainter::drawColor(const SkRegion &userRegion) noexcept
             RGLMakeCurrent(device()->eglDisplay(), eglSurface, eglSurface, device()->eglContext())
     };
 
+    const ProfiledDraw profile { this, "drawColor" };
+
     // Always converted to premultiplied alpha
     const SkColor4f colorF { calcDrawColorColor() };
 
-    if (m_state.blendMode == RBlendMode::DstIn && colorF.fA >= 1.f)
+    if (m_state.blendMode == RBlendMode::DstIn && colorF.fA >= 1.f && !coverageClip())
     {
         device()->log(CZTrace, "Skipping drawColor(DstIn, alpha = 1.f): multiplying dst by 1.f is a noop");
         return true;
     }
 
+    auto &state { device()->glState() };
+    SkRegion clearRegion;
+
+    if (calcClearRegion(region, colorF, clearRegion))
+    {
+        // Fast clear path, no program, blending or vertices
+        state.prepare();
+        glBindFramebuffer(GL_FRAMEBUFFER, fb.value());
+        state.clearColor(colorF.fR, colorF.fG, colorF.fB, colorF.fA);
+        const int fbHeight { surface->image()->size().height() };
+
+        for (SkRegion::Iterator it(clearRegion); !it.done(); it.next())
+        {
+            const SkIRect &r { it.rect() };
+            state.scissor(r.x(), fb.value() == 0 ? fbHeight - r.bottom() : r.y(), r.width(), r.height());
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        return true;
+    }
+
     const auto features { calcDrawColorFeatures(colorF.fA) };
     const auto prog { RGLProgram::GetOrMake(device(), features) };
 
@@ -559,29 +664,90 @@ bool RGLPainter::drawColor(const SkRegion &userRegion) noexcept
         return false;
     }
 
+    state.prepare();
+    state.unbindArrayBuffer();
     prog->bind();
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindFramebuffer(GL_FRAMEBUFFER, fb.value());
     setDrawColorUniforms(features, prog, colorF);
 
+    if (features.has(RGLShader::HasClip))
+        setClipUniforms(prog);
+
     // posProj
     SkScalar matVals[9];
     calcPosProj(surface.get(), fb.value() == 0, matVals);
     glUniformMatrix3fv(prog->loc().posProj, 1, GL_FALSE, matVals);
 
-    std::vector<GLfloat> vbo { genVBO(region) };
-    glEnableVertexAttribArray(prog->loc().pos);
-    glVertexAttribPointer(prog->loc().pos, 2, GL_FLOAT, GL_FALSE, 0, vbo.data());
-
     setDrawColorBlendFunc(features);
+    drawRegion(surface.get(), fb == 0, region, prog->loc().pos);
+    return true;
+}
+
+bool RGLPainter::drawShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread, const SkRegion *userRegion) noexcept
+{
+    if (deferDrawShadow(rrect, sigma, color, spread, userRegion))
+        return true;
+
+    ShadowInfo shadow;
+
+    if (!calcShadow(rrect, sigma, color, spread, userRegion, shadow))
+        return true; // Empty
+
+    const auto surface { m_surface };
+
+    if (!surface || !surface->image())
+        return false;
+
+    const auto fb { surface->image()->asGL()->glFb(device()) };
+
+    if (!fb.has_value())
+    {
+        device()->log(CZError, CZLN, "Failed to get GL framebuffer from RGLImage");
+        return false;
+    }
+
+    const EGLSurface eglSurface { surface->image()->asGL()->eglSurface(device()) };
+    const auto current {
+        eglSurface == EGL_NO_SURFACE ?
+            RGLMakeCurrent::FromDevice(device(), true) :
+            RGLMakeCurrent(device()->eglDisplay(), eglSurface, eglSurface, device()->eglContext())
+    };
+
+    const ProfiledDraw profile { this, "drawShadow" };
+
+    // The coverage is multiplied into the alpha, so it always blends
+    auto features { calcDrawColorFeatures(0.f) };
+    features.add(RGLShader::HasShadow);
+    const auto prog { RGLProgram::GetOrMake(device(), features) };
+
+    if (!prog)
+    {
+        device()->log(CZError, CZLN, "Failed to create a GL program with the required features");
+        return false;
+    }
+
+    auto &state { device()->glState() };
+    state.prepare();
+    state.unbindArrayBuffer();
+    prog->bind();
+    glBindFramebuffer(GL_FRAMEBUFFER, fb.value());
+    setDrawColorUniforms(features, prog, shadow.color);
 
-    glViewport(0, 0, surface->image()->size().width(), surface->image()->size().height());
-    setScissors(surface.get(), fb == 0, region);
+    if (features.has(RGLShader::HasClip))
+        setClipUniforms(prog);
 
+    const SkRect &r { shadow.rrect.rect() };
+    glUniform4f(prog->loc().shadowRect, r.left(), r.top(), r.right(), r.bottom());
+    glUniform4fv(prog->loc().shadowRadii, 1, shadow.radii);
+    glUniform1f(prog->loc().shadowSigma, shadow.sigma);
 
-    glDrawArrays(GL_TRIANGLES, 0, region.computeRegionComplexity() * 6);
-    glDisableVertexAttribArray(prog->loc().pos);
-    glUseProgram(0);
+    // posProj
+    SkScalar matVals[9];
+    calcPosProj(surface.get(), fb.value() == 0, matVals);
+    glUniformMatrix3fv(prog->loc().posProj, 1, GL_FALSE, matVals);
+
+    setDrawColorBlendFunc(features);
+    drawRegion(surface.get(), fb == 0, shadow.region, prog->loc().pos);
     return true;
 }
 
@@ -611,6 +777,7 @@ CZBitset<RGLShader::Features> RGLPainter::calcDrawImageFeatures(std::shared_ptr<
     }
 
     features.setFlag(RGLShader::HasFactorA, m_state.factor.fA * m_state.opacity != 1.f);
+    features.setFlag(RGLShader::HasClip, coverageClip() != nullptr);
 
     switch (blendMode())
     {
@@ -659,6 +826,13 @@ CZBitset<RGLShader::Features> RGLPainter::calcDrawColorFeatures(SkScalar finalAl
 {
     CZBitset<RGLShader::Features> features {};
 
+    // The clip coverage is multiplied into the alpha, so SrcOver must blend
+    if (coverageClip())
+    {
+        features.add(RGLShader::HasClip);
+        finalAlpha = 0.f;
+    }
+
     switch (blendMode())
     {
     case RBlendMode::Src: // glBlend disabled
@@ -696,27 +870,44 @@ void RGLPainter::setDrawColorUniforms(CZBitset<RGLShader::Features> features, st
         glUniform1f(prog->loc().factorA, colorF.fA);
 }
 
+void RGLPainter::setClipUniforms(std::shared_ptr<RGLProgram> prog) const noexcept
+{
+    const SkRRect &rrect { *coverageClip() };
+    const SkRect &r { rrect.rect() };
+    GLfloat radiiX[4], radiiY[4];
+
+    for (int i = 0; i < 4; i++)
+    {
+        const SkVector radii { rrect.radii(SkRRect::Corner(i)) };
+        radiiX[i] = radii.x();
+        radiiY[i] = radii.y();
+    }
+
+    glUniform4f(prog->loc().clipRect, r.left(), r.top(), r.right(), r.bottom());
+    glUniform4fv(prog->loc().clipRadiiX, 1, radiiX);
+    glUniform4fv(prog->loc().clipRadiiY, 1, radiiY);
+    glUniform1f(prog->loc().clipPixelSize, viewportPixelSize());
+}
+
 void RGLPainter::setDrawColorBlendFunc(CZBitset<RGLShader::Features> features) const noexcept
 {
+    auto &state { device()->glState() };
+
     switch (blendMode())
     {
     case RBlendMode::Src:
-        glDisable(GL_BLEND);
+        state.setBlend(false);
         break;
     case RBlendMode::SrcOver:
         if (features.has(RGLShader::HasFactorA))
         {
-            glEnable(GL_BLEND);
-            glBlendEquation(GL_FUNC_ADD);
-            glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+            state.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
         }
         else
-            glDisable(GL_BLEND);
+            state.setBlend(false);
         break;
     case RBlendMode::DstIn:
-        glEnable(GL_BLEND);
-        glBlendEquation(GL_FUNC_ADD);
-        glBlendFunc(GL_ZERO, GL_SRC_ALPHA);
+        state.blendFunc(GL_ZERO, GL_SRC_ALPHA);
         break;
     };
 }
@@ -742,5 +933,5 @@ SkColor4f RGLPainter::calcDrawColorColor() const noexcept
         colorF.fB *= colorF.fA * m_state.factor.fB;
     }
 
-    return colorF;
+    return mapOutputColor(colorF, true);
 }
@@ -19,6 +19,7 @@ public:
     bool drawImage(const RDrawImageInfo& image, const SkRegion *region = nullptr, const RDrawImageInfo* mask = nullptr) noexcept override;
     bool drawImageEffect(const RDrawImageInfo& image, ImageEffect effect, const SkRegion *region = nullptr) noexcept override;
     bool drawColor(const SkRegion &region) noexcept override;
+    bool drawShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread = 0.f, const SkRegion *region = nullptr) noexcept override;
 
     /**
      * @brief Returns the device used for rendering by this painter as an RGLDevice.
@@ -27,18 +28,25 @@ public:
     bool setGeometry(const RSurfaceGeometry &geometry) noexcept override;
 
 private:
+    void writeTimestamp(UInt64 event, bool end) noexcept override;
     CZBitset<RGLShader::Features> calcDrawImageFeatures(std::shared_ptr<RImage> image, RGLTexture *imageTex, RGLTexture *maskTex) const noexcept;
     CZBitset<RGLShader::Features> calcDrawColorFeatures(SkScalar finalAlpha) const noexcept;
     SkColor4f calcDrawColorColor() const noexcept;
     void setDrawColorUniforms(CZBitset<RGLShader::Features> features, std::shared_ptr<RGLProgram> prog, const SkColor4f &colorF) const noexcept;
     void setDrawColorBlendFunc(CZBitset<RGLShader::Features> features) const noexcept;
+    void setClipUniforms(std::shared_ptr<RGLProgram> prog) const noexcept;
 
     std::vector<GLfloat> genVBO(const SkRegion &region) const noexcept;
     SkRegion calcDrawImageRegion(RSurface *surface, const RDrawImageInfo &imageInfo, const SkRegion *clip, const RDrawImageInfo *maskInfo) const noexcept;
     void calcPosProj(RSurface *surface, bool flipY, SkScalar *outMat) const noexcept;
     void calcImageProj(const RDrawImageInfo &info, SkScalar *outMat) const noexcept;
-    void setScissors(RSurface *surface, bool flipY, const SkRegion &region) const noexcept;
-    void bindTexture(RGLTexture tex, GLuint uniform, const RDrawImageInfo &info, GLuint slot) const noexcept;
+    // Maps a viewport rect to the framebuffer (clamped), returns false if it does not map to whole pixels
+    bool mapToFb(RSurface *surface, bool flipY, const SkIRect &rect, SkIRect *out) const noexcept;
+    void setScissors(RSurface *surface, bool flipY, const SkIRect &bounds) const noexcept;
+
+    // Sets the viewport, scissor and vertices, then draws the region (see RegionStrategy)
+    void drawRegion(RSurface *surface, bool flipY, const SkRegion &region, GLuint posLoc) const noexcept;
+    void bindTexture(RGLTexture tex, GLuint uniform, const RDrawImageInfo &info, GLuint slot, bool mipmapped = false) const noexcept;
     friend class RGLDevice;
     friend class RGLShader;
     friend class RGLProgram;
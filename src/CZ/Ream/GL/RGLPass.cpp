@@ -12,8 +12,18 @@ RGLPass::~RGLPass() noexcept
     if (m_lastUsage == 0)
         return; // Was not used at all
 
-    if (m_lastUsage == RPassCap_SkCanvas)
+    if (m_lastUsage == RPassCap_Painter)
+    {
+        m_painter->flushDeferredDraws();
+
+        // Skia may be used next by another pass sharing the context
+        if (m_skSurface)
+            m_skSurface->recordingContext()->asDirectContext()->resetContext(m_device->asGL()->glState().takeSkiaResetFlags());
+    }
+    else if (m_lastUsage == RPassCap_SkCanvas)
         m_skSurface->recordingContext()->asDirectContext()->flush(m_skSurface.get());
+
+    m_device->asGL()->writeTimestamp(m_profilerEvent, true);
 }
 
 SkCanvas *RGLPass::getCanvas(bool sync) const noexcept
@@ -60,20 +70,33 @@ void RGLPass::updateCurrent(RPassCap cap) const noexcept
 {
     auto *glDevice { m_device->asGL() };
     const EGLSurface eglSurface { m_image->asGL()->eglSurface(glDevice) };
-    m_current.reset(new RGLMakeCurrent(glDevice->eglDisplay(), eglSurface, eglSurface, glDevice->eglContext()));
+
+    // Bound once per pass, the previous binding is restored when the pass ends
+    if (!m_current)
+        m_current.reset(new RGLMakeCurrent(glDevice->eglDisplay(), eglSurface, eglSurface, glDevice->eglContext()));
+    else
+        RGLMakeCurrent::MakeCurrent(glDevice->eglDisplay(), eglSurface, eglSurface, glDevice->eglContext());
 
     if (m_lastUsage == cap)
         return;
 
+    if (m_lastUsage == 0 && m_profilerEvent)
+    {
+        // Collect previous results before issuing new queries
+        glDevice->resolveTimestamps();
+        glDevice->writeTimestamp(m_profilerEvent, false);
+    }
+
+    // Draws deferred by occlusion culling must land before the SkCanvas ones
+    if (m_lastUsage == RPassCap_Painter)
+        m_painter->flushDeferredDraws();
+
     m_lastUsage = cap;
 
     if (cap == RPassCap_SkCanvas)
     {
-        // Ensure RGLPainter commands are flushed
-        glFlush();
-
-        // Reset GL state modified by RGLPainter
-        m_skSurface->recordingContext()->asDirectContext()->resetContext();
+        // Same context, RGLPainter commands are already ordered before Skia's, only reset what it modified
+        m_skSurface->recordingContext()->asDirectContext()->resetContext(glDevice->glState().takeSkiaResetFlags());
     }
     else // RGLPainter
     {
@@ -81,33 +104,7 @@ void RGLPass::updateCurrent(RPassCap cap) const noexcept
         if (m_skSurface)
             m_skSurface->recordingContext()->asDirectContext()->flush(m_skSurface.get());
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-        glBindRenderbuffer(GL_RENDERBUFFER, 0);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.0f);
-        glEnable(GL_BLEND);
-        glEnable(GL_TEXTURE_2D);
-        glEnable(GL_SCISSOR_TEST);
-        glDisable(GL_STENCIL_TEST);
-        glDisable(GL_DEPTH_TEST);
-        glDisable(GL_CULL_FACE);
-        glDisable(GL_DITHER);
-        glDisable(GL_POLYGON_OFFSET_FILL);
-        glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
-        glDisable(GL_SAMPLE_COVERAGE);
-        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-        glCullFace(GL_BACK);
-        glLineWidth(1);
-        glHint(GL_GENERATE_MIPMAP_HINT, GL_FASTEST);
-        glPolygonOffset(0, 0);
-        glDepthFunc(GL_LESS);
-        glDepthRangef(0, 1);
-        glStencilMask(1);
-        glDepthMask(GL_FALSE);
-        glFrontFace(GL_CCW);
-        glBlendColor(0, 0, 0, 0);
-        glBlendEquation(GL_FUNC_ADD);
+        // Skia may have modified anything, RGLPainter re-applies its state on the next draw
+        glDevice->glState().invalidate();
     }
 }
@@ -2,6 +2,7 @@
 #include <CZ/Ream/GL/RGLMakeCurrent.h>
 #include <CZ/Ream/GL/RGLProgram.h>
 #include <CZ/Ream/GL/RGLDevice.h>
+#include <CZ/Ream/RProfiler.h>
 
 using namespace CZ;
 
@@ -36,7 +37,7 @@ RGLProgram::~RGLProgram() noexcept
 
 void RGLProgram::bind() noexcept
 {
-    glUseProgram(m_id);
+    m_device->glState().useProgram(m_id);
 }
 
 RGLProgram::RGLProgram(RGLDevice *device, CZBitset<RGLShader::Features> features) noexcept :
@@ -62,6 +63,7 @@ bool RGLProgram::link() noexcept
     glAttachShader(m_id, m_vert->id());
     glAttachShader(m_id, m_frag->id());
     glLinkProgram(m_id);
+    RProfiler::Count(RProfiler::ProgramCreations);
 
     GLint linked { 0 };
     glGetProgramiv(m_id, GL_LINK_STATUS, &linked);
@@ -78,8 +80,7 @@ bool RGLProgram::link() noexcept
         return false;
     }
 
-    glUseProgram(m_id);
-
+    // Attribute and uniform locations can be queried without binding the program
     m_loc.pos = glGetAttribLocation(m_id, "pos");
     m_loc.posProj = glGetUniformLocation(m_id, "posProj");
 
@@ -110,5 +111,23 @@ bool RGLProgram::link() noexcept
         }
     }
 
+    if (features().has(RGLShader::HasClip))
+    {
+        m_loc.clipRect = glGetUniformLocation(m_id, "clipRect");
+        m_loc.clipRadiiX = glGetUniformLocation(m_id, "clipRadiiX");
+        m_loc.clipRadiiY = glGetUniformLocation(m_id, "clipRadiiY");
+        m_loc.clipPixelSize = glGetUniformLocation(m_id, "clipPixelSize");
+    }
+
+    if (features().has(RGLShader::HasShadow))
+    {
+        m_loc.shadowRect = glGetUniformLocation(m_id, "shadowRect");
+        m_loc.shadowRadii = glGetUniformLocation(m_id, "shadowRadii");
+        m_loc.shadowSigma = glGetUniformLocation(m_id, "shadowSigma");
+    }
+
+    if (features().has(RGLShader::HasGammaLUT))
+        m_loc.gammaLUT = glGetUniformLocation(m_id, "gammaLUT");
+
     return true;
 }
@@ -37,6 +37,17 @@ public:
         GLint factorA;      ///< `factorA` uniform (alpha channel multiplier).
 
         GLint pixelSize;    ///< `pixelSize` uniform (texel size, used by effect shaders).
+
+        GLint clipRect;     ///< `clipRect` uniform (rounded clip rect, LTRB).
+        GLint clipRadiiX;   ///< `clipRadiiX` uniform (horizontal corner radii).
+        GLint clipRadiiY;   ///< `clipRadiiY` uniform (vertical corner radii).
+        GLint clipPixelSize; ///< `clipPixelSize` uniform (anti-aliasing width).
+
+        GLint shadowRect;   ///< `shadowRect` uniform (shadow caster rect, LTRB).
+        GLint shadowRadii;  ///< `shadowRadii` uniform (shadow caster corner radii).
+        GLint shadowSigma;  ///< `shadowSigma` uniform (blur standard deviation).
+
+        GLint gammaLUT;     ///< `gammaLUT` sampler uniform (RGammaLUT::image()).
     };
 
     /**
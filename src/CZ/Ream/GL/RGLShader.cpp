@@ -1,6 +1,7 @@
 #include <CZ/Ream/GL/RGLMakeCurrent.h>
 #include <CZ/Ream/GL/RGLShader.h>
 #include <CZ/Ream/GL/RGLDevice.h>
+#include <CZ/Ream/RGammaLUT.h>
 #include <format>
 
 #include <string>
@@ -22,6 +23,10 @@ attribute vec2 pos;
     #endif
 #endif
 
+#if defined(HAS_CLIP) || defined(HAS_SHADOW)
+    varying vec2 virtPos;
+#endif
+
 void main() {
     vec3 pos3 = vec3(pos, 1.0);
     gl_Position = vec4(pos3 * posProj, 1.0);
@@ -33,6 +38,10 @@ void main() {
         maskCord = (pos3 * maskProj).xy;
     #endif
 #endif
+
+#if defined(HAS_CLIP) || defined(HAS_SHADOW)
+    virtPos = pos;
+#endif
 }
 )";
 
@@ -73,6 +82,162 @@ const char *f = R"(
     uniform float pixelSize;
 #endif
 
+#ifdef HAS_GAMMA_LUT
+    // GAMMA_LUT_SIZE x 1, the curves in RGB
+    uniform sampler2D gammaLUT;
+
+    vec3 gammaLUTMap(vec3 c)
+    {
+        // Entry i at texel center i
+        c = clamp(c, 0.0, 1.0) * ((GAMMA_LUT_SIZE - 1.0) / GAMMA_LUT_SIZE) + (0.5 / GAMMA_LUT_SIZE);
+        return vec3(texture2D(gammaLUT, vec2(c.r, 0.5)).r,
+                    texture2D(gammaLUT, vec2(c.g, 0.5)).g,
+                    texture2D(gammaLUT, vec2(c.b, 0.5)).b);
+    }
+#endif
+
+#ifdef HAS_COLOR_TRANSFORM
+    // Same as RColorDescription::Decode(), linear 1.0 = 203 nits
+    vec3 decodeTF(vec3 c)
+    {
+        #if SRC_TF == 0 // sRGB
+            vec3 a = abs(c);
+            return sign(c) * mix(a / 12.92, pow((a + 0.055) / 1.055, vec3(2.4)), step(0.04045, a));
+        #elif SRC_TF == 1 // Linear
+            return c;
+        #elif SRC_TF == 2 // PQ
+            vec3 e = pow(clamp(c, 0.0, 1.0), vec3(1.0 / 78.84375));
+            return pow(max(e - 0.8359375, 0.0) / (18.8515625 - 18.6875 * e), vec3(1.0 / 0.1593017578125)) * (10000.0 / 203.0);
+        #else // HLG
+            vec3 x = clamp(c, 0.0, 1.0);
+            return mix(x * x / 3.0, (exp((x - 0.55991073) / 0.17883277) + 0.28466892) / 12.0, step(0.5, x)) / 0.26496256;
+        #endif
+    }
+
+    // Same as RColorDescription::Encode()
+    vec3 encodeTF(vec3 c)
+    {
+        #if DST_TF == 0 // sRGB
+            vec3 a = abs(c);
+            return sign(c) * mix(a * 12.92, 1.055 * pow(a, vec3(1.0 / 2.4)) - 0.055, step(0.0031308, a));
+        #elif DST_TF == 1 // Linear
+            return c;
+        #elif DST_TF == 2 // PQ
+            vec3 y = pow(clamp(c * (203.0 / 10000.0), 0.0, 1.0), vec3(0.1593017578125));
+            return pow((0.8359375 + 18.8515625 * y) / (1.0 + 18.6875 * y), vec3(78.84375));
+        #else // HLG
+            vec3 x = clamp(c * 0.26496256, 0.0, 1.0);
+            return mix(sqrt(3.0 * x), 0.17883277 * log(max(12.0 * x - 0.28466892, 1e-6)) + 0.55991073, step(1.0 / 12.0, x));
+        #endif
+    }
+
+    // Unpremultiplied
+    vec3 colorTransform(vec3 c)
+    {
+        c = decodeTF(c);
+
+        #if GAMUT == 1 // BT.709 to BT.2020 (rows)
+            c = c * mat3(0.6274040, 0.3292820, 0.0433136,
+                         0.0690970, 0.9195400, 0.0113612,
+                         0.0163916, 0.0880132, 0.8955950);
+        #elif GAMUT == 2 // BT.2020 to BT.709 (rows)
+            c = c * mat3( 1.6604910, -0.5876411, -0.0728499,
+                         -0.1245505,  1.1328999, -0.0083494,
+                         -0.0181508, -0.1005789,  1.1187297);
+        #endif
+
+        return encodeTF(c);
+    }
+#endif
+
+#if defined(HAS_CLIP) || defined(HAS_SHADOW)
+    varying vec2 virtPos; // Viewport coordinates
+#endif
+
+#ifdef HAS_CLIP
+    // All in viewport coordinates, radii ordered UL, UR, LR, LL
+    uniform vec4 clipRect; // LTRB
+    uniform vec4 clipRadiiX;
+    uniform vec4 clipRadiiY;
+    uniform float clipPixelSize;
+
+    float clipCoverage()
+    {
+        vec2 halfSize = 0.5 * (clipRect.zw - clipRect.xy);
+        vec2 p = virtPos - 0.5 * (clipRect.xy + clipRect.zw);
+        vec2 r;
+
+        if (p.y < 0.0)
+            r = p.x < 0.0 ? vec2(clipRadiiX.x, clipRadiiY.x) : vec2(clipRadiiX.y, clipRadiiY.y);
+        else
+            r = p.x < 0.0 ? vec2(clipRadiiX.w, clipRadiiY.w) : vec2(clipRadiiX.z, clipRadiiY.z);
+
+        // Position relative to the corner's ellipse center
+        vec2 q = abs(p) - halfSize + r;
+        float d;
+
+        if (q.x > 0.0 && q.y > 0.0 && r.x > 0.0 && r.y > 0.0)
+            d = (length(q / r) - 1.0) * min(r.x, r.y); // Exact for circular corners
+        else
+            d = max(q.x - r.x, q.y - r.y);
+
+        return clamp(0.5 - d / clipPixelSize, 0.0, 1.0);
+    }
+#endif
+
+#ifdef HAS_SHADOW
+    // Same layout as the clip, corners are circles with radius shadowRadii
+    uniform vec4 shadowRect;
+    uniform vec4 shadowRadii;
+    uniform float shadowSigma;
+
+    // Abramowitz and Stegun 7.1.27, max error 5e-4
+    vec2 erf(vec2 x)
+    {
+        vec2 s = sign(x);
+        vec2 a = abs(x);
+        x = 1.0 + (0.278393 + (0.230389 + 0.078108 * (a * a)) * a) * a;
+        x *= x;
+        return s - s / (x * x);
+    }
+
+    // Horizontal integral of the blurred row at height y (relative to the center)
+    float shadowRow(float x, float y, float radius, vec2 halfSize)
+    {
+        float delta = min(halfSize.y - radius - abs(y), 0.0);
+        float curved = halfSize.x - radius + sqrt(max(0.0, radius * radius - delta * delta));
+        vec2 integral = 0.5 + 0.5 * erf((x + vec2(-curved, curved)) * (0.70710678 / shadowSigma));
+        return integral.y - integral.x;
+    }
+
+    // The vertical integral is approximated with 4 samples within 3 sigma
+    float shadowCoverage()
+    {
+        vec2 halfSize = 0.5 * (shadowRect.zw - shadowRect.xy);
+        vec2 p = virtPos - 0.5 * (shadowRect.xy + shadowRect.zw);
+        float radius;
+
+        if (p.y < 0.0)
+            radius = p.x < 0.0 ? shadowRadii.x : shadowRadii.y;
+        else
+            radius = p.x < 0.0 ? shadowRadii.w : shadowRadii.z;
+
+        float start = clamp(-3.0 * shadowSigma, p.y - halfSize.y, p.y + halfSize.y);
+        float end = clamp(3.0 * shadowSigma, p.y - halfSize.y, p.y + halfSize.y);
+        float step = (end - start) * 0.25;
+        float y = start + step * 0.5;
+        float value = 0.0;
+
+        for (int i = 0; i < 4; i++)
+        {
+            value += shadowRow(p.x, p.y - y, radius, halfSize) * exp(-(y * y) / (2.0 * shadowSigma * shadowSigma)) * step;
+            y += step;
+        }
+
+        return value / (2.50662827 * shadowSigma); // sqrt(2 * PI) * sigma
+    }
+#endif
+
 void main()
 {
 
@@ -102,6 +267,15 @@ void main()
 
                 gl_FragColor = texture2D(image, imageCord);
 
+                #ifdef HAS_COLOR_TRANSFORM
+                    #ifdef PREMULT_SRC
+                        if (gl_FragColor.a > 0.0)
+                            gl_FragColor.rgb = colorTransform(gl_FragColor.rgb / gl_FragColor.a) * gl_FragColor.a;
+                    #else
+                        gl_FragColor.rgb = colorTransform(gl_FragColor.rgb);
+                    #endif
+                #endif
+
                 // factorRGB must always be unpremult
 
                 #ifdef HAS_R
@@ -148,6 +322,15 @@ void main()
 
             #endif // REPLACE_IMAGE_COLOR
 
+            #ifdef HAS_GAMMA_LUT
+                #if defined(PREMULT_SRC) && !defined(REPLACE_IMAGE_COLOR)
+                    if (gl_FragColor.a > 0.0)
+                        gl_FragColor.rgb = gammaLUTMap(gl_FragColor.rgb / gl_FragColor.a) * gl_FragColor.a;
+                #else
+                    gl_FragColor.rgb = gammaLUTMap(gl_FragColor.rgb);
+                #endif
+            #endif
+
         // DstIn Blend Mode
         #else
 
@@ -185,6 +368,19 @@ void main()
             gl_FragColor.a = 1.0;
         #endif
 
+        #ifdef HAS_SHADOW
+            gl_FragColor *= shadowCoverage();
+        #endif
+
+    #endif
+
+    // Applied like the mask alpha
+    #ifdef HAS_CLIP
+        #if !defined(HAS_IMAGE) || ((BLEND_MODE == 0 || BLEND_MODE == 1) && defined(PREMULT_SRC) && !defined(REPLACE_IMAGE_COLOR))
+            gl_FragColor *= clipCoverage();
+        #else
+            gl_FragColor.a *= clipCoverage();
+        #endif
     #endif
 
 #elif FX == 1 // VibrancyH
@@ -217,6 +413,35 @@ void main()
     gl_FragColor.xyz = ((0.1/6.0) * min(gl_FragColor.xyz, vec3(7.0))) + 0.78;
     gl_FragColor.w = 1.0;
 
+#elif FX == 4 || FX == 5 // YUVLuma, YUVChroma
+
+    // BT.709 limited range (rows), the chroma 2x2 average is the bilinear tap at the block corner
+    const mat3 rgbToYCbCr = mat3(
+        0.2126,  0.7152,  0.0722,
+       -0.1146, -0.3854,  0.5,
+        0.5,    -0.4542, -0.0458
+    );
+
+    vec3 ycc = texture2D(image, imageCord).rgb * rgbToYCbCr;
+
+    #ifdef YUV_10_BIT // 10 bit codes in the upper bits of 16 bit samples (P010)
+        #define Y_OFFSET (64.0 * 64.0 / 65535.0)
+        #define Y_SCALE (876.0 * 64.0 / 65535.0)
+        #define C_OFFSET (512.0 * 64.0 / 65535.0)
+        #define C_SCALE (896.0 * 64.0 / 65535.0)
+    #else
+        #define Y_OFFSET (16.0 / 255.0)
+        #define Y_SCALE (219.0 / 255.0)
+        #define C_OFFSET (128.0 / 255.0)
+        #define C_SCALE (224.0 / 255.0)
+    #endif
+
+    #if FX == 4
+        gl_FragColor = vec4(Y_OFFSET + ycc.x * Y_SCALE, 0.0, 0.0, 1.0);
+    #else
+        gl_FragColor = vec4(C_OFFSET + ycc.yz * C_SCALE, 0.0, 1.0);
+    #endif
+
 #else // VibrancyVDark
 
     #define VBLUR_DARK
@@ -322,6 +547,22 @@ RGLShader::~RGLShader() noexcept
     glDeleteShader(m_id);
 }
 
+CZBitset<RGLShader::Features> RGLShader::ColorTransform(const RColorDescription &src, const RColorDescription &dst) noexcept
+{
+    CZBitset<Features> features {};
+
+    if (src == dst)
+        return features;
+
+    UInt32 gamut { 0 };
+
+    if (src.primaries != dst.primaries)
+        gamut = src.primaries == RPrimaries::SRGB ? 1 : 2;
+
+    features.add(HasColorTransform | (UInt32(src.transfer) << 17) | (UInt32(dst.transfer) << 19) | (gamut << 21));
+    return features;
+}
+
 static GLuint CompileShader(RGLDevice *device, GLenum type, const std::string &features, UInt32 fx)
 {
     std::string source;
@@ -382,8 +623,17 @@ bool RGLShader::build() noexcept
 {
     UInt32 fx { UInt32((m_features.get() & 0xF0000000) >> 28) };
 
+    const std::string gammaLUTStr {
+        !m_features.has(HasGammaLUT) ? "" : std::format("#define HAS_GAMMA_LUT\n#define GAMMA_LUT_SIZE {}.0\n", RGammaLUT::ImageSize) };
+
+    const std::string colorTransformStr {
+        !m_features.has(HasColorTransform) ? "" : std::format("#define HAS_COLOR_TRANSFORM\n#define SRC_TF {}\n#define DST_TF {}\n#define GAMUT {}\n",
+            (m_features.get() & SrcTransfer) >> 17,
+            (m_features.get() & DstTransfer) >> 19,
+            (m_features.get() & Gamut) >> 21) };
+
     const std::string featuresStr {
-        std::format("{}{}{}{}{}{}{}{}{}{}{}{}#define BLEND_MODE {}\n#define FX {}\n",
+        std::format("{}{}{}{}{}{}{}{}{}{}{}{}{}{}{}{}{}#define BLEND_MODE {}\n#define FX {}\n",
             !m_features.has(ImageExternal | MaskExternal) ? "" : "#extension GL_OES_EGL_image_external : require\n",
             !m_features.has(ImageExternal)                ? "#define IMAGE_SAMPLER sampler2D\n" : "#define IMAGE_SAMPLER samplerExternalOES\n",
             !m_features.has(MaskExternal)                 ? "#define MASK_SAMPLER sampler2D\n" : "#define MASK_SAMPLER samplerExternalOES\n", 
@@ -396,6 +646,11 @@ bool RGLShader::build() noexcept
             !m_features.has(HasFactorB)                   ? "" : "#define HAS_B\n",
             !m_features.has(HasFactorA)                   ? "" : "#define HAS_A\n",
             !m_features.has(HasPixelSize)                 ? "" : "#define HAS_PIXEL_SIZE\n",
+            !m_features.has(HasClip)                      ? "" : "#define HAS_CLIP\n",
+            !m_features.has(HasShadow)                    ? "" : "#define HAS_SHADOW\n",
+            !m_features.has(YUV10Bit)                     ? "" : "#define YUV_10_BIT\n",
+            gammaLUTStr,
+            colorTransformStr,
             UInt32(m_features.get() & 0x3),               // Blend Mode
             fx)                                           // Effect
     };
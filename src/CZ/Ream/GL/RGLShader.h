@@ -2,6 +2,7 @@
 #define RGLSHADER_H
 
 #include <CZ/Ream/RObject.h>
+#include <CZ/Ream/RColorDescription.h>
 #include <CZ/Core/CZBitset.h>
 #include <GLES2/gl2.h>
 #include <memory>
@@ -41,15 +42,34 @@ public:
         HasFactorA          = 1u << 10, ///< Applies the alpha-channel multiplier.
         PremultSrc          = 1u << 11, ///< The source color is premultiplied alpha.
         HasPixelSize        = 1u << 12, ///< Provides the `pixelSize` uniform (texel size for effects).
+        HasClip             = 1u << 13, ///< Multiplies the output by the coverage of a rounded rect clip (like the mask alpha).
+        HasShadow           = 1u << 14, ///< Multiplies the color by the Gaussian-blurred coverage of a rounded rect (color mode only).
+        HasGammaLUT         = 1u << 15, ///< Maps the unpremultiplied image color through the `gammaLUT` texture (image Src/SrcOver only).
+
+        /* Bits 16..22 represent an optional color transform of the image samples (image Src/SrcOver only) */
+        HasColorTransform   = 1u << 16, ///< Decodes the samples to linear, converts the primaries and re-encodes them.
+        SrcTransfer         = 3u << 17, ///< RTransferFunction of the image (2 bits).
+        DstTransfer         = 3u << 19, ///< RTransferFunction of the destination (2 bits).
+        Gamut               = 3u << 21, ///< Primaries conversion: 0 none, 1 BT.709 to BT.2020, 2 BT.2020 to BT.709.
+
+        YUV10Bit            = 1u << 23, ///< YUVLuma/YUVChroma: 10 bit levels in the upper bits of a 16 bit target (P010).
 
         /* The upper 4 bits represent effects */
         VibrancyH           = 1u << 28, ///< Horizontal vibrancy blur pass.
         VibrancyLightV      = 2u << 28, ///< Vertical vibrancy blur pass with light-tone saturation.
         VibrancyDarkV       = 3u << 28, ///< Vertical vibrancy blur pass with dark-tone saturation.
+        YUVLuma             = 4u << 28, ///< BT.709 limited range luma (red channel).
+        YUVChroma           = 5u << 28, ///< BT.709 limited range CbCr (red and green channels).
     };
 
     /// Subset of Features that affect the vertex shader (the rest only affect the fragment shader).
-    static constexpr CZBitset<Features> VertFeatures { HasImage | HasMask };
+    static constexpr CZBitset<Features> VertFeatures { HasImage | HasMask | HasClip | HasShadow };
+
+    /**
+     * @brief Returns the color transform bits (HasColorTransform, SrcTransfer, DstTransfer and Gamut) converting
+     *        samples from @p src into @p dst, or 0 if they are equal.
+     */
+    static CZBitset<Features> ColorTransform(const RColorDescription &src, const RColorDescription &dst) noexcept;
 
     /**
      * @brief Returns the cached shader for the given device, feature set, and type, compiling it if needed.
@@ -0,0 +1,145 @@
+#include <CZ/Ream/GL/RGLState.h>
+
+using namespace CZ;
+
+void RGLState::invalidate() noexcept
+{
+    m_prepared = false;
+    m_program.reset();
+    m_blend.reset();
+    m_blendFunc.reset();
+    m_viewport.reset();
+    m_scissor.reset();
+    m_clearColor.reset();
+    m_arrayBuffer.reset();
+    m_vertexAttrib.reset();
+}
+
+void RGLState::prepare() noexcept
+{
+    if (m_prepared)
+        return;
+
+    m_prepared = true;
+    glEnable(GL_SCISSOR_TEST);
+    glDisable(GL_STENCIL_TEST);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DITHER);
+    glDisable(GL_POLYGON_OFFSET_FILL);
+    glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
+    glDisable(GL_SAMPLE_COVERAGE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_FALSE);
+    glStencilMask(1);
+    glFrontFace(GL_CCW);
+    glBlendColor(0, 0, 0, 0);
+    glBlendEquation(GL_FUNC_ADD);
+    markDirty(kView_GrGLBackendState | kStencil_GrGLBackendState | kBlend_GrGLBackendState | kMisc_GrGLBackendState);
+}
+
+void RGLState::useProgram(GLuint program) noexcept
+{
+    if (m_program == program)
+        return;
+
+    glUseProgram(program);
+    m_program = program;
+    markDirty(kProgram_GrGLBackendState);
+}
+
+void RGLState::setBlend(bool enabled) noexcept
+{
+    if (m_blend == enabled)
+        return;
+
+    if (enabled)
+        glEnable(GL_BLEND);
+    else
+        glDisable(GL_BLEND);
+
+    m_blend = enabled;
+    markDirty(kBlend_GrGLBackendState);
+}
+
+void RGLState::blendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcA, GLenum dstA) noexcept
+{
+    setBlend(true);
+
+    const std::array<GLenum, 4> func { srcRGB, dstRGB, srcA, dstA };
+
+    if (m_blendFunc == func)
+        return;
+
+    glBlendFuncSeparate(srcRGB, dstRGB, srcA, dstA);
+    m_blendFunc = func;
+    markDirty(kBlend_GrGLBackendState);
+}
+
+void RGLState::viewport(GLint x, GLint y, GLsizei w, GLsizei h) noexcept
+{
+    const std::array<GLint, 4> box { x, y, w, h };
+
+    if (m_viewport == box)
+        return;
+
+    glViewport(x, y, w, h);
+    m_viewport = box;
+    markDirty(kView_GrGLBackendState);
+}
+
+void RGLState::scissor(GLint x, GLint y, GLsizei w, GLsizei h) noexcept
+{
+    const std::array<GLint, 4> box { x, y, w, h };
+
+    if (m_scissor == box)
+        return;
+
+    glScissor(x, y, w, h);
+    m_scissor = box;
+    markDirty(kView_GrGLBackendState);
+}
+
+void RGLState::clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) noexcept
+{
+    const std::array<GLfloat, 4> color { r, g, b, a };
+
+    if (m_clearColor == color)
+        return;
+
+    glClearColor(r, g, b, a);
+    m_clearColor = color;
+    markDirty(kMisc_GrGLBackendState);
+}
+
+void RGLState::enableVertexAttrib(GLuint location) noexcept
+{
+    // The attribute pointer is set on each draw
+    markDirty(kVertex_GrGLBackendState);
+
+    if (m_vertexAttrib == location)
+        return;
+
+    if (m_vertexAttrib.has_value())
+        glDisableVertexAttribArray(m_vertexAttrib.value());
+
+    glEnableVertexAttribArray(location);
+    m_vertexAttrib = location;
+}
+
+void RGLState::unbindArrayBuffer() noexcept
+{
+    if (m_arrayBuffer == 0u)
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    m_arrayBuffer = 0;
+    markDirty(kVertex_GrGLBackendState);
+}
+
+UInt32 RGLState::takeSkiaResetFlags() noexcept
+{
+    const UInt32 flags { m_skiaDirty | kRenderTarget_GrGLBackendState | kTextureBinding_GrGLBackendState | kPixelStore_GrGLBackendState };
+    m_skiaDirty = 0;
+    return flags;
+}
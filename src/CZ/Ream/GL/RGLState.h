@@ -0,0 +1,81 @@
+#ifndef RGLSTATE_H
+#define RGLSTATE_H
+
+#include <CZ/Ream/Ream.h>
+#include <CZ/skia/gpu/ganesh/gl/GrGLTypes.h>
+#include <GLES2/gl2.h>
+#include <optional>
+#include <array>
+
+/**
+ * @brief Shadow copy of the GL state used by RGLPainter within a single context.
+ *
+ * Each RGLDevice context owns one instance (see RGLDevice::ThreadData). Setters skip the GL call when the
+ * requested value is already set, and record which groups of state were modified so that switching back
+ * to Skia only resets what actually changed (`GrDirectContext::resetContext(takeSkiaResetFlags())`).
+ *
+ * Skia does not report what it modifies, so the cache must be invalidated each time RGLPainter takes over
+ * the context after Skia drew (handled by RGLPass).
+ */
+class CZ::RGLState
+{
+public:
+    CZ_DISABLE_COPY(RGLState)
+    RGLState() noexcept = default;
+
+    /**
+     * @brief Forgets every cached value, the next setter calls always reach GL.
+     */
+    void invalidate() noexcept;
+
+    /**
+     * @brief Sets the state RGLPainter expects but never modifies (depth, culling, etc).
+     *
+     * Must be called after invalidate(), the GL calls are only issued once per invalidation.
+     */
+    void prepare() noexcept;
+
+    void useProgram(GLuint program) noexcept;
+    void setBlend(bool enabled) noexcept;
+
+    /**
+     * @brief Enables blending with GL_FUNC_ADD and the given factors.
+     */
+    void blendFunc(GLenum srcRGB, GLenum dstRGB, GLenum srcA, GLenum dstA) noexcept;
+    void blendFunc(GLenum src, GLenum dst) noexcept { blendFunc(src, dst, src, dst); }
+    void viewport(GLint x, GLint y, GLsizei w, GLsizei h) noexcept;
+    void scissor(GLint x, GLint y, GLsizei w, GLsizei h) noexcept;
+    void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) noexcept;
+
+    /**
+     * @brief Enables the given vertex attribute array, disabling any other previously enabled through this object.
+     */
+    void enableVertexAttrib(GLuint location) noexcept;
+
+    /**
+     * @brief Binds GL_ARRAY_BUFFER to 0 (client-side vertex arrays).
+     */
+    void unbindArrayBuffer() noexcept;
+
+    /**
+     * @brief Returns the GrGLBackendState flags to pass to `GrDirectContext::resetContext()` and clears them.
+     *
+     * Render target, texture and pixel store bindings are always included since other parts of Ream
+     * (e.g. RGLImage) modify them directly.
+     */
+    [[nodiscard]] UInt32 takeSkiaResetFlags() noexcept;
+private:
+    void markDirty(UInt32 skiaFlags) noexcept { m_skiaDirty |= skiaFlags; }
+    bool m_prepared { false };
+    UInt32 m_skiaDirty { kAll_GrBackendState };
+    std::optional<GLuint> m_program;
+    std::optional<bool> m_blend;
+    std::optional<std::array<GLenum, 4>> m_blendFunc;
+    std::optional<std::array<GLint, 4>> m_viewport;
+    std::optional<std::array<GLint, 4>> m_scissor;
+    std::optional<std::array<GLfloat, 4>> m_clearColor;
+    std::optional<GLuint> m_arrayBuffer;
+    std::optional<GLuint> m_vertexAttrib;
+};
+
+#endif // RGLSTATE_H
@@ -3,6 +3,7 @@
 #include <CZ/Ream/GL/RGLDevice.h>
 #include <CZ/Ream/GL/RGLMakeCurrent.h>
 #include <CZ/Ream/RCore.h>
+#include <CZ/Ream/RProfiler.h>
 #include <CZ/Ream/RLog.h>
 
 using namespace CZ;
@@ -18,6 +19,21 @@ static const EGLint eglConfigAttribs[]
     EGL_NONE
 };
 
+// EGL rects have a bottom-left origin
+static void FlipRects(const SkRegion &region, Int32 height, std::vector<EGLint> &rects) noexcept
+{
+    rects.clear();
+    rects.reserve(region.computeRegionComplexity() * 4);
+
+    for (SkRegion::Iterator it { region }; !it.done(); it.next())
+    {
+        rects.emplace_back(it.rect().x());
+        rects.emplace_back(height - it.rect().fBottom);
+        rects.emplace_back(it.rect().width());
+        rects.emplace_back(it.rect().height());
+    }
+}
+
 std::shared_ptr<RGLSwapchainWL> RGLSwapchainWL::Make(wl_surface *surface, SkISize size) noexcept
 {
     auto core { RCore::Get() };
@@ -49,8 +65,6 @@ std::shared_ptr<RGLSwapchainWL> RGLSwapchainWL::Make(wl_surface *surface, SkISiz
         return {};
     }
 
-    auto current { RGLMakeCurrent(device->eglDisplay(), eglSurface, eglSurface, device->eglContext()) };
-
     REGLSurfaceInfo info {};
     info.size = size;
     info.surface = eglSurface;
@@ -85,7 +99,9 @@ std::optional<const RSwapchainImage> RGLSwapchainWL::acquire() noexcept
     RSwapchainImage ssImage {};
     ssImage.image = m_image;
     ssImage.frame = m_frame++;
+    acquireDamage(m_image->size());
     auto current { RGLMakeCurrent(m_device->eglDisplay(), m_eglSurface, m_eglSurface, m_device->eglContext()) };
+    updateSwapInterval();
 
     EGLint age;
     if (eglQuerySurface(m_device->eglDisplay(), m_eglSurface, EGL_BUFFER_AGE_KHR, &age) == EGL_TRUE)
@@ -102,32 +118,53 @@ bool RGLSwapchainWL::present(const RSwapchainImage &image, SkRegion *damage) noe
         return false;
 
     m_acquired = false;
+    RProfiler::EndFrame();
+    SkRegion trackedDamage;
+    damage = commitDamage(image, damage, trackedDamage);
     auto current { RGLMakeCurrent(m_device->eglDisplay(), m_eglSurface, m_eglSurface, m_device->eglContext()) };
-    eglSwapInterval(m_device->eglDisplay(), 0);
+    updateSwapInterval();
 
     if (!damage || !m_device->eglDisplayProcs().eglSwapBuffersWithDamageKHR)
         return eglSwapBuffers(m_device->eglDisplay(), m_eglSurface);
+
+    FlipRects(*damage, image.image->size().height(), m_rects);
+    return m_device->eglDisplayProcs().eglSwapBuffersWithDamageKHR(m_device->eglDisplay(), m_eglSurface, m_rects.data(), m_rects.size() / 4);
+}
+
+void RGLSwapchainWL::updateSwapInterval() noexcept
+{
+    // An explicit FIFO waits for the compositor frame callback. The rest never block (Wayland never tears),
+    // including the default, since blocking clients never return while the surface is hidden
+    const EGLint interval { m_presentModeSet && m_presentMode == RPresentMode::FIFO ? 1 : 0 };
+
+    // Bound to the surface, only set when the mode changes (must be current)
+    if (m_swapInterval == interval)
+        return;
+
+    if (eglSwapInterval(m_device->eglDisplay(), interval) == EGL_TRUE)
+        m_swapInterval = interval;
+}
+
+bool RGLSwapchainWL::setRepaintRegion(const RSwapchainImage &image, const SkRegion &region) noexcept
+{
+    if (image.image != m_image || !m_acquired || !m_device->eglDisplayProcs().eglSetDamageRegionKHR)
+        return false;
+
+    auto current { RGLMakeCurrent(m_device->eglDisplay(), m_eglSurface, m_eglSurface, m_device->eglContext()) };
+
+    // An empty list would mean the entire buffer
+    if (region.isEmpty())
+        m_rects.assign({ 0, 0, 0, 0 });
     else
+        FlipRects(region, m_image->size().height(), m_rects);
+
+    if (m_device->eglDisplayProcs().eglSetDamageRegionKHR(m_device->eglDisplay(), m_eglSurface, m_rects.data(), m_rects.size() / 4) != EGL_TRUE)
     {
-        const auto nRects { damage->computeRegionComplexity() };
-        std::vector<EGLint> rects;
-        rects.resize(nRects * 4);
-
-        SkRegion::Iterator it { *damage };
-        size_t i { 0 };
-
-        // Y-flip is needed
-        while (!it.done())
-        {
-            rects[i++] = it.rect().x();
-            rects[i++] = image.image->size().height() - it.rect().fBottom;
-            rects[i++] = it.rect().width();
-            rects[i++] = it.rect().height();
-            it.next();
-        }
-
-        return m_device->eglDisplayProcs().eglSwapBuffersWithDamageKHR(m_device->eglDisplay(), m_eglSurface, rects.data(), nRects);
+        RLog(CZDebug, CZLN, "eglSetDamageRegionKHR failed");
+        return false;
     }
+
+    return true;
 }
 
 bool RGLSwapchainWL::resize(SkISize size) noexcept
@@ -4,6 +4,7 @@
 #include <CZ/Ream/WL/RWLSwapchain.h>
 #include <wayland-egl-core.h>
 #include <EGL/egl.h>
+#include <vector>
 
 /**
  * @brief OpenGL backend implementation of RWLSwapchain.
@@ -11,7 +12,9 @@
  * Presents to a Wayland surface via EGL. It creates a `wl_egl_window` and an EGLSurface for the
  * given `wl_surface`, wraps that surface as an RGLImage, and drives presentation with
  * `eglSwapBuffers` (using `eglSwapBuffersWithDamageKHR` when damage and the extension are
- * available). Created via RWLSwapchain::Make().
+ * available). With EGL_KHR_partial_update, the region declared with setRepaintRegion() is passed to
+ * `eglSetDamageRegionKHR` so that tiled drivers only load and resolve that area. Created via
+ * RWLSwapchain::Make().
  */
 class CZ::RGLSwapchainWL : public RWLSwapchain
 {
@@ -39,6 +42,13 @@ public:
      */
     bool present(const RSwapchainImage &image, SkRegion *damage = nullptr) noexcept override;
 
+    /**
+     * @brief Declares the repaint region of the acquired image with `eglSetDamageRegionKHR`.
+     *
+     * @return `true` if EGL_KHR_partial_update is supported and the region was accepted.
+     */
+    bool setRepaintRegion(const RSwapchainImage &image, const SkRegion &region) noexcept override;
+
     /**
      * @brief Resizes the swapchain (and the underlying `wl_egl_window`).
      *
@@ -50,11 +60,14 @@ private:
     friend class RWLSwapchain;
     static std::shared_ptr<RGLSwapchainWL> Make(wl_surface *surface, SkISize size) noexcept;
     RGLSwapchainWL(std::shared_ptr<RGLCore> core, RGLDevice *device, std::shared_ptr<RGLImage> image, wl_egl_window *window, wl_surface *surface, EGLSurface eglSurface, SkISize size) noexcept;
+    void updateSwapInterval() noexcept;
     std::shared_ptr<RGLCore> m_core;
     RGLDevice *m_device;
     std::shared_ptr<RGLImage> m_image;
     EGLSurface m_eglSurface { EGL_NO_SURFACE };
     wl_egl_window *m_window;
+    std::vector<EGLint> m_rects; // Y-flipped EGL rects
+    std::optional<EGLint> m_swapInterval; // Last value set with eglSwapInterval()
     bool m_acquired { false };
 };
 
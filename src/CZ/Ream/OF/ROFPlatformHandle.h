@@ -11,6 +11,10 @@
  * RPlatform::Offscreen. Unlike the DRM or Wayland handles, it carries no external resources and
  * simply identifies the offscreen platform (i.e. rendering without a display backend).
  *
+ * Supported by every graphics API: OpenGL uses an `EGL_MESA_platform_surfaceless` display and
+ * Vulkan requires neither WSI extensions nor a DRM node, so software drivers such as llvmpipe
+ * and lavapipe work as well.
+ *
  * Use Make() to create an instance.
  */
 class CZ::ROFPlatformHandle : public RPlatformHandle
@@ -0,0 +1,150 @@
+#include <CZ/Ream/RColorDescription.h>
+#include <CZ/skia/core/SkColorSpace.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace CZ;
+
+// SDR reference white in nits (BT.2408)
+static constexpr float RefWhite { 203.f };
+
+// HLG inverse OETF of the 75% signal (reference white)
+static constexpr float HLGRefWhite { 0.26496256f };
+
+static constexpr float PQ_M1 { 0.1593017578125f };
+static constexpr float PQ_M2 { 78.84375f };
+static constexpr float PQ_C1 { 0.8359375f };
+static constexpr float PQ_C2 { 18.8515625f };
+static constexpr float PQ_C3 { 18.6875f };
+
+static constexpr float HLG_A { 0.17883277f };
+static constexpr float HLG_B { 0.28466892f };
+static constexpr float HLG_C { 0.55991073f };
+
+// Row-major, linear RGB
+static constexpr float BT709ToBT2020[9]
+{
+    0.6274040f, 0.3292820f, 0.0433136f,
+    0.0690970f, 0.9195400f, 0.0113612f,
+    0.0163916f, 0.0880132f, 0.8955950f
+};
+
+static constexpr float BT2020ToBT709[9]
+{
+     1.6604910f, -0.5876411f, -0.0728499f,
+    -0.1245505f,  1.1328999f, -0.0083494f,
+    -0.0181508f, -0.1005789f,  1.1187297f
+};
+
+const float *RColorDescription::GamutMatrix(RPrimaries from, RPrimaries to) noexcept
+{
+    if (from == to)
+        return nullptr;
+
+    return from == RPrimaries::SRGB ? BT709ToBT2020 : BT2020ToBT709;
+}
+
+float RColorDescription::Decode(RTransferFunction tf, float value) noexcept
+{
+    switch (tf)
+    {
+    case RTransferFunction::SRGB:
+    {
+        // Mirrored for negative (extended) values
+        const float x { std::abs(value) };
+        const float y { x <= 0.04045f ? x / 12.92f : std::pow((x + 0.055f) / 1.055f, 2.4f) };
+        return std::copysign(y, value);
+    }
+    case RTransferFunction::Linear:
+        return value;
+    case RTransferFunction::PQ:
+    {
+        const float e { std::pow(std::clamp(value, 0.f, 1.f), 1.f / PQ_M2) };
+        const float y { std::pow(std::max(e - PQ_C1, 0.f) / (PQ_C2 - PQ_C3 * e), 1.f / PQ_M1) };
+        return y * (10000.f / RefWhite);
+    }
+    case RTransferFunction::HLG:
+    {
+        const float x { std::clamp(value, 0.f, 1.f) };
+        const float y { x <= 0.5f ? (x * x) / 3.f : (std::exp((x - HLG_C) / HLG_A) + HLG_B) / 12.f };
+        return y / HLGRefWhite;
+    }
+    }
+
+    return value;
+}
+
+float RColorDescription::Encode(RTransferFunction tf, float value) noexcept
+{
+    switch (tf)
+    {
+    case RTransferFunction::SRGB:
+    {
+        const float x { std::abs(value) };
+        const float y { x <= 0.0031308f ? x * 12.92f : 1.055f * std::pow(x, 1.f / 2.4f) - 0.055f };
+        return std::copysign(y, value);
+    }
+    case RTransferFunction::Linear:
+        return value;
+    case RTransferFunction::PQ:
+    {
+        const float y { std::pow(std::clamp(value * (RefWhite / 10000.f), 0.f, 1.f), PQ_M1) };
+        return std::pow((PQ_C1 + PQ_C2 * y) / (1.f + PQ_C3 * y), PQ_M2);
+    }
+    case RTransferFunction::HLG:
+    {
+        const float x { std::clamp(value * HLGRefWhite, 0.f, 1.f) };
+        return x <= 1.f / 12.f ? std::sqrt(3.f * x) : HLG_A * std::log(12.f * x - HLG_B) + HLG_C;
+    }
+    }
+
+    return value;
+}
+
+SkColor4f RColorDescription::Convert(const SkColor4f &color, const RColorDescription &from, const RColorDescription &to, bool premult) noexcept
+{
+    if (from == to || (premult && color.fA <= 0.f))
+        return color;
+
+    float c[3] { color.fR, color.fG, color.fB };
+
+    for (auto &v : c)
+        v = Decode(from.transfer, premult ? v / color.fA : v);
+
+    if (const float *m = GamutMatrix(from.primaries, to.primaries))
+    {
+        const float r { c[0] }, g { c[1] }, b { c[2] };
+        c[0] = m[0] * r + m[1] * g + m[2] * b;
+        c[1] = m[3] * r + m[4] * g + m[5] * b;
+        c[2] = m[6] * r + m[7] * g + m[8] * b;
+    }
+
+    for (auto &v : c)
+    {
+        v = Encode(to.transfer, v);
+
+        if (premult)
+            v *= color.fA;
+    }
+
+    return { c[0], c[1], c[2], color.fA };
+}
+
+sk_sp<SkColorSpace> RColorDescription::skColorSpace() const noexcept
+{
+    const auto &gamut { primaries == RPrimaries::BT2020 ? SkNamedGamut::kRec2020 : SkNamedGamut::kSRGB };
+
+    switch (transfer)
+    {
+    case RTransferFunction::SRGB:
+        return primaries == RPrimaries::SRGB ? SkColorSpace::MakeSRGB() : SkColorSpace::MakeRGB(SkNamedTransferFn::kSRGB, gamut);
+    case RTransferFunction::Linear:
+        return primaries == RPrimaries::SRGB ? SkColorSpace::MakeSRGBLinear() : SkColorSpace::MakeRGB(SkNamedTransferFn::kLinear, gamut);
+    case RTransferFunction::PQ:
+        return SkColorSpace::MakeRGB(SkNamedTransferFn::kPQ, gamut);
+    case RTransferFunction::HLG:
+        return SkColorSpace::MakeRGB(SkNamedTransferFn::kHLG, gamut);
+    }
+
+    return SkColorSpace::MakeSRGB();
+}
@@ -0,0 +1,95 @@
+#ifndef RCOLORDESCRIPTION_H
+#define RCOLORDESCRIPTION_H
+
+#include <CZ/Core/Cuarzo.h>
+#include <CZ/skia/core/SkColor.h>
+#include <CZ/skia/core/SkRefCnt.h>
+#include <string_view>
+#include <array>
+
+class SkColorSpace;
+
+namespace CZ
+{
+    /**
+     * @brief Transfer function (encoding) of the color values stored in an image.
+     *
+     * Linear values are relative to the SDR reference white (1.0 = 203 nits, BT.2408),
+     * so HDR content goes above 1.0 and requires a float format (e.g. ABGR16161616F) to be stored linearly.
+     */
+    enum class RTransferFunction : UInt8
+    {
+        SRGB,   ///< IEC 61966-2-1 piecewise sRGB curve (the default).
+        Linear, ///< Linear light, e.g. for FP16 composition buffers.
+        PQ,     ///< SMPTE ST 2084 perceptual quantizer (absolute, up to 10000 nits).
+        HLG     ///< ARIB STD-B67 hybrid log-gamma (75% signal = reference white, no OOTF applied).
+    };
+
+    /**
+     * @brief Color primaries (gamut) of an image.
+     */
+    enum class RPrimaries : UInt8
+    {
+        SRGB,  ///< BT.709 / sRGB primaries (the default).
+        BT2020 ///< BT.2020 wide-gamut primaries.
+    };
+
+    /**
+     * @brief Returns a human-readable string for the given transfer function.
+     */
+    inline const std::string_view &RTransferFunctionString(RTransferFunction tf) noexcept
+    {
+        static constexpr const std::array<std::string_view, 4> strings { "sRGB", "Linear", "PQ", "HLG" };
+        return strings[static_cast<int>(tf)];
+    }
+
+    /**
+     * @brief Describes how the color values of an image are encoded.
+     *
+     * Assigned to images with RImage::setColorDescription(). When the description of a source image differs from
+     * the one of the destination, RPainter::drawImage() decodes the samples to linear light, converts the primaries
+     * and re-encodes them with the destination transfer function, fused into the same draw.
+     * Solid colors (SkColor) are always sRGB and converted on the CPU.
+     */
+    struct RColorDescription
+    {
+        RTransferFunction transfer { RTransferFunction::SRGB }; ///< Transfer function.
+        RPrimaries primaries { RPrimaries::SRGB };              ///< Color primaries.
+
+        constexpr bool operator==(const RColorDescription &other) const noexcept = default;
+
+        /**
+         * @brief Returns the 3x3 row-major linear RGB matrix converting @p from primaries into @p to primaries.
+         *
+         * @return nullptr if the primaries are equal (no conversion required).
+         */
+        static const float *GamutMatrix(RPrimaries from, RPrimaries to) noexcept;
+
+        /**
+         * @brief Decodes a single component to linear light.
+         */
+        static float Decode(RTransferFunction tf, float value) noexcept;
+
+        /**
+         * @brief Encodes a single linear light component.
+         */
+        static float Encode(RTransferFunction tf, float value) noexcept;
+
+        /**
+         * @brief Converts a color from one description to another.
+         *
+         * @param color   The color to convert.
+         * @param from    The description @p color is encoded with.
+         * @param to      The target description.
+         * @param premult If true, @p color is premultiplied (it's unpremultiplied before and premultiplied after).
+         */
+        static SkColor4f Convert(const SkColor4f &color, const RColorDescription &from, const RColorDescription &to, bool premult) noexcept;
+
+        /**
+         * @brief Returns an equivalent Skia color space, used by the Raster backend.
+         */
+        sk_sp<SkColorSpace> skColorSpace() const noexcept;
+    };
+};
+
+#endif // RCOLORDESCRIPTION_H
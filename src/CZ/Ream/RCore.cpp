@@ -3,6 +3,7 @@
 #include <CZ/Ream/RLog.h>
 
 #include <CZ/Ream/RResourceTracker.h>
+#include <CZ/Ream/RProfiler.h>
 
 #include <CZ/Ream/GL/RGLCore.h>
 #include <CZ/Ream/VK/RVKCore.h>
@@ -15,10 +16,19 @@
 using namespace CZ;
 
 static std::weak_ptr<RCore> s_core;
+static bool s_envProfile { false };
 
 RCore::RCore(const Options &options) noexcept : m_options(options)
 {
     RResourceTrackerAdd(RCoreRes);
+
+    const char *profileEnv { getenv("CZ_REAM_PROFILE") };
+
+    if (profileEnv && profileEnv[0] != '\0' && RProfiler::StartTrace(profileEnv))
+    {
+        RProfiler::SetEnabled(true);
+        s_envProfile = true;
+    }
 }
 
 void RCore::logInfo() noexcept
@@ -44,6 +54,7 @@ void RCore::logInfo() noexcept
             RLog(CZInfo, "        Sync Import: {}", dev->caps().SyncImport);
             RLog(CZInfo, "        Sync Export: {}", dev->caps().SyncExport);
             RLog(CZInfo, "        Timeline: {}", dev->caps().Timeline);
+            RLog(CZInfo, "        Timestamp Query: {}", dev->caps().TimestampQuery);
         }
         RLog(CZInfo, "------------------------------------\n");
     }
@@ -97,12 +108,6 @@ std::shared_ptr<RCore> RCore::Make(const Options &options) noexcept
             goto fail;
     }
 
-    if (options.platformHandle->platform() == RPlatform::Offscreen)
-    {
-        RLog(CZFatal, CZLN, "The offscreen platform supports only the Raster GAPI");
-        goto fail;
-    }
-
     if (gAPI == RGraphicsAPI::VK)
     {
         auto core { std::shared_ptr<RCore>(new RVKCore(options)) };
@@ -158,6 +163,14 @@ std::shared_ptr<RVKCore> RCore::asVK() noexcept
 RCore::~RCore() noexcept
 {
     RLog(CZTrace, "RCore destroyed");
+
+    if (s_envProfile)
+    {
+        RProfiler::StopTrace();
+        RProfiler::SetEnabled(false);
+        s_envProfile = false;
+    }
+
     RResourceTrackerSub(RCoreRes);
 }
 
@@ -0,0 +1,168 @@
+#include <CZ/Ream/RDamageTracker.h>
+#include <algorithm>
+#include <vector>
+
+using namespace CZ;
+
+// The pairwise merge is quadratic, larger inputs are first reduced by joining neighbours
+static constexpr size_t MaxPairwiseRects { 64 };
+
+std::shared_ptr<RDamageTracker> RDamageTracker::Make(UInt32 maxAge, UInt32 maxRects) noexcept
+{
+    return std::shared_ptr<RDamageTracker>(new RDamageTracker(std::max(maxAge, 1u), maxRects));
+}
+
+void RDamageTracker::addDamage(const SkIRect &rect) noexcept
+{
+    if (m_size.isEmpty())
+        m_damage.op(rect, SkRegion::kUnion_Op);
+    else if (SkIRect clipped; clipped.intersect(rect, SkIRect::MakeSize(m_size)))
+        m_damage.op(clipped, SkRegion::kUnion_Op);
+}
+
+void RDamageTracker::addDamage(const SkRegion &region) noexcept
+{
+    m_damage.op(region, SkRegion::kUnion_Op);
+
+    if (!m_size.isEmpty())
+        m_damage.op(SkIRect::MakeSize(m_size), SkRegion::kIntersect_Op);
+}
+
+void RDamageTracker::damageAll() noexcept
+{
+    m_damage.setRect(SkIRect::MakeSize(m_size));
+}
+
+SkRegion RDamageTracker::repaintRegion(UInt32 age) const noexcept
+{
+    if (age == 0 || age - 1 > m_history.size())
+        return SkRegion(SkIRect::MakeSize(m_size));
+
+    SkRegion region { m_damage };
+
+    for (UInt32 i = 0; i < age - 1; i++)
+        region.op(m_history[i], SkRegion::kUnion_Op);
+
+    return region;
+}
+
+std::optional<SkRegion> RDamageTracker::missedDamage(UInt32 age) const noexcept
+{
+    if (age == 0 || age - 1 > m_history.size())
+        return std::nullopt;
+
+    SkRegion region;
+
+    for (UInt32 i = 0; i < age - 1; i++)
+        region.op(m_history[i], SkRegion::kUnion_Op);
+
+    return region;
+}
+
+void RDamageTracker::endFrame() noexcept
+{
+    Simplify(m_damage, m_maxRects);
+    m_history.emplace_front(std::move(m_damage));
+    m_damage.setEmpty();
+
+    while (m_history.size() > m_maxAge)
+        m_history.pop_back();
+}
+
+void RDamageTracker::resize(SkISize size) noexcept
+{
+    if (m_size == size)
+        return;
+
+    m_size = size;
+    m_history.clear();
+    m_damage.op(SkIRect::MakeSize(m_size), SkRegion::kIntersect_Op);
+}
+
+void RDamageTracker::reset() noexcept
+{
+    m_history.clear();
+    m_damage.setEmpty();
+}
+
+static UInt64 Area(const SkIRect &rect) noexcept
+{
+    return UInt64(rect.width()) * UInt64(rect.height());
+}
+
+void RDamageTracker::Simplify(SkRegion &region, UInt32 maxRects) noexcept
+{
+    if (maxRects == 0 || !region.isComplex())
+        return;
+
+    std::vector<SkIRect> rects;
+
+    // Overlapping joins may split into more rects again, give up after a few rounds
+    for (int round = 0; round < 3; round++)
+    {
+        rects.clear();
+
+        for (SkRegion::Iterator it(region); !it.done(); it.next())
+            rects.emplace_back(it.rect());
+
+        if (rects.size() <= maxRects)
+            return;
+
+        // Rects are sorted by band, so consecutive ones are close to each other
+        while (rects.size() > std::max<size_t>(maxRects, MaxPairwiseRects))
+        {
+            size_t n { 0 };
+
+            for (size_t i = 0; i < rects.size(); i += 2)
+            {
+                rects[n] = rects[i];
+
+                if (i + 1 < rects.size())
+                    rects[n].join(rects[i + 1]);
+
+                n++;
+            }
+
+            rects.resize(n);
+        }
+
+        // Merge the pair that adds the least uncovered area
+        while (rects.size() > maxRects)
+        {
+            size_t bestA { 0 }, bestB { 1 };
+            Int64 bestWaste { INT64_MAX };
+
+            for (size_t a = 0; a < rects.size(); a++)
+            {
+                for (size_t b = a + 1; b < rects.size(); b++)
+                {
+                    SkIRect joined { rects[a] };
+                    joined.join(rects[b]);
+                    const Int64 waste { Int64(Area(joined)) - Int64(Area(rects[a])) - Int64(Area(rects[b])) };
+
+                    if (waste < bestWaste)
+                    {
+                        bestWaste = waste;
+                        bestA = a;
+                        bestB = b;
+                    }
+                }
+            }
+
+            rects[bestA].join(rects[bestB]);
+            rects[bestB] = rects.back();
+            rects.pop_back();
+        }
+
+        region.setRects(rects.data(), rects.size());
+    }
+
+    SkRegion::Iterator it(region);
+    UInt32 count { 0 };
+
+    for (; !it.done() && count <= maxRects; it.next())
+        count++;
+
+    if (count > maxRects)
+        region.setRect(region.getBounds());
+}
@@ -0,0 +1,116 @@
+#ifndef CZ_RDAMAGETRACKER_H
+#define CZ_RDAMAGETRACKER_H
+
+#include <CZ/Ream/RObject.h>
+#include <CZ/skia/core/SkRegion.h>
+#include <optional>
+#include <memory>
+#include <deque>
+
+/**
+ * @brief Accumulates per-frame damage for buffer-age based partial redraw.
+ *
+ * Damage added during a frame is pushed into a ring of the last maxAge() frames by endFrame().
+ * repaintRegion() then returns the area that must be redrawn into a buffer of a given age
+ * (see RSwapchainImage::age), that is, the damage of the current frame plus the damage of the
+ * frames the buffer missed.
+ *
+ * To keep SkRegion operations cheap, the damage of each frame is simplified when pushed so that
+ * it has at most maxRects() rects, merging the rects that waste the least area first.
+ *
+ * All regions are in buffer coordinates.
+ *
+ * @see RSwapchain::setDamageTracker(), RSurface::setRepaintRegion()
+ */
+class CZ::RDamageTracker final : public RObject
+{
+public:
+    /**
+     * @brief Creates a damage tracker.
+     *
+     * @param maxAge   Number of past frames to keep. Buffers older than this are fully repainted.
+     * @param maxRects Maximum number of rects per frame damage, 0 disables simplification.
+     */
+    [[nodiscard]] static std::shared_ptr<RDamageTracker> Make(UInt32 maxAge = 4, UInt32 maxRects = 16) noexcept;
+
+    /**
+     * @brief Adds damage to the current frame.
+     */
+    void addDamage(const SkIRect &rect) noexcept;
+
+    /**
+     * @copydoc addDamage(const SkIRect&)
+     */
+    void addDamage(const SkRegion &region) noexcept;
+
+    /**
+     * @brief Damages the entire buffer in the current frame.
+     */
+    void damageAll() noexcept;
+
+    /**
+     * @brief Damage accumulated during the current frame, clipped to the buffer bounds.
+     */
+    const SkRegion &damage() const noexcept { return m_damage; }
+
+    /**
+     * @brief Returns the region that must be redrawn into a buffer of the given age.
+     *
+     * Includes the damage of the current frame, so it should be called after adding it.
+     *
+     * @param age The buffer age, 0 (undefined contents) or older than the tracked history returns the entire buffer.
+     */
+    SkRegion repaintRegion(UInt32 age) const noexcept;
+
+    /**
+     * @brief Returns the damage of the past frames a buffer of the given age missed.
+     *
+     * Unlike repaintRegion(), the current frame damage is not included. Used to bring an old buffer
+     * up to date by copying from the most recently presented one.
+     *
+     * @return The region, or nullopt if the age is 0 or older than the tracked history.
+     */
+    std::optional<SkRegion> missedDamage(UInt32 age) const noexcept;
+
+    /**
+     * @brief Simplifies and pushes the current frame damage into the history, then clears it.
+     */
+    void endFrame() noexcept;
+
+    /**
+     * @brief Sets the buffer size.
+     *
+     * If it differs from the current one, the history is cleared (subsequent buffers are fully repainted)
+     * and the current frame damage is clipped to the new bounds.
+     */
+    void resize(SkISize size) noexcept;
+
+    /**
+     * @brief Buffer size set with resize().
+     */
+    SkISize size() const noexcept { return m_size; }
+
+    /**
+     * @brief Clears the history and the current frame damage.
+     */
+    void reset() noexcept;
+
+    UInt32 maxAge() const noexcept { return m_maxAge; }
+    UInt32 maxRects() const noexcept { return m_maxRects; }
+
+    /**
+     * @brief Merges the rects of a region until it has at most `maxRects` rects.
+     *
+     * The resulting region always contains the original one.
+     */
+    static void Simplify(SkRegion &region, UInt32 maxRects) noexcept;
+private:
+    RDamageTracker(UInt32 maxAge, UInt32 maxRects) noexcept : m_maxAge(maxAge), m_maxRects(maxRects) {}
+    SkISize m_size {};
+    SkRegion m_damage;
+    std::deque<SkRegion> m_history; // Most recent first
+    UInt32 m_maxAge;
+    UInt32 m_maxRects;
+};
+
+#endif // CZ_RDAMAGETRACKER_H
@@ -16,7 +16,7 @@ RDevice::~RDevice() noexcept
         m_gbmDevice = nullptr;
     }
 
-    if (core().platform() == RPlatform::Wayland)
+    if (core().platform() != RPlatform::DRM)
     {
         if (drmFd() >= 0)
         {
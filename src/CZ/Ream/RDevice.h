@@ -2,6 +2,7 @@
 #define RDEVICE_H
 
 #include <CZ/Ream/DRM/RDRMFormat.h>
+#include <CZ/Ream/RResourceTracker.h>
 #include <CZ/Ream/RLog.h>
 #include <CZ/Ream/RObject.h>
 #include <CZ/Core/CZWeak.h>
@@ -73,6 +74,9 @@ public:
 
         /// Supports timeline (as opposed to binary) synchronization.
         bool Timeline;
+
+        /// Supports GPU timestamp queries, used by RProfiler.
+        bool TimestampQuery;
     };
 
     /**
@@ -179,6 +183,25 @@ public:
     const RDRMFormatSet &textureFormats() const noexcept { return m_textureFormats; }
     const RDRMFormatSet &renderFormats() const noexcept { return m_renderFormats; }
 
+    /**
+     * @brief Returns the memory of the given type held by resources allocated by this device.
+     *
+     * @see RResourceTrackerGetBytes()
+     */
+    RMemoryUsage memoryUsage(RMemoryType type) const noexcept { return m_memory->mem[type].usage(); }
+
+    /**
+     * @brief Returns the total memory held by resources allocated by this device.
+     */
+    RMemoryUsage memoryUsage() const noexcept { return m_memory->total.usage(); }
+
+    /**
+     * @brief The counters behind memoryUsage().
+     *
+     * Resources that may outlive the device keep a reference to release their bytes.
+     */
+    const std::shared_ptr<RDeviceMemory> &memoryCounters() const noexcept { return m_memory; }
+
     CZWeak<CZObject> drmLeaseGlobal; // Reserved for Louvre's DRM lease globals
 
     /// Logger for messages related to this device.
@@ -205,6 +228,7 @@ protected:
     RDRMFormatSet m_textureFormats;
     RDRMFormatSet m_renderFormats;
     CZWeak<SRMDevice> m_srmDevice;
+    std::shared_ptr<RDeviceMemory> m_memory { std::make_shared<RDeviceMemory>() };
 };
 
 #endif // RDEVICE_H
@@ -1,4 +1,9 @@
 #include <CZ/Ream/RGammaLUT.h>
+#include <CZ/Ream/RImage.h>
+#include <CZ/Ream/RCore.h>
+#include <CZ/Ream/RLog.h>
+#include <drm_fourcc.h>
+#include <algorithm>
 #include <cmath>
 
 using namespace CZ;
@@ -8,6 +13,7 @@ void CZ::RGammaLUT::fill(Float64 gamma, Float64 brightness, Float64 contrast) no
     if (size() == 0)
         return;
 
+    // Bumps m_serial
     auto r { red()   };
     auto g { green() };
     auto b { blue()  };
@@ -31,6 +37,96 @@ void CZ::RGammaLUT::fill(Float64 gamma, Float64 brightness, Float64 contrast) no
     }
 }
 
+float RGammaLUT::sample(std::span<const UInt16> curve, float x) const noexcept
+{
+    const float pos { std::clamp(x, 0.f, 1.f) * float(curve.size() - 1) };
+    const size_t i { std::min(size_t(pos), curve.size() - 1) };
+    const size_t j { std::min(i + 1, curve.size() - 1) };
+    const float t { pos - float(i) };
+    return (float(curve[i]) + (float(curve[j]) - float(curve[i])) * t) / float(UINT16_MAX);
+}
+
+void RGammaLUT::map(float &r, float &g, float &b) const noexcept
+{
+    if (size() == 0)
+        return;
+
+    r = sample(red(), r);
+    g = sample(green(), g);
+    b = sample(blue(), b);
+}
+
+void RGammaLUT::toTables8(UInt8 r[256], UInt8 g[256], UInt8 b[256]) const noexcept
+{
+    for (UInt32 i = 0; i < 256; i++)
+    {
+        float cr { i / 255.f }, cg { cr }, cb { cr };
+        map(cr, cg, cb);
+        r[i] = UInt8(cr * 255.f + 0.5f);
+        g[i] = UInt8(cg * 255.f + 0.5f);
+        b[i] = UInt8(cb * 255.f + 0.5f);
+    }
+}
+
+std::shared_ptr<RImage> RGammaLUT::image(RDevice *device) const noexcept
+{
+    if (size() == 0)
+        return {};
+
+    if (!device)
+        device = RCore::Get()->mainDevice();
+
+    std::lock_guard<std::mutex> lock { m_imageMutex };
+
+    auto cached { std::find_if(m_images.begin(), m_images.end(), [device](const auto &c) { return c.device == device; }) };
+
+    if (cached != m_images.end() && cached->serial == m_serial)
+        return cached->image;
+
+    // Little-endian BGRA
+    std::vector<UInt8> pixels(ImageSize * 4);
+
+    for (UInt32 i = 0; i < ImageSize; i++)
+    {
+        float r { i / float(ImageSize - 1) }, g { r }, b { r };
+        map(r, g, b);
+        pixels[i * 4 + 0] = UInt8(b * 255.f + 0.5f);
+        pixels[i * 4 + 1] = UInt8(g * 255.f + 0.5f);
+        pixels[i * 4 + 2] = UInt8(r * 255.f + 0.5f);
+        pixels[i * 4 + 3] = 255;
+    }
+
+    const RPixelBufferInfo info
+    {
+        .size = { (int)ImageSize, 1 },
+        .stride = ImageSize * 4,
+        .format = DRM_FORMAT_ARGB8888,
+        .pixels = pixels.data(),
+        .alphaType = kOpaque_SkAlphaType
+    };
+
+    RImageConstraints constraints {};
+    constraints.allocator = device;
+    auto image { RImage::MakeFromPixels(info, { DRM_FORMAT_ARGB8888, { DRM_FORMAT_MOD_INVALID } }, &constraints) };
+
+    if (!image)
+    {
+        RLog(CZError, CZLN, "Failed to create the gamma LUT image");
+
+        if (cached != m_images.end())
+            m_images.erase(cached);
+
+        return {};
+    }
+
+    if (cached != m_images.end())
+        *cached = { device, image, m_serial };
+    else
+        m_images.emplace_back(CachedImage { device, image, m_serial });
+
+    return image;
+}
+
 std::shared_ptr<RGammaLUT> RGammaLUT::Make(size_t size) noexcept
 {
     return std::shared_ptr<RGammaLUT>(new RGammaLUT(size));
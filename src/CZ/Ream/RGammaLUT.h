@@ -4,10 +4,15 @@
 #include <CZ/Ream/RObject.h>
 #include <CZ/Core/CZWeak.h>
 #include <memory>
+#include <mutex>
 #include <span>
+#include <vector>
 
 /**
  * @brief Gamma LUT.
+ *
+ * Besides being passed to KMS (GAMMA_LUT), it can be applied by RPainter (see RPainter::setGammaLUT()) for
+ * outputs without hardware gamma support, e.g. offscreen targets or nested sessions.
  */
 class CZ::RGammaLUT final : public RObject
 {
@@ -50,6 +55,7 @@ public:
     void setSize(size_t size) noexcept
     {
         m_table.resize(size * 3);
+        m_serial++;
     }
 
     /**
@@ -78,20 +84,26 @@ public:
     /**
      * @brief Gets a pointer to the beginning of the red curve in the array.
      *
+     * Counts as a table change for image(), so the span should be requested again for later changes.
+     *
      * @return Pointer to the red curve in the array, or `nullptr` if the table size is 0.
      */
     std::span<UInt16> red() noexcept
     {
+        m_serial++;
         return std::span<UInt16>(m_table.data(), size());
     }
 
     /**
      * @brief Gets a pointer to the beginning of the green curve in the array.
      *
+     * Counts as a table change for image(), see red().
+     *
      * @return Pointer to the green curve in the array, or `nullptr` if the table size is 0.
      */
     std::span<UInt16> green() noexcept
     {
+        m_serial++;
         const auto s  { size() };
         return std::span<UInt16>(m_table.data() + s, s);
     }
@@ -99,10 +111,13 @@ public:
     /**
      * @brief Gets a pointer to the beginning of the blue curve in the array.
      *
+     * Counts as a table change for image(), see red().
+     *
      * @return Pointer to the blue curve in the array, or `nullptr` if the table size is 0.
      */
     std::span<UInt16> blue() noexcept
     {
+        m_serial++;
         const auto s  { size() };
         return std::span<UInt16>(m_table.data() + s * 2, s);
     }
@@ -139,9 +154,48 @@ public:
         return std::span<const UInt16>(m_table.data() + s * 2, s);
     }
 
+    /**
+     * @brief Maps an unpremultiplied color through the curves, interpolating linearly between entries.
+     *
+     * Components are clamped to [0, 1]. Does nothing if the table size is 0.
+     */
+    void map(float &r, float &g, float &b) const noexcept;
+
+    /**
+     * @brief Resamples the curves into 256 entry 8 bit tables (e.g. for SkColorFilters::TableARGB()).
+     */
+    void toTables8(UInt8 r[256], UInt8 g[256], UInt8 b[256]) const noexcept;
+
+    /// Width of image()
+    static constexpr UInt32 ImageSize { 1024 };
+
+    /**
+     * @brief Returns the curves as an ImageSize x 1 ARGB8888 image, sampled by the GPU painters.
+     *
+     * The red, green and blue curves are resampled into the matching channels. An image is cached per device
+     * and only recreated after setSize(), fill() or a request of the writable curves.
+     *
+     * @param device The allocator device, or nullptr for RCore::mainDevice().
+     * @return The image, or nullptr if the table size is 0 or the allocation failed.
+     */
+    std::shared_ptr<RImage> image(RDevice *device = nullptr) const noexcept;
+
 private:
     RGammaLUT(UInt32 size = 0) noexcept { setSize(size); }
+    float sample(std::span<const UInt16> curve, float x) const noexcept;
     std::vector<UInt16> m_table;
+    UInt32 m_serial { 0 }; // Bumped on every (potential) table change
+
+    // image() cache, one per device
+    struct CachedImage
+    {
+        RDevice *device;
+        std::shared_ptr<RImage> image;
+        UInt32 serial; // m_serial it was created from
+    };
+
+    mutable std::mutex m_imageMutex;
+    mutable std::vector<CachedImage> m_images;
 };
 
 #endif // RGAMMALUT_H
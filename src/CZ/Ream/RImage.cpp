@@ -2,6 +2,7 @@
 #include <CZ/Ream/GL/RGLImage.h>
 #include <CZ/Ream/RDMABufferInfo.h>
 #include <CZ/Ream/RResourceTracker.h>
+#include <CZ/Ream/RProfiler.h>
 #include <CZ/Ream/RCore.h>
 #include <CZ/Ream/RLog.h>
 
@@ -18,6 +19,8 @@
 #include <CZ/skia/codec/SkCodec.h>
 #include <CZ/skia/modules/svg/include/SkSVGDOM.h>
 
+#include <algorithm>
+
 using namespace CZ;
 
 std::shared_ptr<RImage> RImage::Make(SkISize size, const RDRMFormat &format, const RImageConstraints *constraints) noexcept
@@ -30,14 +33,17 @@ std::shared_ptr<RImage> RImage::Make(SkISize size, const RDRMFormat &format, con
         return {};
     }
 
+    std::shared_ptr<RImage> image;
+
     if (core->graphicsAPI() == RGraphicsAPI::GL)
-        return RGLImage::Make(size, format, constraints);
+        image = RGLImage::Make(size, format, constraints);
     else if (core->graphicsAPI() == RGraphicsAPI::RS)
-        return RRSImage::Make(size, format, constraints);
+        image = RRSImage::Make(size, format, constraints);
     else if (core->graphicsAPI() == RGraphicsAPI::VK)
-        return RVKImage::Make(size, format, constraints);
+        image = RVKImage::Make(size, format, constraints);
 
-    return {};
+    ApplyMipmapsConstraint(image.get(), constraints);
+    return image;
 }
 
 std::shared_ptr<RImage> RImage::MakeFromPixels(const RPixelBufferInfo &info, const RDRMFormat &format, const RImageConstraints *constraints) noexcept
@@ -77,6 +83,44 @@ std::shared_ptr<RImage> RImage::MakeFromPixels(const RPixelBufferInfo &info, con
     return image;
 }
 
+/* Decodes straight into the target bitmap when the codec can produce its size (e.g. JPEG decoders scale by
+ * 1/2, 1/4 or 1/8 while decoding), otherwise from the nearest codec size down with a filtered draw.
+ * Rotated (EXIF) images are left to SkImages::DeferredFromEncodedData() */
+static bool DecodeScaled(SkCodec &codec, SkBitmap &bitmap) noexcept
+{
+    if (codec.getOrigin() != kTopLeft_SkEncodedOrigin)
+        return false;
+
+    const SkISize srcSize { codec.dimensions() };
+    const SkISize dstSize { bitmap.dimensions() };
+    const float scale { std::max(dstSize.width() / float(srcSize.width()), dstSize.height() / float(srcSize.height())) };
+    const SkISize decodeSize { scale < 1.f ? codec.getScaledDimensions(scale) : srcSize };
+
+    if (decodeSize == dstSize)
+    {
+        const auto res { codec.getPixels(bitmap.pixmap()) };
+
+        if (res == SkCodec::kSuccess || res == SkCodec::kIncompleteInput)
+            return true;
+    }
+
+    SkBitmap decoded;
+
+    if (!decoded.tryAllocPixels(SkImageInfo::MakeN32Premul(decodeSize)))
+        return false;
+
+    const auto res { codec.getPixels(decoded.pixmap()) };
+
+    if (res != SkCodec::kSuccess && res != SkCodec::kIncompleteInput)
+        return false;
+
+    decoded.setImmutable();
+    SkCanvas canvas { bitmap };
+    canvas.clear(SK_ColorTRANSPARENT);
+    canvas.drawImageRect(decoded.asImage(), SkRect::Make(dstSize), SkSamplingOptions(SkFilterMode::kLinear, SkMipmapMode::kLinear));
+    return true;
+}
+
 static std::shared_ptr<RImage> LoadImage(SkColorType skFormat, const std::filesystem::path &path, const RDRMFormat &format, SkISize size, const RImageConstraints *constraints) noexcept
 {
     SkBitmap bitmap;
@@ -114,16 +158,6 @@ static std::shared_ptr<RImage> LoadImage(SkColorType skFormat, const std::filesy
         SkScalarCeilToInt(finalSize.fHeight)
     );
 
-    // Decode into a temporary SkImage first (preserves original orientation/color),
-    // then draw it into the target bitmap with scaling/conversion.
-    sk_sp<SkImage> srcImage = SkImages::DeferredFromEncodedData(data);
-
-    if (!srcImage)
-    {
-        RLog(CZDebug, CZLN, "Failed to decode image file: {}", path.c_str());
-        return {};
-    }
-
     SkImageInfo info = SkImageInfo::Make(
         finalPixelSize,
         skFormat,
@@ -135,15 +169,28 @@ static std::shared_ptr<RImage> LoadImage(SkColorType skFormat, const std::filesy
         return {};
     }
 
-    SkCanvas canvas{ bitmap };
-    canvas.clear(SK_ColorTRANSPARENT);
-
-    // Draw the source image (full) into the target rect with filtering.
-    SkRect srcRect = SkRect::MakeIWH(srcSize.width(), srcSize.height());
-    SkRect dstRect = SkRect::MakeIWH(finalPixelSize.width(), finalPixelSize.height());
-    SkPaint paint;
-    paint.setAntiAlias(true);
-    canvas.drawImageRect(srcImage, srcRect, dstRect, SkSamplingOptions(), &paint, SkCanvas::kFast_SrcRectConstraint);
+    if (!DecodeScaled(*codec, bitmap))
+    {
+        // Decode into a temporary SkImage first (preserves original orientation/color),
+        // then draw it into the target bitmap with scaling/conversion.
+        sk_sp<SkImage> srcImage = SkImages::DeferredFromEncodedData(data);
+
+        if (!srcImage)
+        {
+            RLog(CZDebug, CZLN, "Failed to decode image file: {}", path.c_str());
+            return {};
+        }
+
+        SkCanvas canvas{ bitmap };
+        canvas.clear(SK_ColorTRANSPARENT);
+
+        // Draw the source image (full) into the target rect with filtering.
+        SkRect srcRect = SkRect::MakeIWH(srcSize.width(), srcSize.height());
+        SkRect dstRect = SkRect::MakeIWH(finalPixelSize.width(), finalPixelSize.height());
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        canvas.drawImageRect(srcImage, srcRect, dstRect, SkSamplingOptions(), &paint, SkCanvas::kFast_SrcRectConstraint);
+    }
 
     // At this point bitmap has the rendered image (SVG or raster), in desired format/size.
     if (!bitmap.pixelRef() || !bitmap.readyToDraw()) {
@@ -262,10 +309,18 @@ std::shared_ptr<RImage> RImage::FromDMA(const RDMABufferInfo &info, CZOwn owners
         goto fail;
     }
 
-    if (core->graphicsAPI() == RGraphicsAPI::GL)
-        return RGLImage::FromDMA(info, ownership, constraints);
-    else if (core->graphicsAPI() == RGraphicsAPI::VK)
-        return RVKImage::FromDMA(info, ownership, constraints);
+    if (core->graphicsAPI() == RGraphicsAPI::GL || core->graphicsAPI() == RGraphicsAPI::VK)
+    {
+        std::shared_ptr<RImage> image;
+
+        if (core->graphicsAPI() == RGraphicsAPI::GL)
+            image = RGLImage::FromDMA(info, ownership, constraints);
+        else
+            image = RVKImage::FromDMA(info, ownership, constraints);
+
+        ApplyMipmapsConstraint(image.get(), constraints);
+        return image;
+    }
 
 fail:
     if (ownership == CZOwn::Own)
@@ -277,6 +332,21 @@ fail:
     return {};
 }
 
+void RImage::ApplyMipmapsConstraint(RImage *image, const RImageConstraints *constraints) noexcept
+{
+    if (!image || !constraints)
+        return;
+
+    for (const auto &dev : constraints->caps)
+    {
+        if (dev.second.has(RImageCap_Mipmaps))
+        {
+            image->m_mipmaps = true;
+            return;
+        }
+    }
+}
+
 std::shared_ptr<RGLImage> RImage::asGL() const noexcept
 {
     return std::dynamic_pointer_cast<RGLImage>(m_self.lock());
@@ -297,6 +367,19 @@ RImage::~RImage() noexcept
     RResourceTrackerSub(RResourceType::RImageRes);
 }
 
+void RImage::profileUpload(const RPixelBufferRegion &region) const noexcept
+{
+    if (!RProfiler::Enabled())
+        return;
+
+    UInt64 bytes { 0 };
+
+    for (SkRegion::Iterator it(region.region); !it.done(); it.next())
+        bytes += UInt64(it.rect().width()) * UInt64(it.rect().height()) * formatInfo().bytesPerBlock;
+
+    RProfiler::Count(RProfiler::BytesUploaded, bytes);
+}
+
 RImage::RImage(std::shared_ptr<RCore> core, RDevice *device, SkISize size, const RFormatInfo *formatInfo, SkAlphaType alphaType, RModifier modifier) noexcept :
     m_size(size),
     m_formatInfo(formatInfo),
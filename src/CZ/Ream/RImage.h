@@ -3,6 +3,7 @@
 
 #include <CZ/Ream/RObject.h>
 #include <CZ/Ream/RDMABufferInfo.h>
+#include <CZ/Ream/RColorDescription.h>
 #include <CZ/Ream/DRM/RDRMFormat.h>
 #include <CZ/skia/core/SkSize.h>
 #include <CZ/skia/core/SkRegion.h>
@@ -154,7 +155,10 @@ namespace CZ
         /// Backed by a GBM buffer object (gbmBo()).
         RImageCap_GBMBo     = 1u << 5,
 
-        /// All of the above caps combined.
+        /// Mipmaps are generated lazily when an RPainter minifies the image with RImageFilter::Linear (opt-in).
+        RImageCap_Mipmaps   = 1u << 6,
+
+        /// All of the above caps combined, except the opt-in RImageCap_Mipmaps.
         RImageCap_All       = 0x3F
     };
 
@@ -176,6 +180,11 @@ namespace CZ
 
         /// The allocator device; if nullptr, RCore::mainDevice() is used.
         RDevice *allocator { nullptr };
+
+        /// GBM storage only: lets writePixels() write into a spare buffer and swap it in instead of waiting
+        /// for pending GPU reads. Swapping changes the underlying buffer, so it stops once gbmBo() or drmFb()
+        /// are handed out (e.g. for scanout or export).
+        bool gbmWriteDoubleBuffer { false };
     };
 }
 
@@ -222,7 +231,10 @@ public:
      * @brief Loads an image from a file.
      *
      * Supports common raster formats and SVG. The decoded content is scaled/converted to
-     * @p format and, if given, @p size.
+     * @p format and, if given, @p size. Codecs that can decode at a reduced size (e.g. JPEG) decode
+     * directly near @p size.
+     *
+     * Decoding is synchronous, see RImageLoader for loading files on worker threads with a cache.
      *
      * @param size        Desired output size in pixels; {0, 0} keeps the source dimensions.
      * @param format      Requested DRM format for the new image.
@@ -328,6 +340,22 @@ public:
      */
     SkAlphaType alphaType() const noexcept { return m_alphaType; }
 
+    /**
+     * @brief Returns how the color values of the image are encoded.
+     *
+     * Defaults to sRGB. See setColorDescription().
+     */
+    const RColorDescription &colorDescription() const noexcept { return m_colorDescription; }
+
+    /**
+     * @brief Sets how the color values of the image are encoded.
+     *
+     * This is metadata only, the pixels are not modified. When drawn with RPainter, the samples are converted
+     * into the description of the destination image, e.g. an HDR output composes into a linear ABGR16161616F
+     * image and draws it into a PQ encoded 2101010 scanout buffer.
+     */
+    void setColorDescription(const RColorDescription &desc) noexcept { m_colorDescription = desc; }
+
     /**
      * @brief Returns the DRM format modifier of the image's storage.
      */
@@ -377,10 +405,17 @@ public:
     /**
      * @brief Returns the write serial.
      *
-     * Starts at 0 and is incremented by each successful writePixels() call.
+     * Starts at 0 and is incremented by each successful writePixels() call and each RPass targeting the image.
      */
     UInt32 writeSerial() const noexcept { return m_writeSerial; }
 
+    /**
+     * @brief Returns `true` if the image was created requesting RImageCap_Mipmaps.
+     *
+     * Mip levels are generated on the first minified draw after each change of writeSerial().
+     */
+    bool mipmaps() const noexcept { return m_mipmaps; }
+
     /**
      * @brief Attempts to cast this image to an RGLImage.
      *
@@ -411,11 +446,20 @@ public:
     // Reserved for Louvre
     std::shared_ptr<CZObjectBase> louvre;
 protected:
+    friend class RPass;
     RImage(std::shared_ptr<RCore> core, RDevice *device, SkISize size, const RFormatInfo *formatInfo, SkAlphaType alphaType, RModifier modifiers) noexcept;
+
+    // Sets m_mipmaps if any device in the constraints requests RImageCap_Mipmaps
+    static void ApplyMipmapsConstraint(RImage *image, const RImageConstraints *constraints) noexcept;
+
+    // Adds the region size to RProfiler::BytesUploaded
+    void profileUpload(const RPixelBufferRegion &region) const noexcept;
     SkISize m_size;
     UInt32 m_writeSerial {};
+    bool m_mipmaps { false };
     const RFormatInfo *m_formatInfo;
     SkAlphaType m_alphaType;
+    RColorDescription m_colorDescription;
     RModifier m_modifier;
     RDevice *m_allocator;
     std::unordered_set<RFormat> m_readFormats;
@@ -0,0 +1,273 @@
+#include <CZ/Ream/RImageLoader.h>
+#include <CZ/Ream/RLog.h>
+#include <algorithm>
+#include <format>
+
+using namespace CZ;
+
+std::shared_ptr<RImageLoader> RImageLoader::Make(UInt32 threads, size_t cacheLimit) noexcept
+{
+    if (threads == 0)
+        threads = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+
+    auto loader { std::shared_ptr<RImageLoader>(new RImageLoader(cacheLimit)) };
+
+    try
+    {
+        for (UInt32 i = 0; i < threads; i++)
+            loader->m_workers.emplace_back([l = loader.get()] { l->work(); });
+    }
+    catch (const std::system_error &e)
+    {
+        if (loader->m_workers.empty())
+        {
+            RLog(CZError, CZLN, "Failed to start the worker threads: {}", e.what());
+            return {};
+        }
+    }
+
+    return loader;
+}
+
+RImageLoader::~RImageLoader() noexcept
+{
+    std::deque<std::shared_ptr<Job>> queue;
+
+    {
+        std::lock_guard lock { m_mutex };
+        m_stop = true;
+        queue.swap(m_queue);
+    }
+
+    m_cv.notify_all();
+
+    for (auto &worker : m_workers)
+        worker.join();
+
+    for (auto &job : queue)
+    {
+        job->promise.set_value({});
+
+        for (auto &callback : job->callbacks)
+            callback({});
+    }
+}
+
+// Empty if the file can't be stat'ed (not cached, the load reports the error)
+std::string RImageLoader::MakeKey(const std::filesystem::path &path, const RDRMFormat &format, SkISize size) noexcept
+{
+    std::error_code ec;
+    const auto mtime { std::filesystem::last_write_time(path, ec) };
+
+    if (ec)
+        return {};
+
+    return std::format("{}|{}|{}x{}|{}", path.native(), mtime.time_since_epoch().count(), size.width(), size.height(), format.format());
+}
+
+RImageLoader::Result RImageLoader::load(const std::filesystem::path &path, const RDRMFormat &format, SkISize size, const RImageConstraints *constraints) noexcept
+{
+    return enqueue(path, format, size, constraints, nullptr);
+}
+
+void RImageLoader::load(const std::filesystem::path &path, const RDRMFormat &format, SkISize size, Callback callback, const RImageConstraints *constraints) noexcept
+{
+    enqueue(path, format, size, constraints, std::move(callback));
+}
+
+std::vector<RImageLoader::Result> RImageLoader::preload(std::span<const Request> requests) noexcept
+{
+    std::vector<Result> results;
+    results.reserve(requests.size());
+
+    for (const auto &request : requests)
+        results.emplace_back(enqueue(request.path, request.format, request.size, nullptr, nullptr));
+
+    return results;
+}
+
+RImageLoader::Result RImageLoader::enqueue(const std::filesystem::path &path, const RDRMFormat &format, SkISize size, const RImageConstraints *constraints, Callback callback) noexcept
+{
+    std::string key { constraints ? std::string() : MakeKey(path, format, size) };
+    std::unique_lock lock { m_mutex };
+
+    if (!key.empty())
+    {
+        if (auto image { findCached(key) })
+        {
+            lock.unlock();
+            std::promise<std::shared_ptr<RImage>> promise;
+            promise.set_value(image);
+
+            if (callback)
+                callback(image);
+
+            return promise.get_future().share();
+        }
+
+        // Shares the decode already in progress
+        if (auto it { m_pending.find(key) }; it != m_pending.end())
+        {
+            if (callback)
+                it->second->callbacks.emplace_back(std::move(callback));
+
+            return it->second->result;
+        }
+    }
+
+    auto job { std::make_shared<Job>() };
+    job->key = std::move(key);
+    job->request = { path, format, size };
+    job->result = job->promise.get_future().share();
+
+    if (constraints)
+        job->constraints = *constraints;
+
+    if (callback)
+        job->callbacks.emplace_back(std::move(callback));
+
+    if (m_stop || m_workers.empty())
+    {
+        lock.unlock();
+        job->promise.set_value({});
+
+        for (auto &cb : job->callbacks)
+            cb({});
+
+        return job->result;
+    }
+
+    if (!job->key.empty())
+        m_pending[job->key] = job;
+
+    m_queue.emplace_back(job);
+    lock.unlock();
+    m_cv.notify_one();
+    return job->result;
+}
+
+void RImageLoader::work() noexcept
+{
+    while (true)
+    {
+        std::shared_ptr<Job> job;
+
+        {
+            std::unique_lock lock { m_mutex };
+            m_cv.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+
+            if (m_stop)
+                return;
+
+            job = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        auto image { RImage::LoadFile(job->request.path, job->request.format, job->request.size,
+            job->constraints.has_value() ? &job->constraints.value() : nullptr) };
+
+        std::vector<Callback> callbacks;
+
+        {
+            std::lock_guard lock { m_mutex };
+
+            if (!job->key.empty())
+            {
+                m_pending.erase(job->key);
+
+                if (image)
+                    addCached(job->key, image);
+            }
+
+            // Callbacks added while loading are taken here too
+            callbacks.swap(job->callbacks);
+        }
+
+        job->promise.set_value(image);
+
+        for (auto &callback : callbacks)
+            callback(image);
+    }
+}
+
+std::shared_ptr<RImage> RImageLoader::cached(const std::filesystem::path &path, const RDRMFormat &format, SkISize size) noexcept
+{
+    const std::string key { MakeKey(path, format, size) };
+
+    if (key.empty())
+        return {};
+
+    std::lock_guard lock { m_mutex };
+    return findCached(key);
+}
+
+std::shared_ptr<RImage> RImageLoader::findCached(const std::string &key) noexcept
+{
+    auto it { m_cacheMap.find(key) };
+
+    if (it == m_cacheMap.end())
+        return {};
+
+    // Most recently used first
+    m_cache.splice(m_cache.begin(), m_cache, it->second);
+    return it->second->image;
+}
+
+void RImageLoader::addCached(const std::string &key, std::shared_ptr<RImage> image) noexcept
+{
+    const auto &info { image->formatInfo() };
+    const size_t bytes { size_t(image->size().width()) * size_t(image->size().height()) * info.bytesPerBlock / (info.blockWidth * info.blockHeight) };
+
+    // Never cached, it would evict everything else
+    if (bytes > m_cacheLimit)
+        return;
+
+    if (auto it { m_cacheMap.find(key) }; it != m_cacheMap.end())
+    {
+        m_cacheSize -= it->second->bytes;
+        m_cache.erase(it->second);
+        m_cacheMap.erase(it);
+    }
+
+    m_cache.emplace_front(CacheEntry { key, std::move(image), bytes });
+    m_cacheMap[key] = m_cache.begin();
+    m_cacheSize += bytes;
+    evict();
+}
+
+void RImageLoader::evict() noexcept
+{
+    while (m_cacheSize > m_cacheLimit && !m_cache.empty())
+    {
+        m_cacheSize -= m_cache.back().bytes;
+        m_cacheMap.erase(m_cache.back().key);
+        m_cache.pop_back();
+    }
+}
+
+void RImageLoader::setCacheLimit(size_t bytes) noexcept
+{
+    std::lock_guard lock { m_mutex };
+    m_cacheLimit = bytes;
+    evict();
+}
+
+size_t RImageLoader::cacheLimit() const noexcept
+{
+    std::lock_guard lock { m_mutex };
+    return m_cacheLimit;
+}
+
+size_t RImageLoader::cacheSize() const noexcept
+{
+    std::lock_guard lock { m_mutex };
+    return m_cacheSize;
+}
+
+void RImageLoader::clearCache() noexcept
+{
+    std::lock_guard lock { m_mutex };
+    m_cache.clear();
+    m_cacheMap.clear();
+    m_cacheSize = 0;
+}
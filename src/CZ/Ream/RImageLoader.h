@@ -0,0 +1,157 @@
+#ifndef CZ_RIMAGELOADER_H
+#define CZ_RIMAGELOADER_H
+
+#include <CZ/Ream/RObject.h>
+#include <CZ/Ream/RImage.h>
+#include <condition_variable>
+#include <unordered_map>
+#include <functional>
+#include <filesystem>
+#include <optional>
+#include <future>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <deque>
+#include <list>
+#include <span>
+
+/**
+ * @brief Loads image files on worker threads, with a memory-bounded cache.
+ *
+ * Each load runs RImage::LoadFile() on a worker thread (decoding, scaling and uploading), so that loading
+ * cursor themes, icons or wallpapers doesn't block the calling thread. Results are delivered through a
+ * std::shared_future or a callback.
+ *
+ * Loaded images are cached by (path, modification time, size, format), so that e.g. SVG icons are
+ * rasterized only once per size. The least recently used images are evicted once the cache exceeds
+ * cacheLimit() bytes. Concurrent requests for the same key share a single decode.
+ *
+ * @note Cached images are shared by all requesters and should be treated as read-only.
+ *       Loads with RImageConstraints bypass the cache.
+ */
+class CZ::RImageLoader final : public RObject
+{
+public:
+    /**
+     * @brief A file to load, see load() for the meaning of each field.
+     */
+    struct Request
+    {
+        std::filesystem::path path;                                                ///< Image file.
+        RDRMFormat format { DRM_FORMAT_ARGB8888, { DRM_FORMAT_MOD_INVALID } };    ///< Requested format.
+        SkISize size { 0, 0 };                                                     ///< Requested size, {0, 0} keeps the source size.
+    };
+
+    /// Result of a load, nullptr on failure
+    using Result = std::shared_future<std::shared_ptr<RImage>>;
+
+    /// Called with the loaded image (nullptr on failure)
+    using Callback = std::function<void(std::shared_ptr<RImage>)>;
+
+    /**
+     * @brief Creates a loader.
+     *
+     * @param threads    Number of worker threads, 0 picks one based on the number of CPU cores.
+     * @param cacheLimit Maximum number of bytes of the cached images (estimated from their size and format).
+     * @return The loader, or nullptr on failure.
+     */
+    [[nodiscard]] static std::shared_ptr<RImageLoader> Make(UInt32 threads = 0, size_t cacheLimit = 64 * 1024 * 1024) noexcept;
+
+    /**
+     * @brief Stops the workers.
+     *
+     * Waits for the loads in progress, queued ones are resolved with nullptr.
+     */
+    ~RImageLoader() noexcept;
+
+    /**
+     * @brief Queues a file load.
+     *
+     * @param path        Image file, see RImage::LoadFile().
+     * @param format      Requested DRM format.
+     * @param size        Requested size in pixels, {0, 0} keeps the source dimensions.
+     * @param constraints Optional allocation constraints (copied). The result is not cached.
+     * @return The result, already satisfied if the image was cached.
+     */
+    Result load(const std::filesystem::path &path, const RDRMFormat &format, SkISize size = {0, 0}, const RImageConstraints *constraints = nullptr) noexcept;
+
+    /**
+     * @brief Queues a file load and calls @p callback with the result.
+     *
+     * The callback is called from a worker thread, or immediately from the calling thread if the image was cached.
+     */
+    void load(const std::filesystem::path &path, const RDRMFormat &format, SkISize size, Callback callback, const RImageConstraints *constraints = nullptr) noexcept;
+
+    /**
+     * @brief Queues many loads at once, decoded in parallel by the workers.
+     *
+     * @return The result of each request, in the same order.
+     */
+    std::vector<Result> preload(std::span<const Request> requests) noexcept;
+
+    /**
+     * @brief Returns the cached image of a request without loading it, or nullptr.
+     */
+    std::shared_ptr<RImage> cached(const std::filesystem::path &path, const RDRMFormat &format, SkISize size = {0, 0}) noexcept;
+
+    /**
+     * @brief Sets the maximum number of bytes of the cached images, evicting the least recently used ones if needed.
+     */
+    void setCacheLimit(size_t bytes) noexcept;
+
+    /**
+     * @brief Maximum number of bytes of the cached images.
+     */
+    size_t cacheLimit() const noexcept;
+
+    /**
+     * @brief Estimated number of bytes of the currently cached images.
+     */
+    size_t cacheSize() const noexcept;
+
+    /**
+     * @brief Removes all images from the cache (images still referenced elsewhere stay alive).
+     */
+    void clearCache() noexcept;
+
+private:
+    struct Job
+    {
+        std::string key; // Empty if not cached
+        Request request;
+        std::optional<RImageConstraints> constraints;
+        std::promise<std::shared_ptr<RImage>> promise;
+        Result result;
+        std::vector<Callback> callbacks;
+    };
+
+    struct CacheEntry
+    {
+        std::string key;
+        std::shared_ptr<RImage> image;
+        size_t bytes;
+    };
+
+    RImageLoader(size_t cacheLimit) noexcept : m_cacheLimit(cacheLimit) {}
+    static std::string MakeKey(const std::filesystem::path &path, const RDRMFormat &format, SkISize size) noexcept;
+    Result enqueue(const std::filesystem::path &path, const RDRMFormat &format, SkISize size, const RImageConstraints *constraints, Callback callback) noexcept;
+    std::shared_ptr<RImage> findCached(const std::string &key) noexcept; // Locked
+    void addCached(const std::string &key, std::shared_ptr<RImage> image) noexcept; // Locked
+    void evict() noexcept; // Locked
+    void work() noexcept;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<std::thread> m_workers;
+    std::deque<std::shared_ptr<Job>> m_queue;
+    std::unordered_map<std::string, std::shared_ptr<Job>> m_pending; // Queued or in progress, by key
+    std::list<CacheEntry> m_cache; // Most recently used first
+    std::unordered_map<std::string, std::list<CacheEntry>::iterator> m_cacheMap;
+    size_t m_cacheLimit;
+    size_t m_cacheSize {};
+    bool m_stop {};
+};
+
+#endif // CZ_RIMAGELOADER_H
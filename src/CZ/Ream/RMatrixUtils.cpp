@@ -3,50 +3,49 @@
 
 using namespace CZ;
 
-SkMatrix RMatrixUtils::DstTransform(CZTransform transform, SkSize dstSize) noexcept
+/* Coefficients of each CZTransform applied to a rect of size (w, h) at the origin:
+ * x' = a * x + b * y + txW * w + txH * h
+ * y' = c * x + d * y + tyW * w + tyH * h */
+struct TransformCoeffs
+{
+    SkScalar a, b, c, d;
+    SkScalar txW, txH, tyW, tyH;
+};
+
+static constexpr TransformCoeffs DstCoeffs(CZTransform transform) noexcept
 {
     switch (transform)
     {
-    case CZTransform::Normal:
-        return SkMatrix();
-    case CZTransform::Rotated90:
-        return SkMatrix::MakeAll(
-            0, 1, 0,
-            -1, 0, dstSize.width(),
-            0, 0, 1 );
-    case CZTransform::Rotated180:
-        return SkMatrix::MakeAll(
-            -1, 0, dstSize.width(),
-            0,-1, dstSize.height(),
-            0, 0, 1);
-    case CZTransform::Rotated270:
-        return SkMatrix::MakeAll(
-            0, -1, dstSize.height(),
-            1,  0, 0,
-            0,  0, 1);
-    case CZTransform::Flipped:
-        return SkMatrix::MakeAll(
-            -1, 0, dstSize.width(),
-            0, 1, 0,
-            0, 0, 1);
-    case CZTransform::Flipped90:
-        return SkMatrix::MakeAll(
-            0, 1, 0,
-            1, 0, 0,
-            0, 0, 1);
-    case CZTransform::Flipped180:
-        return SkMatrix::MakeAll(
-            1,  0, 0,
-            0, -1, dstSize.height(),
-            0,  0, 1);
-    case CZTransform::Flipped270:
-        return SkMatrix::MakeAll(
-            0, -1, dstSize.height(),
-            -1, 0,  dstSize.width(),
-            0,  0, 1);
-        break;
+    case CZTransform::Normal:     return {  1,  0,  0,  1,   0, 0,  0, 0 };
+    case CZTransform::Rotated90:  return {  0,  1, -1,  0,   0, 0,  1, 0 };
+    case CZTransform::Rotated180: return { -1,  0,  0, -1,   1, 0,  0, 1 };
+    case CZTransform::Rotated270: return {  0, -1,  1,  0,   0, 1,  0, 0 };
+    case CZTransform::Flipped:    return { -1,  0,  0,  1,   1, 0,  0, 0 };
+    case CZTransform::Flipped90:  return {  0,  1,  1,  0,   0, 0,  0, 0 };
+    case CZTransform::Flipped180: return {  1,  0,  0, -1,   0, 0,  0, 1 };
+    case CZTransform::Flipped270: return {  0, -1, -1,  0,   0, 1,  1, 0 };
     }
-    return SkMatrix();
+
+    return { 1, 0, 0, 1, 0, 0, 0, 0 };
+}
+
+static_assert(DstCoeffs(CZTransform::Rotated90).tyW == 1 && DstCoeffs(CZTransform::Flipped270).txH == 1);
+
+/* DstTransform(transform, size) * [sX 0 tX; 0 sY tY], followed by a (postX, postY) translation */
+static SkMatrix ComposeScaleTranslate(CZTransform transform, SkSize size,
+                                      SkScalar sX, SkScalar sY, SkScalar tX, SkScalar tY,
+                                      SkScalar postX = 0.f, SkScalar postY = 0.f) noexcept
+{
+    const TransformCoeffs k { DstCoeffs(transform) };
+    return SkMatrix::MakeAll(
+        k.a * sX, k.b * sY, k.a * tX + k.b * tY + k.txW * size.width() + k.txH * size.height() + postX,
+        k.c * sX, k.d * sY, k.c * tX + k.d * tY + k.tyW * size.width() + k.tyH * size.height() + postY,
+        0.f,      0.f,      1.f);
+}
+
+SkMatrix RMatrixUtils::DstTransform(CZTransform transform, SkSize dstSize) noexcept
+{
+    return ComposeScaleTranslate(transform, dstSize, 1.f, 1.f, 0.f, 0.f);
 }
 
 SkMatrix RMatrixUtils::VirtualToImage(CZTransform transform, SkRect viewport, SkRect dst) noexcept
@@ -72,67 +71,40 @@ SkMatrix RMatrixUtils::VirtualToImage(CZTransform transform, SkRect viewport, Sk
         tY = -viewport.top() * sY;
     }
 
-    return
-        SkMatrix::MakeAll(
-            sX,  0.f, tX,
-            0.f, sY,  tY,
-            0.f, 0.f, 1.f).
-        postConcat(DstTransform(transform, size)).postTranslate(dst.x(), dst.y());
+    return ComposeScaleTranslate(transform, size, sX, sY, tX, tY, dst.x(), dst.y());
+}
+
+SkMatrix RMatrixUtils::ImageToNDC(const SkMatrix &toImage, SkISize imageSize, bool flipY) noexcept
+{
+    // Row operations instead of two matrix concatenations (toImage is affine)
+    const SkScalar nX { 2.f / imageSize.width() };
+    const SkScalar nY { (flipY ? -2.f : 2.f) / imageSize.height() };
+    const SkScalar tY { flipY ? toImage.getTranslateY() - imageSize.height() : toImage.getTranslateY() };
+
+    return SkMatrix::MakeAll(
+        toImage.getScaleX() * nX, toImage.getSkewX() * nX,  toImage.getTranslateX() * nX - 1.f,
+        toImage.getSkewY() * nY,  toImage.getScaleY() * nY, tY * nY - 1.f,
+        0.f, 0.f, 1.f);
 }
 
 SkMatrix RMatrixUtils::VirtualToNDC(CZTransform transform, SkRect viewport, SkRect dst, SkISize imageSize, bool flipY) noexcept
 {
-    SkMatrix mat { VirtualToImage(transform, viewport, dst) };
-
-    if (flipY)
-        mat.postConcat(SkMatrix::MakeAll(
-            1, 0, 0,
-            0,-1, imageSize.height(),
-            0, 0, 1));
-
-    return mat.postConcat(SkMatrix::MakeAll(
-        2.0f / imageSize.width(), 0,                         -1,
-        0,                        2.0f / imageSize.height(), -1,
-        0,                        0,                          1));
+    return ImageToNDC(VirtualToImage(transform, viewport, dst), imageSize, flipY);
 }
 
 SkMatrix RMatrixUtils::VirtualToUV(SkRect dst, CZTransform srcTransform, SkScalar srcScale, SkRect srcRect, SkISize texSize) noexcept
 {
-    const auto sX { srcRect.width() / dst.width() };
-    const auto sY { srcRect.height() / dst.height() };
-    const auto tX { srcRect.left() - dst.left() * sX };
-    const auto tY { srcRect.top()  - dst.top()  * sY };
-
-    SkMatrix dstToSrcVirtual;
-    dstToSrcVirtual.setAll(
-        sX, 0,  tX,
-        0,  sY, tY,
-        0,  0,  1);
-
-    SkMatrix virtToPixel;
-    virtToPixel.setAll(
-        srcScale, 0,        0,
-        0,        srcScale, 0,
-        0,        0,        1
-        );
-
-    SkMatrix M { dstToSrcVirtual };
-    M.postConcat(virtToPixel);
-
-    SkRect srcPixelRect;
-    virtToPixel.mapRect(&srcPixelRect, srcRect);
-
-    SkMatrix cz = DstTransform(srcTransform,
-        CZ::Is90Transform(srcTransform) ? SkSize::Make(texSize.height(),texSize.width()) : SkSize::Make(texSize));
-    M.postConcat(cz);
-
-    SkMatrix toUV;
-    toUV.setAll(
-        1.0f / texSize.width(),  0,                        0,
-        0,                       1.0f / texSize.height(),  0,
-        0,                       0,                        1);
-    M.postConcat(toUV);
+    // dst -> src (virtual) -> src (pixels)
+    const auto sX { srcRect.width() / dst.width() * srcScale };
+    const auto sY { srcRect.height() / dst.height() * srcScale };
+    const auto tX { (srcRect.left() - dst.left() * srcRect.width() / dst.width()) * srcScale };
+    const auto tY { (srcRect.top()  - dst.top()  * srcRect.height() / dst.height()) * srcScale };
+
+    const SkSize size { CZ::Is90Transform(srcTransform) ? SkSize::Make(texSize.height(), texSize.width()) : SkSize::Make(texSize) };
+    SkMatrix M { ComposeScaleTranslate(srcTransform, size, sX, sY, tX, tY) };
 
+    // Pixels -> UV
+    M.postScale(1.f / texSize.width(), 1.f / texSize.height());
     return M;
 }
 
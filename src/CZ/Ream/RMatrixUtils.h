@@ -25,6 +25,9 @@ public:
     /// Virtual -> RImage coords
     static SkMatrix VirtualToImage(CZTransform transform, SkRect viewport, SkRect dst) noexcept;
 
+    /// RImage -> NDC coords, toImage must be affine (e.g. the result of VirtualToImage())
+    static SkMatrix ImageToNDC(const SkMatrix &toImage, SkISize imageSize, bool flipY) noexcept;
+
     /// Virtual -> RImage -> UV coords
     static SkMatrix VirtualToUV(SkRect dst, CZTransform srcTransform, SkScalar srcScale, SkRect srcRect, SkISize texSize) noexcept;
 
@@ -2,10 +2,13 @@
 #include <CZ/skia/gpu/ganesh/GrRecordingContext.h>
 #include <CZ/skia/core/SkRegion.h>
 #include <CZ/Ream/RPainter.h>
+#include <CZ/Ream/RMatrixUtils.h>
 #include <CZ/Ream/RSurface.h>
 #include <CZ/Ream/RDevice.h>
 #include <CZ/Ream/RImage.h>
 #include <CZ/Ream/RSync.h>
+#include <CZ/Ream/RProfiler.h>
+#include <CZ/Ream/RGammaLUT.h>
 
 using namespace CZ;
 
@@ -47,3 +50,452 @@ void RPainter::clear() noexcept
     drawColor(SkRegion(geometry().viewport.roundOut()));
     restore();
 }
+
+static UInt64 RegionArea(const SkRegion &region) noexcept
+{
+    UInt64 area { 0 };
+
+    for (SkRegion::Iterator it(region); !it.done(); it.next())
+        area += UInt64(it.rect().width()) * UInt64(it.rect().height());
+
+    return area;
+}
+
+static bool SameGeometry(const RSurfaceGeometry &a, const RSurfaceGeometry &b) noexcept
+{
+    return a.viewport == b.viewport && a.dst == b.dst && a.transform == b.transform;
+}
+
+void RPainter::setOcclusionCulling(bool enabled) noexcept
+{
+    if (m_occlusionCulling == enabled)
+        return;
+
+    if (!enabled)
+        flushDeferredDraws();
+
+    m_occlusionCulling = enabled;
+}
+
+bool RPainter::flushDeferredDraws() noexcept
+{
+    if (m_deferred.empty())
+        return true;
+
+    /* Walk front to back accumulating opaque coverage. It is only valid within the same geometry
+     * since regions are in viewport coordinates */
+
+    SkRegion opaque;
+    const RSurfaceGeometry *opaqueGeometry { nullptr };
+
+    for (auto it = m_deferred.rbegin(); it != m_deferred.rend(); it++)
+    {
+        if (opaqueGeometry && !SameGeometry(*opaqueGeometry, it->state.geometry))
+            opaque.setEmpty();
+
+        opaqueGeometry = &it->state.geometry;
+        m_overdrawStats.requestedArea += RegionArea(it->region);
+
+        if (!opaque.isEmpty())
+            it->region.op(opaque, SkRegion::kDifference_Op);
+
+        if (!it->opaque.isEmpty())
+            opaque.op(it->opaque, SkRegion::kUnion_Op);
+    }
+
+    /* Replay back to front */
+
+    std::vector<DeferredDraw> draws;
+    draws.swap(m_deferred);
+
+    const State prevState { m_state };
+    bool ret { true };
+    m_replaying = true;
+
+    for (auto &draw : draws)
+    {
+        if (draw.region.isEmpty())
+        {
+            m_overdrawStats.culledDraws++;
+            continue;
+        }
+
+        m_overdrawStats.draws++;
+        m_overdrawStats.drawnArea += RegionArea(draw.region);
+        m_state = draw.state;
+
+        switch (draw.type)
+        {
+        case DrawType::Image:
+            ret &= drawImage(*draw.image, &draw.region, draw.mask ? &*draw.mask : nullptr);
+            break;
+        case DrawType::Color:
+            ret &= drawColor(draw.region);
+            break;
+        case DrawType::ImageEffect:
+            ret &= drawImageEffect(*draw.image, draw.effect, &draw.region);
+            break;
+        case DrawType::Shadow:
+            ret &= drawShadow(draw.shadow->rrect, draw.shadow->sigma, draw.shadow->color, draw.shadow->spread, &draw.region);
+            break;
+        }
+    }
+
+    m_replaying = false;
+    m_state = prevState;
+    return ret;
+}
+
+void RPainter::deferDraw(DeferredDraw &&draw) noexcept
+{
+    const bool canOcclude { draw.state.blendMode != RBlendMode::DstIn && !draw.mask &&
+                            draw.state.opacity >= 1.f && draw.state.factor.fA >= 1.f };
+
+    if (canOcclude && m_nextOpaqueRegion)
+    {
+        draw.opaque = *m_nextOpaqueRegion;
+        draw.opaque.op(draw.region, SkRegion::kIntersect_Op);
+    }
+
+    m_nextOpaqueRegion.reset();
+
+    if (draw.state.clipRRect)
+    {
+        const SkIRect bounds { draw.state.clipRRect->rect().roundOut() };
+        draw.region.op(bounds, SkRegion::kIntersect_Op);
+
+        // Src replaces the corners too (see setClipRRect())
+        if (draw.state.blendMode == RBlendMode::Src)
+            draw.opaque.op(bounds, SkRegion::kIntersect_Op);
+        else
+            draw.opaque.op(ClipInnerRegion(*draw.state.clipRRect), SkRegion::kIntersect_Op);
+    }
+
+    m_deferred.emplace_back(std::move(draw));
+}
+
+bool RPainter::deferDrawImage(const RDrawImageInfo &image, const SkRegion *region, const RDrawImageInfo *mask) noexcept
+{
+    if (!m_occlusionCulling || m_replaying)
+        return false;
+
+    DeferredDraw draw { .type = DrawType::Image, .state = m_state, .image = image };
+
+    if (mask)
+        draw.mask = *mask;
+
+    draw.region.setRect(geometry().viewport.roundOut());
+    draw.region.op(image.dst, SkRegion::kIntersect_Op);
+
+    if (mask)
+        draw.region.op(mask->dst, SkRegion::kIntersect_Op);
+
+    if (region)
+        draw.region.op(*region, SkRegion::kIntersect_Op);
+
+    if (!mask && image.image)
+    {
+        /* Src replaces the destination, even if translucent */
+        if (blendMode() == RBlendMode::Src ||
+            (blendMode() == RBlendMode::SrcOver && image.image->alphaType() == kOpaque_SkAlphaType && opacity() >= 1.f && factor().fA >= 1.f))
+            draw.opaque = draw.region;
+    }
+
+    deferDraw(std::move(draw));
+    return true;
+}
+
+bool RPainter::deferDrawColor(const SkRegion &region) noexcept
+{
+    if (!m_occlusionCulling || m_replaying)
+        return false;
+
+    DeferredDraw draw { .type = DrawType::Color, .state = m_state };
+    draw.region.setRect(geometry().viewport.roundOut());
+    draw.region.op(region, SkRegion::kIntersect_Op);
+
+    if (blendMode() == RBlendMode::Src ||
+        (blendMode() == RBlendMode::SrcOver && SkColorGetA(color()) == 255 && opacity() >= 1.f && factor().fA >= 1.f))
+        draw.opaque = draw.region;
+
+    deferDraw(std::move(draw));
+    return true;
+}
+
+bool RPainter::deferDrawImageEffect(const RDrawImageInfo &image, ImageEffect effect, const SkRegion *region) noexcept
+{
+    if (!m_occlusionCulling || m_replaying)
+        return false;
+
+    DeferredDraw draw { .type = DrawType::ImageEffect, .state = m_state, .image = image, .effect = effect };
+    draw.region.setRect(geometry().viewport.roundOut());
+    draw.region.op(image.dst, SkRegion::kIntersect_Op);
+
+    if (region)
+        draw.region.op(*region, SkRegion::kIntersect_Op);
+
+    deferDraw(std::move(draw));
+    return true;
+}
+
+bool RPainter::deferDrawShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread, const SkRegion *region) noexcept
+{
+    if (!m_occlusionCulling || m_replaying)
+        return false;
+
+    ShadowInfo info;
+
+    // Shadows are never opaque
+    DeferredDraw draw { .type = DrawType::Shadow, .state = m_state, .shadow = ShadowArgs { rrect, sigma, color, spread } };
+
+    if (calcShadow(rrect, sigma, color, spread, region, info))
+        draw.region = info.region;
+
+    deferDraw(std::move(draw));
+    return true;
+}
+
+SkRegion RPainter::viewportClip() const noexcept
+{
+    SkRegion region { geometry().viewport.roundOut() };
+
+    if (m_state.clipRRect)
+        region.op(m_state.clipRRect->rect().roundOut(), SkRegion::kIntersect_Op);
+
+    if (!m_repaintRegion)
+        return region;
+
+    if (!m_repaintClip || !SameGeometry(m_repaintClip->first, geometry()))
+    {
+        SkMatrix imageToVirtual;
+        virtualToImage().invert(&imageToVirtual);
+
+        // Rounded out, so fractional scales repaint slightly more but never less
+        std::vector<SkIRect> rects;
+
+        for (SkRegion::Iterator it(*m_repaintRegion); !it.done(); it.next())
+            rects.emplace_back(imageToVirtual.mapRect(SkRect::Make(it.rect())).roundOut());
+
+        m_repaintClip.emplace(geometry(), SkRegion());
+        m_repaintClip->second.setRects(rects.data(), rects.size());
+    }
+
+    region.op(m_repaintClip->second, SkRegion::kIntersect_Op);
+    return region;
+}
+
+const SkRRect *RPainter::coverageClip() const noexcept
+{
+    if (!m_state.clipRRect)
+        return nullptr;
+
+    const SkRRect &rrect { *m_state.clipRRect };
+
+    // Whole pixel sides are already handled by viewportClip()
+    if (rrect.isEmpty() || (rrect.isRect() && rrect.rect() == SkRect::Make(rrect.rect().roundOut())))
+        return nullptr;
+
+    return &rrect;
+}
+
+SkRegion RPainter::ClipInnerRegion(const SkRRect &rrect) noexcept
+{
+    const SkRect &r { rrect.rect() };
+    const SkVector ul { rrect.radii(SkRRect::kUpperLeft_Corner) };
+    const SkVector ur { rrect.radii(SkRRect::kUpperRight_Corner) };
+    const SkVector lr { rrect.radii(SkRRect::kLowerRight_Corner) };
+    const SkVector ll { rrect.radii(SkRRect::kLowerLeft_Corner) };
+
+    const SkIRect h { SkRect::MakeLTRB(r.left(), r.top() + std::max(ul.y(), ur.y()), r.right(), r.bottom() - std::max(ll.y(), lr.y())).roundIn() };
+    const SkIRect v { SkRect::MakeLTRB(r.left() + std::max(ul.x(), ll.x()), r.top(), r.right() - std::max(ur.x(), lr.x()), r.bottom()).roundIn() };
+
+    SkRegion inner;
+
+    if (!h.isEmpty())
+        inner.setRect(h);
+
+    if (!v.isEmpty())
+        inner.op(v, SkRegion::kUnion_Op);
+
+    return inner;
+}
+
+SkScalar RPainter::viewportPixelSize() const noexcept
+{
+    const SkMatrix &m { virtualToImage() };
+    const SkScalar det { std::abs(m.getScaleX() * m.getScaleY() - m.getSkewX() * m.getSkewY()) };
+    return det > 0.f ? 1.f / std::sqrt(det) : 1.f;
+}
+
+bool RPainter::calcClearRegion(const SkRegion &region, const SkColor4f &color, SkRegion &out) const noexcept
+{
+    if (!m_surface || !m_surface->image() || coverageClip())
+        return false;
+
+    if (blendMode() != RBlendMode::Src && (blendMode() != RBlendMode::SrcOver || color.fA < 1.f))
+        return false;
+
+    // Normal transform or any multiple of 90 degrees, without skew
+    const SkMatrix &m { virtualToImage() };
+
+    if (!m.rectStaysRect())
+        return false;
+
+    constexpr SkScalar epsilon { 1.f / 256.f };
+    std::vector<SkIRect> rects;
+    rects.reserve(region.computeRegionComplexity());
+
+    for (SkRegion::Iterator it(region); !it.done(); it.next())
+    {
+        const SkRect mapped { m.mapRect(SkRect::Make(it.rect())) };
+        const SkIRect rounded { mapped.round() };
+
+        if (std::abs(mapped.left() - rounded.left()) >= epsilon || std::abs(mapped.top() - rounded.top()) >= epsilon ||
+            std::abs(mapped.right() - rounded.right()) >= epsilon || std::abs(mapped.bottom() - rounded.bottom()) >= epsilon)
+            return false;
+
+        rects.emplace_back(rounded);
+    }
+
+    out.setRects(rects.data(), rects.size());
+    out.op(SkIRect::MakeSize(m_surface->image()->size()), SkRegion::kIntersect_Op);
+    return true;
+}
+
+SkColor4f RPainter::MapGammaLUT(const RGammaLUT *lut, const SkColor4f &color, bool premult) noexcept
+{
+    if (!lut || lut->size() == 0)
+        return color;
+
+    if (premult && color.fA <= 0.f)
+        return color;
+
+    SkColor4f ret { color };
+
+    if (premult)
+    {
+        ret.fR /= color.fA;
+        ret.fG /= color.fA;
+        ret.fB /= color.fA;
+    }
+
+    lut->map(ret.fR, ret.fG, ret.fB);
+
+    if (premult)
+    {
+        ret.fR *= color.fA;
+        ret.fG *= color.fA;
+        ret.fB *= color.fA;
+    }
+
+    return ret;
+}
+
+SkColor4f RPainter::mapOutputColor(const SkColor4f &color, bool premult) const noexcept
+{
+    SkColor4f ret { color };
+
+    if (m_surface && m_surface->image())
+        ret = RColorDescription::Convert(ret, {}, m_surface->image()->colorDescription(), premult);
+
+    return MapGammaLUT(m_state.gammaLUT.get(), ret, premult);
+}
+
+bool RPainter::calcShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread, const SkRegion *region, ShadowInfo &out) const noexcept
+{
+    out.rrect = rrect;
+
+    if (spread != 0.f)
+        out.rrect.outset(spread, spread);
+
+    if (out.rrect.isEmpty())
+        return false;
+
+    const SkScalar maxRadius { 0.5f * std::min(out.rrect.width(), out.rrect.height()) };
+
+    for (int i = 0; i < 4; i++)
+    {
+        const SkVector radii { out.rrect.radii(SkRRect::Corner(i)) };
+        out.radii[i] = std::min({ radii.x(), radii.y(), maxRadius });
+    }
+
+    // Below a quarter of a pixel the blur is invisible, the clamp keeps the erf well defined
+    out.sigma = std::max(sigma, 0.25f * viewportPixelSize());
+
+    out.color = SkColor4f::FromColor(color);
+    out.color.fA *= m_state.opacity * m_state.factor.fA;
+    out.color.fR *= out.color.fA * m_state.factor.fR;
+    out.color.fG *= out.color.fA * m_state.factor.fG;
+    out.color.fB *= out.color.fA * m_state.factor.fB;
+
+    if (m_state.blendMode == RBlendMode::SrcOver && out.color.fA <= 0.f)
+        return false;
+
+    out.color = mapOutputColor(out.color, true);
+    const SkScalar extent { 3.f * out.sigma };
+    out.region = viewportClip();
+    out.region.op(out.rrect.rect().makeOutset(extent, extent).roundOut(), SkRegion::kIntersect_Op);
+
+    if (region)
+        out.region.op(*region, SkRegion::kIntersect_Op);
+
+    return !out.region.isEmpty();
+}
+
+const SkMatrix &RPainter::virtualToImage() const noexcept
+{
+    if (!m_virtualToImage || !SameGeometry(m_virtualToImage->first, geometry()))
+        m_virtualToImage.emplace(geometry(), RMatrixUtils::VirtualToImage(geometry().transform, geometry().viewport, geometry().dst));
+
+    return m_virtualToImage->second;
+}
+
+RPainter::RegionStrategy RPainter::pickRegionStrategy(const SkRegion &region) const noexcept
+{
+    if (m_regionStrategy != RegionStrategy::Auto)
+        return m_regionStrategy;
+
+    // Each rect costs a draw call, worth it only to skip vertex generation for a few rects
+    return region.computeRegionComplexity() <= MaxScissorRects ? RegionStrategy::Scissor : RegionStrategy::RectList;
+}
+
+bool RPainter::isMinified(const RDrawImageInfo &image) const noexcept
+{
+    const auto &geo { geometry() };
+
+    if (image.src.isEmpty() || geo.viewport.isEmpty())
+        return false;
+
+    // Virtual to image pixels (the geometry transform swaps the axes if rotated 90°)
+    const bool rotated { CZ::Is90Transform(geo.transform) };
+    const SkScalar scaleX { (rotated ? geo.dst.height() : geo.dst.width()) / geo.viewport.width() };
+    const SkScalar scaleY { (rotated ? geo.dst.width() : geo.dst.height()) / geo.viewport.height() };
+
+    // src is already in the orientation of dst
+    const SkScalar srcW { image.src.width() * image.srcScale };
+    const SkScalar srcH { image.src.height() * image.srcScale };
+
+    return image.dst.width() * scaleX < srcW || image.dst.height() * scaleY < srcH;
+}
+
+RPainter::ProfiledDraw::ProfiledDraw(RPainter *painter, const char *name) noexcept : m_painter(painter)
+{
+    if (m_painter->m_profiledDrawDepth++ > 0)
+        return;
+
+    m_event = RProfiler::BeginEvent(RProfiler::EventType::Draw, name, m_painter->m_device);
+
+    if (m_event)
+        m_painter->writeTimestamp(m_event, false);
+}
+
+RPainter::ProfiledDraw::~ProfiledDraw() noexcept
+{
+    m_painter->m_profiledDrawDepth--;
+
+    if (!m_event)
+        return;
+
+    m_painter->writeTimestamp(m_event, true);
+    RProfiler::EndEvent(m_event);
+}
@@ -4,6 +4,7 @@
 #include <CZ/skia/core/SkRRect.h>
 #include <CZ/skia/core/SkColor.h>
 #include <CZ/skia/core/SkCanvas.h>
+#include <CZ/skia/core/SkRegion.h>
 #include <CZ/Ream/RSurfaceGeometry.h>
 #include <CZ/Ream/RObject.h>
 #include <CZ/Ream/RImageFilter.h>
@@ -11,7 +12,9 @@
 #include <CZ/Ream/RBlendMode.h>
 #include <CZ/Core/CZTransform.h>
 #include <CZ/Core/CZBitset.h>
+#include <optional>
 #include <memory>
+#include <vector>
 
 namespace CZ
 {
@@ -127,6 +130,36 @@ public:
         VibrancyH = 1u,      ///< Sigma 6 horizontal blur pass.
         VibrancyLightV = 2u, ///< Sigma 3 vertical blur pass + light tone saturation.
         VibrancyDarkV = 3u,  ///< Sigma 3 vertical blur pass + dark tone saturation.
+
+        /**
+         * BT.709 limited range luma written to the red channel, e.g. into the R8/R16 plane of an NV12/P010 buffer.
+         * 16 bit targets (R16/GR1616) get 10 bit levels in the upper bits, as P010 expects. Alpha is ignored.
+         */
+        YUVLuma = 4u,
+
+        /**
+         * BT.709 limited range Cb/Cr written to the red/green channels, e.g. into the GR88/GR1616 plane of an NV12/P010 buffer.
+         * With a 2:1 dst/src scale and RImageFilter::Linear each pixel gets the average of its 2x2 source block. Alpha is ignored.
+         */
+        YUVChroma = 5u,
+    };
+
+    /**
+     * @brief How the GPU backends rasterize the region of a draw.
+     *
+     * @see setRegionStrategy()
+     */
+    enum class RegionStrategy : UInt8
+    {
+        /// Scissor for simple regions, rect list otherwise.
+        Auto,
+
+        /// A single draw with two triangles per rect of the region, scissored to the region bounds.
+        RectList,
+
+        /// One draw per rect, each restricted to the rect with the scissor (no per-rect vertices).
+        /// Only used if the rects map to whole pixels of the destination image, otherwise falls back to RectList.
+        Scissor
     };
 
     /**
@@ -153,6 +186,27 @@ public:
 
         /// Viewport -> (transform) -> dst mapping.
         RSurfaceGeometry geometry {};
+
+        /// Anti-aliased rounded rect clip in viewport coordinates (see setClipRRect()).
+        std::optional<SkRRect> clipRRect;
+
+        /// Curves applied to the color of each draw (see setGammaLUT()).
+        std::shared_ptr<const RGammaLUT> gammaLUT;
+    };
+
+    /**
+     * @brief Overdraw statistics gathered while occlusion culling is enabled.
+     *
+     * Painters are created per RPass, so these are per-pass numbers. Areas are in viewport units.
+     *
+     * @see setOcclusionCulling()
+     */
+    struct OverdrawStats
+    {
+        UInt32 draws {};          ///< Draw calls forwarded to the backend.
+        UInt32 culledDraws {};    ///< Draw calls skipped because they were fully occluded.
+        UInt64 requestedArea {};  ///< Area covered by all draws before culling.
+        UInt64 drawnArea {};      ///< Area actually drawn after culling.
     };
 
     /**
@@ -287,6 +341,50 @@ public:
      */
     const SkColor4f &factor() const noexcept { return m_state.factor; }
 
+    /**
+     * @brief Clips drawImage() and drawColor() to a rounded rect, in viewport coordinates.
+     *
+     * Per-corner and elliptical radii are supported (see SkRRect::setRectRadii()). The coverage of the corners
+     * is evaluated analytically with anti-aliasing, so rounded window corners don't require a mask image.
+     * drawImageEffect() is only clipped to the bounds of the rect.
+     *
+     * Within the rect bounds the coverage is applied like the alpha of a drawImage() mask: with RBlendMode::SrcOver
+     * pixels outside the rounded corners are left untouched, while RBlendMode::Src and RBlendMode::DstIn make them transparent.
+     *
+     * @param rrect The clip. An empty rect clips everything.
+     */
+    void setClipRRect(const SkRRect &rrect) noexcept { m_state.clipRRect = rrect; }
+
+    /**
+     * @brief Removes the clip set with setClipRRect().
+     */
+    void clearClipRRect() noexcept { m_state.clipRRect.reset(); }
+
+    /**
+     * @brief Returns the clip set with setClipRRect(), if any.
+     */
+    const std::optional<SkRRect> &clipRRect() const noexcept { return m_state.clipRRect; }
+
+    /**
+     * @brief Applies a gamma LUT to the color written by drawImage(), drawColor() and drawShadow().
+     *
+     * Meant for outputs without hardware gamma support (night light, calibration). Instead of an extra full-screen
+     * pass, the curves are applied within the same draw and therefore only to the drawn (damaged) region: by the
+     * shader as a texture lookup on GL and Vulkan, as a color filter on Raster, and on the CPU for solid colors.
+     *
+     * The curves map the unpremultiplied source color before blending, so the result is exact for RBlendMode::Src
+     * and opaque draws, e.g. the final composition of an offscreen frame into the output. drawImageEffect() and
+     * RBlendMode::DstIn (alpha only) are not affected.
+     *
+     * @param lut The LUT, or nullptr to disable it.
+     */
+    void setGammaLUT(std::shared_ptr<const RGammaLUT> lut) noexcept { m_state.gammaLUT = std::move(lut); }
+
+    /**
+     * @brief Returns the LUT set with setGammaLUT(), if any.
+     */
+    const std::shared_ptr<const RGammaLUT> &gammaLUT() const noexcept { return m_state.gammaLUT; }
+
     /**
      * @brief Draws an image onto the surface.
      *
@@ -295,6 +393,11 @@ public:
      * - If no mask is provided, the effective rendering area is the intersection between `region` and `image.dst`.
      * - If a mask is provided, the region is further intersected with `mask.dst`.
      *
+     * If the RImage::colorDescription() of the image and the surface image differ (and the blend mode isn't DstIn),
+     * the samples are decoded to linear light, converted into the destination primaries and re-encoded, e.g. sRGB
+     * windows composed into a linear FP16 image, which is then encoded as PQ into the output buffer.
+     * Solid colors (color(), drawColor(), drawShadow()) are sRGB and converted on the CPU.
+     *
      * @param image  Information about the image to draw.
      * @param region Clipping region within the RSurface viewport.
      * @param mask   Optional mask image. If provided, applies alpha masking using `mask.a`.
@@ -306,11 +409,30 @@ public:
     /**
      * @brief Fills the specified region with the current color().
      *
+     * Src fills, and SrcOver fills with an opaque color, of regions that map to whole pixels are carried out
+     * as clears (glClear, vkCmdClearAttachments or a render pass loadOp, plain stores on Raster).
+     *
      * @param region The region within the surface to fill.
      * @return true if the operation succeeded, false otherwise.
      */
     virtual bool drawColor(const SkRegion& region) noexcept = 0;
 
+    /**
+     * @brief Draws the blurred shadow of a rounded rect.
+     *
+     * The Gaussian blur of the rounded rect is evaluated in closed form (erf based) for each pixel, so no pre-blurred
+     * images are required. The shadow is filled with @p color and honors the current geometry, opacity, factor,
+     * blend mode and rounded clip, like drawColor(). Elliptical corners are blurred as circles with their smaller radius.
+     *
+     * @param rrect  The shadow caster in viewport coordinates.
+     * @param sigma  Standard deviation of the blur in viewport units. The shadow extends 3 * sigma beyond the caster.
+     * @param color  Unpremultiplied color of the shadow.
+     * @param spread Outsets the caster and its radii before blurring (insets if negative).
+     * @param region Optional clipping region within the RSurface viewport.
+     * @return true if the shadow was successfully drawn, false otherwise.
+     */
+    virtual bool drawShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread = 0.f, const SkRegion *region = nullptr) noexcept = 0;
+
     // Alpha, factor, blend mode, etc are ignored
     /**
      * @brief Draws an image applying a built-in image effect.
@@ -342,6 +464,69 @@ public:
      */
     void clear() noexcept;
 
+    /**
+     * @brief Enables or disables occlusion culling.
+     *
+     * While enabled, draw calls are recorded (together with the current state) instead of being executed.
+     * When flushed, the regions covered by opaque draws are subtracted from the draws issued before them,
+     * so pixels hidden by later draws (e.g. windows drawn back to front) are neither shaded nor blended,
+     * and fully hidden draws are skipped.
+     *
+     * A draw is considered opaque within its visible region when it uses RBlendMode::Src, or RBlendMode::SrcOver
+     * with an opaque image or color, opacity and factor alpha of 1 and no mask. The rounded corners of a setClipRRect()
+     * clip are excluded. Use setOpaqueRegion() to declare
+     * opaque areas of translucent images. drawImageEffect() is only opaque where declared.
+     *
+     * Disabling it flushes the recorded draws. They are also flushed when the pass switches to the SkCanvas
+     * API or ends.
+     *
+     * @see flushDeferredDraws(), overdrawStats()
+     */
+    void setOcclusionCulling(bool enabled) noexcept;
+
+    /**
+     * @brief Whether occlusion culling is enabled, see setOcclusionCulling().
+     */
+    bool occlusionCulling() const noexcept { return m_occlusionCulling; }
+
+    /**
+     * @brief Sets how the region of each draw is rasterized by the OpenGL and Vulkan backends.
+     *
+     * With RegionStrategy::Auto (default), regions with at most MaxScissorRects rects use the scissor
+     * and the rest a rect list. The Raster backend always clips with the region directly.
+     */
+    void setRegionStrategy(RegionStrategy strategy) noexcept { m_regionStrategy = strategy; }
+
+    /**
+     * @brief The strategy set with setRegionStrategy().
+     */
+    RegionStrategy regionStrategy() const noexcept { return m_regionStrategy; }
+
+    /**
+     * @brief Maximum number of rects of a region drawn with RegionStrategy::Scissor when using RegionStrategy::Auto.
+     */
+    static constexpr int MaxScissorRects { 4 };
+
+    /**
+     * @brief Declares the opaque region of the next draw call, in viewport coordinates.
+     *
+     * Only used by occlusion culling. The region is clipped to the area actually drawn, and ignored if the
+     * draw has a mask, uses RBlendMode::DstIn, or its opacity or factor alpha are below 1.
+     */
+    void setOpaqueRegion(const SkRegion &region) noexcept { m_nextOpaqueRegion = region; }
+
+    /**
+     * @brief Executes the draws recorded by occlusion culling, skipping occluded regions.
+     *
+     * @return false if any of the draws failed, true otherwise.
+     */
+    bool flushDeferredDraws() noexcept;
+
+    /**
+     * @brief Returns the overdraw statistics of the draws flushed so far.
+     */
+    const OverdrawStats &overdrawStats() const noexcept { return m_overdrawStats; }
+
     /**
      * @brief Returns the device used for rendering by this painter.
      *
@@ -357,11 +542,130 @@ protected:
     friend class RSurface;
     friend class RPass;
     friend class RSKPass;
+
+    /* Called at the top of each backend draw. Return true if the draw was recorded for occlusion culling */
+    bool deferDrawImage(const RDrawImageInfo &image, const SkRegion *region, const RDrawImageInfo *mask) noexcept;
+    bool deferDrawColor(const SkRegion &region) noexcept;
+    bool deferDrawImageEffect(const RDrawImageInfo &image, ImageEffect effect, const SkRegion *region) noexcept;
+    bool deferDrawShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread, const SkRegion *region) noexcept;
+
+    /* Viewport bounds intersected with the RSurface repaint region (see RSurface::setRepaintRegion()) and
+     * the bounds of the rounded clip. Backends start every draw region from it */
+    SkRegion viewportClip() const noexcept;
+
+    /* The rounded clip if some of its edges require per-pixel coverage (corners or fractional sides), nullptr otherwise */
+    const SkRRect *coverageClip() const noexcept;
+
+    /* Part of the rounded rect bounds fully covered by it (the cross between the corners), in viewport coordinates.
+     * Only the rest needs per-pixel coverage */
+    static SkRegion ClipInnerRegion(const SkRRect &rrect) noexcept;
+
+    /* Viewport units per destination pixel, e.g. the width of the rounded clip anti-aliasing */
+    SkScalar viewportPixelSize() const noexcept;
+
+    /* True if drawColor() with the given premultiplied color is a plain clear of the destination pixels (Src, or
+     * SrcOver with an opaque color, no rounded clip and every rect mapped to whole pixels). Fills out with the
+     * region in image pixels (top-left origin) within the image bounds, which may be empty.
+     * Backends use it to skip blending and rasterization (glClear, vkCmdClearAttachments, memset) */
+    bool calcClearRegion(const SkRegion &region, const SkColor4f &color, SkRegion &out) const noexcept;
+
+    /* Maps the color through the LUT (if not nullptr and not empty), unpremultiplying it first if premult */
+    static SkColor4f MapGammaLUT(const RGammaLUT *lut, const SkColor4f &color, bool premult) noexcept;
+
+    /* Solid (sRGB) color as written into the destination: converted into the RImage::colorDescription() of the
+     * surface image and mapped through the gamma LUT */
+    SkColor4f mapOutputColor(const SkColor4f &color, bool premult) const noexcept;
+
+    /* drawShadow() arguments resolved for the backends */
+    struct ShadowInfo
+    {
+        SkRRect rrect;      // Outset by the spread
+        SkScalar radii[4];  // Circular corners UL, UR, LR, LL, at most half the rect size
+        SkScalar sigma;     // At least a fraction of a pixel
+        SkColor4f color;    // Premultiplied, with opacity, factor and mapOutputColor() applied
+        SkRegion region;    // Blur bounds within viewportClip() and the user region
+    };
+
+    /* Returns false if there is nothing to draw */
+    bool calcShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread, const SkRegion *region, ShadowInfo &out) const noexcept;
+
+    /* RMatrixUtils::VirtualToImage() of the current geometry, recomputed only when the geometry changes */
+    const SkMatrix &virtualToImage() const noexcept;
+
+    /* Resolves RegionStrategy::Auto for the given region */
+    RegionStrategy pickRegionStrategy(const SkRegion &region) const noexcept;
+
+    /* True if the image is scaled down on either axis when drawn with the current geometry.
+     * Backends sample mipmaps (RImageCap_Mipmaps) in that case if minFilter is Linear */
+    bool isMinified(const RDrawImageInfo &image) const noexcept;
+
+    /* RProfiler event for the scope of a backend draw. Nested draws (e.g. an effect implemented
+     * with drawColor()) are part of the outer one */
+    class ProfiledDraw
+    {
+    public:
+        ProfiledDraw(RPainter *painter, const char *name) noexcept;
+        ~ProfiledDraw() noexcept;
+    private:
+        RPainter *m_painter;
+        UInt64 m_event { 0 };
+    };
+
+    /* Writes a GPU timestamp at the begin or end of a profiled draw or the pass (m_passEvent) */
+    virtual void writeTimestamp(UInt64 event, bool end) noexcept { CZ_UNUSED(event) CZ_UNUSED(end) }
+
+    // RProfiler event of the RPass, 0 if not profiled
+    UInt64 m_passEvent { 0 };
+
     State m_state {};
     std::vector<State> m_history;
     RPainter(std::shared_ptr<RSurface> surface, RDevice *device) noexcept : m_surface(surface), m_device(device) { reset(); }
     std::shared_ptr<RSurface> m_surface;
     RDevice *m_device;
+private:
+    enum class DrawType
+    {
+        Image,
+        Color,
+        ImageEffect,
+        Shadow
+    };
+
+    struct ShadowArgs
+    {
+        SkRRect rrect;
+        SkScalar sigma;
+        SkColor color;
+        SkScalar spread;
+    };
+
+    struct DeferredDraw
+    {
+        DrawType type;
+        State state;
+        std::optional<RDrawImageInfo> image;
+        std::optional<RDrawImageInfo> mask;
+        ImageEffect effect {};
+        std::optional<ShadowArgs> shadow;
+        SkRegion region;  // Area the draw covers
+        SkRegion opaque;  // Part of region that hides what's below
+    };
+
+    void deferDraw(DeferredDraw &&draw) noexcept;
+
+    // RSurface repaint region at the time the pass was created (image coords)
+    std::optional<SkRegion> m_repaintRegion;
+
+    // m_repaintRegion in viewport coords, valid while the geometry matches
+    mutable std::optional<std::pair<RSurfaceGeometry, SkRegion>> m_repaintClip;
+    mutable std::optional<std::pair<RSurfaceGeometry, SkMatrix>> m_virtualToImage;
+    bool m_occlusionCulling { false };
+    bool m_replaying { false };
+    RegionStrategy m_regionStrategy { RegionStrategy::Auto };
+    std::optional<SkRegion> m_nextOpaqueRegion;
+    std::vector<DeferredDraw> m_deferred;
+    OverdrawStats m_overdrawStats {};
+    UInt32 m_profiledDrawDepth { 0 };
 };
 
 #endif // RPAINTER_H
@@ -1,9 +1,16 @@
 #include <CZ/Ream/RPass.h>
+#include <CZ/Ream/RLockGuard.h>
 #include <CZ/Ream/RSurface.h>
 #include <CZ/Ream/RImage.h>
 #include <CZ/Ream/RSync.h>
 #include <CZ/Ream/RDevice.h>
 #include <CZ/Ream/RCore.h>
+#include <CZ/Ream/RResourceTracker.h>
+#include <CZ/Ream/RProfiler.h>
+
+#include <CZ/skia/gpu/ganesh/GrDirectContext.h>
+#include <CZ/skia/core/SkSurface.h>
+#include <CZ/skia/core/SkCanvas.h>
 
 #include <CZ/Ream/GL/RGLPass.h>
 #include <CZ/Ream/RS/RRSPass.h>
@@ -14,6 +21,21 @@ using namespace CZ;
 RPass::RPass(std::shared_ptr<RSurface> surface, std::shared_ptr<RImage> image, std::shared_ptr<RPainter> painter, sk_sp<SkSurface> skSurface, RDevice *device, CZBitset<RPassCap> caps) noexcept :
     m_surface(surface), m_image(image), m_painter(painter), m_skSurface(skSurface), m_device(device), m_caps(caps)
 {
+    m_profilerEvent = RProfiler::BeginEvent(RProfiler::EventType::Pass, "RPass", device);
+
+    if (m_painter)
+    {
+        m_painter->m_passEvent = m_profilerEvent;
+        m_painter->m_repaintRegion = m_surface->repaintRegion();
+    }
+
+    // The SkSurface is shared by all passes targeting the image, the clip is removed in the destructor
+    if (m_skSurface && m_surface->repaintRegion())
+    {
+        m_canvasSaveCount = m_skSurface->getCanvas()->save();
+        m_skSurface->getCanvas()->clipRegion(*m_surface->repaintRegion());
+    }
+
     if (m_image->readSync())
         m_image->readSync()->gpuWait(device);
 
@@ -23,7 +45,29 @@ RPass::RPass(std::shared_ptr<RSurface> surface, std::shared_ptr<RImage> image, s
 
 RPass::~RPass() noexcept
 {
+    if (m_canvasSaveCount >= 0)
+        m_skSurface->getCanvas()->restoreToCount(m_canvasSaveCount);
+
     m_image->setWriteSync(RSync::Make(m_device));
+
+    {
+        // Invalidates mipmaps and other content derived caches
+        RLockGuard lock {};
+        m_image->m_writeSerial++;
+    }
+
+    // Sample the cache of the context that recorded this pass (Skia contexts are per thread)
+    if (m_skSurface && m_skSurface->recordingContext())
+    {
+        if (auto *context { m_skSurface->recordingContext()->asDirectContext() })
+        {
+            size_t bytes { 0 };
+            context->getResourceCacheUsage(nullptr, &bytes);
+            RResourceTrackerSetSkiaCacheBytes(m_device, context, bytes);
+        }
+    }
+
+    RProfiler::EndEvent(m_profilerEvent);
 }
 
 void RPass::resetGeometry() noexcept
@@ -112,6 +112,12 @@ protected:
     sk_sp<SkSurface> m_skSurface;
     RDevice *m_device;
     CZBitset<RPassCap> m_caps;
+
+    // RProfiler event, 0 if not profiled
+    UInt64 m_profilerEvent { 0 };
+
+    // SkCanvas save count before the RSurface repaint region clip, -1 if not clipped
+    int m_canvasSaveCount { -1 };
 };
 
 #endif // CZ_RPASS_H
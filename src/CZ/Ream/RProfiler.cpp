@@ -0,0 +1,400 @@
+#include <CZ/Ream/RProfiler.h>
+#include <CZ/Ream/RDevice.h>
+#include <CZ/Ream/RLog.h>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <cstdio>
+#include <unistd.h>
+
+using namespace CZ;
+
+std::atomic<bool> RProfiler::s_enabled { false };
+
+namespace
+{
+    struct Frame
+    {
+        RProfiler::FrameStats stats {};
+        std::vector<RProfiler::Event> events;
+        UInt32 pendingGPU { 0 };
+        bool ended { false };
+    };
+
+    struct EventRef
+    {
+        UInt64 frame;
+        size_t index;
+        bool pendingGPU;
+    };
+
+    struct Profiler
+    {
+        std::mutex mutex;
+        RProfiler::FrameCallback callback;
+        std::deque<Frame> frames; // Back is the current frame
+        std::unordered_map<UInt64, EventRef> refs;
+        UInt64 nextId { 1 };
+        UInt64 nextFrame { 0 };
+        UInt32 maxFrameLatency { 4 };
+
+        FILE *trace { nullptr };
+        UInt64 traceBegin { 0 };
+        bool traceFirst { true };
+        std::vector<RDevice*> traceDevices; // Devices whose GPU track was already named
+    };
+}
+
+static Profiler &P() noexcept
+{
+    static Profiler p;
+    return p;
+}
+
+static UInt32 ThreadId() noexcept
+{
+    static thread_local const UInt32 tid { static_cast<UInt32>(gettid()) };
+    return tid;
+}
+
+static Frame &CurrentFrame(Profiler &p) noexcept
+{
+    if (p.frames.empty() || p.frames.back().ended)
+    {
+        auto &frame { p.frames.emplace_back() };
+        frame.stats.frame = p.nextFrame++;
+        frame.stats.cpuBegin = RProfiler::Now();
+    }
+
+    return p.frames.back();
+}
+
+static RProfiler::Event *FindEvent(Profiler &p, UInt64 id, EventRef **outRef = nullptr) noexcept
+{
+    auto it { p.refs.find(id) };
+
+    if (it == p.refs.end() || p.frames.empty() || it->second.frame < p.frames.front().stats.frame)
+        return nullptr;
+
+    auto &frame { p.frames[it->second.frame - p.frames.front().stats.frame] };
+
+    if (outRef)
+        *outRef = &it->second;
+
+    return &frame.events[it->second.index];
+}
+
+static void TraceWrite(Profiler &p, const char *fmt, auto&&... args) noexcept
+{
+    if (!p.trace)
+        return;
+
+    if (!p.traceFirst)
+        fputs(",\n", p.trace);
+
+    p.traceFirst = false;
+    fprintf(p.trace, fmt, args...);
+}
+
+static double TraceTime(Profiler &p, UInt64 ns) noexcept
+{
+    return ns >= p.traceBegin ? double(ns - p.traceBegin) / 1000.0 : 0.0;
+}
+
+static UInt32 GPUTrack(RDevice *device) noexcept
+{
+    // Pseudo thread id grouping the GPU slices of each device
+    return 0x40000000 | (static_cast<UInt32>(reinterpret_cast<uintptr_t>(device) >> 4) & 0x0FFFFFFF);
+}
+
+static void TraceDeviceName(Profiler &p, RDevice *device) noexcept
+{
+    if (std::find(p.traceDevices.begin(), p.traceDevices.end(), device) != p.traceDevices.end())
+        return;
+
+    p.traceDevices.emplace_back(device);
+    TraceWrite(p, R"({"name":"thread_name","ph":"M","pid":1,"tid":%u,"args":{"name":"GPU %s"}})",
+        GPUTrack(device), device->drmNode().c_str());
+}
+
+static void TraceFrame(Profiler &p, const Frame &frame) noexcept
+{
+    if (!p.trace)
+        return;
+
+    const auto &s { frame.stats };
+
+    TraceWrite(p, R"({"name":"Frame %llu","cat":"frame","ph":"X","pid":1,"tid":0,"ts":%.3f,"dur":%.3f})",
+        (unsigned long long)s.frame, TraceTime(p, s.cpuBegin), double(s.cpuEnd - s.cpuBegin) / 1000.0);
+
+    TraceWrite(p, R"({"name":"Ream","ph":"C","pid":1,"ts":%.3f,"args":{"passes":%u,"draws":%u,"vertices":%llu,"fences":%llu,"bytesUploaded":%llu,"programs":%llu,"pipelines":%llu,"makeCurrent":%llu,"gpuMs":%.3f}})",
+        TraceTime(p, s.cpuEnd), s.passes, s.draws,
+        (unsigned long long)s.counters[RProfiler::Vertices],
+        (unsigned long long)s.counters[RProfiler::Fences],
+        (unsigned long long)s.counters[RProfiler::BytesUploaded],
+        (unsigned long long)s.counters[RProfiler::ProgramCreations],
+        (unsigned long long)s.counters[RProfiler::PipelineCreations],
+        (unsigned long long)s.counters[RProfiler::MakeCurrentCalls],
+        double(s.gpuTime) / 1000000.0);
+
+    for (const auto &e : frame.events)
+    {
+        const char *cat { e.type == RProfiler::EventType::Pass ? "pass" : "draw" };
+
+        TraceWrite(p, R"({"name":"%s","cat":"%s","ph":"X","pid":1,"tid":%u,"ts":%.3f,"dur":%.3f})",
+            e.name, cat, e.thread, TraceTime(p, e.cpuBegin), double(e.cpuEnd - e.cpuBegin) / 1000.0);
+
+        if (e.gpuDuration < 0)
+            continue;
+
+        if (e.device)
+            TraceDeviceName(p, e.device);
+
+        TraceWrite(p, R"({"name":"%s","cat":"%s,gpu","ph":"X","pid":1,"tid":%u,"ts":%.3f,"dur":%.3f})",
+                e.name, cat, GPUTrack(e.device), TraceTime(p, e.cpuBegin), double(e.gpuDuration) / 1000.0);
+    }
+}
+
+/* Pops finished frames, must be called with the mutex locked */
+static std::deque<Frame> TakeFinishedFrames(Profiler &p, bool all = false) noexcept
+{
+    std::deque<Frame> finished;
+
+    while (!p.frames.empty())
+    {
+        auto &frame { p.frames.front() };
+
+        if (!frame.ended)
+            break;
+
+        const bool expired { p.nextFrame - frame.stats.frame > p.maxFrameLatency };
+
+        if (!all && frame.pendingGPU > 0 && !expired)
+            break;
+
+        auto &s { frame.stats };
+        s.gpuComplete = frame.pendingGPU == 0;
+
+        for (const auto &e : frame.events)
+        {
+            p.refs.erase(e.id);
+
+            if (e.type == RProfiler::EventType::Pass)
+            {
+                s.passes++;
+                s.cpuPassTime += e.cpuEnd - e.cpuBegin;
+
+                if (e.gpuDuration > 0)
+                    s.gpuTime += e.gpuDuration;
+            }
+            else
+                s.draws++;
+        }
+
+        finished.emplace_back(std::move(frame));
+        p.frames.pop_front();
+    }
+
+    return finished;
+}
+
+static void Deliver(Profiler &p, std::unique_lock<std::mutex> &lock, std::deque<Frame> &&frames) noexcept
+{
+    if (frames.empty())
+        return;
+
+    for (const auto &frame : frames)
+        TraceFrame(p, frame);
+
+    auto callback { p.callback };
+    lock.unlock();
+
+    if (callback)
+        for (const auto &frame : frames)
+            callback(frame.stats, frame.events);
+}
+
+UInt64 RProfiler::Now() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RProfiler::SetEnabled(bool enabled) noexcept
+{
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+
+    if (s_enabled == enabled)
+        return;
+
+    s_enabled = enabled;
+
+    if (!enabled)
+    {
+        p.frames.clear();
+        p.refs.clear();
+    }
+}
+
+void RProfiler::SetFrameCallback(const FrameCallback &callback) noexcept
+{
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+    p.callback = callback;
+}
+
+bool RProfiler::StartTrace(const std::filesystem::path &path) noexcept
+{
+    StopTrace();
+
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+    p.trace = fopen(path.c_str(), "w");
+
+    if (!p.trace)
+    {
+        RLog(CZError, CZLN, "Failed to open trace file {}", path.string());
+        return false;
+    }
+
+    p.traceBegin = Now();
+    p.traceFirst = true;
+    p.traceDevices.clear();
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", p.trace);
+    TraceWrite(p, R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"Ream"}})");
+    return true;
+}
+
+void RProfiler::StopTrace() noexcept
+{
+    auto &p { P() };
+    std::unique_lock lock { p.mutex };
+
+    if (!p.trace)
+        return;
+
+    // Flush everything, including frames still waiting for GPU results
+    Deliver(p, lock, TakeFinishedFrames(p, true));
+
+    if (!lock.owns_lock())
+        lock.lock();
+
+    if (!p.trace)
+        return;
+
+    fputs("\n]}\n", p.trace);
+    fclose(p.trace);
+    p.trace = nullptr;
+}
+
+void RProfiler::EndFrame() noexcept
+{
+    if (!Enabled())
+        return;
+
+    auto &p { P() };
+    std::unique_lock lock { p.mutex };
+    auto &frame { CurrentFrame(p) };
+    frame.stats.cpuEnd = Now();
+    frame.ended = true;
+    Deliver(p, lock, TakeFinishedFrames(p));
+}
+
+UInt32 RProfiler::MaxFrameLatency() noexcept
+{
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+    return p.maxFrameLatency;
+}
+
+void RProfiler::SetMaxFrameLatency(UInt32 frames) noexcept
+{
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+    p.maxFrameLatency = frames;
+}
+
+void RProfiler::CountInternal(Counter counter, UInt64 value) noexcept
+{
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+    CurrentFrame(p).stats.counters[counter] += value;
+}
+
+UInt64 RProfiler::BeginEvent(EventType type, const char *name, RDevice *device) noexcept
+{
+    if (!Enabled())
+        return 0;
+
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+    auto &frame { CurrentFrame(p) };
+    const UInt64 id { p.nextId++ };
+    const UInt64 now { Now() };
+    p.refs[id] = { frame.stats.frame, frame.events.size(), false };
+    frame.events.emplace_back(Event {
+        .id = id,
+        .type = type,
+        .name = name,
+        .device = device,
+        .thread = ThreadId(),
+        .cpuBegin = now,
+        .cpuEnd = now,
+        .gpuDuration = -1 });
+    return id;
+}
+
+void RProfiler::EndEvent(UInt64 id) noexcept
+{
+    if (id == 0)
+        return;
+
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+    auto *event { FindEvent(p, id) };
+
+    if (!event)
+        return;
+
+    event->cpuEnd = Now();
+
+    if (event->device && event->device->asRS())
+        event->gpuDuration = event->cpuEnd - event->cpuBegin;
+}
+
+void RProfiler::ExpectGPUTime(UInt64 id) noexcept
+{
+    if (id == 0)
+        return;
+
+    auto &p { P() };
+    std::lock_guard lock { p.mutex };
+    EventRef *ref;
+
+    if (!FindEvent(p, id, &ref) || ref->pendingGPU)
+        return;
+
+    ref->pendingGPU = true;
+    p.frames[ref->frame - p.frames.front().stats.frame].pendingGPU++;
+}
+
+void RProfiler::SetGPUTime(UInt64 id, Int64 duration) noexcept
+{
+    if (id == 0)
+        return;
+
+    auto &p { P() };
+    std::unique_lock lock { p.mutex };
+    EventRef *ref;
+    auto *event { FindEvent(p, id, &ref) };
+
+    if (!event || !ref->pendingGPU)
+        return;
+
+    ref->pendingGPU = false;
+    event->gpuDuration = duration;
+    p.frames[ref->frame - p.frames.front().stats.frame].pendingGPU--;
+    Deliver(p, lock, TakeFinishedFrames(p));
+}
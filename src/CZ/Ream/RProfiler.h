@@ -0,0 +1,189 @@
+#ifndef CZ_RPROFILER_H
+#define CZ_RPROFILER_H
+
+#include <CZ/Ream/Ream.h>
+#include <filesystem>
+#include <functional>
+#include <atomic>
+#include <vector>
+
+/**
+ * @brief Opt-in frame profiler.
+ *
+ * Records CPU and GPU time for each RPass and RPainter draw call and aggregates per-frame statistics
+ * (draws, vertices, fences, uploaded bytes, program/pipeline creations, EGL context switches).
+ *
+ * GPU time comes from `GL_EXT_disjoint_timer_query` on OpenGL, `vkCmdWriteTimestamp` on Vulkan and
+ * the wall-clock time of the draw on Raster. GPU results arrive a few frames late, so each frame is
+ * delivered once all its GPU queries resolve or after MaxFrameLatency() frames, whichever comes first.
+ *
+ * Results can be consumed through a frame callback or written to a Chrome trace (Perfetto compatible)
+ * JSON file. GPU slices are anchored at the CPU begin time of their event, only their durations are exact.
+ *
+ * Disabled by default. Setting the @c CZ_REAM_PROFILE environment variable to a file path enables it and
+ * traces to that path for the lifetime of RCore.
+ *
+ * @note All functions are thread-safe and cost a single atomic load while profiling is disabled.
+ */
+class CZ::RProfiler
+{
+public:
+    /**
+     * @brief Kind of a profiled event.
+     */
+    enum class EventType
+    {
+        Pass, ///< An RPass, from creation to destruction.
+        Draw  ///< A single RPainter draw call.
+    };
+
+    /**
+     * @brief Per-frame counters.
+     */
+    enum Counter
+    {
+        Vertices,          ///< Vertices submitted by RPainter.
+        Fences,            ///< RSync fences created.
+        BytesUploaded,     ///< Bytes written through RImage::writePixels().
+        ProgramCreations,  ///< OpenGL programs linked.
+        PipelineCreations, ///< Vulkan pipelines created.
+        MakeCurrentCalls,  ///< `eglMakeCurrent()` calls made by the OpenGL backend.
+        CounterLast        ///< Sentinel marking the number of counters.
+    };
+
+    /**
+     * @brief A profiled event.
+     *
+     * Times are in nanoseconds, CPU times are taken from `std::chrono::steady_clock`.
+     */
+    struct Event
+    {
+        UInt64 id;
+        EventType type;
+        const char *name;
+        RDevice *device;
+        UInt32 thread;
+        UInt64 cpuBegin;
+        UInt64 cpuEnd;
+        Int64 gpuDuration; ///< -1 if unknown.
+    };
+
+    /**
+     * @brief Statistics of a finished frame.
+     */
+    struct FrameStats
+    {
+        UInt64 frame;
+        UInt64 cpuBegin;
+        UInt64 cpuEnd;
+        UInt64 cpuPassTime;  ///< Sum of the CPU time of every pass.
+        UInt64 gpuTime;      ///< Sum of the GPU time of every pass.
+        bool gpuComplete;    ///< false if some GPU queries did not resolve in time.
+        UInt32 passes;
+        UInt32 draws;
+        UInt64 counters[CounterLast];
+    };
+
+    /**
+     * @brief Frame callback.
+     *
+     * Invoked from the thread that completed the frame, without any Ream lock held.
+     */
+    using FrameCallback = std::function<void(const FrameStats &stats, const std::vector<Event> &events)>;
+
+    /**
+     * @brief Enables or disables profiling.
+     *
+     * Disabling it drops the events of frames still waiting for GPU results.
+     */
+    static void SetEnabled(bool enabled) noexcept;
+
+    /**
+     * @brief Returns true if profiling is enabled.
+     */
+    static bool Enabled() noexcept { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Sets the callback invoked for each finished frame, or unsets it if empty.
+     */
+    static void SetFrameCallback(const FrameCallback &callback) noexcept;
+
+    /**
+     * @brief Starts writing finished frames to a Chrome trace JSON file.
+     *
+     * Events are appended as frames finish, so long traces do not accumulate in memory.
+     * Any trace in progress is stopped first.
+     *
+     * @return true on success, false if the file could not be opened.
+     */
+    static bool StartTrace(const std::filesystem::path &path) noexcept;
+
+    /**
+     * @brief Finishes and closes the current trace file, if any.
+     */
+    static void StopTrace() noexcept;
+
+    /**
+     * @brief Marks the end of the current frame.
+     *
+     * Called by RWLSwapchain implementations on present. Users presenting through other means
+     * (e.g. DRM) should call it once per frame.
+     */
+    static void EndFrame() noexcept;
+
+    /**
+     * @brief Maximum number of frames a frame can wait for its GPU results. Defaults to 4.
+     */
+    static UInt32 MaxFrameLatency() noexcept;
+    static void SetMaxFrameLatency(UInt32 frames) noexcept;
+
+    /**
+     * @brief Adds @p value to the given counter of the current frame.
+     */
+    static void Count(Counter counter, UInt64 value = 1) noexcept
+    {
+        if (Enabled())
+            CountInternal(counter, value);
+    }
+
+    /* Backend interface */
+
+    /**
+     * @brief Begins an event on the calling thread.
+     *
+     * @return The event id, or 0 if profiling is disabled.
+     */
+    static UInt64 BeginEvent(EventType type, const char *name, RDevice *device) noexcept;
+
+    /**
+     * @brief Ends an event. On Raster devices its GPU time is its wall-clock time.
+     *
+     * Ignored if @p id is 0.
+     */
+    static void EndEvent(UInt64 id) noexcept;
+
+    /**
+     * @brief Tells the profiler a GPU query was issued for the event.
+     *
+     * Its frame is held back until SetGPUTime() is called or MaxFrameLatency() frames pass.
+     */
+    static void ExpectGPUTime(UInt64 id) noexcept;
+
+    /**
+     * @brief Resolves a GPU query issued with ExpectGPUTime().
+     *
+     * @param duration GPU time in nanoseconds, or -1 if the query was lost (e.g. on a disjoint GPU timer).
+     */
+    static void SetGPUTime(UInt64 id, Int64 duration) noexcept;
+
+    /**
+     * @brief Returns the current time in nanoseconds, in the same clock as Event::cpuBegin.
+     */
+    static UInt64 Now() noexcept;
+private:
+    RProfiler() = delete;
+    static void CountInternal(Counter counter, UInt64 value) noexcept;
+    static std::atomic<bool> s_enabled;
+};
+
+#endif // CZ_RPROFILER_H
@@ -1,5 +1,9 @@
 #include <CZ/Ream/RResourceTracker.h>
+#include <CZ/Ream/RDevice.h>
+#include <CZ/Ream/RCore.h>
 #include <CZ/Ream/RLog.h>
+#include <unordered_map>
+#include <mutex>
 
 using namespace CZ;
 
@@ -15,20 +19,73 @@ struct ResourceTracker
         if (lvl >= 6) // The tracker is created before RLog
         {
             RLog(CZTrace, "Memory leaks:");
-            RLog(CZTrace, "- RCore: {}", count[RCoreRes]);
-            RLog(CZTrace, "- RImage: {}", count[RImageRes]);
-            RLog(CZTrace, "- RSurface: {}", count[RSurfaceRes]);
-            RLog(CZTrace, "- RDevice: {}", count[RDeviceRes]);
-            RLog(CZTrace, "- RSync: {}", count[RSyncRes]);
-            RLog(CZTrace, "- RDRMFramebuffer: {}", count[RDRMFramebufferRes]);
-            RLog(CZTrace, "- RDRMTimeline: {}", count[RDRMTimelineRes]);
-            RLog(CZTrace, "- RDumbBuffer: {}", count[RDumbBufferRes]);
-            RLog(CZTrace, "- RGBMBo: {}", count[RGBMBoRes]);
-            RLog(CZTrace, "- REGLImage: {}", count[REGLImageRes]);
+            RLog(CZTrace, "- RCore: {}", count[RCoreRes].load());
+            RLog(CZTrace, "- RImage: {}", count[RImageRes].load());
+            RLog(CZTrace, "- RSurface: {}", count[RSurfaceRes].load());
+            RLog(CZTrace, "- RDevice: {}", count[RDeviceRes].load());
+            RLog(CZTrace, "- RSync: {}", count[RSyncRes].load());
+            RLog(CZTrace, "- RDRMFramebuffer: {}", count[RDRMFramebufferRes].load());
+            RLog(CZTrace, "- RDRMTimeline: {}", count[RDRMTimelineRes].load());
+            RLog(CZTrace, "- RDumbBuffer: {}", count[RDumbBufferRes].load());
+            RLog(CZTrace, "- RGBMBo: {}", count[RGBMBoRes].load());
+            RLog(CZTrace, "- REGLImage: {}", count[REGLImageRes].load());
+            RLog(CZTrace, "Memory (bytes / peak):");
+            RLog(CZTrace, "- Native: {} / {}", mem[RNativeMem].bytes.load(), mem[RNativeMem].peak.load());
+            RLog(CZTrace, "- GBM: {} / {}", mem[RGBMMem].bytes.load(), mem[RGBMMem].peak.load());
+            RLog(CZTrace, "- Shm: {} / {}", mem[RShmMem].bytes.load(), mem[RShmMem].peak.load());
+            RLog(CZTrace, "- Dumb: {} / {}", mem[RDumbMem].bytes.load(), mem[RDumbMem].peak.load());
+            RLog(CZTrace, "- Staging: {} / {}", mem[RStagingMem].bytes.load(), mem[RStagingMem].peak.load());
+            RLog(CZTrace, "- Vertex: {} / {}", mem[RVertexMem].bytes.load(), mem[RVertexMem].peak.load());
+            RLog(CZTrace, "- Skia cache: {} / {}", mem[RSkiaCacheMem].bytes.load(), mem[RSkiaCacheMem].peak.load());
         }
     }
-    int count[RResLast] {};
-    int lvl { 0 };
+
+    void checkBudget(UInt64 totalBytes) noexcept
+    {
+        const UInt64 limit { budget.load(std::memory_order_relaxed) };
+
+        if (limit == 0)
+            return;
+
+        if (totalBytes <= limit)
+        {
+            overBudget.store(false, std::memory_order_relaxed);
+            return;
+        }
+
+        // Only notify when crossing the budget
+        if (overBudget.exchange(true, std::memory_order_relaxed))
+            return;
+
+        RMemoryBudgetCallback callback;
+
+        {
+            std::lock_guard lock { mutex };
+            callback = budgetCallback;
+        }
+
+        if (callback)
+            callback(totalBytes, limit);
+    }
+
+    std::atomic<int> count[RResLast] {};
+    std::atomic<int> lvl { 0 };
+
+    RMemoryCounter mem[RMemLast];
+    RMemoryCounter total;
+
+    std::atomic<UInt64> budget { 0 };
+    std::atomic<bool> overBudget { false };
+
+    struct SkiaCache
+    {
+        RDevice *device;
+        UInt64 bytes;
+    };
+
+    std::mutex mutex;
+    RMemoryBudgetCallback budgetCallback;
+    std::unordered_map<const void*, SkiaCache> skiaCaches;
 };
 
 static ResourceTracker rt {};
@@ -53,3 +110,115 @@ void CZ::RResourceTrackerLog() noexcept
 {
     rt.log();
 }
+
+void CZ::RResourceTrackerAddBytes(RMemoryType type, RDevice *device, UInt64 bytes) noexcept
+{
+    if (bytes == 0)
+        return;
+
+    rt.mem[type].add(bytes);
+    const UInt64 total { rt.total.add(bytes) };
+
+    if (device)
+    {
+        auto &memory { *device->memoryCounters() };
+        memory.mem[type].add(bytes);
+        memory.total.add(bytes);
+    }
+
+    rt.checkBudget(total);
+}
+
+void CZ::RResourceTrackerSubBytes(RMemoryType type, RDevice *device, UInt64 bytes) noexcept
+{
+    RResourceTrackerSubBytes(type, device ? device->memoryCounters() : nullptr, bytes);
+}
+
+void CZ::RResourceTrackerSubBytes(RMemoryType type, const std::shared_ptr<RDeviceMemory> &memory, UInt64 bytes) noexcept
+{
+    if (bytes == 0)
+        return;
+
+    rt.mem[type].sub(bytes);
+    rt.total.sub(bytes);
+
+    if (memory)
+    {
+        memory->mem[type].sub(bytes);
+        memory->total.sub(bytes);
+    }
+}
+
+void CZ::RResourceTrackerSetSkiaCacheBytes(RDevice *device, const void *context, UInt64 bytes) noexcept
+{
+    UInt64 prev { 0 };
+
+    {
+        std::lock_guard lock { rt.mutex };
+
+        if (bytes == 0)
+        {
+            auto it { rt.skiaCaches.find(context) };
+
+            if (it == rt.skiaCaches.end())
+                return;
+
+            prev = it->second.bytes;
+            rt.skiaCaches.erase(it);
+        }
+        else
+        {
+            auto &cache { rt.skiaCaches[context] };
+            prev = cache.bytes;
+            cache = { device, bytes };
+        }
+    }
+
+    if (bytes > prev)
+        RResourceTrackerAddBytes(RSkiaCacheMem, device, bytes - prev);
+    else
+        RResourceTrackerSubBytes(RSkiaCacheMem, device, prev - bytes);
+}
+
+RMemoryUsage CZ::RResourceTrackerGetBytes(RMemoryType type, RDevice *device) noexcept
+{
+    return device ? device->memoryUsage(type) : rt.mem[type].usage();
+}
+
+RMemoryUsage CZ::RResourceTrackerGetTotalBytes(RDevice *device) noexcept
+{
+    return device ? device->memoryUsage() : rt.total.usage();
+}
+
+void CZ::RResourceTrackerResetPeaks() noexcept
+{
+    for (auto &counter : rt.mem)
+        counter.resetPeak();
+
+    rt.total.resetPeak();
+
+    if (auto core { RCore::Get() })
+    {
+        for (auto *device : core->devices())
+        {
+            auto &memory { *device->memoryCounters() };
+
+            for (auto &counter : memory.mem)
+                counter.resetPeak();
+
+            memory.total.resetPeak();
+        }
+    }
+}
+
+void CZ::RResourceTrackerSetBudget(UInt64 budget, const RMemoryBudgetCallback &callback) noexcept
+{
+    {
+        std::lock_guard lock { rt.mutex };
+        rt.budgetCallback = callback;
+    }
+
+    rt.overBudget = false;
+    rt.budget = budget;
+    rt.checkBudget(rt.total.usage().bytes);
+}
@@ -1,6 +1,11 @@
 #ifndef CZ_RRESOURCETRACKER_H
 #define CZ_RRESOURCETRACKER_H
 
+#include <CZ/Ream/Ream.h>
+#include <functional>
+#include <atomic>
+#include <memory>
+
 namespace CZ
 {
     /**
@@ -24,6 +29,74 @@ namespace CZ
         RResLast            ///< Sentinel marking the number of resource types.
     };
 
+    /**
+     * @brief Categories of memory accounted in bytes by the resource tracker.
+     */
+    enum RMemoryType
+    {
+        RNativeMem,     ///< Image storage allocated by the graphics API (GL textures, VkDeviceMemory).
+        RGBMMem,        ///< GBM buffer objects owned by Ream.
+        RShmMem,        ///< Shared memory (Raster images, also used as wl_shm buffers).
+        RDumbMem,       ///< DRM dumb buffers.
+        RStagingMem,    ///< Transient upload/readback staging buffers.
+        RVertexMem,     ///< Painter vertex buffers.
+        RSkiaCacheMem,  ///< Skia GrDirectContext resource caches, sampled when an RPass ends.
+        RMemLast        ///< Sentinel marking the number of memory types.
+    };
+
+    /**
+     * @brief Memory usage of an RMemoryType.
+     */
+    struct RMemoryUsage
+    {
+        UInt64 bytes; ///< Bytes currently held.
+        UInt64 peak;  ///< High-water mark since startup or the last RResourceTrackerResetPeaks().
+    };
+
+    /**
+     * @brief Lock-free byte counter with a high-water mark.
+     */
+    struct RMemoryCounter
+    {
+        std::atomic<UInt64> bytes {};
+        std::atomic<UInt64> peak {};
+
+        /**
+         * @brief Adds @p n bytes and returns the new total.
+         */
+        UInt64 add(UInt64 n) noexcept
+        {
+            const UInt64 total { bytes.fetch_add(n, std::memory_order_relaxed) + n };
+            UInt64 prev { peak.load(std::memory_order_relaxed) };
+            while (prev < total && !peak.compare_exchange_weak(prev, total, std::memory_order_relaxed)) {}
+            return total;
+        }
+
+        void sub(UInt64 n) noexcept { bytes.fetch_sub(n, std::memory_order_relaxed); }
+        void resetPeak() noexcept { peak.store(bytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+        RMemoryUsage usage() const noexcept { return { bytes.load(std::memory_order_relaxed), peak.load(std::memory_order_relaxed) }; }
+    };
+
+    /**
+     * @brief Memory counters of a device.
+     *
+     * Shared with resources that may be released after their device is destroyed,
+     * see RDevice::memoryCounters().
+     */
+    struct RDeviceMemory
+    {
+        RMemoryCounter mem[RMemLast]; ///< Per-type counters.
+        RMemoryCounter total;         ///< Sum of all types.
+    };
+
+    /**
+     * @brief Callback invoked when the total accounted memory exceeds the budget.
+     *
+     * Called from the allocating thread, without any tracker lock held. A typical response is to
+     * release caches (e.g. RCore::clearGarbage(), dropping unused images).
+     */
+    using RMemoryBudgetCallback = std::function<void(UInt64 totalBytes, UInt64 budget)>;
+
     /**
      * @brief Increments the live-instance count for the given resource type.
      *
@@ -52,6 +125,61 @@ namespace CZ
      * Intended for detecting leaks; output is emitted at trace verbosity.
      */
     void RResourceTrackerLog() noexcept;
+
+    /**
+     * @brief Accounts @p bytes of memory of the given type allocated by @p device.
+     *
+     * Thread-safe and lock-free. @p device may be nullptr for memory not tied to a device.
+     */
+    void RResourceTrackerAddBytes(RMemoryType type, RDevice *device, UInt64 bytes) noexcept;
+
+    /**
+     * @brief Releases @p bytes previously accounted with RResourceTrackerAddBytes().
+     *
+     * @p device must still be alive, use the RDeviceMemory variant otherwise.
+     */
+    void RResourceTrackerSubBytes(RMemoryType type, RDevice *device, UInt64 bytes) noexcept;
+
+    /**
+     * @brief Releases @p bytes previously accounted with RResourceTrackerAddBytes().
+     *
+     * @param memory The counters of the allocating device (RDevice::memoryCounters()), or nullptr.
+     */
+    void RResourceTrackerSubBytes(RMemoryType type, const std::shared_ptr<RDeviceMemory> &memory, UInt64 bytes) noexcept;
+
+    /**
+     * @brief Updates the sampled resource cache usage of a Skia GrDirectContext.
+     *
+     * Pass 0 bytes when the context is destroyed.
+     */
+    void RResourceTrackerSetSkiaCacheBytes(RDevice *device, const void *context, UInt64 bytes) noexcept;
+
+    /**
+     * @brief Returns the memory usage of the given type.
+     *
+     * @param device The device to query, or nullptr for the sum of all devices.
+     */
+    RMemoryUsage RResourceTrackerGetBytes(RMemoryType type, RDevice *device = nullptr) noexcept;
+
+    /**
+     * @brief Returns the sum of all memory types.
+     *
+     * @param device The device to query, or nullptr for the sum of all devices.
+     */
+    RMemoryUsage RResourceTrackerGetTotalBytes(RDevice *device = nullptr) noexcept;
+
+    /**
+     * @brief Resets every high-water mark to the current usage.
+     */
+    void RResourceTrackerResetPeaks() noexcept;
+
+    /**
+     * @brief Sets a memory budget.
+     *
+     * @p callback is invoked each time the total accounted memory rises above @p budget,
+     * and again only after it drops back below it. A budget of 0 disables it.
+     */
+    void RResourceTrackerSetBudget(UInt64 budget, const RMemoryBudgetCallback &callback) noexcept;
 };
 
 #endif // CZ_RRESOURCETRACKER_H
@@ -1,6 +1,7 @@
 #include <CZ/Ream/SK/RSKFormat.h>
 #include <CZ/Ream/RS/RRSImage.h>
 #include <CZ/Ream/RS/RRSDevice.h>
+#include <CZ/Ream/RResourceTracker.h>
 #include <CZ/Ream/RCore.h>
 #include <CZ/skia/core/SkImage.h>
 #include <CZ/skia/core/SkSurface.h>
@@ -123,6 +124,21 @@ CZBitset<RImageCap> RRSImage::checkDeviceCaps(CZBitset<RImageCap> caps, RDevice
     return caps;
 }
 
+sk_sp<SkImage> RRSImage::mipmappedSkImage() const noexcept
+{
+    if (!mipmaps())
+        return {};
+
+    if (!m_mipImage || m_mipSerial != writeSerial())
+    {
+        // Shares the pixels, only the mip levels are allocated
+        m_mipImage = m_skImage->withDefaultMipmaps();
+        m_mipSerial = writeSerial();
+    }
+
+    return m_mipImage;
+}
+
 bool RRSImage::writePixels(const RPixelBufferRegion &region) noexcept
 {
     if (region.format != formatInfo().format)
@@ -160,6 +176,7 @@ bool RRSImage::writePixels(const RPixelBufferRegion &region) noexcept
         iter.next();
     }
     m_writeSerial++;
+    profileUpload(region);
     return true;
 }
 
@@ -220,11 +237,15 @@ int RRSImage::resize(SkISize size) noexcept
     m_size = size;
     m_skSurface.reset();
     m_skImage.reset();
+    m_mipImage.reset();
 
     if (newByteSize > m_shm->size())
     {
         ret = 1;
         assert(m_shm->resize(newByteSize));
+        RResourceTrackerSubBytes(RShmMem, m_memory, m_shmSize);
+        m_shmSize = m_shm->size();
+        RResourceTrackerAddBytes(RShmMem, allocator(), m_shmSize);
     }
 
     auto data { SkData::MakeWithoutCopy(m_shm->map(), m_shm->size()) };
@@ -244,9 +265,19 @@ int RRSImage::resize(SkISize size) noexcept
 RRSImage::RRSImage(std::shared_ptr<RCore> core, std::shared_ptr<CZSharedMemory> shm, sk_sp<SkImage> skImage, sk_sp<SkSurface> skSurface, RDevice *device,
                    SkISize size, size_t stride, const RFormatInfo *formatInfo, SkAlphaType alphaType, RModifier modifier) noexcept :
     RImage(core, device, size, formatInfo, alphaType, modifier),
-    m_stride(stride), m_shm(shm), m_skImage(skImage), m_skSurface(skSurface)
+    m_stride(stride), m_shm(shm), m_shmSize(shm->size()), m_skImage(skImage), m_skSurface(skSurface)
 {
+    RResourceTrackerAddBytes(RShmMem, device, m_shmSize);
+
+    if (device)
+        m_memory = device->memoryCounters();
+
     m_writeFormats.emplace(formatInfo->format);
     m_readFormats.emplace(formatInfo->format);
 }
 
+
+RRSImage::~RRSImage() noexcept
+{
+    RResourceTrackerSubBytes(RShmMem, m_memory, m_shmSize);
+}
@@ -35,6 +35,8 @@ public:
      */
     [[nodiscard]] static std::shared_ptr<RRSImage> Make(SkISize size, const RDRMFormat &format, const RImageConstraints *constraints = nullptr) noexcept;
 
+    ~RRSImage() noexcept;
+
     /**
      * @brief Always returns an empty pointer.
      *
@@ -68,6 +70,15 @@ public:
         return m_skImage;
     }
 
+    /**
+     * @brief Returns an SkImage with mip levels built from the current pixels (RImageCap_Mipmaps).
+     *
+     * The levels are rebuilt lazily when writeSerial() changes.
+     *
+     * @return The mipmapped image, or `nullptr` if the image was not created with RImageCap_Mipmaps.
+     */
+    sk_sp<SkImage> mipmappedSkImage() const noexcept;
+
     /**
      * @brief Returns the SkSurface wrapping the shared-memory pixels.
      *
@@ -133,7 +144,11 @@ private:
              RDevice *device, SkISize size, size_t stride, const RFormatInfo *formatInfo, SkAlphaType alphaType, RModifier modifier) noexcept;
     size_t m_stride;
     std::shared_ptr<CZSharedMemory> m_shm;
+    size_t m_shmSize; // Accounted in RResourceTracker
+    std::shared_ptr<RDeviceMemory> m_memory; // Counters of the allocator, the image may outlive it
     sk_sp<SkImage> m_skImage;
     sk_sp<SkSurface> m_skSurface;
+    mutable sk_sp<SkImage> m_mipImage;
+    mutable UInt32 m_mipSerial {};
 };
 #endif // CZ_RRSIMAGE_H
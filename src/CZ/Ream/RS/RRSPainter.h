@@ -2,6 +2,7 @@
 #define CZ_RRSPAINTER_H
 
 #include <CZ/Ream/RPainter.h>
+#include <functional>
 
 /**
  * @brief Raster (software) implementation of RPainter.
@@ -39,6 +40,14 @@ public:
      */
     bool drawColor(const SkRegion &region) noexcept override;
 
+    /**
+     * @brief Draws a blurred rounded rect. Implements RPainter::drawShadow().
+     *
+     * The coverage is evaluated on the CPU with a vectorized erf approximation into an alpha-only
+     * bitmap, which is then drawn with the shadow color and the current blend mode.
+     */
+    bool drawShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread = 0.f, const SkRegion *region = nullptr) noexcept override;
+
     /**
      * @brief Returns the associated device downcast to the Raster backend type.
      */
@@ -61,7 +70,10 @@ private:
     };
 
     RRSPainter(std::shared_ptr<RSurface> surface, RRSDevice *device) noexcept : RPainter(surface, (RDevice*)device) {};
-    ValRes validateDrawImage(const RDrawImageInfo &image, const SkRegion *region, const RDrawImageInfo *mask, std::shared_ptr<RSurface> surface, SkPath &outClip) noexcept;
+    // Clips to the device region and draws, only the corner tiles of the rounded clip (if any) use the
+    // anti-aliased clip. draw() must use the given blend mode
+    void drawClipped(SkCanvas *c, const SkRegion &deviceClip, SkBlendMode mode, const std::function<void(SkBlendMode)> &draw) noexcept;
+    ValRes validateDrawImage(const RDrawImageInfo &image, const SkRegion *region, const RDrawImageInfo *mask, std::shared_ptr<RSurface> surface, SkRegion &outClip) noexcept;
 };
 
 #endif // CZ_RRSPAINTER_H
@@ -4,11 +4,20 @@
 
 using namespace CZ;
 
-RRSPass::~RRSPass() noexcept {}
+RRSPass::~RRSPass() noexcept
+{
+    if (m_painter)
+        m_painter->flushDeferredDraws();
+}
 
 SkCanvas *RRSPass::getCanvas(bool sync) const noexcept
 {
     CZ_UNUSED(sync)
+
+    // Even for parameter updates, the canvas could otherwise be drawn before the painter draws deferred by occlusion culling
+    if (m_painter)
+        m_painter->flushDeferredDraws();
+
     if (m_skSurface)
         return m_skSurface->getCanvas();
     return nullptr;
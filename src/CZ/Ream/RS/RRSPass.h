@@ -22,6 +22,9 @@ public:
     /**
      * @brief Returns the surface's SkCanvas. Implements RPass::getCanvas().
      *
+     * Pending painter draws (deferred by occlusion culling) are always flushed first, so that canvas
+     * commands are ordered after them.
+     *
      * @note The @p sync argument is ignored by the Raster backend.
      * @return The canvas, or nullptr if the pass has no SkSurface.
      */
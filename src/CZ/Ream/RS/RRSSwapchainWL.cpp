@@ -1,9 +1,13 @@
 #include <CZ/Ream/RS/RRSSwapchainWL.h>
 #include <CZ/Ream/RS/RRSImage.h>
 #include <CZ/Ream/RS/RRSCore.h>
+#include <CZ/Ream/RDamageTracker.h>
 #include <CZ/Ream/WL/RWLFormat.h>
+#include <CZ/Ream/RProfiler.h>
 #include <CZ/Ream/RLog.h>
 #include <CZ/Core/Utils/CZVectorUtils.h>
+#include <algorithm>
+#include <cstring>
 
 using namespace CZ;
 
@@ -15,6 +19,7 @@ std::optional<const RSwapchainImage> RRSSwapchainWL::acquire() noexcept
         return {};
 
     m_acquired = true;
+    acquireDamage(m_size);
 
     // Search for a released buffer
 
@@ -41,8 +46,12 @@ std::optional<const RSwapchainImage> RRSSwapchainWL::acquire() noexcept
 
         m_releasedIdx.erase(buffer->ssImage.index);
         buffer->ssImage.age = bestAge;
-        buffer->ssImage.frame = m_frame++;
         buffer->resize(m_size);
+
+        if (m_copyForward && bestAge > 1 && copyForwardInto(*buffer))
+            buffer->ssImage.age = 1;
+
+        buffer->ssImage.frame = m_frame++;
     }
 
     // Or create a new one...
@@ -64,6 +73,9 @@ std::optional<const RSwapchainImage> RRSSwapchainWL::acquire() noexcept
 bool RRSSwapchainWL::present(const RSwapchainImage &image, SkRegion *damage) noexcept
 {
     m_acquired = false;
+    RProfiler::EndFrame();
+    SkRegion trackedDamage;
+    damage = commitDamage(image, damage, trackedDamage);
     wl_surface_attach(m_surface, m_buffers[image.index]->buffer, 0, 0);
 
     if (!damage || wl_surface_get_version(m_surface) < 3)
@@ -80,6 +92,62 @@ bool RRSSwapchainWL::present(const RSwapchainImage &image, SkRegion *damage) noe
     }
 
     wl_surface_commit(m_surface);
+    m_lastPresented = m_buffers[image.index];
+    return true;
+}
+
+void RRSSwapchainWL::setCopyForward(bool enabled, SkScalar maxRatio) noexcept
+{
+    m_copyForward = enabled;
+    m_copyForwardMaxRatio = std::clamp(maxRatio, 0.f, 1.f);
+}
+
+bool RRSSwapchainWL::copyForwardInto(Buffer &buffer) noexcept
+{
+    auto last { m_lastPresented.lock() };
+
+    if (!m_damageTracker || !last || last.get() == &buffer)
+        return false;
+
+    auto *dstImage { buffer.ssImage.image->asRS() };
+    auto *srcImage { last->ssImage.image->asRS() };
+    const SkISize size { dstImage->size() };
+
+    if (srcImage->size() != size || srcImage->stride() != dstImage->stride())
+        return false;
+
+    // The tracker was resized by acquire(), its history is empty if the size changed
+    auto missed { m_damageTracker->missedDamage(buffer.ssImage.age) };
+
+    if (!missed)
+        return false;
+
+    missed->op(SkIRect::MakeSize(size), SkRegion::kIntersect_Op);
+
+    UInt64 area { 0 };
+
+    for (SkRegion::Iterator it(*missed); !it.done(); it.next())
+        area += UInt64(it.rect().width()) * UInt64(it.rect().height());
+
+    if (area > m_copyForwardMaxRatio * UInt64(size.width()) * UInt64(size.height()))
+        return false;
+
+    // Row memcpys, vectorized by libc. Reading while the compositor reads the last buffer is fine
+    constexpr size_t bpp { 4 }; // DRM_FORMAT_ARGB8888
+    const size_t stride { dstImage->stride() };
+    const auto *src { static_cast<const UInt8*>(srcImage->shm()->map()) };
+    auto *dst { static_cast<UInt8*>(dstImage->shm()->map()) };
+
+    for (SkRegion::Iterator it(*missed); !it.done(); it.next())
+    {
+        const SkIRect &r { it.rect() };
+        const size_t offset { r.y() * stride + r.x() * bpp };
+        const size_t width { r.width() * bpp };
+
+        for (Int32 y = 0; y < r.height(); y++)
+            std::memcpy(dst + offset + y * stride, src + offset + y * stride, width);
+    }
+
     return true;
 }
 
@@ -16,6 +16,9 @@
  * Buffers are recycled based on compositor release events: acquire() reuses the least recently used
  * released buffer (resizing it if needed) or allocates a new one, and surplus buffers are freed
  * once enough frames have elapsed. Only one image may be acquired at a time.
+ *
+ * In copy-forward mode (see setCopyForward()) older buffers are brought up to date with the last
+ * presented one, so the client only repaints the damage of the current frame.
  */
 class CZ::RRSSwapchainWL : public RWLSwapchain
 {
@@ -46,6 +49,24 @@ public:
      * @return false if @p size is empty, true otherwise.
      */
     bool resize(SkISize size) noexcept override;
+
+    /**
+     * @brief Enables or disables copy-forward mode (disabled by default).
+     *
+     * When enabled and a damage tracker is set, acquire() copies the damage of the frames an older
+     * buffer missed from the last presented buffer and reports it with age 1, so that the client only
+     * repaints the current frame damage instead of the union of several frames.
+     * If the copy would exceed @p maxRatio of the buffer area, the buffer keeps its real age.
+     *
+     * @param enabled  Whether to copy forward.
+     * @param maxRatio Maximum copied area relative to the buffer area, in the range [0, 1].
+     */
+    void setCopyForward(bool enabled, SkScalar maxRatio = 0.5f) noexcept;
+
+    /**
+     * @brief Whether copy-forward mode is enabled.
+     */
+    bool copyForward() const noexcept { return m_copyForward; }
 private:
     friend class RWLSwapchain;
 
@@ -66,10 +87,14 @@ private:
     static std::shared_ptr<RRSSwapchainWL> Make(wl_surface *surface, SkISize size) noexcept;
     RRSSwapchainWL(std::shared_ptr<RRSCore> core, RRSDevice *device, wl_surface *surface, SkISize size) noexcept;
     void freeForgottenBuffers() noexcept;
+    bool copyForwardInto(Buffer &buffer) noexcept;
     std::shared_ptr<RRSCore> m_core;
     RRSDevice *m_device;
     std::vector<std::shared_ptr<Buffer>> m_buffers;
     std::unordered_set<UInt32> m_releasedIdx;
+    std::weak_ptr<Buffer> m_lastPresented;
+    SkScalar m_copyForwardMaxRatio { 0.5f };
+    bool m_copyForward { false };
     bool m_acquired { false };
 };
 
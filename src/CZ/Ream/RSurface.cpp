@@ -114,6 +114,10 @@ bool RSurface::resize(SkISize size, SkScalar scale, bool shrink) noexcept
     c.writeFormats = m_image->writeFormats();
     c.caps[c.allocator] = m_image->checkDeviceCaps(RImageCap_All, c.allocator);
 
+    // Mipmaps stay opt-in, only kept if the current image has them
+    if (m_image->mipmaps())
+        c.caps[c.allocator].add(RImageCap_Mipmaps);
+
     auto image { RImage::Make(imageSize, { m_image->formatInfo().format, { m_image->modifier() } }, &c) };
 
     if (image)
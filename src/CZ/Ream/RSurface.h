@@ -7,7 +7,9 @@
 #include <CZ/Ream/RSurfaceGeometry.h>
 #include <CZ/Ream/RPassCap.h>
 #include <CZ/skia/core/SkRect.h>
+#include <CZ/skia/core/SkRegion.h>
 #include <memory>
+#include <optional>
 
 namespace CZ { struct RImageConstraints; }
 
@@ -94,6 +96,21 @@ public:
      */
     bool resize(SkISize size, SkScalar scale, bool shrink = false) noexcept;
 
+    /**
+     * @brief Restricts rendering of subsequent passes to a region of the image (partial redraw).
+     *
+     * Passes created after this call clip both SkCanvas and RPainter draws to the region,
+     * e.g. to RSwapchain::repaintRegion() when rendering into an aged swapchain image.
+     *
+     * @param region Region in image (buffer) coordinates, or nullopt to disable clipping (default).
+     */
+    void setRepaintRegion(const std::optional<SkRegion> &region) noexcept { m_repaintRegion = region; }
+
+    /**
+     * @brief Returns the region set with setRepaintRegion().
+     */
+    const std::optional<SkRegion> &repaintRegion() const noexcept { return m_repaintRegion; }
+
     /**
      * @brief Destructor.
      */
@@ -102,6 +119,7 @@ private:
     RSurface(std::shared_ptr<RImage> image) noexcept;
     std::shared_ptr<RImage> m_image;
     RSurfaceGeometry m_geometry {};
+    std::optional<SkRegion> m_repaintRegion;
     std::weak_ptr<RSurface> m_self;
 };
 
@@ -0,0 +1,47 @@
+#include <CZ/Ream/RSwapchain.h>
+#include <CZ/Ream/RDamageTracker.h>
+#include <CZ/Ream/RImage.h>
+
+using namespace CZ;
+
+SkRegion RSwapchain::repaintRegion(const RSwapchainImage &image) const noexcept
+{
+    if (!image.image)
+        return {};
+
+    // The tracker is resized by acquire(), a different size means it was set afterwards
+    if (!m_damageTracker || m_damageTracker->size() != image.image->size())
+        return SkRegion(SkIRect::MakeSize(image.image->size()));
+
+    return m_damageTracker->repaintRegion(image.age);
+}
+
+bool RSwapchain::setRepaintRegion(const RSwapchainImage &image, const SkRegion &region) noexcept
+{
+    CZ_UNUSED(image)
+    CZ_UNUSED(region)
+    return false;
+}
+
+void RSwapchain::acquireDamage(SkISize size) noexcept
+{
+    if (m_damageTracker)
+        m_damageTracker->resize(size);
+}
+
+SkRegion *RSwapchain::commitDamage(const RSwapchainImage &image, SkRegion *damage, SkRegion &storage) noexcept
+{
+    if (!m_damageTracker)
+        return damage;
+
+    m_damageTracker->resize(image.image->size());
+
+    if (damage)
+        m_damageTracker->addDamage(*damage);
+    else
+        m_damageTracker->damageAll();
+
+    storage = m_damageTracker->damage();
+    m_damageTracker->endFrame();
+    return &storage;
+}
@@ -2,6 +2,7 @@
 #define RSWAPCHAIN_H
 
 #include <CZ/skia/core/SkSize.h>
+#include <CZ/skia/core/SkRegion.h>
 #include <CZ/Ream/RObject.h>
 #include <memory>
 #include <optional>
@@ -30,6 +31,16 @@ namespace CZ
         /// Index of this image within the swapchain.
         UInt32 index;
     };
+
+    /**
+     * @brief Presentation mode of an RSwapchain.
+     */
+    enum class RPresentMode
+    {
+        FIFO,     ///< Presents are shown in order at vblank, never tears (default).
+        Mailbox,  ///< Only the latest present is shown at vblank, lower latency without tearing.
+        Immediate ///< Presents are shown as soon as possible, lowest latency but may tear.
+    };
 };
 
 /**
@@ -68,6 +79,8 @@ public:
      *                - May extend beyond the image bounds.
      *                - Passing @c nullptr indicates full damage.
      *                - Passing an empty region indicates no damage.
+     *                - If a damage tracker is set, it is added to the tracker's current frame damage
+     *                  (@c nullptr damages the whole image) and the accumulated damage is presented instead.
      *
      * @return @c true if the presentation succeeded, otherwise @c false.
      */
@@ -83,9 +96,72 @@ public:
      * @return @c true if the resize request was accepted, otherwise @c false.
      */
     virtual bool resize(SkISize size) noexcept = 0;
+
+    /**
+     * @brief Sets the damage tracker fed by present().
+     *
+     * Damage added to the tracker between acquire() and present() becomes the damage of the frame.
+     * Pass @c nullptr to disable tracking (default).
+     */
+    void setDamageTracker(std::shared_ptr<RDamageTracker> tracker) noexcept { m_damageTracker = tracker; }
+
+    /**
+     * @brief Returns the damage tracker, or @c nullptr if not set.
+     */
+    const std::shared_ptr<RDamageTracker> &damageTracker() const noexcept { return m_damageTracker; }
+
+    /**
+     * @brief Returns the region that must be redrawn into the given image, in buffer coordinates.
+     *
+     * Based on the image age and the damage tracker history, see RDamageTracker::repaintRegion().
+     * Returns the entire image if no damage tracker is set.
+     *
+     * @note The current frame damage must be added to the tracker before calling it.
+     */
+    SkRegion repaintRegion(const RSwapchainImage &image) const noexcept;
+
+    /**
+     * @brief Declares the region of an acquired image that is going to be repainted.
+     *
+     * Must be called after acquire() and before rendering into the image, at most once per frame.
+     * Backends able to skip loading the rest of the image (EGL_KHR_partial_update) take advantage of it,
+     * in which case pixels outside the region must be left untouched, e.g. by also passing it to
+     * RSurface::setRepaintRegion() so that the painter and Skia clip to it.
+     *
+     * @param image  The acquired image.
+     * @param region Region in buffer coordinates, typically repaintRegion().
+     * @return @c true if the backend uses the region, @c false if it is ignored.
+     */
+    virtual bool setRepaintRegion(const RSwapchainImage &image, const SkRegion &region) noexcept;
+
+    /**
+     * @brief Sets the presentation mode used from the next acquire() on.
+     *
+     * Backends fall back to the closest supported mode (Immediate to Mailbox to FIFO, Mailbox to FIFO),
+     * and ignore it if the platform paces presentation itself.
+     *
+     * @note The GL Wayland swapchain never blocks in present() (swap interval 0) unless FIFO is set
+     *       explicitly with this function.
+     */
+    void setPresentMode(RPresentMode mode) noexcept { m_presentMode = mode; m_presentModeSet = true; }
+
+    /**
+     * @brief Returns the requested presentation mode, RPresentMode::FIFO by default.
+     */
+    RPresentMode presentMode() const noexcept { return m_presentMode; }
 protected:
+    /* Called by each acquire() implementation with the size of the acquired image.
+     * Resizes the damage tracker, clearing its history if the size changed */
+    void acquireDamage(SkISize size) noexcept;
+
+    /* Called at the top of each present() implementation. Ends the damage tracker frame
+     * and returns the damage to present (storage or damage if there is no tracker) */
+    SkRegion *commitDamage(const RSwapchainImage &image, SkRegion *damage, SkRegion &storage) noexcept;
     SkISize m_size;
     UInt32 m_frame { 0 };
+    RPresentMode m_presentMode { RPresentMode::FIFO };
+    bool m_presentModeSet { false }; // True once setPresentMode() is called
+    std::shared_ptr<RDamageTracker> m_damageTracker;
 };
 
 #endif // RSWAPCHAIN_H
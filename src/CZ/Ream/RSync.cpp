@@ -5,6 +5,7 @@
 #include <CZ/Ream/VK/RVKSync.h>
 #include <CZ/Ream/VK/RVKDevice.h>
 #include <CZ/Ream/RResourceTracker.h>
+#include <CZ/Ream/RProfiler.h>
 #include <fcntl.h>
 
 using namespace CZ;
@@ -42,16 +43,20 @@ std::shared_ptr<RSync> RSync::Make(RDevice *device) noexcept
         return {};
     }
 
-    if (core->asGL())
-        return RGLSync::Make((RGLDevice*)device);
+    std::shared_ptr<RSync> sync;
 
-    if (core->asVK())
+    if (core->asGL())
+        sync = RGLSync::Make((RGLDevice*)device);
+    else if (core->asVK())
     {
         RVKDevice *vk { device ? device->asVK() : core->mainDevice()->asVK() };
-        return RVKSync::Make(vk);
+        sync = RVKSync::Make(vk);
     }
 
-    return {};
+    if (sync)
+        RProfiler::Count(RProfiler::Fences);
+
+    return sync;
 }
 
 RSync::RSync(std::shared_ptr<RCore> core, RDevice *device, bool isExternal) noexcept :
@@ -0,0 +1,329 @@
+#include <CZ/Ream/RYUVConverter.h>
+#include <CZ/Ream/RDMABufferInfo.h>
+#include <CZ/Ream/RSurface.h>
+#include <CZ/Ream/RPainter.h>
+#include <CZ/Ream/RImage.h>
+#include <CZ/Ream/RCore.h>
+#include <CZ/Ream/RPass.h>
+#include <CZ/Ream/RLog.h>
+#include <CZ/skia/core/SkSurface.h>
+#include <CZ/skia/core/SkPixmap.h>
+#include <CZ/skia/core/SkImage.h>
+#include <drm_fourcc.h>
+#include <cstring>
+#include <vector>
+#include <bit>
+
+using namespace CZ;
+
+static SkISize ChromaSize(SkISize size) noexcept
+{
+    return { (size.width() + 1) / 2, (size.height() + 1) / 2 };
+}
+
+// Rounds the rect out to even coordinates (whole 2x2 blocks)
+static SkIRect EvenRect(const SkIRect &rect) noexcept
+{
+    return SkIRect::MakeLTRB(rect.fLeft & ~1, rect.fTop & ~1, (rect.fRight + 1) & ~1, (rect.fBottom + 1) & ~1);
+}
+
+std::shared_ptr<RYUVConverter> RYUVConverter::Make(SkISize size, RFormat format, const RImageConstraints *constraints) noexcept
+{
+    if (size.isEmpty())
+    {
+        RLog(CZError, CZLN, "Invalid size {}x{}", size.width(), size.height());
+        return {};
+    }
+
+    if (format != DRM_FORMAT_NV12 && format != DRM_FORMAT_P010)
+    {
+        RLog(CZError, CZLN, "Unsupported format {}, expected NV12 or P010", RDRMFormat::FormatName(format));
+        return {};
+    }
+
+    auto core { RCore::Get() };
+
+    if (!core)
+    {
+        RLog(CZError, CZLN, "Missing RCore");
+        return {};
+    }
+
+    RImageConstraints cons {};
+
+    if (constraints)
+        cons = *constraints;
+
+    if (!cons.allocator)
+        cons.allocator = core->mainDevice();
+
+    cons.caps[cons.allocator].add(RImageCap_Dst);
+
+    const bool p010 { format == DRM_FORMAT_P010 };
+    auto luma { RImage::Make(size, { p010 ? DRM_FORMAT_R16 : DRM_FORMAT_R8, { DRM_FORMAT_MOD_INVALID } }, &cons) };
+    auto chroma { RImage::Make(ChromaSize(size), { p010 ? DRM_FORMAT_GR1616 : DRM_FORMAT_GR88, { DRM_FORMAT_MOD_INVALID } }, &cons) };
+
+    if (!luma || !chroma)
+    {
+        RLog(CZError, CZLN, "Failed to create the {} planes", RDRMFormat::FormatName(format));
+        return {};
+    }
+
+    return std::shared_ptr<RYUVConverter>(new RYUVConverter(format, size, luma, chroma));
+}
+
+std::shared_ptr<RYUVConverter> RYUVConverter::MakeFromDMA(const RDMABufferInfo &info) noexcept
+{
+    if (!info.isValid())
+        return {};
+
+    if (info.format != DRM_FORMAT_NV12 && info.format != DRM_FORMAT_P010)
+    {
+        RLog(CZError, CZLN, "Unsupported format {}, expected NV12 or P010", RDRMFormat::FormatName(info.format));
+        return {};
+    }
+
+    if (info.planeCount != 2)
+    {
+        RLog(CZError, CZLN, "Expected 2 planes, got {}", info.planeCount);
+        return {};
+    }
+
+    const bool p010 { info.format == DRM_FORMAT_P010 };
+    const SkISize size { info.width, info.height };
+    const SkISize chromaSize { ChromaSize(size) };
+
+    RDMABufferInfo plane {};
+    plane.modifier = info.modifier;
+    plane.planeCount = 1;
+
+    plane.width = size.width();
+    plane.height = size.height();
+    plane.format = p010 ? DRM_FORMAT_R16 : DRM_FORMAT_R8;
+    plane.offset[0] = info.offset[0];
+    plane.stride[0] = info.stride[0];
+    plane.fd[0] = info.fd[0];
+    auto luma { RImage::FromDMA(plane, CZOwn::Borrow) };
+
+    plane.width = chromaSize.width();
+    plane.height = chromaSize.height();
+    plane.format = p010 ? DRM_FORMAT_GR1616 : DRM_FORMAT_GR88;
+    plane.offset[0] = info.offset[1];
+    plane.stride[0] = info.stride[1];
+    plane.fd[0] = info.fd[1];
+    auto chroma { RImage::FromDMA(plane, CZOwn::Borrow) };
+
+    if (!luma || !chroma)
+    {
+        RLog(CZError, CZLN, "Failed to import the {} planes", RDRMFormat::FormatName(info.format));
+        return {};
+    }
+
+    return std::shared_ptr<RYUVConverter>(new RYUVConverter(info.format, size, luma, chroma));
+}
+
+RYUVConverter::RYUVConverter(RFormat format, SkISize size, std::shared_ptr<RImage> luma, std::shared_ptr<RImage> chroma) noexcept :
+    m_format(format),
+    m_size(size),
+    m_luma(luma),
+    m_chroma(chroma),
+    m_lumaSurface(RSurface::WrapImage(luma)),
+    m_chromaSurface(RSurface::WrapImage(chroma))
+{
+    const SkISize chromaSize { ChromaSize(size) };
+
+    // The chroma viewport is the frame rounded up to whole 2x2 blocks, each chroma pixel center
+    // then maps to the corner shared by its 4 luma pixels
+    m_lumaSurface->setGeometry({
+        .viewport = SkRect::Make(size),
+        .dst = SkRect::Make(size) });
+
+    m_chromaSurface->setGeometry({
+        .viewport = SkRect::MakeWH(chromaSize.width() * 2, chromaSize.height() * 2),
+        .dst = SkRect::Make(chromaSize) });
+}
+
+bool RYUVConverter::convert(std::shared_ptr<RImage> src, const SkRegion *damage, RDevice *device) noexcept
+{
+    if (!src)
+    {
+        RLog(CZError, CZLN, "Missing source RImage");
+        return false;
+    }
+
+    const SkISize blocks { ChromaSize(m_size) };
+    const SkIRect frame { SkIRect::MakeWH(blocks.width() * 2, blocks.height() * 2) };
+    SkRegion region;
+
+    if (damage)
+    {
+        std::vector<SkIRect> rects;
+        rects.reserve(damage->computeRegionComplexity());
+
+        for (SkRegion::Iterator it(*damage); !it.done(); it.next())
+            rects.emplace_back(EvenRect(it.rect()));
+
+        region.setRects(rects.data(), rects.size());
+        region.op(frame, SkRegion::kIntersect_Op);
+    }
+    else
+        region.setRect(frame);
+
+    if (region.isEmpty())
+        return true;
+
+    if (src->asRS() && m_luma->asRS() && convertRS(src.get(), region))
+        return true;
+
+    // The source is stretched over the whole blocks, the extra column/row of odd sizes samples the clamped edge
+    RDrawImageInfo info {};
+    info.image = src;
+    info.src = SkRect::MakeWH(
+        src->size().width() * SkScalar(frame.width()) / SkScalar(m_size.width()),
+        src->size().height() * SkScalar(frame.height()) / SkScalar(m_size.height()));
+    info.dst = frame;
+    info.minFilter = info.magFilter = RImageFilter::Linear;
+
+    bool ok { true };
+
+    {
+        auto pass { m_lumaSurface->beginPass(RPassCap_Painter, device) };
+        auto *painter { pass ? pass->getPainter() : nullptr };
+        ok = painter && painter->drawImageEffect(info, RPainter::YUVLuma, &region);
+    }
+
+    if (ok)
+    {
+        auto pass { m_chromaSurface->beginPass(RPassCap_Painter, device) };
+        auto *painter { pass ? pass->getPainter() : nullptr };
+        ok = painter && painter->drawImageEffect(info, RPainter::YUVChroma, &region);
+    }
+
+    if (!ok)
+        RLog(CZError, CZLN, "Failed to convert the source RImage");
+
+    return ok;
+}
+
+/* Raster fast path (NV12 from 8888 at the frame size), 4 pixels per step with the compiler vector
+ * extensions (SSE2 or NEON, see the RRSPainter kernels). BT.709 limited range in 8.8 fixed point */
+typedef Int32 RYI4 __attribute__((vector_size(16)));
+
+static inline void Unpack4(const UInt32 *src, int rShift, int bShift, RYI4 &r, RYI4 &g, RYI4 &b) noexcept
+{
+    RYI4 v;
+    std::memcpy(&v, src, sizeof(v));
+    r = (v >> rShift) & 0xFF;
+    g = (v >> 8) & 0xFF;
+    b = (v >> bShift) & 0xFF;
+}
+
+static inline RYI4 Luma4(RYI4 r, RYI4 g, RYI4 b) noexcept
+{
+    return ((47 * r + 157 * g + 16 * b + 128) >> 8) + 16;
+}
+
+// Two rows of an even span [x, x + count) of a 2x2 block aligned rect
+static void ConvertRows(const UInt32 *row0, const UInt32 *row1, UInt8 *y0, UInt8 *y1, UInt8 *uv, int count, int rShift, int bShift) noexcept
+{
+    int i { 0 };
+
+    for (; i + 4 <= count; i += 4)
+    {
+        RYI4 r0, g0, b0, r1, g1, b1;
+        Unpack4(row0 + i, rShift, bShift, r0, g0, b0);
+        Unpack4(row1 + i, rShift, bShift, r1, g1, b1);
+
+        const RYI4 l0 { Luma4(r0, g0, b0) };
+        const RYI4 l1 { Luma4(r1, g1, b1) };
+
+        for (int j = 0; j < 4; j++)
+        {
+            y0[i + j] = l0[j];
+            y1[i + j] = l1[j];
+        }
+
+        // Vertical sums, then the horizontal pairs (2x2 block sums)
+        const RYI4 r { r0 + r1 }, g { g0 + g1 }, b { b0 + b1 };
+
+        for (int j = 0; j < 2; j++)
+        {
+            const Int32 sr { r[j * 2] + r[j * 2 + 1] };
+            const Int32 sg { g[j * 2] + g[j * 2 + 1] };
+            const Int32 sb { b[j * 2] + b[j * 2 + 1] };
+            uv[i + j * 2]     = ((-26 * sr - 86 * sg + 112 * sb + 512) >> 10) + 128;
+            uv[i + j * 2 + 1] = ((112 * sr - 102 * sg - 10 * sb + 512) >> 10) + 128;
+        }
+    }
+
+    for (; i < count; i += 2)
+    {
+        Int32 sr {}, sg {}, sb {};
+
+        for (int j = 0; j < 2; j++)
+        {
+            const UInt32 p0 { row0[i + j] }, p1 { row1[i + j] };
+            const Int32 pr0 ((p0 >> rShift) & 0xFF), pg0 ((p0 >> 8) & 0xFF), pb0 ((p0 >> bShift) & 0xFF);
+            const Int32 pr1 ((p1 >> rShift) & 0xFF), pg1 ((p1 >> 8) & 0xFF), pb1 ((p1 >> bShift) & 0xFF);
+            y0[i + j] = ((47 * pr0 + 157 * pg0 + 16 * pb0 + 128) >> 8) + 16;
+            y1[i + j] = ((47 * pr1 + 157 * pg1 + 16 * pb1 + 128) >> 8) + 16;
+            sr += pr0 + pr1;
+            sg += pg0 + pg1;
+            sb += pb0 + pb1;
+        }
+
+        uv[i]     = ((-26 * sr - 86 * sg + 112 * sb + 512) >> 10) + 128;
+        uv[i + 1] = ((112 * sr - 102 * sg - 10 * sb + 512) >> 10) + 128;
+    }
+}
+
+bool RYUVConverter::convertRS(RImage *src, const SkRegion &region) noexcept
+{
+    if constexpr (std::endian::native != std::endian::little)
+        return false;
+
+    // Odd sizes would need the clamped edge, left to the painter
+    if (m_format != DRM_FORMAT_NV12 || src->size() != m_size || (m_size.width() & 1) || (m_size.height() & 1))
+        return false;
+
+    int rShift, bShift;
+
+    switch (src->formatInfo().format)
+    {
+    case DRM_FORMAT_ARGB8888:
+    case DRM_FORMAT_XRGB8888:
+        rShift = 16; bShift = 0;
+        break;
+    case DRM_FORMAT_ABGR8888:
+    case DRM_FORMAT_XBGR8888:
+        rShift = 0; bShift = 16;
+        break;
+    default:
+        return false;
+    }
+
+    SkPixmap srcPixels, lumaPixels, chromaPixels;
+    auto lumaSurface { m_luma->skSurface() };
+    auto chromaSurface { m_chroma->skSurface() };
+
+    if (!src->skImage() || !src->skImage()->peekPixels(&srcPixels) || !lumaSurface || !chromaSurface ||
+        !lumaSurface->peekPixels(&lumaPixels) || !chromaSurface->peekPixels(&chromaPixels))
+        return false;
+
+    lumaSurface->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+    chromaSurface->notifyContentWillChange(SkSurface::kRetain_ContentChangeMode);
+
+    for (SkRegion::Iterator it(region); !it.done(); it.next())
+    {
+        const SkIRect &r { it.rect() };
+
+        for (int y = r.fTop; y < r.fBottom; y += 2)
+            ConvertRows(
+                srcPixels.addr32(r.fLeft, y), srcPixels.addr32(r.fLeft, y + 1),
+                lumaPixels.writable_addr8(r.fLeft, y), lumaPixels.writable_addr8(r.fLeft, y + 1),
+                static_cast<UInt8*>(chromaPixels.writable_addr(r.fLeft / 2, y / 2)),
+                r.width(), rShift, bShift);
+    }
+
+    return true;
+}
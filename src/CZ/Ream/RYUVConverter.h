@@ -0,0 +1,93 @@
+#ifndef CZ_RYUVCONVERTER_H
+#define CZ_RYUVCONVERTER_H
+
+#include <CZ/Ream/RObject.h>
+#include <CZ/skia/core/SkRegion.h>
+#include <memory>
+
+namespace CZ { struct RImageConstraints; }
+
+/**
+ * @brief Converts RGB images into NV12 or P010 planes, e.g. for screencasting and remote desktop.
+ *
+ * Instead of reading back full RGBA frames and converting them on the CPU, the frame is rendered into a
+ * luma plane (R8 or R16) and a half resolution chroma plane (GR88 or GR1616) with RPainter::drawImageEffect()
+ * (RPainter::YUVLuma and RPainter::YUVChroma), so encoders receive 1.5 bytes (NV12) or 3 bytes (P010)
+ * per pixel. The output is BT.709 limited range: 8 bit levels for NV12, and 10 bit levels (64-940 luma,
+ * 64-960 chroma) stored in the upper 10 bits of each 16 bit sample for P010.
+ *
+ * The planes can either be allocated by the converter or imported from a 2 plane NV12/P010 DMA-buf
+ * (e.g. a GBM or VA-API surface), in which case the GPU backends render straight into it.
+ * On the Raster backend 8888 sources are converted with a SIMD kernel.
+ *
+ * Alpha is ignored, transparent regions are converted as if composited over black.
+ */
+class CZ::RYUVConverter final : public RObject
+{
+public:
+    /**
+     * @brief Allocates the planes of a frame.
+     *
+     * @param size        Frame size in pixels, odd sizes get a rounded up chroma plane.
+     * @param format      DRM_FORMAT_NV12 or DRM_FORMAT_P010.
+     * @param constraints Optional constraints applied to both planes, e.g. to require RImageCap_GBMBo for
+     *                    exporting them. RImageCap_Dst is always added for the allocator device.
+     * @return The converter, or nullptr on failure.
+     */
+    [[nodiscard]] static std::shared_ptr<RYUVConverter> Make(SkISize size, RFormat format, const RImageConstraints *constraints = nullptr) noexcept;
+
+    /**
+     * @brief Imports the planes of an NV12 or P010 DMA-buf (GL and VK only).
+     *
+     * Each plane is imported as a single plane R8/GR88 (R16/GR1616) image, the buffer's modifier must
+     * therefore describe planes that are independent of each other (e.g. DRM_FORMAT_MOD_LINEAR).
+     *
+     * @param info The buffer, with 2 planes. The caller keeps the ownership of its file descriptors.
+     * @return The converter, or nullptr on failure.
+     */
+    [[nodiscard]] static std::shared_ptr<RYUVConverter> MakeFromDMA(const RDMABufferInfo &info) noexcept;
+
+    /**
+     * @brief Renders @p src into the planes.
+     *
+     * The source is scaled to fit the frame. Only @p damage is converted, the rest of the planes keep their
+     * previous content. Damage rects are rounded out to even coordinates so that every chroma sample covers
+     * its whole 2x2 luma block.
+     *
+     * @param src    The RGB source image.
+     * @param damage Damage in frame coordinates, or nullptr to convert the whole frame.
+     * @param device The device used for rendering, or nullptr for the main device.
+     * @return true on success, false otherwise.
+     */
+    bool convert(std::shared_ptr<RImage> src, const SkRegion *damage = nullptr, RDevice *device = nullptr) noexcept;
+
+    /**
+     * @brief DRM_FORMAT_NV12 or DRM_FORMAT_P010.
+     */
+    RFormat format() const noexcept { return m_format; }
+
+    /**
+     * @brief Frame size in pixels (the size of luma()).
+     */
+    SkISize size() const noexcept { return m_size; }
+
+    /**
+     * @brief The Y plane (R8 or R16).
+     */
+    std::shared_ptr<RImage> luma() const noexcept { return m_luma; }
+
+    /**
+     * @brief The interleaved CbCr plane at half resolution (GR88 or GR1616).
+     */
+    std::shared_ptr<RImage> chroma() const noexcept { return m_chroma; }
+
+private:
+    RYUVConverter(RFormat format, SkISize size, std::shared_ptr<RImage> luma, std::shared_ptr<RImage> chroma) noexcept;
+    bool convertRS(RImage *src, const SkRegion &region) noexcept;
+    RFormat m_format;
+    SkISize m_size;
+    std::shared_ptr<RImage> m_luma, m_chroma;
+    std::shared_ptr<RSurface> m_lumaSurface, m_chromaSurface;
+};
+
+#endif // CZ_RYUVCONVERTER_H
@@ -82,7 +82,13 @@ namespace CZ
     class RMatrixUtils;
     class RGammaLUT;
     class RSwapchain;
+    class RProfiler;
+    class RDamageTracker;
+    class RYUVConverter;
+    class RImageLoader;
     struct RDMABufferInfo;
+    struct RColorDescription;
+    struct RDeviceMemory;
 
     // GL/EGL
     class RGLCore;
@@ -97,6 +103,7 @@ namespace CZ
 
     class RGLStrings;
     class RGLMakeCurrent;
+    class RGLState;
     class RGLContextData;
     class RGLContextDataManager;
     struct RGLThreadDataManager;
@@ -121,6 +128,9 @@ namespace CZ
     class RRSPainter;
     class RRSPass;
     class RRSSwapchainWL;
+
+    // Skia
+    class RSKPersistentCache;
 }
 
 #endif
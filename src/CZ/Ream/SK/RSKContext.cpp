@@ -1,4 +1,7 @@
 #include <CZ/Ream/SK/RSKContext.h>
+#include <CZ/Ream/SK/RSKPersistentCache.h>
+#include <unordered_map>
+#include <mutex>
 
 using namespace CZ;
 
@@ -12,7 +15,7 @@ struct SKGrOptions : public GrContextOptions
         fDisableGpuYUVConversion = true;
         fReducedShaderVariations = false;
         fSuppressPrints = true;
-        fSuppressMipmapSupport = true;
+        fSuppressMipmapSupport = false; // Mipmapped SkImages are only created on request
         fSkipGLErrorChecks = GrContextOptions::Enable::kYes;
         fBufferMapThreshold = -1;
         fDisableDistanceFieldPaths = true;
@@ -34,3 +37,24 @@ GrContextOptions &CZ::GetSKContextOptions() noexcept
     static SKGrOptions s_options {};
     return s_options;
 }
+
+GrContextOptions CZ::MakeSKContextOptions(const std::string &deviceKey) noexcept
+{
+    // Caches must outlive every GrDirectContext using them
+    static std::mutex s_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<RSKPersistentCache>> s_caches;
+
+    GrContextOptions options { GetSKContextOptions() };
+
+    if (options.fPersistentCache)
+        return options;
+
+    std::lock_guard lock { s_mutex };
+    auto it { s_caches.find(deviceKey) };
+
+    if (it == s_caches.end())
+        it = s_caches.emplace(deviceKey, RSKPersistentCache::Make(deviceKey)).first;
+
+    options.fPersistentCache = it->second.get();
+    return options;
+}
@@ -2,6 +2,7 @@
 #define CZ_RSKCONTEXT_H
 
 #include <CZ/skia/gpu/ganesh/GrContextOptions.h>
+#include <string>
 
 namespace CZ
 {
@@ -11,6 +12,16 @@ namespace CZ
      * The returned reference can be modified before creating an RCore to customize the options.
      */
     GrContextOptions &GetSKContextOptions() noexcept;
+
+    /**
+     * @brief Returns a copy of GetSKContextOptions() for a specific device.
+     *
+     * If no `fPersistentCache` was set by the user, a disk-backed RSKPersistentCache is assigned, shared
+     * by every context created with the same device key.
+     *
+     * @param deviceKey Description of the device and driver (see RSKPersistentCache::Make()).
+     */
+    GrContextOptions MakeSKContextOptions(const std::string &deviceKey) noexcept;
 };
 
 #endif // CZ_RSKCONTEXT_H
@@ -0,0 +1,219 @@
+#include <CZ/Ream/SK/RSKPersistentCache.h>
+#include <CZ/Ream/RLog.h>
+#include <CZ/skia/core/SkMilestone.h>
+#include <CZ/skia/core/SkData.h>
+#include <CZReamVersion.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <format>
+#include <unistd.h>
+
+using namespace CZ;
+namespace fs = std::filesystem;
+
+static constexpr UInt32 EntryMagic { 0x43534b52 }; // RKSC
+static constexpr UInt64 MaxEntrySize { 8 * 1024 * 1024 };
+
+struct EntryHeader
+{
+    UInt32 magic;
+    UInt32 keySize;
+    UInt64 dataSize;
+};
+
+// Stable across runs (unlike std::hash)
+static UInt64 Hash(const void *data, size_t size, UInt64 hash = 0xcbf29ce484222325) noexcept
+{
+    const UInt8 *bytes { static_cast<const UInt8*>(data) };
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+static fs::path RootDir() noexcept
+{
+    if (const char *env { getenv("CZ_REAM_SHADER_CACHE_DIR") }; env && *env)
+        return env;
+
+    if (const char *env { getenv("XDG_CACHE_HOME") }; env && *env)
+        return fs::path(env) / "cz-ream" / "skia";
+
+    if (const char *env { getenv("HOME") }; env && *env)
+        return fs::path(env) / ".cache" / "cz-ream" / "skia";
+
+    return {};
+}
+
+std::shared_ptr<RSKPersistentCache> RSKPersistentCache::Make(const std::string &deviceKey) noexcept
+{
+    if (const char *env { getenv("CZ_REAM_SHADER_CACHE") }; env && atoi(env) == 0)
+        return {};
+
+    const fs::path root { RootDir() };
+
+    if (root.empty())
+    {
+        RLog(CZWarning, CZLN, "No cache directory available, the Skia shader cache is disabled");
+        return {};
+    }
+
+    const std::string fullKey { std::format("{}|skia-m{}|ream-{}", deviceKey, SK_MILESTONE, CZ_REAM_VERSION) };
+    const fs::path dir { root / std::format("{:016x}", Hash(fullKey.data(), fullKey.size())) };
+
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    if (ec)
+    {
+        RLog(CZWarning, CZLN, "Failed to create the Skia shader cache directory {}: {}", dir.string(), ec.message());
+        return {};
+    }
+
+    UInt64 maxSize { 64 };
+
+    if (const char *env { getenv("CZ_REAM_SHADER_CACHE_MAX_MB") }; env && atoi(env) > 0)
+        maxSize = atoi(env);
+
+    auto cache { std::shared_ptr<RSKPersistentCache>(new RSKPersistentCache(dir, maxSize * 1024 * 1024)) };
+    RLog(CZTrace, "Skia shader cache: {} ({} bytes used)", dir.string(), cache->m_size);
+    return cache;
+}
+
+RSKPersistentCache::RSKPersistentCache(const fs::path &dir, UInt64 maxSize) noexcept :
+    m_dir(dir),
+    m_maxSize(maxSize)
+{
+    std::error_code ec;
+
+    for (const auto &entry : fs::directory_iterator(m_dir, ec))
+        if (entry.is_regular_file(ec))
+            m_size += entry.file_size(ec);
+}
+
+fs::path RSKPersistentCache::entryPath(const SkData &key) const noexcept
+{
+    return m_dir / std::format("{:016x}", Hash(key.data(), key.size()));
+}
+
+sk_sp<SkData> RSKPersistentCache::load(const SkData &key)
+{
+    const fs::path path { entryPath(key) };
+    std::ifstream file { path, std::ios::binary };
+
+    if (!file)
+        return nullptr;
+
+    EntryHeader header {};
+
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != EntryMagic ||
+        header.keySize != key.size() ||
+        header.dataSize > MaxEntrySize)
+        return nullptr;
+
+    // Hash collisions are possible, compare the full key
+    std::vector<char> storedKey(header.keySize);
+
+    if (!file.read(storedKey.data(), storedKey.size()) || memcmp(storedKey.data(), key.data(), key.size()) != 0)
+        return nullptr;
+
+    sk_sp<SkData> data { SkData::MakeUninitialized(header.dataSize) };
+
+    if (!file.read(static_cast<char*>(data->writable_data()), header.dataSize))
+        return nullptr;
+
+    // Keeps recently used entries away from eviction
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return data;
+}
+
+void RSKPersistentCache::store(const SkData &key, const SkData &data)
+{
+    if (data.size() > MaxEntrySize)
+        return;
+
+    const fs::path path { entryPath(key) };
+    const fs::path tmpPath { std::format("{}.{}.{}.tmp", path.string(), getpid(), gettid()) };
+    const EntryHeader header { EntryMagic, UInt32(key.size()), data.size() };
+
+    {
+        std::ofstream file { tmpPath, std::ios::binary | std::ios::trunc };
+
+        if (!file ||
+            !file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+            !file.write(static_cast<const char*>(key.data()), key.size()) ||
+            !file.write(static_cast<const char*>(data.data()), data.size()) ||
+            !file.flush())
+        {
+            file.close();
+            std::error_code ec;
+            fs::remove(tmpPath, ec);
+            RLog(CZWarning, CZLN, "Failed to write Skia shader cache entry {}", tmpPath.string());
+            return;
+        }
+    }
+
+    std::error_code ec;
+    const UInt64 prevSize { fs::exists(path, ec) ? fs::file_size(path, ec) : 0 };
+
+    // Atomic, readers see either the previous entry or the new one
+    fs::rename(tmpPath, path, ec);
+
+    if (ec)
+    {
+        fs::remove(tmpPath, ec);
+        return;
+    }
+
+    std::lock_guard lock { m_mutex };
+    m_size += sizeof(header) + key.size() + data.size();
+    m_size -= std::min(m_size, prevSize);
+
+    if (m_size > m_maxSize)
+        evict();
+}
+
+void RSKPersistentCache::evict() noexcept
+{
+    struct Entry
+    {
+        fs::path path;
+        fs::file_time_type time;
+        UInt64 size;
+    };
+
+    std::vector<Entry> entries;
+    std::error_code ec;
+    m_size = 0;
+
+    for (const auto &entry : fs::directory_iterator(m_dir, ec))
+    {
+        if (!entry.is_regular_file(ec) || entry.path().extension() == ".tmp")
+            continue;
+
+        entries.emplace_back(entry.path(), entry.last_write_time(ec), entry.file_size(ec));
+        m_size += entries.back().size;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.time < b.time; });
+
+    // Leave some headroom so that eviction does not run on every store
+    const UInt64 target { m_maxSize - m_maxSize / 4 };
+
+    for (const auto &entry : entries)
+    {
+        if (m_size <= target)
+            break;
+
+        if (fs::remove(entry.path, ec))
+            m_size -= std::min(m_size, entry.size);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef CZ_RSKPERSISTENTCACHE_H
+#define CZ_RSKPERSISTENTCACHE_H
+
+#include <CZ/skia/gpu/ganesh/GrContextOptions.h>
+#include <CZ/Ream/Ream.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <mutex>
+
+/**
+ * @brief Disk-backed Skia shader cache shared by the GL and VK backends.
+ *
+ * Stores the program binaries/SPIR-V Skia produces (see `GrContextOptions::fShaderCacheStrategy`) so they are not
+ * recompiled on each process or per-thread GrDirectContext. Each device gets its own directory, named after a hash
+ * of the device/driver description, the Skia milestone and the Ream version, so stale binaries are never loaded.
+ *
+ * Entries are written to a temporary file and renamed, so concurrent processes never read partial entries.
+ * When the cache exceeds its size limit, the least recently used entries are removed.
+ *
+ * Environment variables:
+ * - `CZ_REAM_SHADER_CACHE=0` disables the cache.
+ * - `CZ_REAM_SHADER_CACHE_DIR` overrides the root directory (default: `$XDG_CACHE_HOME/cz-ream/skia` or `~/.cache/cz-ream/skia`).
+ * - `CZ_REAM_SHADER_CACHE_MAX_MB` sets the size limit per device in MiB (default: 64).
+ */
+class CZ::RSKPersistentCache final : public GrContextOptions::PersistentCache
+{
+public:
+    CZ_DISABLE_COPY(RSKPersistentCache)
+
+    /**
+     * @brief Creates a cache for the given device.
+     *
+     * @param deviceKey Description of the device and driver, e.g. vendor, renderer and driver version strings.
+     * @return The cache or `nullptr` if disabled or the directory could not be created.
+     */
+    [[nodiscard]] static std::shared_ptr<RSKPersistentCache> Make(const std::string &deviceKey) noexcept;
+
+    sk_sp<SkData> load(const SkData &key) override;
+    void store(const SkData &key, const SkData &data) override;
+
+    /**
+     * @brief Directory where the entries of this cache are stored.
+     */
+    const std::filesystem::path &dir() const noexcept { return m_dir; }
+private:
+    RSKPersistentCache(const std::filesystem::path &dir, UInt64 maxSize) noexcept;
+    std::filesystem::path entryPath(const SkData &key) const noexcept;
+    void evict() noexcept;
+    std::filesystem::path m_dir;
+    UInt64 m_maxSize;
+    UInt64 m_size { 0 };
+    std::mutex m_mutex;
+};
+
+#endif // CZ_RSKPERSISTENTCACHE_H
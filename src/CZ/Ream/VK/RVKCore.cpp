@@ -142,13 +142,15 @@ bool RVKCore::initInstanceExtensions() noexcept
             "VK_KHR_wayland_surface"
         };
     }
-    else
+    else if (platform() == RPlatform::DRM)
     {
         // TODO: Add required DRM extensions
         m_requiredInstanceExtensions = {
             VK_KHR_SURFACE_EXTENSION_NAME,
         };
     }
+    else // Offscreen
+        m_requiredInstanceExtensions = {};
 
     for (const auto *ext : m_requiredInstanceExtensions)
     {
@@ -1,6 +1,7 @@
 #include <CZ/Core/Utils/CZStringUtils.h>
 #include <CZ/Ream/DRM/RDRMPlatformHandle.h>
 #include <CZ/Ream/SK/RSKContext.h>
+#include <CZ/Ream/RResourceTracker.h>
 #include <CZ/Ream/VK/RVKDevice.h>
 #include <CZ/Ream/VK/RVKCore.h>
 #include <CZ/Ream/VK/RVKFormat.h>
@@ -10,8 +11,10 @@
 #include <CZ/skia/gpu/ganesh/vk/GrVkDirectContext.h>
 #include <CZ/skia/gpu/vk/VulkanBackendContext.h>
 
+#include <algorithm>
 #include <fcntl.h>
 #include <optional>
+#include <format>
 #include <gbm.h>
 #include <sys/sysmacros.h>
 #include <sys/stat.h>
@@ -72,31 +75,53 @@ RVKDevice::~RVKDevice() noexcept
             // Device teardown: render threads are stopped, so draining every thread's entries from
             // here is safe (no concurrent pool access).
             std::lock_guard<std::mutex> lock { m_garbageMutex };
-            for (auto &g : m_garbage)
+            for (auto &list : m_garbage)
             {
-                g.cleanup();
-                vkDestroyFence(m_device, g.fence, nullptr);
+                for (Garbage *g { list.second.head }; g;)
+                {
+                    Garbage *next { g->m_next };
+                    vkDestroyFence(m_device, g->m_fence, nullptr);
+                    delete g;
+                    g = next;
+                }
             }
             m_garbage.clear();
+
+            for (VkFence fence : m_fencePool)
+                vkDestroyFence(m_device, fence, nullptr);
+            m_fencePool.clear();
         }
 
         {
             std::lock_guard<std::mutex> lock { m_skContextsMutex };
+            for (const auto &ctx : m_skContexts)
+                RResourceTrackerSetSkiaCacheBytes(this, ctx.second.get(), 0);
             m_skContexts.clear();
         }
         m_pipelines.reset();
+        RResourceTrackerSetSkiaCacheBytes(this, m_skContext.get(), 0);
         m_skContext.reset();
         m_allocator.reset();
 
         // Destroy any pending-wait semaphores never consumed by a submission.
-        for (auto &pw : m_pendingWaits)
-            if (pw.second)
-                vkDestroySemaphore(m_device, pw.first, nullptr);
-        m_pendingWaits.clear();
+        for (PendingWait *pw { m_pendingWaits.exchange(nullptr) }; pw;)
+        {
+            PendingWait *next { pw->next };
+            if (pw->owned)
+                vkDestroySemaphore(m_device, pw->semaphore, nullptr);
+            delete pw;
+            pw = next;
+        }
 
         if (m_commandPool != VK_NULL_HANDLE)
             vkDestroyCommandPool(m_device, m_commandPool, nullptr);
 
+        if (m_transferCommandPool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(m_device, m_transferCommandPool, nullptr);
+
+        if (m_transferTimeline != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_device, m_transferTimeline, nullptr);
+
         vkDestroyDevice(m_device, nullptr);
         m_device = VK_NULL_HANDLE;
     }
@@ -122,31 +147,103 @@ void RVKDevice::wait() noexcept
     if (m_device == VK_NULL_HANDLE)
         return;
 
-    std::lock_guard<std::mutex> lock { m_queueMutex };
+    // Requires external synchronization of every queue
+    std::scoped_lock lock { m_transferMutex, m_queueMutex };
     vkDeviceWaitIdle(m_device);
 }
 
+// Fences kept for reuse, a frame rarely has more passes in flight
+static constexpr size_t MaxPooledFences { 64 };
+
 void RVKDevice::clearGarbage() noexcept
 {
     if (m_device == VK_NULL_HANDLE)
         return;
 
-    const auto self { std::this_thread::get_id() };
+    Garbage *ready { nullptr };
+
+    {
+        std::lock_guard<std::mutex> lock { m_garbageMutex };
+        const auto it { m_garbage.find(std::this_thread::get_id()) };
+
+        if (it == m_garbage.end())
+            return;
+
+        // Fences signal in submission order, the first pending one ends the batch
+        GarbageList &list { it->second };
+        Garbage *last { nullptr };
+
+        for (Garbage *g { list.head }; g && vkGetFenceStatus(m_device, g->m_fence) == VK_SUCCESS; g = g->m_next)
+            last = g;
+
+        if (!last)
+            return;
+
+        ready = list.head;
+        list.head = last->m_next;
+        last->m_next = nullptr;
+
+        if (!list.head)
+            m_garbage.erase(it);
+    }
+
+    std::vector<VkFence> fences;
+
+    while (ready)
+    {
+        Garbage *next { ready->m_next };
+        fences.emplace_back(ready->m_fence);
+        delete ready;
+        ready = next;
+    }
+
+    vkResetFences(m_device, fences.size(), fences.data());
+
     std::lock_guard<std::mutex> lock { m_garbageMutex };
-    for (size_t i = 0; i < m_garbage.size();)
+
+    for (VkFence fence : fences)
     {
-        auto &g { m_garbage[i] };
-        // Only free resources on the thread that created them (command-pool external-sync rule).
-        if (g.owner == self && vkGetFenceStatus(m_device, g.fence) == VK_SUCCESS)
+        if (m_fencePool.size() < MaxPooledFences)
+            m_fencePool.emplace_back(fence);
+        else
+            vkDestroyFence(m_device, fence, nullptr);
+    }
+}
+
+VkFence RVKDevice::acquireFence() const noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock { m_garbageMutex };
+
+        if (!m_fencePool.empty())
         {
-            g.cleanup();
-            vkDestroyFence(m_device, g.fence, nullptr);
-            m_garbage[i] = std::move(m_garbage.back());
-            m_garbage.pop_back();
+            const VkFence fence { m_fencePool.back() };
+            m_fencePool.pop_back();
+            return fence;
         }
-        else
-            i++;
     }
+
+    VkFence fence { VK_NULL_HANDLE };
+    VkFenceCreateInfo fi {};
+    fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(m_device, &fi, nullptr, &fence) != VK_SUCCESS)
+        return VK_NULL_HANDLE;
+
+    return fence;
+}
+
+void RVKDevice::recycleFence(VkFence fence) const noexcept
+{
+    if (fence == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock { m_garbageMutex };
+
+    if (m_fencePool.size() < MaxPooledFences)
+        m_fencePool.emplace_back(fence);
+    else
+        vkDestroyFence(m_device, fence, nullptr);
 }
 
 UInt32 RVKDevice::findMemoryType(UInt32 typeBits, VkMemoryPropertyFlags props) const noexcept
@@ -160,190 +257,421 @@ UInt32 RVKDevice::findMemoryType(UInt32 typeBits, VkMemoryPropertyFlags props) c
     return UINT32_MAX;
 }
 
-bool RVKDevice::immediateSubmit(const std::function<void(VkCommandBuffer)> &record) const noexcept
+bool RVKDevice::submit(Submission &submission) const noexcept
 {
-    std::lock_guard<std::mutex> lock { m_queueMutex };
+    Submission *head { m_submissions.load(std::memory_order_relaxed) };
+
+    do
+        submission.next = head;
+    while (!m_submissions.compare_exchange_weak(head, &submission, std::memory_order_release, std::memory_order_relaxed));
 
+    /* Whichever thread finds the queue idle submits everything pushed so far, the others sleep until
+     * it is done and retry if their submission was pushed too late */
+    while (!submission.done.load(std::memory_order_acquire))
+    {
+        if (!m_submitting.exchange(true, std::memory_order_acquire))
+        {
+            processSubmissions();
+            m_submitting.store(false, std::memory_order_release);
+            m_submitting.notify_all();
+        }
+        else
+            m_submitting.wait(true, std::memory_order_acquire);
+    }
+
+    return submission.ok;
+}
+
+void RVKDevice::processSubmissions() const noexcept
+{
+    Submission *list { m_submissions.exchange(nullptr, std::memory_order_acquire) };
+
+    if (!list)
+        return;
+
+    // Pushed LIFO, submitted in push order
+    std::vector<Submission*> batch;
+
+    for (; list; list = list->next)
+        batch.emplace_back(list);
+
+    std::reverse(batch.begin(), batch.end());
+
+    // Taken after the submissions, so waits queued by a thread before its submission are always here
+    PendingWait *waits { m_pendingWaits.exchange(nullptr, std::memory_order_acquire) };
+
+    if (waits)
+    {
+        const auto consumer { std::find_if(batch.begin(), batch.end(), [](Submission *s) { return s->consumeWaits; }) };
+
+        if (consumer == batch.end())
+        {
+            // Left for the next submission that consumes them
+            PendingWait *tail { waits };
+
+            while (tail->next)
+                tail = tail->next;
+
+            PendingWait *head { m_pendingWaits.load(std::memory_order_relaxed) };
+
+            do
+                tail->next = head;
+            while (!m_pendingWaits.compare_exchange_weak(head, waits, std::memory_order_release, std::memory_order_relaxed));
+        }
+        else
+        {
+            while (waits)
+            {
+                PendingWait *next { waits->next };
+                (*consumer)->waits.emplace_back(waits->semaphore);
+                (*consumer)->waitValues.emplace_back(0);
+
+                if (waits->owned)
+                    (*consumer)->ownedWaits.emplace_back(waits->semaphore);
+
+                delete waits;
+                waits = next;
+            }
+        }
+    }
+
+    std::vector<VkSubmitInfo> infos;
+    infos.reserve(batch.size());
+
+    for (Submission *s : batch)
+    {
+        s->waitStages.assign(s->waits.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+        VkSubmitInfo &info { infos.emplace_back() };
+        info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        info.waitSemaphoreCount = s->waits.size();
+        info.pWaitSemaphores = s->waits.data();
+        info.pWaitDstStageMask = s->waitStages.data();
+        info.commandBufferCount = s->cmd != VK_NULL_HANDLE ? 1 : 0;
+        info.pCommandBuffers = s->cmd != VK_NULL_HANDLE ? &s->cmd : nullptr;
+        info.signalSemaphoreCount = s->signal != VK_NULL_HANDLE ? 1 : 0;
+        info.pSignalSemaphores = s->signal != VK_NULL_HANDLE ? &s->signal : nullptr;
+
+        // Only chained when needed, timeline semaphores may be unsupported
+        if (s->signalValue != 0 || std::any_of(s->waitValues.begin(), s->waitValues.end(), [](UInt64 v) { return v != 0; }))
+        {
+            s->timelineInfo = {};
+            s->timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            s->timelineInfo.waitSemaphoreValueCount = s->waitValues.size();
+            s->timelineInfo.pWaitSemaphoreValues = s->waitValues.data();
+            s->timelineInfo.signalSemaphoreValueCount = info.signalSemaphoreCount;
+            s->timelineInfo.pSignalSemaphoreValues = &s->signalValue;
+            info.pNext = &s->timelineInfo;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock { m_queueMutex };
+
+        // A single fence per vkQueueSubmit, so a fenced submission ends each run
+        size_t first { 0 };
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            if (batch[i]->fence == VK_NULL_HANDLE && i + 1 < batch.size())
+                continue;
+
+            const bool ok { vkQueueSubmit(m_graphicsQueue, i - first + 1, &infos[first], batch[i]->fence) == VK_SUCCESS };
+
+            for (size_t j = first; j <= i; j++)
+                batch[j]->ok = ok;
+
+            first = i + 1;
+        }
+    }
+
+    // The submitting threads may destroy their Submission right after this
+    for (Submission *s : batch)
+        s->done.store(true, std::memory_order_release);
+}
+
+VkCommandBuffer RVKDevice::recordOneShot(VkCommandPool pool, const std::function<void(VkCommandBuffer)> &record) const noexcept
+{
     VkCommandBufferAllocateInfo allocInfo {};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = m_commandPool;
+    allocInfo.commandPool = pool;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     allocInfo.commandBufferCount = 1;
 
     VkCommandBuffer cmd { VK_NULL_HANDLE };
     if (vkAllocateCommandBuffers(m_device, &allocInfo, &cmd) != VK_SUCCESS)
-        return false;
+        return VK_NULL_HANDLE;
 
     VkCommandBufferBeginInfo beginInfo {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-    bool ok { false };
-    VkFence fence { VK_NULL_HANDLE };
-
-    // Consume any semaphores queued via queueWait() so this submission waits on them.
-    std::vector<VkSemaphore> waitSems;
-    std::vector<VkPipelineStageFlags> waitStages;
-    std::vector<VkSemaphore> ownedWaits;
-    for (auto &pw : m_pendingWaits)
+    if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS)
     {
-        waitSems.push_back(pw.first);
-        waitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-        if (pw.second)
-            ownedWaits.push_back(pw.first);
+        vkFreeCommandBuffers(m_device, pool, 1, &cmd);
+        return VK_NULL_HANDLE;
     }
-    m_pendingWaits.clear();
-
-    if (vkBeginCommandBuffer(cmd, &beginInfo) != VK_SUCCESS)
-        goto cleanup;
 
     record(cmd);
 
     if (vkEndCommandBuffer(cmd) != VK_SUCCESS)
-        goto cleanup;
-
     {
-        VkFenceCreateInfo fenceInfo {};
-        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        if (vkCreateFence(m_device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
-            goto cleanup;
+        vkFreeCommandBuffers(m_device, pool, 1, &cmd);
+        return VK_NULL_HANDLE;
+    }
 
-        VkSubmitInfo submit {};
-        submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit.waitSemaphoreCount = waitSems.size();
-        submit.pWaitSemaphores = waitSems.data();
-        submit.pWaitDstStageMask = waitStages.data();
-        submit.commandBufferCount = 1;
-        submit.pCommandBuffers = &cmd;
+    return cmd;
+}
 
-        if (vkQueueSubmit(m_graphicsQueue, 1, &submit, fence) != VK_SUCCESS)
-            goto cleanup;
+bool RVKDevice::immediateSubmit(const std::function<void(VkCommandBuffer)> &record) const noexcept
+{
+    VkCommandBuffer cmd { VK_NULL_HANDLE };
 
-        vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
-        ok = true;
+    {
+        std::lock_guard<std::mutex> lock { m_commandPoolMutex };
+        cmd = recordOneShot(m_commandPool, record);
     }
 
-cleanup:
-    if (fence != VK_NULL_HANDLE)
-        vkDestroyFence(m_device, fence, nullptr);
+    if (cmd == VK_NULL_HANDLE)
+        return false;
+
+    const bool ok { submitCommand(cmd) };
+
+    std::lock_guard<std::mutex> lock { m_commandPoolMutex };
     vkFreeCommandBuffers(m_device, m_commandPool, 1, &cmd);
-    for (VkSemaphore s : ownedWaits)
-        vkDestroySemaphore(m_device, s, nullptr);
     return ok;
 }
 
-bool RVKDevice::submitCommand(VkCommandBuffer cmd) const noexcept
+bool RVKDevice::transferSubmit(const std::function<void(VkCommandBuffer)> &release,
+                               const std::function<void(VkCommandBuffer)> &record,
+                               const std::function<void(VkCommandBuffer)> &acquire) const noexcept
 {
-    std::lock_guard<std::mutex> lock { m_queueMutex };
+    if (m_transferQueue == VK_NULL_HANDLE)
+        return false;
+
+    // Timeline values must be signalled in increasing order, so transfers do not overlap each other
+    std::lock_guard<std::mutex> transferLock { m_transferMutex };
+
+    const UInt64 released { m_transferTimelineValue + 1 };
+    const UInt64 transferred { m_transferTimelineValue + 2 };
+    const UInt64 acquired { m_transferTimelineValue + 3 };
+
+    VkCommandBuffer releaseCmd { VK_NULL_HANDLE }, acquireCmd { VK_NULL_HANDLE };
+    const VkCommandBuffer transferCmd { recordOneShot(m_transferCommandPool, record) };
+
+    if (transferCmd == VK_NULL_HANDLE)
+        return false;
 
-    std::vector<VkSemaphore> waitSems;
-    std::vector<VkPipelineStageFlags> waitStages;
-    std::vector<VkSemaphore> ownedWaits;
-    for (auto &pw : m_pendingWaits)
     {
-        waitSems.push_back(pw.first);
-        waitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-        if (pw.second)
-            ownedWaits.push_back(pw.first);
+        std::lock_guard<std::mutex> lock { m_commandPoolMutex };
+
+        UInt64 completed { 0 };
+        m_procs.getSemaphoreCounterValueKHR(m_device, m_transferTimeline, &completed);
+
+        for (size_t i = 0; i < m_transferRetired.size();)
+        {
+            if (m_transferRetired[i].first <= completed)
+            {
+                vkFreeCommandBuffers(m_device, m_commandPool, 1, &m_transferRetired[i].second);
+                m_transferRetired[i] = m_transferRetired.back();
+                m_transferRetired.pop_back();
+            }
+            else
+                i++;
+        }
+
+        releaseCmd = recordOneShot(m_commandPool, release);
+        acquireCmd = recordOneShot(m_commandPool, acquire);
+
+        if (releaseCmd == VK_NULL_HANDLE || acquireCmd == VK_NULL_HANDLE)
+        {
+            if (releaseCmd != VK_NULL_HANDLE)
+                vkFreeCommandBuffers(m_device, m_commandPool, 1, &releaseCmd);
+            if (acquireCmd != VK_NULL_HANDLE)
+                vkFreeCommandBuffers(m_device, m_commandPool, 1, &acquireCmd);
+            vkFreeCommandBuffers(m_device, m_transferCommandPool, 1, &transferCmd);
+            return false;
+        }
     }
-    m_pendingWaits.clear();
 
-    VkFence fence { VK_NULL_HANDLE };
-    VkFenceCreateInfo fi {};
-    fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    if (vkCreateFence(m_device, &fi, nullptr, &fence) != VK_SUCCESS)
+    // After all prior graphics work
+    Submission releaseSubmission {};
+    releaseSubmission.cmd = releaseCmd;
+    releaseSubmission.signal = m_transferTimeline;
+    releaseSubmission.signalValue = released;
+
+    if (!submit(releaseSubmission))
+    {
+        std::lock_guard<std::mutex> lock { m_commandPoolMutex };
+        vkFreeCommandBuffers(m_device, m_commandPool, 1, &releaseCmd);
+        vkFreeCommandBuffers(m_device, m_commandPool, 1, &acquireCmd);
+        vkFreeCommandBuffers(m_device, m_transferCommandPool, 1, &transferCmd);
         return false;
+    }
 
-    VkSubmitInfo submit {};
-    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit.waitSemaphoreCount = waitSems.size();
-    submit.pWaitSemaphores = waitSems.data();
-    submit.pWaitDstStageMask = waitStages.data();
-    submit.commandBufferCount = 1;
-    submit.pCommandBuffers = &cmd;
+    m_transferTimelineValue = released;
+
+    // The transfer queue is only used here, m_transferMutex is enough
+    const VkPipelineStageFlags transferStage { VK_PIPELINE_STAGE_TRANSFER_BIT };
+    VkTimelineSemaphoreSubmitInfo tsi {};
+    tsi.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    tsi.waitSemaphoreValueCount = 1;
+    tsi.pWaitSemaphoreValues = &released;
+    tsi.signalSemaphoreValueCount = 1;
+    tsi.pSignalSemaphoreValues = &transferred;
+
+    VkSubmitInfo transferInfo {};
+    transferInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    transferInfo.pNext = &tsi;
+    transferInfo.waitSemaphoreCount = 1;
+    transferInfo.pWaitSemaphores = &m_transferTimeline;
+    transferInfo.pWaitDstStageMask = &transferStage;
+    transferInfo.commandBufferCount = 1;
+    transferInfo.pCommandBuffers = &transferCmd;
+    transferInfo.signalSemaphoreCount = 1;
+    transferInfo.pSignalSemaphores = &m_transferTimeline;
+
+    bool ok { vkQueueSubmit(m_transferQueue, 1, &transferInfo, VK_NULL_HANDLE) == VK_SUCCESS };
 
-    bool ok { vkQueueSubmit(m_graphicsQueue, 1, &submit, fence) == VK_SUCCESS };
     if (ok)
+    {
+        m_transferTimelineValue = transferred;
+
+        Submission acquireSubmission {};
+        acquireSubmission.cmd = acquireCmd;
+        acquireSubmission.waits.emplace_back(m_transferTimeline);
+        acquireSubmission.waitValues.emplace_back(transferred);
+        acquireSubmission.signal = m_transferTimeline;
+        acquireSubmission.signalValue = acquired;
+        acquireSubmission.consumeWaits = false;
+        ok = submit(acquireSubmission);
+
+        if (ok)
+            m_transferTimelineValue = acquired;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock { m_commandPoolMutex };
+        m_transferRetired.emplace_back(released, releaseCmd);
+
+        if (ok)
+            m_transferRetired.emplace_back(acquired, acquireCmd);
+        else
+        {
+            // Resources are left owned by the transfer family, which only happens on device loss
+            RLog(CZError, CZLN, "{}: Transfer queue submission failed", m_properties.deviceName);
+            vkFreeCommandBuffers(m_device, m_commandPool, 1, &acquireCmd);
+        }
+    }
+
+    // Waits for the release as well, so owned waits can be destroyed
+    const UInt64 waitValue { m_transferTimelineValue >= transferred ? transferred : released };
+    VkSemaphoreWaitInfo waitInfo {};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &m_transferTimeline;
+    waitInfo.pValues = &waitValue;
+    m_procs.waitSemaphoresKHR(m_device, &waitInfo, UINT64_MAX);
+
+    vkFreeCommandBuffers(m_device, m_transferCommandPool, 1, &transferCmd);
+
+    for (VkSemaphore s : releaseSubmission.ownedWaits)
+        vkDestroySemaphore(m_device, s, nullptr);
+
+    return ok;
+}
+
+bool RVKDevice::submitCommand(VkCommandBuffer cmd) const noexcept
+{
+    const VkFence fence { acquireFence() };
+    if (fence == VK_NULL_HANDLE)
+        return false;
+
+    Submission submission {};
+    submission.cmd = cmd;
+    submission.fence = fence;
+
+    const bool ok { submit(submission) };
+
+    if (ok)
+    {
         vkWaitForFences(m_device, 1, &fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(m_device, 1, &fence);
+        recycleFence(fence);
+    }
+    else
+        vkDestroyFence(m_device, fence, nullptr);
 
-    vkDestroyFence(m_device, fence, nullptr);
-    for (VkSemaphore s : ownedWaits)
+    for (VkSemaphore s : submission.ownedWaits)
         vkDestroySemaphore(m_device, s, nullptr);
     return ok;
 }
 
 bool RVKDevice::submitCommandAsync(VkCommandBuffer cmd, VkFence fence, std::vector<VkSemaphore> &ownedWaitsOut,
-                                   VkSemaphore signal) const noexcept
+                                   VkSemaphore signal, VkSemaphore wait) const noexcept
 {
-    std::lock_guard<std::mutex> lock { m_queueMutex };
+    Submission submission {};
+    submission.cmd = cmd;
+    submission.fence = fence;
+    submission.signal = signal;
 
-    std::vector<VkSemaphore> waitSems;
-    std::vector<VkPipelineStageFlags> waitStages;
-    for (auto &pw : m_pendingWaits)
+    if (wait != VK_NULL_HANDLE)
     {
-        waitSems.push_back(pw.first);
-        waitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-        if (pw.second)
-            ownedWaitsOut.push_back(pw.first); // caller destroys these once `fence` signals
+        submission.waits.emplace_back(wait);
+        submission.waitValues.emplace_back(0);
     }
-    m_pendingWaits.clear();
 
-    VkSubmitInfo submit {};
-    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit.waitSemaphoreCount = waitSems.size();
-    submit.pWaitSemaphores = waitSems.data();
-    submit.pWaitDstStageMask = waitStages.data();
-    submit.commandBufferCount = 1;
-    submit.pCommandBuffers = &cmd;
-    submit.signalSemaphoreCount = (signal != VK_NULL_HANDLE) ? 1 : 0;
-    submit.pSignalSemaphores = (signal != VK_NULL_HANDLE) ? &signal : nullptr;
+    const bool ok { submit(submission) };
 
-    return vkQueueSubmit(m_graphicsQueue, 1, &submit, fence) == VK_SUCCESS;
+    // The caller destroys these once `fence` signals
+    ownedWaitsOut.insert(ownedWaitsOut.end(), submission.ownedWaits.begin(), submission.ownedWaits.end());
+    return ok;
 }
 
-void RVKDevice::deferDestroy(VkFence fence, std::function<void()> cleanup) const noexcept
+void RVKDevice::deferDestroy(VkFence fence, std::unique_ptr<Garbage> garbage) const noexcept
 {
+    Garbage *g { garbage.release() };
+    g->m_fence = fence;
+
     std::lock_guard<std::mutex> lock { m_garbageMutex };
-    m_garbage.push_back({ fence, std::move(cleanup), std::this_thread::get_id() });
+    GarbageList &list { m_garbage[std::this_thread::get_id()] };
+
+    if (list.tail)
+        list.tail->m_next = g;
+    else
+        list.head = g;
+
+    list.tail = g;
 }
 
 void RVKDevice::queueWait(VkSemaphore semaphore, bool owned) const noexcept
 {
     if (semaphore == VK_NULL_HANDLE)
         return;
-    std::lock_guard<std::mutex> lock { m_queueMutex };
-    m_pendingWaits.emplace_back(semaphore, owned);
+
+    PendingWait *wait { new PendingWait { semaphore, owned, m_pendingWaits.load(std::memory_order_relaxed) } };
+
+    while (!m_pendingWaits.compare_exchange_weak(wait->next, wait, std::memory_order_release, std::memory_order_relaxed)) {}
 }
 
 bool RVKDevice::submitSignal(VkSemaphore semaphore, VkFence fence) const noexcept
 {
-    std::lock_guard<std::mutex> lock { m_queueMutex };
-
-    VkSubmitInfo submit {};
-    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     // A null semaphore yields a fence-only signal (CPU-side completion tracking).
-    submit.signalSemaphoreCount = semaphore != VK_NULL_HANDLE ? 1 : 0;
-    submit.pSignalSemaphores = semaphore != VK_NULL_HANDLE ? &semaphore : nullptr;
-
-    return vkQueueSubmit(m_graphicsQueue, 1, &submit, fence) == VK_SUCCESS;
+    Submission submission {};
+    submission.fence = fence;
+    submission.signal = semaphore;
+    submission.consumeWaits = false;
+    return submit(submission);
 }
 
 bool RVKDevice::submitSignalTimeline(VkSemaphore semaphore, UInt64 value, VkFence fence) const noexcept
 {
-    std::lock_guard<std::mutex> lock { m_queueMutex };
-
-    VkTimelineSemaphoreSubmitInfo tsi {};
-    tsi.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
-    tsi.signalSemaphoreValueCount = 1;
-    tsi.pSignalSemaphoreValues = &value;
-
-    VkSubmitInfo submit {};
-    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit.pNext = &tsi;
-    submit.signalSemaphoreCount = 1;
-    submit.pSignalSemaphores = &semaphore;
-
-    return vkQueueSubmit(m_graphicsQueue, 1, &submit, fence) == VK_SUCCESS;
+    Submission submission {};
+    submission.fence = fence;
+    submission.signal = semaphore;
+    submission.signalValue = value;
+    submission.consumeWaits = false;
+    return submit(submission);
 }
 
 bool RVKDevice::init() noexcept
@@ -425,8 +753,13 @@ bool RVKDevice::initExtensions() noexcept
     m_ext.EXT_physical_device_drm = hasExtension(VK_EXT_PHYSICAL_DEVICE_DRM_EXTENSION_NAME);
 
     if (m_core.platform() == RPlatform::Wayland)
+    {
         m_ext.KHR_swapchain = enable(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 
+        // Forwards the present damage to the compositor (wl_surface.damage_buffer)
+        m_ext.KHR_incremental_present = m_ext.KHR_swapchain && enable(VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME);
+    }
+
     // DMA-buf import/export + DRM format modifier images (the compositor path).
     {
         const bool extMem   { enable(VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME) };
@@ -472,9 +805,9 @@ bool RVKDevice::initDRM() noexcept
 
         vkGetPhysicalDeviceProperties2(m_physicalDevice, &props2);
 
-        if (m_core.platform() == RPlatform::Wayland)
+        if (m_core.platform() != RPlatform::DRM)
         {
-            // The GBM allocator is best-effort on Wayland; DMA interop still works without it.
+            // The GBM allocator is best-effort on Wayland and Offscreen; DMA interop still works without it.
             const auto renderDev { makedev(drmProps.renderMajor, drmProps.renderMinor) };
             const auto primaryDev { makedev(drmProps.primaryMajor, drmProps.primaryMinor) };
             const dev_t chosen { drmProps.hasRender ? renderDev : primaryDev };
@@ -559,7 +892,7 @@ bool RVKDevice::initDRM() noexcept
     }
 
 end:
-    if (m_core.platform() == RPlatform::Wayland)
+    if (m_core.platform() != RPlatform::DRM)
         return true;
 
     // Mandatory for the DRM platform
@@ -579,24 +912,44 @@ bool RVKDevice::initQueues() noexcept
         if (families[i].queueCount > 0 && (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT))
         {
             m_graphicsQueueFamily = i;
-            return true;
+            m_timestampValidBits = families[i].timestampValidBits;
+            break;
         }
     }
 
-    RLog(CZError, CZLN, "{}: No graphics-capable queue family found", m_properties.deviceName);
-    return false;
+    if (m_graphicsQueueFamily == UINT32_MAX)
+    {
+        RLog(CZError, CZLN, "{}: No graphics-capable queue family found", m_properties.deviceName);
+        return false;
+    }
+
+    if (const char *env { getenv("CZ_REAM_VK_TRANSFER_QUEUE") }; env && atoi(env) == 0)
+        return true;
+
+    /* Dedicated transfer family (usually backed by a DMA engine). Prefer one without compute support, and require
+     * 1x1 granularity since uploads and readbacks copy arbitrary rects */
+    for (UInt32 i = 0; i < count; i++)
+    {
+        const auto &family { families[i] };
+        const auto &granularity { family.minImageTransferGranularity };
+
+        if (family.queueCount == 0 ||
+            !(family.queueFlags & VK_QUEUE_TRANSFER_BIT) ||
+            (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) ||
+            granularity.width != 1 || granularity.height != 1 || granularity.depth != 1)
+            continue;
+
+        if (m_transferQueueFamily == UINT32_MAX || !(family.queueFlags & VK_QUEUE_COMPUTE_BIT))
+            m_transferQueueFamily = i;
+    }
+
+    return true;
 }
 
 bool RVKDevice::initDevice() noexcept
 {
     const float priority { 1.f };
 
-    VkDeviceQueueCreateInfo queueInfo {};
-    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueInfo.queueFamilyIndex = m_graphicsQueueFamily;
-    queueInfo.queueCount = 1;
-    queueInfo.pQueuePriorities = &priority;
-
     // Build a VkPhysicalDeviceFeatures2 chain and enable only the supported extension features.
     m_features2 = {};
     m_features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
@@ -639,11 +992,30 @@ bool RVKDevice::initDevice() noexcept
     if (m_ext.KHR_dynamic_rendering && !m_dynRenderFeatures.dynamicRendering)
         m_ext.KHR_dynamic_rendering = false;
 
+    // The transfer queue hands resources over with a timeline semaphore
+    if (!m_ext.KHR_timeline_semaphore)
+        m_transferQueueFamily = UINT32_MAX;
+
+    VkDeviceQueueCreateInfo queueInfos[2] {};
+    UInt32 queueInfoCount { 1 };
+
+    queueInfos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfos[0].queueFamilyIndex = m_graphicsQueueFamily;
+    queueInfos[0].queueCount = 1;
+    queueInfos[0].pQueuePriorities = &priority;
+
+    if (m_transferQueueFamily != UINT32_MAX)
+    {
+        queueInfos[1] = queueInfos[0];
+        queueInfos[1].queueFamilyIndex = m_transferQueueFamily;
+        queueInfoCount++;
+    }
+
     VkDeviceCreateInfo createInfo {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     createInfo.pNext = &m_features2; // features2 in pNext => pEnabledFeatures must be null
-    createInfo.queueCreateInfoCount = 1;
-    createInfo.pQueueCreateInfos = &queueInfo;
+    createInfo.queueCreateInfoCount = queueInfoCount;
+    createInfo.pQueueCreateInfos = queueInfos;
     createInfo.enabledExtensionCount = m_requiredExtensions.size();
     createInfo.ppEnabledExtensionNames = m_requiredExtensions.data();
 
@@ -666,10 +1038,34 @@ bool RVKDevice::initDevice() noexcept
         return false;
     }
 
+    if (m_transferQueueFamily != UINT32_MAX)
+    {
+        poolInfo.queueFamilyIndex = m_transferQueueFamily;
+
+        VkSemaphoreTypeCreateInfo typeInfo {};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semInfo {};
+        semInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semInfo.pNext = &typeInfo;
+
+        if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_transferCommandPool) == VK_SUCCESS &&
+            vkCreateSemaphore(m_device, &semInfo, nullptr, &m_transferTimeline) == VK_SUCCESS)
+        {
+            vkGetDeviceQueue(m_device, m_transferQueueFamily, 0, &m_transferQueue);
+            RLog(CZTrace, CZLN, "{}: Using transfer queue family {}", m_properties.deviceName, m_transferQueueFamily);
+        }
+        else
+            RLog(CZWarning, CZLN, "{}: Failed to set up the transfer queue, using the graphics queue for transfers", m_properties.deviceName);
+    }
+
     // Capabilities that depend on the created device.
     m_caps.Rendering = true;
     m_caps.SyncCPU = true;
     m_caps.SyncGPU = true;
+    m_caps.TimestampQuery = m_timestampValidBits > 0 && m_properties.limits.timestampPeriod > 0.f;
 
     if (m_ext.KHR_timeline_semaphore && drmFd() >= 0)
     {
@@ -806,7 +1202,14 @@ sk_sp<GrDirectContext> RVKDevice::makeSkContext() const noexcept
     bc.fMemoryAllocator = m_allocator;
     bc.fGetProc = m_getProc;
 
-    return GrDirectContexts::MakeVulkan(bc, CZ::GetSKContextOptions());
+    // Pipeline caches are only valid for the same device and driver
+    std::string cacheKey { std::format("VK|{:x}|{:x}|{:x}|{}|", m_properties.vendorID, m_properties.deviceID,
+        m_properties.driverVersion, m_properties.deviceName) };
+
+    for (auto byte : m_properties.pipelineCacheUUID)
+        cacheKey += std::format("{:02x}", byte);
+
+    return GrDirectContexts::MakeVulkan(bc, CZ::MakeSKContextOptions(cacheKey));
 }
 
 sk_sp<GrDirectContext> RVKDevice::skContext() const noexcept
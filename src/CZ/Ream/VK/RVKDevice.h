@@ -10,16 +10,17 @@
 #include <unordered_map>
 #include <functional>
 #include <memory>
+#include <atomic>
 #include <thread>
 #include <mutex>
 
 /**
  * @brief Vulkan backend implementation of RDevice.
  *
- * Wraps a single VkPhysicalDevice/VkDevice and its graphics queue, and owns the resources shared
- * across the backend: the painter pipeline cache, per-thread Skia (Ganesh) contexts, a queue mutex
- * serializing submissions, and a fence-tracked deferred-destruction queue enabling asynchronous,
- * non-blocking command submission.
+ * Wraps a single VkPhysicalDevice/VkDevice, its graphics queue and, if available, a dedicated transfer
+ * queue. Owns the resources shared across the backend: the painter pipeline cache, per-thread Skia (Ganesh)
+ * contexts, a queue mutex serializing submissions, and a fence-tracked deferred-destruction queue enabling
+ * asynchronous, non-blocking command submission.
  *
  * Obtained by downcasting an RDevice via RDevice::asVK().
  */
@@ -34,6 +35,18 @@ public:
     VkQueue graphicsQueue() const noexcept { return m_graphicsQueue; }
     UInt32 graphicsQueueFamily() const noexcept { return m_graphicsQueueFamily; }
 
+    /**
+     * @brief Queue of a transfer-only family, used for pixel uploads and readbacks (see transferSubmit()).
+     *
+     * VK_NULL_HANDLE if the device has no such family with 1x1 image transfer granularity, timeline
+     * semaphores are unsupported, or `CZ_REAM_VK_TRANSFER_QUEUE=0` is set.
+     */
+    VkQueue transferQueue() const noexcept { return m_transferQueue; }
+    UInt32 transferQueueFamily() const noexcept { return m_transferQueueFamily; }
+
+    // Valid bits of graphics queue timestamps, 0 if unsupported
+    UInt32 timestampValidBits() const noexcept { return m_timestampValidBits; }
+
     const VkPhysicalDeviceProperties &properties() const noexcept { return m_properties; }
     const VkPhysicalDeviceMemoryProperties &memoryProperties() const noexcept { return m_memoryProperties; }
     const RVKDeviceProcs &procs() const noexcept { return m_procs; }
@@ -52,7 +65,8 @@ public:
     /**
      * @brief Serializes access to the shared VkQueue.
      *
-     * VkQueue submission and vkDeviceWaitIdle require external synchronization.
+     * VkQueue submission and vkDeviceWaitIdle require external synchronization. Ream's own submissions
+     * do not wait on it directly, they are batched by whichever thread finds the queue idle (see submit()).
      */
     std::mutex &queueMutex() const noexcept { return m_queueMutex; }
 
@@ -65,13 +79,32 @@ public:
     /**
      * @brief Records and synchronously submits a one-shot command buffer on the graphics queue.
      *
-     * Serialized via queueMutex() and blocks until the GPU finishes (fence wait).
+     * Blocks until the GPU finishes (fence wait).
      * Used for pixel uploads/downloads and layout transitions.
      *
      * @return true on success.
      */
     bool immediateSubmit(const std::function<void(VkCommandBuffer)> &record) const noexcept;
 
+    /**
+     * @brief Records and synchronously submits a one-shot command buffer on the transfer queue.
+     *
+     * Resources shared with the graphics queue must change queue family ownership, so three command buffers are
+     * recorded and chained with a timeline semaphore:
+     *
+     * 1. @p release on the graphics queue, after all prior graphics work (consumes pending waits).
+     * 2. @p record on the transfer queue, which must acquire, use and release the resources back.
+     * 3. @p acquire on the graphics queue, before any later graphics work.
+     *
+     * Recording and waiting for the transfer do not block graphics submissions. Blocks until 2. completes,
+     * 3. is not waited for.
+     *
+     * @return true on success, false if there is no transferQueue() or a submission failed.
+     */
+    bool transferSubmit(const std::function<void(VkCommandBuffer)> &release,
+                        const std::function<void(VkCommandBuffer)> &record,
+                        const std::function<void(VkCommandBuffer)> &acquire) const noexcept;
+
     /**
      * @brief Submits an already-recorded command buffer, consuming pending waits, and blocks
      *        until it completes. Used by RVKPainter::flush.
@@ -88,17 +121,52 @@ public:
      *
      * If @p signal is not VK_NULL_HANDLE it is signalled on completion (e.g. a swapchain present
      * semaphore that vkQueuePresentKHR waits on), so present need not block the CPU.
+     *
+     * If @p wait is not VK_NULL_HANDLE this submission (and not whichever consumes the pending
+     * waits first) waits on it, e.g. a swapchain acquire semaphore. It is not destroyed.
      */
     bool submitCommandAsync(VkCommandBuffer cmd, VkFence fence, std::vector<VkSemaphore> &ownedWaitsOut,
-                            VkSemaphore signal = VK_NULL_HANDLE) const noexcept;
+                            VkSemaphore signal = VK_NULL_HANDLE, VkSemaphore wait = VK_NULL_HANDLE) const noexcept;
+
+    /**
+     * @brief Resources released once a graphics queue submission completes, see deferDestroy().
+     *
+     * Subclasses release their resources in the destructor, which runs on the thread that
+     * called deferDestroy().
+     */
+    class Garbage
+    {
+    public:
+        virtual ~Garbage() noexcept = default;
+    private:
+        friend class RVKDevice;
+        VkFence m_fence { VK_NULL_HANDLE };
+        Garbage *m_next { nullptr };
+    };
 
     /**
-     * @brief Registers a cleanup to run once @p fence is signalled (deferred/GPU-safe destruction).
+     * @brief Returns an unsignalled fence from the device fence pool (or a new one).
+     *
+     * Pass it to a graphics queue submission and then to deferDestroy(), which recycles it.
+     * If it ends up unused, return it with recycleFence().
      *
-     * The fence is destroyed after the cleanup runs. Drained by clearGarbage() (called by the
-     * compositor each frame) and fully flushed at device destruction.
+     * @return The fence or VK_NULL_HANDLE on failure.
      */
-    void deferDestroy(VkFence fence, std::function<void()> cleanup) const noexcept;
+    VkFence acquireFence() const noexcept;
+
+    /**
+     * @brief Returns an unsignalled fence obtained with acquireFence() to the pool.
+     */
+    void recycleFence(VkFence fence) const noexcept;
+
+    /**
+     * @brief Destroys @p garbage once @p fence is signalled (deferred/GPU-safe destruction).
+     *
+     * @p fence must come from acquireFence() and belong to a graphics queue submission made by the
+     * calling thread right before. Entries are kept in per-thread lists in submission order, drained
+     * by clearGarbage() (called by the compositor each frame) and fully flushed at device destruction.
+     */
+    void deferDestroy(VkFence fence, std::unique_ptr<Garbage> garbage) const noexcept;
 
     /**
      * @brief Queues a semaphore for the next queue submission to wait on.
@@ -155,8 +223,19 @@ private:
     VkDevice m_device { VK_NULL_HANDLE };
     VkQueue m_graphicsQueue { VK_NULL_HANDLE };
     UInt32 m_graphicsQueueFamily { UINT32_MAX };
+    UInt32 m_timestampValidBits { 0 };
     VkCommandPool m_commandPool { VK_NULL_HANDLE };
 
+    // Dedicated transfer queue (see transferSubmit()), everything below is guarded by m_transferMutex
+    VkQueue m_transferQueue { VK_NULL_HANDLE };
+    UInt32 m_transferQueueFamily { UINT32_MAX };
+    VkCommandPool m_transferCommandPool { VK_NULL_HANDLE };
+    VkSemaphore m_transferTimeline { VK_NULL_HANDLE };
+    mutable UInt64 m_transferTimelineValue { 0 };
+    // Graphics command buffers of previous transfers, freed once the timeline reaches the value (guarded by m_commandPoolMutex)
+    mutable std::vector<std::pair<UInt64, VkCommandBuffer>> m_transferRetired;
+    mutable std::mutex m_transferMutex;
+
     VkPhysicalDeviceProperties m_properties {};
     VkPhysicalDeviceMemoryProperties m_memoryProperties {};
     VkPhysicalDeviceFeatures m_features {};
@@ -183,23 +262,63 @@ private:
     mutable std::unordered_map<std::thread::id, sk_sp<GrDirectContext>> m_skContexts;
 
     mutable std::mutex m_queueMutex;
-    // Semaphores the next queue submission must wait on (RVKSync::gpuWait). Guarded by m_queueMutex.
-    mutable std::vector<std::pair<VkSemaphore, bool>> m_pendingWaits;
-
-    // Fence-tracked deferred destruction: cleanup runs once its fence signals (drained by
-    // clearGarbage()). Lets submissions be async without freeing in-flight resources. Each entry
-    // records the thread that created the resources; cleanup MUST run on that same thread because
-    // Vulkan command pools require external synchronization (NVIDIA crashes on cross-thread
-    // destruction that Mesa tolerates). clearGarbage() therefore only drains the caller thread's
-    // entries.
-    struct Garbage
+
+    /* Graphics queue submission. Lives on the stack of the submitting thread, which blocks in submit()
+     * until it is handed to vkQueueSubmit (not until it completes) */
+    struct Submission
+    {
+        VkCommandBuffer cmd { VK_NULL_HANDLE }; // VK_NULL_HANDLE for signal-only submissions
+        VkFence fence { VK_NULL_HANDLE };
+        VkSemaphore signal { VK_NULL_HANDLE };
+        UInt64 signalValue { 0 };               // Timeline value of signal, 0 if binary
+        bool consumeWaits { true };             // Waits on the semaphores queued with queueWait()
+        std::vector<VkSemaphore> waits;
+        std::vector<UInt64> waitValues;         // One per wait, 0 for binary semaphores
+
+        // Output: owned queueWait() semaphores consumed, to be destroyed once the submission completes
+        std::vector<VkSemaphore> ownedWaits;
+        bool ok { false };
+
+        // Used by the submitting thread
+        std::vector<VkPipelineStageFlags> waitStages;
+        VkTimelineSemaphoreSubmitInfo timelineInfo {};
+        Submission *next { nullptr };
+        std::atomic<bool> done { false };
+    };
+
+    /* Pushes the submission into a lock-free stack. The first thread to find the queue idle submits every pushed
+     * submission, merged into as few vkQueueSubmit calls as their fences allow, while the others sleep */
+    bool submit(Submission &submission) const noexcept;
+    void processSubmissions() const noexcept;
+    mutable std::atomic<Submission*> m_submissions { nullptr };
+    mutable std::atomic<bool> m_submitting { false };
+
+    // Semaphores the next submission with consumeWaits must wait on (RVKSync::gpuWait), lock-free stack
+    struct PendingWait
+    {
+        VkSemaphore semaphore;
+        bool owned;
+        PendingWait *next;
+    };
+    mutable std::atomic<PendingWait*> m_pendingWaits { nullptr };
+
+    // Allocates and records a one-shot command buffer, the caller synchronizes the pool
+    VkCommandBuffer recordOneShot(VkCommandPool pool, const std::function<void(VkCommandBuffer)> &record) const noexcept;
+    mutable std::mutex m_commandPoolMutex; // Guards m_commandPool
+
+    // Fence-tracked deferred destruction: garbage is destroyed once its fence signals (drained by
+    // clearGarbage()). Lets submissions be async without freeing in-flight resources. Lists are per
+    // thread because Vulkan command pools require external synchronization (NVIDIA crashes on
+    // cross-thread destruction that Mesa tolerates), so clearGarbage() only drains the caller's list.
+    // Fences signal in submission order, so draining stops at the first pending entry.
+    struct GarbageList
     {
-        VkFence fence;
-        std::function<void()> cleanup;
-        std::thread::id owner;
+        Garbage *head { nullptr };
+        Garbage *tail { nullptr };
     };
     mutable std::mutex m_garbageMutex;
-    mutable std::vector<Garbage> m_garbage;
+    mutable std::unordered_map<std::thread::id, GarbageList> m_garbage;
+    mutable std::vector<VkFence> m_fencePool; // Unsignalled fences, guarded by m_garbageMutex
 
     std::unique_ptr<RVKPipeline> m_pipelines;
     std::mutex m_pipelinesMutex;
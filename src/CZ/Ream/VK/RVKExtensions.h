@@ -53,6 +53,7 @@ namespace CZ
     struct RVKDeviceExtensions
     {
         bool KHR_swapchain;
+        bool KHR_incremental_present;
         bool KHR_external_memory_fd;
         bool EXT_external_memory_dma_buf;
         bool EXT_image_drm_format_modifier;
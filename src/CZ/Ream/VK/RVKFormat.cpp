@@ -38,6 +38,8 @@ static const std::unordered_map<RFormat, VkFormat> &VKFromDRMMap() noexcept
         // single/dual channel
         { DRM_FORMAT_R8,           VK_FORMAT_R8_UNORM },
         { DRM_FORMAT_GR88,         VK_FORMAT_R8G8_UNORM },
+        { DRM_FORMAT_R16,          VK_FORMAT_R16_UNORM },
+        { DRM_FORMAT_GR1616,       VK_FORMAT_R16G16_UNORM },
     };
     return map;
 }
@@ -62,6 +64,8 @@ RFormat RVKFormat::ToDRM(VkFormat format) noexcept
     case VK_FORMAT_R16G16B16A16_SFLOAT:     return DRM_FORMAT_ABGR16161616F;
     case VK_FORMAT_R8_UNORM:                return DRM_FORMAT_R8;
     case VK_FORMAT_R8G8_UNORM:              return DRM_FORMAT_GR88;
+    case VK_FORMAT_R16_UNORM:               return DRM_FORMAT_R16;
+    case VK_FORMAT_R16G16_UNORM:            return DRM_FORMAT_GR1616;
     default:                                return DRM_FORMAT_INVALID;
     }
 }
@@ -6,6 +6,7 @@
 #include <CZ/Ream/DRM/RDRMFormat.h>
 #include <CZ/Ream/DRM/RDRMFramebuffer.h>
 #include <CZ/Ream/GBM/RGBMBo.h>
+#include <CZ/Ream/RResourceTracker.h>
 #include <CZ/Ream/RCore.h>
 #include <CZ/Ream/RLog.h>
 #include <CZ/Core/CZBitset.h>
@@ -22,6 +23,7 @@
 
 #include <drm_fourcc.h>
 #include <cstring>
+#include <cmath>
 
 using namespace CZ;
 
@@ -99,6 +101,13 @@ RVKImage::~RVKImage() noexcept
     if (m_memory != VK_NULL_HANDLE && m_ownsMemory)
         vkFreeMemory(dev, m_memory, nullptr);
 
+    RResourceTrackerSubBytes(RNativeMem, m_dev, m_nativeMemorySize);
+
+    if (m_mips.view != VK_NULL_HANDLE) vkDestroyImageView(dev, m_mips.view, nullptr);
+    if (m_mips.image != VK_NULL_HANDLE) vkDestroyImage(dev, m_mips.image, nullptr);
+    if (m_mips.memory != VK_NULL_HANDLE) vkFreeMemory(dev, m_mips.memory, nullptr);
+    RResourceTrackerSubBytes(RNativeMem, m_dev, m_mips.size);
+
     // Destroy cross-device imported copies (each on its own device).
     for (auto &[sdev, s] : m_shared)
     {
@@ -657,6 +666,8 @@ bool RVKImage::initNativeStorage() noexcept
         return false;
     }
     m_memorySize = req.size;
+    m_nativeMemorySize = req.size;
+    RResourceTrackerAddBytes(RNativeMem, m_dev, m_nativeMemorySize);
 
     if (vkBindImageMemory(dev, m_image, m_memory, 0) != VK_SUCCESS)
     {
@@ -680,6 +691,174 @@ bool RVKImage::initNativeStorage() noexcept
     return true;
 }
 
+bool RVKImage::initMipChain() const noexcept
+{
+    if (m_mips.image != VK_NULL_HANDLE)
+        return true;
+
+    if (m_mips.unsupported)
+        return false;
+
+    m_mips.unsupported = true;
+
+    if (!mipmaps() || !(m_usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+        return false;
+
+    VkFormatProperties props {};
+    vkGetPhysicalDeviceFormatProperties(m_dev->physicalDevice(), m_vkFormat, &props);
+    const VkFormatFeatureFlags required { VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT };
+
+    if ((props.optimalTilingFeatures & required) != required)
+        return false;
+
+    const VkDevice dev { m_dev->device() };
+    m_mips.levels = 1 + UInt32(std::floor(std::log2(std::max(size().width(), size().height()))));
+
+    VkImageCreateInfo ci {};
+    ci.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    ci.imageType = VK_IMAGE_TYPE_2D;
+    ci.format = m_vkFormat;
+    ci.extent = { (UInt32)size().width(), (UInt32)size().height(), 1 };
+    ci.mipLevels = m_mips.levels;
+    ci.arrayLayers = 1;
+    ci.samples = VK_SAMPLE_COUNT_1_BIT;
+    ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ci.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    if (vkCreateImage(dev, &ci, nullptr, &m_mips.image) != VK_SUCCESS)
+    {
+        RLog(CZError, CZLN, "RVKImage: vkCreateImage failed (mipmaps)");
+        return false;
+    }
+
+    VkMemoryRequirements req {};
+    vkGetImageMemoryRequirements(dev, m_mips.image, &req);
+
+    VkMemoryAllocateInfo ai {};
+    ai.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    ai.allocationSize = req.size;
+    ai.memoryTypeIndex = m_dev->findMemoryType(req.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (ai.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(dev, &ai, nullptr, &m_mips.memory) != VK_SUCCESS)
+    {
+        RLog(CZError, CZLN, "RVKImage: vkAllocateMemory failed (mipmaps)");
+        vkDestroyImage(dev, m_mips.image, nullptr);
+        m_mips.image = VK_NULL_HANDLE;
+        return false;
+    }
+
+    m_mips.size = req.size;
+    RResourceTrackerAddBytes(RNativeMem, m_dev, m_mips.size);
+
+    VkImageViewCreateInfo vi {};
+    vi.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    vi.image = m_mips.image;
+    vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vi.format = m_vkFormat;
+    vi.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, m_mips.levels, 0, 1 };
+
+    if (vkBindImageMemory(dev, m_mips.image, m_mips.memory, 0) != VK_SUCCESS ||
+        vkCreateImageView(dev, &vi, nullptr, &m_mips.view) != VK_SUCCESS)
+    {
+        RLog(CZError, CZLN, "RVKImage: Failed to create the mipmaps view");
+        return false; // Released by the destructor
+    }
+
+    m_mips.unsupported = false;
+    return true;
+}
+
+VkImageView RVKImage::recordMipmaps(VkCommandBuffer cmd, std::optional<UInt32> &generated) const noexcept
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+
+    if (!initMipChain())
+        return VK_NULL_HANDLE;
+
+    if (m_mips.serial == writeSerial())
+        return m_mips.view;
+
+    const auto barrier = [&](UInt32 level, UInt32 count, VkImageLayout oldLayout, VkImageLayout newLayout,
+                             VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
+                             VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+    {
+        VkImageMemoryBarrier b {};
+        b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        b.oldLayout = oldLayout;
+        b.newLayout = newLayout;
+        b.srcAccessMask = srcAccess;
+        b.dstAccessMask = dstAccess;
+        b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        b.image = m_mips.image;
+        b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, count, 0, 1 };
+        vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
+    };
+
+    transitionLayout(cmd, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                     VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    // Previous contents may still be sampled by earlier submissions
+    barrier(0, m_mips.levels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    Int32 w { size().width() };
+    Int32 h { size().height() };
+
+    VkImageCopy copy {};
+    copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    copy.extent = { (UInt32)w, (UInt32)h, 1 };
+    vkCmdCopyImage(cmd, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_mips.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+    transitionLayout(cmd, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                     VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    for (UInt32 level = 1; level < m_mips.levels; level++)
+    {
+        barrier(level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+        const Int32 nw { std::max(1, w / 2) };
+        const Int32 nh { std::max(1, h / 2) };
+
+        VkImageBlit blit {};
+        blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1 };
+        blit.srcOffsets[1] = { w, h, 1 };
+        blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1 };
+        blit.dstOffsets[1] = { nw, nh, 1 };
+        vkCmdBlitImage(cmd, m_mips.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       m_mips.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+        w = nw;
+        h = nh;
+    }
+
+    if (m_mips.levels > 1)
+        barrier(0, m_mips.levels - 1, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    barrier(m_mips.levels - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    generated = writeSerial();
+    return m_mips.view;
+}
+
+void RVKImage::publishMipmaps(UInt32 serial) const noexcept
+{
+    std::lock_guard<std::mutex> lock { m_mutex };
+    m_mips.serial = serial;
+}
+
 void RVKImage::assignReadWriteFormats() noexcept
 {
     // Staging transfers require the CPU buffer to already be in the image's native format.
@@ -857,6 +1036,15 @@ CZBitset<RImageCap> RVKImage::checkDeviceCaps(CZBitset<RImageCap> caps, RDevice
         ret.add(RImageCap_GBMBo);
     if (caps.has(RImageCap_DRMFb) && drmFb(dev))
         ret.add(RImageCap_DRMFb);
+    if (caps.has(RImageCap_Mipmaps) && (m_usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+    {
+        VkFormatProperties props {};
+        vkGetPhysicalDeviceFormatProperties(m_dev->physicalDevice(), m_vkFormat, &props);
+        const VkFormatFeatureFlags required { VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT };
+        if ((props.optimalTilingFeatures & required) == required)
+            ret.add(RImageCap_Mipmaps);
+    }
 
     return ret;
 }
@@ -908,6 +1096,76 @@ void RVKImage::syncLayoutFromSkia() const noexcept
         m_layout = info.fImageLayout;
 }
 
+bool RVKImage::submitCopy(VkImageLayout copyLayout, VkAccessFlags copyAccess, VkImageLayout finalLayout,
+                          const std::function<void(VkCommandBuffer)> &copy) noexcept
+{
+    if (m_dev->transferQueue() == VK_NULL_HANDLE)
+    {
+        return m_dev->immediateSubmit([&](VkCommandBuffer cmd)
+        {
+            transitionLayout(cmd, copyLayout,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, copyAccess);
+            copy(cmd);
+            transitionLayout(cmd, finalLayout,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             copyAccess, VK_ACCESS_SHADER_READ_BIT);
+        });
+    }
+
+    /* The release and acquire barriers of each ownership transfer must describe the same layout transition
+     * (see VkImageMemoryBarrier), only the stage/access masks of the side performing them apply */
+
+    const UInt32 gfx { m_dev->graphicsQueueFamily() };
+    const UInt32 xfer { m_dev->transferQueueFamily() };
+    const VkImageLayout oldLayout { m_layout };
+
+    auto barrier = [this](VkCommandBuffer cmd, VkImageLayout from, VkImageLayout to, UInt32 srcFamily, UInt32 dstFamily,
+                          VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+    {
+        VkImageMemoryBarrier b {};
+        b.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        b.oldLayout = from;
+        b.newLayout = to;
+        b.srcQueueFamilyIndex = srcFamily;
+        b.dstQueueFamilyIndex = dstFamily;
+        b.image = m_image;
+        b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        b.srcAccessMask = srcAccess;
+        b.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
+    };
+
+    const bool ok { m_dev->transferSubmit(
+        [&](VkCommandBuffer cmd)
+        {
+            barrier(cmd, oldLayout, copyLayout, gfx, xfer,
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                    VK_ACCESS_MEMORY_WRITE_BIT, 0);
+        },
+        [&](VkCommandBuffer cmd)
+        {
+            barrier(cmd, oldLayout, copyLayout, gfx, xfer,
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0, copyAccess);
+            copy(cmd);
+            barrier(cmd, copyLayout, finalLayout, xfer, gfx,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                    copyAccess, 0);
+        },
+        [&](VkCommandBuffer cmd)
+        {
+            barrier(cmd, copyLayout, finalLayout, xfer, gfx,
+                    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                    0, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_MEMORY_READ_BIT);
+        }) };
+
+    if (ok)
+        setTrackedLayout(finalLayout);
+
+    return ok;
+}
+
 bool RVKImage::writePixels(const RPixelBufferRegion &region) noexcept
 {
     if (region.format != formatInfo().format)
@@ -940,6 +1198,7 @@ bool RVKImage::writePixels(const RPixelBufferRegion &region) noexcept
 
     VkBuffer staging { VK_NULL_HANDLE };
     VkDeviceMemory stagingMem { VK_NULL_HANDLE };
+    VkDeviceSize stagingSize { 0 };
     bool ok { false };
     void *mapped { nullptr };
 
@@ -960,6 +1219,8 @@ bool RVKImage::writePixels(const RPixelBufferRegion &region) noexcept
         ai.memoryTypeIndex = memType;
         if (vkAllocateMemory(dev, &ai, nullptr, &stagingMem) != VK_SUCCESS)
             goto cleanup;
+        stagingSize = ai.allocationSize;
+        RResourceTrackerAddBytes(RStagingMem, m_dev, stagingSize);
         if (vkBindBufferMemory(dev, staging, stagingMem, 0) != VK_SUCCESS)
             goto cleanup;
         if (vkMapMemory(dev, stagingMem, 0, total, 0, &mapped) != VK_SUCCESS)
@@ -996,26 +1257,23 @@ bool RVKImage::writePixels(const RPixelBufferRegion &region) noexcept
         vkUnmapMemory(dev, stagingMem);
     }
 
-    ok = m_dev->immediateSubmit([&](VkCommandBuffer cmd)
+    ok = submitCopy(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    [&](VkCommandBuffer cmd)
     {
-        transitionLayout(cmd, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         0, VK_ACCESS_TRANSFER_WRITE_BIT);
-
         vkCmdCopyBufferToImage(cmd, staging, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                                copies.size(), copies.data());
-
-        transitionLayout(cmd, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                         VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
     });
 
     if (ok)
+    {
         m_writeSerial++;
+        profileUpload(region);
+    }
 
 cleanup:
     if (stagingMem != VK_NULL_HANDLE)
         vkFreeMemory(dev, stagingMem, nullptr);
+    RResourceTrackerSubBytes(RStagingMem, m_dev, stagingSize);
     if (staging != VK_NULL_HANDLE)
         vkDestroyBuffer(dev, staging, nullptr);
     return ok;
@@ -1070,6 +1328,7 @@ bool RVKImage::readPixels(const RPixelBufferRegion &region) noexcept
 
     VkBuffer staging { VK_NULL_HANDLE };
     VkDeviceMemory stagingMem { VK_NULL_HANDLE };
+    VkDeviceSize stagingSize { 0 };
     bool ok { false };
     void *mapped { nullptr };
 
@@ -1090,24 +1349,18 @@ bool RVKImage::readPixels(const RPixelBufferRegion &region) noexcept
         ai.memoryTypeIndex = memType;
         if (vkAllocateMemory(dev, &ai, nullptr, &stagingMem) != VK_SUCCESS)
             goto cleanup;
+        stagingSize = ai.allocationSize;
+        RResourceTrackerAddBytes(RStagingMem, m_dev, stagingSize);
         if (vkBindBufferMemory(dev, staging, stagingMem, 0) != VK_SUCCESS)
             goto cleanup;
     }
 
-    ok = m_dev->immediateSubmit([&](VkCommandBuffer cmd)
+    ok = submitCopy(VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT,
+                    m_layout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : m_layout,
+                    [&](VkCommandBuffer cmd)
     {
-        const VkImageLayout prev { m_layout };
-        transitionLayout(cmd, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         0, VK_ACCESS_TRANSFER_READ_BIT);
-
         vkCmdCopyImageToBuffer(cmd, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                                staging, copies.size(), copies.data());
-
-        const VkImageLayout rest { prev == VK_IMAGE_LAYOUT_UNDEFINED ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : prev };
-        transitionLayout(cmd, rest,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                         VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT);
     });
 
     if (!ok)
@@ -1138,6 +1391,7 @@ bool RVKImage::readPixels(const RPixelBufferRegion &region) noexcept
 cleanup:
     if (stagingMem != VK_NULL_HANDLE)
         vkFreeMemory(dev, stagingMem, nullptr);
+    RResourceTrackerSubBytes(RStagingMem, m_dev, stagingSize);
     if (staging != VK_NULL_HANDLE)
         vkDestroyBuffer(dev, staging, nullptr);
     return ok;
@@ -6,6 +6,7 @@
 #include <CZ/Core/CZOwn.h>
 #include <vulkan/vulkan.h>
 #include <unordered_map>
+#include <functional>
 #include <optional>
 #include <thread>
 #include <mutex>
@@ -120,6 +121,32 @@ public:
                           VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
                           VkAccessFlags srcAccess, VkAccessFlags dstAccess) const noexcept;
 
+    /**
+     * @brief Records the generation of a mipmapped copy of this image (RImageCap_Mipmaps).
+     *
+     * The copy is created lazily and its levels are only re-blitted when writeSerial() differs from the
+     * last published generation (see publishMipmaps()). Must be recorded outside a render pass.
+     * Leaves the image in SHADER_READ_ONLY_OPTIMAL if copied.
+     *
+     * @param cmd       The command buffer.
+     * @param generated Set to the writeSerial() the levels were generated from if a generation was recorded.
+     *                  The caller publishes it with publishMipmaps() once @p cmd is submitted.
+     * @return A view of the copy in SHADER_READ_ONLY_OPTIMAL covering all levels, or VK_NULL_HANDLE
+     *         if unsupported (not created with RImageCap_Mipmaps, imported or unsupported format).
+     */
+    VkImageView recordMipmaps(VkCommandBuffer cmd, std::optional<UInt32> &generated) const noexcept;
+
+    /**
+     * @brief Marks the levels as generated from @p serial.
+     *
+     * Called after submitting the command buffer passed to recordMipmaps(), so that other command buffers
+     * only skip the generation once it is queue-ordered before them.
+     */
+    void publishMipmaps(UInt32 serial) const noexcept;
+
+    /** @brief View of the mipmapped copy, VK_NULL_HANDLE if not created yet. */
+    VkImageView mipmapsView() const noexcept { return m_mips.view; }
+
     /** @brief The tracked VkImageLayout of the primary image. */
     VkImageLayout layout() const noexcept { return m_layout; }
 
@@ -152,6 +179,11 @@ private:
     static bool ImportDMA(RVKDevice *device, const RDMABufferInfo &info, VkFormat vkFmt, VkImageUsageFlags usage,
                           VkImage &outImage, VkDeviceMemory &outMemory, VkImageView &outView, VkDeviceSize *outSize = nullptr) noexcept;
 
+    /* Runs a copy between m_image (in copyLayout) and a staging buffer, then leaves the image in finalLayout.
+     * Uses the device transfer queue if available, transferring the image ownership back and forth */
+    bool submitCopy(VkImageLayout copyLayout, VkAccessFlags copyAccess, VkImageLayout finalLayout,
+                    const std::function<void(VkCommandBuffer)> &copy) noexcept;
+
     bool ensureBackendTexture() const noexcept;
     bool ensureBackendRenderTarget() const noexcept;
     void fillImageInfo(void *grVkImageInfo) const noexcept;
@@ -170,6 +202,7 @@ private:
     VkDeviceMemory m_memory { VK_NULL_HANDLE };
     VkImageView m_view { VK_NULL_HANDLE };
     VkDeviceSize m_memorySize { 0 };
+    VkDeviceSize m_nativeMemorySize { 0 }; // Allocated (not imported) memory accounted in RResourceTracker
     VkImageTiling m_tiling { VK_IMAGE_TILING_OPTIMAL };
     VkFormat m_vkFormat { VK_FORMAT_UNDEFINED };
     VkImageUsageFlags m_usage { 0 };
@@ -205,6 +238,20 @@ private:
         mutable VkImageLayout layout { VK_IMAGE_LAYOUT_UNDEFINED };
     };
     mutable std::unordered_map<RVKDevice*, SharedImage> m_shared;
+
+    // Mipmapped copy sampled by RVKPainter when minifying (see recordMipmaps())
+    struct MipChain
+    {
+        VkImage image { VK_NULL_HANDLE };
+        VkDeviceMemory memory { VK_NULL_HANDLE };
+        VkImageView view { VK_NULL_HANDLE };
+        VkDeviceSize size { 0 }; // Accounted in RResourceTracker
+        UInt32 levels { 0 };
+        std::optional<UInt32> serial; // writeSerial() the levels were generated from, published after submission
+        bool unsupported { false };
+    };
+    mutable MipChain m_mips;
+    bool initMipChain() const noexcept;
 };
 
 #endif // CZ_RVKIMAGE_H
@@ -3,9 +3,12 @@
 #include <CZ/Ream/VK/RVKImage.h>
 #include <CZ/Ream/VK/RVKDevice.h>
 #include <CZ/Ream/RMatrixUtils.h>
+#include <CZ/Ream/RGammaLUT.h>
 #include <CZ/Ream/RSurface.h>
 #include <CZ/Ream/RImage.h>
 #include <CZ/Ream/RSync.h>
+#include <CZ/Ream/RResourceTracker.h>
+#include <CZ/Ream/RProfiler.h>
 #include <CZ/Ream/RLog.h>
 
 #include <algorithm>
@@ -15,6 +18,7 @@
 using namespace CZ;
 
 static constexpr VkDeviceSize VBO_CAPACITY { 1u << 20 }; // 1 MiB
+static constexpr UInt32 TIMESTAMP_QUERIES { 512 }; // Pass + 255 draws
 
 RVKPainter::RVKPainter(std::shared_ptr<RSurface> surface, RVKDevice *device) noexcept :
     RPainter(surface, device)
@@ -31,11 +35,105 @@ RVKPainter::~RVKPainter() noexcept
     const VkDevice d { dev()->device() };
     if (m_vboMem != VK_NULL_HANDLE) { vkUnmapMemory(d, m_vboMem); vkFreeMemory(d, m_vboMem, nullptr); }
     if (m_vbo != VK_NULL_HANDLE) vkDestroyBuffer(d, m_vbo, nullptr);
+    RResourceTrackerSubBytes(RVertexMem, dev(), m_vboCapacity);
     if (m_framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(d, m_framebuffer, nullptr);
     if (m_descPool != VK_NULL_HANDLE) vkDestroyDescriptorPool(d, m_descPool, nullptr);
     if (m_pool != VK_NULL_HANDLE) vkDestroyCommandPool(d, m_pool, nullptr);
 }
 
+void RVKPainter::writeTimestamp(UInt64 event, bool end) noexcept
+{
+    if (event == 0)
+        return;
+
+    if (end)
+    {
+        if (!m_recording || m_queryPool == VK_NULL_HANDLE)
+            return;
+
+        for (auto it = m_timestamps.rbegin(); it != m_timestamps.rend(); it++)
+        {
+            if (it->event == event && !it->ended)
+            {
+                vkCmdWriteTimestamp(m_cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, it->query + 1);
+                it->ended = true;
+                return;
+            }
+        }
+
+        return;
+    }
+
+    // Draw timestamps may come before anything else was recorded
+    if (!beginRecording() || m_queryPool == VK_NULL_HANDLE || (m_timestamps.size() + 1) * 2 > TIMESTAMP_QUERIES)
+        return;
+
+    for (const auto &timestamp : m_timestamps)
+        if (timestamp.event == event)
+            return;
+
+    const UInt32 query { UInt32(m_timestamps.size() * 2) };
+    vkCmdWriteTimestamp(m_cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, query);
+    m_timestamps.push_back({ event, query, false });
+    RProfiler::ExpectGPUTime(event);
+}
+
+struct RVKPainter::PassGarbage final : public RVKDevice::Garbage
+{
+    RVKDevice *device { nullptr };
+    VkCommandPool pool { VK_NULL_HANDLE };
+    VkCommandBuffer cmd { VK_NULL_HANDLE };
+    VkBuffer vbo { VK_NULL_HANDLE };
+    VkDeviceMemory vboMem { VK_NULL_HANDLE };
+    VkDeviceSize vboSize { 0 };
+    VkDescriptorPool descPool { VK_NULL_HANDLE };
+    VkFramebuffer framebuffer { VK_NULL_HANDLE };
+    VkQueryPool queryPool { VK_NULL_HANDLE };
+    std::vector<Timestamp> timestamps;
+    std::vector<VkSemaphore> ownedWaits;
+
+    ~PassGarbage() noexcept override
+    {
+        const VkDevice dd { device->device() };
+        ResolveTimestamps(device, queryPool, timestamps);
+        if (cmd != VK_NULL_HANDLE) vkFreeCommandBuffers(dd, pool, 1, &cmd);
+        if (framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(dd, framebuffer, nullptr);
+        if (descPool != VK_NULL_HANDLE) vkDestroyDescriptorPool(dd, descPool, nullptr);
+        if (vboMem != VK_NULL_HANDLE) { vkUnmapMemory(dd, vboMem); vkFreeMemory(dd, vboMem, nullptr); }
+        if (vbo != VK_NULL_HANDLE) vkDestroyBuffer(dd, vbo, nullptr);
+        RResourceTrackerSubBytes(RVertexMem, device, vboSize);
+        if (pool != VK_NULL_HANDLE) vkDestroyCommandPool(dd, pool, nullptr);
+        for (VkSemaphore s : ownedWaits) vkDestroySemaphore(dd, s, nullptr);
+    }
+};
+
+void RVKPainter::ResolveTimestamps(RVKDevice *device, VkQueryPool pool, const std::vector<Timestamp> &timestamps) noexcept
+{
+    if (pool == VK_NULL_HANDLE)
+        return;
+
+    const VkDevice d { device->device() };
+    const UInt32 bits { device->timestampValidBits() };
+    const UInt64 mask { bits >= 64 ? ~UInt64(0) : (UInt64(1) << bits) - 1 };
+    const double period { device->properties().limits.timestampPeriod };
+
+    for (const auto &timestamp : timestamps)
+    {
+        UInt64 results[2] {};
+
+        if (!timestamp.ended || vkGetQueryPoolResults(d, pool, timestamp.query, 2, sizeof(results), results,
+                sizeof(UInt64), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        {
+            RProfiler::SetGPUTime(timestamp.event, -1);
+            continue;
+        }
+
+        RProfiler::SetGPUTime(timestamp.event, Int64(double((results[1] - results[0]) & mask) * period));
+    }
+
+    vkDestroyQueryPool(d, pool, nullptr);
+}
+
 RVKDevice *RVKPainter::dev() const noexcept { return (RVKDevice*)m_device; }
 
 bool RVKPainter::setGeometry(const RSurfaceGeometry &geometry) noexcept
@@ -114,13 +212,14 @@ bool RVKPainter::beginRecording() noexcept
         vkBindBufferMemory(d, m_vbo, m_vboMem, 0);
         vkMapMemory(d, m_vboMem, 0, VBO_CAPACITY, 0, &m_vboMapped);
         m_vboCapacity = req.size;
+        RResourceTrackerAddBytes(RVertexMem, dev(), m_vboCapacity);
     }
 
     if (m_descPool == VK_NULL_HANDLE)
     {
         VkDescriptorPoolSize ps {};
         ps.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        ps.descriptorCount = 512;
+        ps.descriptorCount = 768; // Image + mask + gamma LUT per set
         VkDescriptorPoolCreateInfo dpi {};
         dpi.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
         dpi.maxSets = 256;
@@ -150,10 +249,28 @@ bool RVKPainter::beginRecording() noexcept
         0, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT);
 
     m_recording = true;
+
+    if (m_passEvent && dev()->caps().TimestampQuery)
+    {
+        VkQueryPoolCreateInfo qpi {};
+        qpi.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        qpi.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        qpi.queryCount = TIMESTAMP_QUERIES;
+
+        if (vkCreateQueryPool(d, &qpi, nullptr, &m_queryPool) == VK_SUCCESS)
+        {
+            vkCmdResetQueryPool(m_cmd, m_queryPool, 0, TIMESTAMP_QUERIES);
+            m_timestamps.clear();
+            writeTimestamp(m_passEvent, false);
+        }
+        else
+            m_queryPool = VK_NULL_HANDLE;
+    }
+
     return true;
 }
 
-void RVKPainter::ensureRenderPass() noexcept
+void RVKPainter::ensureRenderPass(const VkClearColorValue *clear) noexcept
 {
     if (m_renderPassActive)
         return;
@@ -161,11 +278,28 @@ void RVKPainter::ensureRenderPass() noexcept
     const UInt32 W { (UInt32)m_target->size().width() };
     const UInt32 H { (UInt32)m_target->size().height() };
 
+    VkClearValue clearValue {};
+    bool folded { false };
     VkRenderPassBeginInfo rpb {};
     rpb.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     rpb.renderPass = m_rp;
     rpb.framebuffer = m_framebuffer;
     rpb.renderArea.extent = { W, H };
+
+    if (clear)
+    {
+        // Compatible with m_rp (and the framebuffer), only the loadOp differs
+        const VkRenderPass clearRp { dev()->pipelines()->renderPass(m_format, true) };
+
+        if (clearRp != VK_NULL_HANDLE)
+        {
+            clearValue.color = *clear;
+            rpb.renderPass = clearRp;
+            rpb.clearValueCount = 1;
+            rpb.pClearValues = &clearValue;
+            folded = true;
+        }
+    }
     vkCmdBeginRenderPass(m_cmd, &rpb, VK_SUBPASS_CONTENTS_INLINE);
 
     VkViewport vp {};
@@ -174,6 +308,18 @@ void RVKPainter::ensureRenderPass() noexcept
     vkCmdSetViewport(m_cmd, 0, 1, &vp);
 
     m_renderPassActive = true;
+
+    // The CLEAR render pass could not be created, clear within the LOAD one
+    if (!clear || folded)
+        return;
+
+    VkClearAttachment attachment {};
+    attachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    attachment.clearValue.color = *clear;
+    VkClearRect rect {};
+    rect.rect.extent = { W, H };
+    rect.layerCount = 1;
+    vkCmdClearAttachments(m_cmd, 1, &attachment, 1, &rect);
 }
 
 void RVKPainter::endRenderPassIfActive() noexcept
@@ -212,12 +358,69 @@ void RVKPainter::transitionSource(const std::shared_ptr<RImage> &img) noexcept
     m_readImages.push_back(img);
 }
 
+// Region rect mapped to image pixels (clamped), exact is false if it does not map to whole pixels
+static VkRect2D ToImageRect(const SkMatrix &vi, const SkIRect &rect, SkISize size, bool *exact = nullptr) noexcept
+{
+    const SkRect mapped { vi.mapRect(SkRect::Make(rect)) };
+    const SkIRect covered { mapped.roundOut() };
+    SkIRect clamped;
+
+    if (!clamped.intersect(covered, SkIRect::MakeSize(size)))
+        clamped.setEmpty();
+
+    if (exact)
+    {
+        constexpr SkScalar epsilon { 1.f / 256.f };
+        *exact = std::abs(mapped.left() - covered.left()) < epsilon && std::abs(mapped.top() - covered.top()) < epsilon &&
+                 std::abs(mapped.right() - covered.right()) < epsilon && std::abs(mapped.bottom() - covered.bottom()) < epsilon;
+    }
+
+    return { { clamped.x(), clamped.y() }, { (UInt32)clamped.width(), (UInt32)clamped.height() } };
+}
+
+bool RVKPainter::useScissorRects(const SkRegion &region, const SkMatrix &vi) const noexcept
+{
+    if (pickRegionStrategy(region) != RegionStrategy::Scissor)
+        return false;
+
+    bool exact { true };
+
+    for (SkRegion::Iterator it(region); !it.done() && exact; it.next())
+        ToImageRect(vi, it.rect(), m_target->size(), &exact);
+
+    return exact;
+}
+
+void RVKPainter::drawRegion(const SkRegion &region, const SkMatrix &vi, bool scissorRects, UInt32 firstVertex, UInt32 quadCount) noexcept
+{
+    if (!scissorRects)
+    {
+        const VkRect2D scissor { ToImageRect(vi, region.getBounds(), m_target->size()) };
+        vkCmdSetScissor(m_cmd, 0, 1, &scissor);
+        vkCmdDraw(m_cmd, quadCount * 6, 1, firstVertex, 0);
+        return;
+    }
+
+    // A single bounds quad, the scissor does the clipping
+    for (SkRegion::Iterator it(region); !it.done(); it.next())
+    {
+        const VkRect2D scissor { ToImageRect(vi, it.rect(), m_target->size()) };
+
+        if (scissor.extent.width == 0 || scissor.extent.height == 0)
+            continue;
+
+        vkCmdSetScissor(m_cmd, 0, 1, &scissor);
+        vkCmdDraw(m_cmd, 6, 1, firstVertex, 0);
+    }
+}
+
 float *RVKPainter::reserveVertices(UInt32 vertexCount, UInt32 &firstVertex) noexcept
 {
     const VkDeviceSize needed { (VkDeviceSize)(m_vertexCount + vertexCount) * 6 * sizeof(float) };
     if (needed > m_vboCapacity)
         return nullptr; // overflow (should not happen for typical regions)
 
+    RProfiler::Count(RProfiler::Vertices, vertexCount);
     firstVertex = m_vertexCount;
     float *ptr { static_cast<float*>(m_vboMapped) + (size_t)m_vertexCount * 6 };
     m_vertexCount += vertexCount;
@@ -230,6 +433,7 @@ void RVKPainter::flush() noexcept
         return;
 
     endRenderPassIfActive();
+    writeTimestamp(m_passEvent, true);
 
     // The render pass leaves the image in COLOR_ATTACHMENT_OPTIMAL (its finalLayout), which is
     // valid for any render-target image. Do NOT force SHADER_READ_ONLY here: render-target-only
@@ -248,50 +452,51 @@ void RVKPainter::flush() noexcept
     // CZ_REAM_VK_SYNC_SUBMIT=1 forces the legacy blocking submit (for A/B comparison / debugging).
     static const bool forceSync { [] { const char *e { std::getenv("CZ_REAM_VK_SYNC_SUBMIT") }; return e && atoi(e) != 0; }() };
 
-    VkFence fence { VK_NULL_HANDLE };
-    VkFenceCreateInfo fi {};
-    fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    const VkFence fence { forceSync ? VK_NULL_HANDLE : dev()->acquireFence() };
 
-    if (forceSync || vkCreateFence(d, &fi, nullptr, &fence) != VK_SUCCESS)
+    if (fence == VK_NULL_HANDLE)
     {
-        if (fence != VK_NULL_HANDLE) { vkDestroyFence(d, fence, nullptr); fence = VK_NULL_HANDLE; }
         // Blocking submit + immediate cleanup (legacy path).
         dev()->submitCommand(m_cmd);
+        ResolveTimestamps(dev(), m_queryPool, m_timestamps);
         vkFreeCommandBuffers(d, m_pool, 1, &m_cmd);
         if (m_framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(d, m_framebuffer, nullptr);
         if (m_descPool != VK_NULL_HANDLE) vkDestroyDescriptorPool(d, m_descPool, nullptr);
         if (m_vboMem != VK_NULL_HANDLE) { vkUnmapMemory(d, m_vboMem); vkFreeMemory(d, m_vboMem, nullptr); }
         if (m_vbo != VK_NULL_HANDLE) vkDestroyBuffer(d, m_vbo, nullptr);
+        RResourceTrackerSubBytes(RVertexMem, dev(), m_vboCapacity);
         if (m_pool != VK_NULL_HANDLE) vkDestroyCommandPool(d, m_pool, nullptr);
     }
     else
     {
-        std::vector<VkSemaphore> ownedWaits;
-        dev()->submitCommandAsync(m_cmd, fence, ownedWaits);
-
         // Hand every per-pass resource to the fence-tracked GC (freed once the GPU is done).
-        const VkCommandPool pool { m_pool };
-        const VkCommandBuffer cmd { m_cmd };
-        const VkBuffer vbo { m_vbo };
-        const VkDeviceMemory vboMem { m_vboMem };
-        const VkDescriptorPool descPool { m_descPool };
-        const VkFramebuffer framebuffer { m_framebuffer };
-        RVKDevice *device { dev() };
-
-        device->deferDestroy(fence, [device, pool, cmd, vbo, vboMem, descPool, framebuffer,
-                                     ow = std::move(ownedWaits)]()
+        auto garbage { std::make_unique<PassGarbage>() };
+        garbage->device = dev();
+        garbage->pool = m_pool;
+        garbage->cmd = m_cmd;
+        garbage->vbo = m_vbo;
+        garbage->vboMem = m_vboMem;
+        garbage->vboSize = m_vboCapacity;
+        garbage->descPool = m_descPool;
+        garbage->framebuffer = m_framebuffer;
+        garbage->queryPool = m_queryPool;
+        garbage->timestamps = std::move(m_timestamps);
+
+        // A fence that never signals would stall this thread's GC, nothing is in flight if the submission failed
+        if (dev()->submitCommandAsync(m_cmd, fence, garbage->ownedWaits))
+            dev()->deferDestroy(fence, std::move(garbage));
+        else
         {
-            const VkDevice dd { device->device() };
-            if (cmd != VK_NULL_HANDLE) vkFreeCommandBuffers(dd, pool, 1, &cmd);
-            if (framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(dd, framebuffer, nullptr);
-            if (descPool != VK_NULL_HANDLE) vkDestroyDescriptorPool(dd, descPool, nullptr);
-            if (vboMem != VK_NULL_HANDLE) { vkUnmapMemory(dd, vboMem); vkFreeMemory(dd, vboMem, nullptr); }
-            if (vbo != VK_NULL_HANDLE) vkDestroyBuffer(dd, vbo, nullptr);
-            if (pool != VK_NULL_HANDLE) vkDestroyCommandPool(dd, pool, nullptr);
-            for (VkSemaphore s : ow) vkDestroySemaphore(dd, s, nullptr);
-        });
+            dev()->recycleFence(fence);
+            m_mipImages.clear();
+        }
     }
 
+    // Later command buffers are queue-ordered after the generation from now on
+    for (auto &mip : m_mipImages)
+        mip.first->asVK()->publishMipmaps(mip.second);
+    m_mipImages.clear();
+
     // These resources now belong to the GC (or were freed on the fallback path).
     m_cmd = VK_NULL_HANDLE;
     m_framebuffer = VK_NULL_HANDLE;
@@ -301,6 +506,8 @@ void RVKPainter::flush() noexcept
     m_vboMapped = nullptr;
     m_vboCapacity = 0;
     m_pool = VK_NULL_HANDLE;
+    m_queryPool = VK_NULL_HANDLE;
+    m_timestamps.clear();
 
     // Publish a read sync for source images (ordered after this submit on the same queue).
     if (!m_readImages.empty())
@@ -331,6 +538,32 @@ static SkColor4f DrawColorColor(const RPainter::State &s) noexcept
     return c;
 }
 
+// Fills the rounded clip fields and, if there is a clip or @p viewportPos, the inverse geometry that maps
+// gl_FragCoord back to viewport coordinates. Returns the number of bytes to push.
+static UInt32 ClipPushConstants(const SkRRect *clip, const SkMatrix &vi, SkScalar pixelSize, RVKPushConstants &pc, bool viewportPos = false) noexcept
+{
+    SkMatrix iv;
+    if ((!clip && !viewportPos) || !vi.invert(&iv))
+        return RVKPushConstantsBaseSize;
+
+    if (clip)
+    {
+        const SkRect &r { clip->rect() };
+        pc.clipRect[0] = r.left(); pc.clipRect[1] = r.top(); pc.clipRect[2] = r.right(); pc.clipRect[3] = r.bottom();
+
+        for (int i = 0; i < 4; i++)
+        {
+            const SkVector radii { clip->radii(SkRRect::Corner(i)) };
+            pc.clipRadiiX[i] = radii.x();
+            pc.clipRadiiY[i] = radii.y();
+        }
+    }
+
+    pc.clipMapX[0] = iv.getScaleX(); pc.clipMapX[1] = iv.getSkewX();  pc.clipMapX[2] = iv.getTranslateX(); pc.clipMapX[3] = pixelSize;
+    pc.clipMapY[0] = iv.getSkewY();  pc.clipMapY[1] = iv.getScaleY(); pc.clipMapY[2] = iv.getTranslateY();
+    return sizeof(RVKPushConstants);
+}
+
 static RVKBlend ColorBlend(RBlendMode mode) noexcept
 {
     switch (mode)
@@ -346,30 +579,78 @@ static RVKBlend ColorBlend(RBlendMode mode) noexcept
 
 bool RVKPainter::drawColor(const SkRegion &userRegion) noexcept
 {
+    if (deferDrawColor(userRegion))
+        return true;
+
+    const ProfiledDraw profile { this, "drawColor" };
+
     if (blendMode() == RBlendMode::SrcOver && (SkColorGetA(color()) == 0 || factor().fA <= 0.f || opacity() <= 0.f))
         return true;
 
     if (!m_target)
         return false;
 
-    const SkIRect clipRect { geometry().viewport.roundOut() };
-    SkRegion region;
-    if (!region.op(clipRect, userRegion, SkRegion::kIntersect_Op))
+    SkRegion region { viewportClip() };
+    if (!region.op(userRegion, SkRegion::kIntersect_Op))
         return true;
 
-    const SkColor4f colorF { DrawColorColor(m_state) };
-    if (blendMode() == RBlendMode::DstIn && colorF.fA >= 1.f)
+    const SkColor4f colorF { mapOutputColor(DrawColorColor(m_state), true) };
+    const SkRRect *clipRRect { coverageClip() };
+    if (blendMode() == RBlendMode::DstIn && colorF.fA >= 1.f && !clipRRect)
         return true; // multiplying dst by 1 is a no-op
 
+    SkRegion clearRegion;
+
+    if (calcClearRegion(region, colorF, clearRegion))
+    {
+        if (clearRegion.isEmpty())
+            return true;
+
+        if (!beginRecording())
+            return false;
+
+        const VkClearColorValue value { .float32 = { colorF.fR, colorF.fG, colorF.fB, colorF.fA } };
+
+        // A full clear before the render pass begins is folded into its loadOp
+        if (!m_renderPassActive && clearRegion.isRect() && clearRegion.getBounds() == SkIRect::MakeSize(m_target->size()))
+        {
+            ensureRenderPass(&value);
+            return true;
+        }
+
+        ensureRenderPass();
+
+        std::vector<VkClearRect> rects;
+        rects.reserve(clearRegion.computeRegionComplexity());
+
+        for (SkRegion::Iterator it(clearRegion); !it.done(); it.next())
+        {
+            const SkIRect &r { it.rect() };
+            rects.emplace_back(VkClearRect {
+                .rect = { { r.x(), r.y() }, { UInt32(r.width()), UInt32(r.height()) } },
+                .baseArrayLayer = 0,
+                .layerCount = 1 });
+        }
+
+        VkClearAttachment attachment {};
+        attachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        attachment.colorAttachment = 0;
+        attachment.clearValue.color = value;
+        vkCmdClearAttachments(m_cmd, 1, &attachment, rects.size(), rects.data());
+        return true;
+    }
+
     if (!beginRecording())
         return false;
     ensureRenderPass();
 
     const int W { m_target->size().width() };
     const int H { m_target->size().height() };
-    const SkMatrix vi { RMatrixUtils::VirtualToImage(geometry().transform, geometry().viewport, geometry().dst) };
+    const SkMatrix &vi { virtualToImage() };
 
-    const UInt32 quadCount { (UInt32)region.computeRegionComplexity() };
+    const bool scissorRects { useScissorRects(region, vi) };
+    const SkRegion quads { scissorRects ? SkRegion(region.getBounds()) : region };
+    const UInt32 quadCount { (UInt32)quads.computeRegionComplexity() };
     UInt32 firstVertex { 0 };
     float *v { reserveVertices(quadCount * 6, firstVertex) };
     if (!v)
@@ -383,7 +664,7 @@ bool RVKPainter::drawColor(const SkRegion &userRegion) noexcept
         *v++ = 0.f; *v++ = 0.f;           // maskUV (unused)
     };
 
-    for (SkRegion::Iterator it(region); !it.done(); it.next())
+    for (SkRegion::Iterator it(quads); !it.done(); it.next())
     {
         const SkRect r { SkRect::Make(it.rect()) };
         SkPoint c[4] {
@@ -395,7 +676,7 @@ bool RVKPainter::drawColor(const SkRegion &userRegion) noexcept
     }
 
     auto *pm { dev()->pipelines() };
-    VkPipeline pipe { pm->colorPipeline(m_rp, m_format, ColorBlend(blendMode())) };
+    VkPipeline pipe { pm->colorPipeline(m_rp, m_format, ColorBlend(blendMode()), clipRRect != nullptr) };
     if (pipe == VK_NULL_HANDLE)
         return false;
 
@@ -404,27 +685,92 @@ bool RVKPainter::drawColor(const SkRegion &userRegion) noexcept
     VkDeviceSize vboOffset { 0 };
     vkCmdBindVertexBuffers(m_cmd, 0, 1, &m_vbo, &vboOffset);
 
-    // Scissor = region bounds mapped to image coords.
-    SkRect bounds; vi.mapRect(&bounds, SkRect::Make(region.getBounds()));
-    VkRect2D scissor {};
-    const int x0 { std::clamp((int)std::floor(bounds.left()), 0, W) };
-    const int y0 { std::clamp((int)std::floor(bounds.top()), 0, H) };
-    const int x1 { std::clamp((int)std::ceil(bounds.right()), 0, W) };
-    const int y1 { std::clamp((int)std::ceil(bounds.bottom()), 0, H) };
-    scissor.offset = { x0, y0 };
-    scissor.extent = { (UInt32)std::max(0, x1 - x0), (UInt32)std::max(0, y1 - y0) };
-    vkCmdSetScissor(m_cmd, 0, 1, &scissor);
-
     RVKPushConstants pc {};
     pc.color[0] = colorF.fR; pc.color[1] = colorF.fG; pc.color[2] = colorF.fB; pc.color[3] = colorF.fA;
-    vkCmdPushConstants(m_cmd, pm->colorLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pc), &pc);
+    const UInt32 pcSize { ClipPushConstants(clipRRect, vi, viewportPixelSize(), pc) };
+    vkCmdPushConstants(m_cmd, pm->colorLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, pcSize, &pc);
+
+    drawRegion(region, vi, scissorRects, firstVertex, quadCount);
+    return true;
+}
+
+bool RVKPainter::drawShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread, const SkRegion *userRegion) noexcept
+{
+    if (deferDrawShadow(rrect, sigma, color, spread, userRegion))
+        return true;
+
+    const ProfiledDraw profile { this, "drawShadow" };
+
+    ShadowInfo shadow;
+    if (!calcShadow(rrect, sigma, color, spread, userRegion, shadow))
+        return true;
+
+    if (!m_target)
+        return false;
+
+    if (!beginRecording())
+        return false;
+    ensureRenderPass();
+
+    const int W { m_target->size().width() };
+    const int H { m_target->size().height() };
+    const SkMatrix &vi { virtualToImage() };
+    const SkRegion &region { shadow.region };
+
+    const bool scissorRects { useScissorRects(region, vi) };
+    const SkRegion quads { scissorRects ? SkRegion(region.getBounds()) : region };
+    const UInt32 quadCount { (UInt32)quads.computeRegionComplexity() };
+    UInt32 firstVertex { 0 };
+    float *v { reserveVertices(quadCount * 6, firstVertex) };
+    if (!v)
+        return false;
+
+    const auto emit = [&](float ix, float iy)
+    {
+        *v++ = 2.f * ix / (float)W - 1.f;
+        *v++ = 2.f * iy / (float)H - 1.f;
+        *v++ = 0.f; *v++ = 0.f;
+        *v++ = 0.f; *v++ = 0.f;
+    };
+
+    for (SkRegion::Iterator it(quads); !it.done(); it.next())
+    {
+        const SkRect r { SkRect::Make(it.rect()) };
+        SkPoint c[4] {
+            { r.fLeft, r.fTop }, { r.fRight, r.fTop }, { r.fRight, r.fBottom }, { r.fLeft, r.fBottom } };
+        vi.mapPoints(c, 4);
+        emit(c[0].fX, c[0].fY); emit(c[1].fX, c[1].fY); emit(c[2].fX, c[2].fY);
+        emit(c[0].fX, c[0].fY); emit(c[2].fX, c[2].fY); emit(c[3].fX, c[3].fY);
+    }
+
+    const SkRRect *clipRRect { coverageClip() };
+    auto *pm { dev()->pipelines() };
+
+    // The coverage is multiplied into the alpha, so Src blends like drawColor() and SrcOver always blends
+    VkPipeline pipe { pm->colorPipeline(m_rp, m_format, ColorBlend(blendMode()), clipRRect != nullptr, true) };
+    if (pipe == VK_NULL_HANDLE)
+        return false;
+
+    vkCmdBindPipeline(m_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe);
+
+    VkDeviceSize vboOffset { 0 };
+    vkCmdBindVertexBuffers(m_cmd, 0, 1, &m_vbo, &vboOffset);
 
-    vkCmdDraw(m_cmd, quadCount * 6, 1, firstVertex, 0);
+    RVKPushConstants pc {};
+    pc.color[0] = shadow.color.fR; pc.color[1] = shadow.color.fG; pc.color[2] = shadow.color.fB; pc.color[3] = shadow.color.fA;
+    std::memcpy(pc.factor, shadow.radii, sizeof(pc.factor));
+    const SkRect &r { shadow.rrect.rect() };
+    pc.shadowRect[0] = r.left(); pc.shadowRect[1] = r.top(); pc.shadowRect[2] = r.right(); pc.shadowRect[3] = r.bottom();
+    const UInt32 pcSize { ClipPushConstants(clipRRect, vi, viewportPixelSize(), pc, true) };
+    pc.clipMapY[3] = shadow.sigma;
+    vkCmdPushConstants(m_cmd, pm->colorLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, pcSize, &pc);
+
+    drawRegion(region, vi, scissorRects, firstVertex, quadCount);
     return true;
 }
 
 // Blend selection mirroring RGLPainter::drawImage's glBlendFunc chain.
-static RVKBlend ImageBlend(RBlendMode mode, bool replaceColor, SkAlphaType at, float colorA, bool hasMask) noexcept
+static RVKBlend ImageBlend(RBlendMode mode, bool replaceColor, SkAlphaType at, float colorA, bool hasMask, bool hasClip) noexcept
 {
     const RVKBlend disabled { false, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO };
     const RVKBlend srcAlphaZero { true, VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ZERO, VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO };
@@ -435,13 +781,14 @@ static RVKBlend ImageBlend(RBlendMode mode, bool replaceColor, SkAlphaType at, f
     if (mode == RBlendMode::Src)
     {
         if (replaceColor) return srcAlphaZero;
-        return (at == kUnpremul_SkAlphaType) ? srcAlphaZero : disabled;
+        // The clip coverage is applied to the alpha of opaque images
+        return (at == kUnpremul_SkAlphaType || (hasClip && at == kOpaque_SkAlphaType)) ? srcAlphaZero : disabled;
     }
     if (mode == RBlendMode::SrcOver)
     {
         if (replaceColor) return srcAlphaOver;
         if (at == kOpaque_SkAlphaType)
-            return (colorA >= 1.f && !hasMask) ? disabled : srcAlphaOver;
+            return (colorA >= 1.f && !hasMask && !hasClip) ? disabled : srcAlphaOver;
         if (at == kUnpremul_SkAlphaType) return srcAlphaOver;
         return premultOver; // premultiplied
     }
@@ -450,6 +797,11 @@ static RVKBlend ImageBlend(RBlendMode mode, bool replaceColor, SkAlphaType at, f
 
 bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip, const RDrawImageInfo *maskInfo) noexcept
 {
+    if (deferDrawImage(imageInfo, clip, maskInfo))
+        return true;
+
+    const ProfiledDraw profile { this, "drawImage" };
+
     if (blendMode() == RBlendMode::SrcOver && (factor().fA <= 0.f || opacity() <= 0.f))
         return true;
     if (!m_target)
@@ -459,7 +811,7 @@ bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip
     if (!image)
         return false;
 
-    SkRegion region { geometry().viewport.roundOut() };
+    SkRegion region { viewportClip() };
     region.op(imageInfo.dst, SkRegion::kIntersect_Op);
     if (maskInfo)
         region.op(maskInfo->dst, SkRegion::kIntersect_Op);
@@ -483,15 +835,18 @@ bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip
     SkColor4f colorF { m_state.factor };
     if (replaceColor)
     {
-        const SkColor4f rc { SkColor4f::FromColor(color()) };
+        // sRGB, the gamma LUT is applied by the shader
+        const SkColor4f rc { RColorDescription::Convert(SkColor4f::FromColor(color()), {}, m_target->colorDescription(), false) };
         colorF.fA *= opacity();
         colorF.fR *= rc.fR; colorF.fG *= rc.fG; colorF.fB *= rc.fB;
     }
     else
         colorF.fA *= opacity();
 
+    const SkRRect *clipRRect { coverageClip() };
+
     // Fast-paths for opaque source + no mask (reduce to a solid color fill).
-    if (image->alphaType() == kOpaque_SkAlphaType && !mask)
+    if (image->alphaType() == kOpaque_SkAlphaType && !mask && !clipRRect)
     {
         if (blendMode() == RBlendMode::DstIn)
         {
@@ -527,12 +882,50 @@ bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip
     if (maskVk && dev() != maskVk->allocatorVK() && !maskVk->ensureCrossDevice(dev()))
         return false;
 
+    std::shared_ptr<RImage> lut;
+    RVKImage *lutVk { nullptr };
+    if (gammaLUT() && gammaLUT()->size() > 0 && blendMode() != RBlendMode::DstIn)
+    {
+        lut = gammaLUT()->image(dev());
+        lutVk = lut ? lut->asVK().get() : nullptr;
+        if (!lutVk || lutVk->vkImageView() == VK_NULL_HANDLE)
+        {
+            RLog(CZError, CZLN, "Failed to get the gamma LUT image");
+            return false;
+        }
+        if (dev() != lutVk->allocatorVK() && !lutVk->ensureCrossDevice(dev()))
+            return false;
+    }
+
     if (!beginRecording())
         return false;
 
+    VkImageView mipView { VK_NULL_HANDLE };
+    if (image->mipmaps() && imageInfo.minFilter == RImageFilter::Linear && dev() == srcVk->allocatorVK() && isMinified(imageInfo))
+    {
+        const auto recorded { std::find_if(m_mipImages.begin(), m_mipImages.end(), [&](const auto &mip)
+            { return mip.first == image && mip.second == image->writeSerial(); }) };
+
+        // Already generated earlier in this command buffer
+        if (recorded != m_mipImages.end())
+            mipView = srcVk->mipmapsView();
+        else
+        {
+            // Blits are illegal inside a render pass.
+            endRenderPassIfActive();
+            std::optional<UInt32> generated;
+            mipView = srcVk->recordMipmaps(m_cmd, generated);
+
+            if (generated)
+                m_mipImages.emplace_back(image, *generated);
+        }
+    }
+
     transitionSource(image);
     if (mask)
         transitionSource(mask);
+    if (lut)
+        transitionSource(lut);
 
     ensureRenderPass();
 
@@ -541,15 +934,22 @@ bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip
     spec.replaceImageColor = replaceColor ? 1 : 0;
     spec.premultSrc = (!replaceColor && blendMode() != RBlendMode::DstIn && image->alphaType() == kPremul_SkAlphaType) ? 1 : 0;
     spec.blendDstIn = (blendMode() == RBlendMode::DstIn) ? 1 : 0;
+    spec.hasClip = clipRRect ? 1 : 0;
+    spec.hasGammaLUT = lut ? 1 : 0;
 
-    const RVKBlend blend { ImageBlend(blendMode(), replaceColor, image->alphaType(), colorF.fA, mask != nullptr) };
+    // The samples are converted into the destination encoding before anything else
+    const RColorDescription &srcDesc { image->colorDescription() };
+    const RColorDescription &dstDesc { m_target->colorDescription() };
+    spec.hasColorTransform = (!replaceColor && blendMode() != RBlendMode::DstIn && srcDesc != dstDesc) ? 1 : 0;
+
+    const RVKBlend blend { ImageBlend(blendMode(), replaceColor, image->alphaType(), colorF.fA, mask != nullptr, clipRRect != nullptr) };
 
     auto *pm { dev()->pipelines() };
     VkPipeline pipe { pm->imagePipeline(m_rp, m_format, blend, spec) };
     if (pipe == VK_NULL_HANDLE)
         return false;
 
-    // Allocate + update a descriptor set (image + mask combined image samplers).
+    // Allocate + update a descriptor set (image + mask + gamma LUT combined image samplers).
     VkDescriptorSetLayout setLayout { pm->imageSetLayout() };
     VkDescriptorSetAllocateInfo dsa {};
     dsa.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
@@ -560,19 +960,24 @@ bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip
     if (vkAllocateDescriptorSets(dev()->device(), &dsa, &set) != VK_SUCCESS)
         return false;
 
-    VkSampler imgSampler { pm->sampler(imageInfo.minFilter, imageInfo.magFilter, imageInfo.wrapS, imageInfo.wrapT) };
+    VkSampler imgSampler { pm->sampler(imageInfo.minFilter, imageInfo.magFilter, imageInfo.wrapS, imageInfo.wrapT, mipView != VK_NULL_HANDLE) };
     VkSampler maskSampler { mask ? pm->sampler(maskInfo->minFilter, maskInfo->magFilter, maskInfo->wrapS, maskInfo->wrapT) : imgSampler };
 
-    VkDescriptorImageInfo dii[2] {};
+    VkSampler lutSampler { lut ? pm->sampler(RImageFilter::Linear, RImageFilter::Linear, RImageWrap::ClampToEdge, RImageWrap::ClampToEdge) : imgSampler };
+
+    VkDescriptorImageInfo dii[3] {};
     dii[0].sampler = imgSampler;
-    dii[0].imageView = srcVk->vkImageView(dev()); // per-device view (cross-device aware)
+    dii[0].imageView = mipView != VK_NULL_HANDLE ? mipView : srcVk->vkImageView(dev()); // per-device view (cross-device aware)
     dii[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     dii[1].sampler = maskSampler;
-    dii[1].imageView = (maskVk ? maskVk : srcVk)->vkImageView(dev()); // dummy = source when no mask
+    dii[1].imageView = maskVk ? maskVk->vkImageView(dev()) : dii[0].imageView; // dummy = source when no mask
     dii[1].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    dii[2].sampler = lutSampler;
+    dii[2].imageView = lutVk ? lutVk->vkImageView(dev()) : dii[0].imageView; // dummy = source when no LUT
+    dii[2].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-    VkWriteDescriptorSet writes[2] {};
-    for (UInt32 i = 0; i < 2; i++)
+    VkWriteDescriptorSet writes[3] {};
+    for (UInt32 i = 0; i < 3; i++)
     {
         writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         writes[i].dstSet = set;
@@ -581,19 +986,21 @@ bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip
         writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         writes[i].pImageInfo = &dii[i];
     }
-    vkUpdateDescriptorSets(dev()->device(), 2, writes, 0, nullptr);
+    vkUpdateDescriptorSets(dev()->device(), 3, writes, 0, nullptr);
 
     // Vertices: NDC positions + normalized image/mask UVs (all derived on the CPU).
     const int W { m_target->size().width() };
     const int H { m_target->size().height() };
-    const SkMatrix vi { RMatrixUtils::VirtualToImage(geometry().transform, geometry().viewport, geometry().dst) };
+    const SkMatrix &vi { virtualToImage() };
     const SkMatrix imageProj { RMatrixUtils::VirtualToUV(SkRect::Make(imageInfo.dst), imageInfo.srcTransform, imageInfo.srcScale, imageInfo.src, image->size()) };
     SkMatrix maskProj;
     maskProj.setIdentity();
     if (mask)
         maskProj = RMatrixUtils::VirtualToUV(SkRect::Make(maskInfo->dst), maskInfo->srcTransform, maskInfo->srcScale, maskInfo->src, mask->size());
 
-    const UInt32 quadCount { (UInt32)region.computeRegionComplexity() };
+    const bool scissorRects { useScissorRects(region, vi) };
+    const SkRegion quads { scissorRects ? SkRegion(region.getBounds()) : region };
+    const UInt32 quadCount { (UInt32)quads.computeRegionComplexity() };
     UInt32 firstVertex { 0 };
     float *v { reserveVertices(quadCount * 6, firstVertex) };
     if (!v)
@@ -609,7 +1016,7 @@ bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip
         *v++ = muv.fX; *v++ = muv.fY;
     };
 
-    for (SkRegion::Iterator it(region); !it.done(); it.next())
+    for (SkRegion::Iterator it(quads); !it.done(); it.next())
     {
         const SkRect r { SkRect::Make(it.rect()) };
         SkPoint vpts[4] { { r.fLeft, r.fTop }, { r.fRight, r.fTop }, { r.fRight, r.fBottom }, { r.fLeft, r.fBottom } };
@@ -624,26 +1031,30 @@ bool RVKPainter::drawImage(const RDrawImageInfo &imageInfo, const SkRegion *clip
     vkCmdBindVertexBuffers(m_cmd, 0, 1, &m_vbo, &vboOffset);
     vkCmdBindDescriptorSets(m_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pm->imageLayout(), 0, 1, &set, 0, nullptr);
 
-    SkRect bounds; vi.mapRect(&bounds, SkRect::Make(region.getBounds()));
-    VkRect2D scissor {};
-    const int x0 { std::clamp((int)std::floor(bounds.left()), 0, W) };
-    const int y0 { std::clamp((int)std::floor(bounds.top()), 0, H) };
-    const int x1 { std::clamp((int)std::ceil(bounds.right()), 0, W) };
-    const int y1 { std::clamp((int)std::ceil(bounds.bottom()), 0, H) };
-    scissor.offset = { x0, y0 };
-    scissor.extent = { (UInt32)std::max(0, x1 - x0), (UInt32)std::max(0, y1 - y0) };
-    vkCmdSetScissor(m_cmd, 0, 1, &scissor);
-
     RVKPushConstants pc {};
     pc.factor[0] = colorF.fR; pc.factor[1] = colorF.fG; pc.factor[2] = colorF.fB; pc.factor[3] = colorF.fA;
-    vkCmdPushConstants(m_cmd, pm->imageLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pc), &pc);
 
-    vkCmdDraw(m_cmd, quadCount * 6, 1, firstVertex, 0);
+    if (spec.hasColorTransform)
+    {
+        pc.color[0] = float(srcDesc.transfer);
+        pc.color[1] = float(dstDesc.transfer);
+        pc.color[2] = srcDesc.primaries == dstDesc.primaries ? 0.f : (srcDesc.primaries == RPrimaries::SRGB ? 1.f : 2.f);
+    }
+
+    const UInt32 pcSize { ClipPushConstants(clipRRect, vi, viewportPixelSize(), pc) };
+    vkCmdPushConstants(m_cmd, pm->imageLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, pcSize, &pc);
+
+    drawRegion(region, vi, scissorRects, firstVertex, quadCount);
     return true;
 }
 
 bool RVKPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect effect, const SkRegion *clip) noexcept
 {
+    if (deferDrawImageEffect(imageInfo, effect, clip))
+        return true;
+
+    const ProfiledDraw profile { this, "drawImageEffect" };
+
     if (!m_target)
         return false;
 
@@ -651,7 +1062,7 @@ bool RVKPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect ef
     if (!image)
         return false;
 
-    SkRegion region { geometry().viewport.roundOut() };
+    SkRegion region { viewportClip() };
     region.op(imageInfo.dst, SkRegion::kIntersect_Op);
     if (clip)
         region.op(*clip, SkRegion::kIntersect_Op);
@@ -707,10 +1118,12 @@ bool RVKPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect ef
 
     const int W { m_target->size().width() };
     const int H { m_target->size().height() };
-    const SkMatrix vi { RMatrixUtils::VirtualToImage(geometry().transform, geometry().viewport, geometry().dst) };
+    const SkMatrix &vi { virtualToImage() };
     const SkMatrix imageProj { RMatrixUtils::VirtualToUV(SkRect::Make(imageInfo.dst), imageInfo.srcTransform, imageInfo.srcScale, imageInfo.src, image->size()) };
 
-    const UInt32 quadCount { (UInt32)region.computeRegionComplexity() };
+    const bool scissorRects { useScissorRects(region, vi) };
+    const SkRegion quads { scissorRects ? SkRegion(region.getBounds()) : region };
+    const UInt32 quadCount { (UInt32)quads.computeRegionComplexity() };
     UInt32 firstVertex { 0 };
     float *v { reserveVertices(quadCount * 6, firstVertex) };
     if (!v)
@@ -725,7 +1138,7 @@ bool RVKPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect ef
         *v++ = 0.f; *v++ = 0.f;
     };
 
-    for (SkRegion::Iterator it(region); !it.done(); it.next())
+    for (SkRegion::Iterator it(quads); !it.done(); it.next())
     {
         const SkRect r { SkRect::Make(it.rect()) };
         SkPoint vpts[4] { { r.fLeft, r.fTop }, { r.fRight, r.fTop }, { r.fRight, r.fBottom }, { r.fLeft, r.fBottom } };
@@ -740,22 +1153,29 @@ bool RVKPainter::drawImageEffect(const RDrawImageInfo &imageInfo, ImageEffect ef
     vkCmdBindVertexBuffers(m_cmd, 0, 1, &m_vbo, &vboOffset);
     vkCmdBindDescriptorSets(m_cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pm->imageLayout(), 0, 1, &set, 0, nullptr);
 
-    SkRect bounds; vi.mapRect(&bounds, SkRect::Make(region.getBounds()));
-    VkRect2D scissor {};
-    const int x0 { std::clamp((int)std::floor(bounds.left()), 0, W) };
-    const int y0 { std::clamp((int)std::floor(bounds.top()), 0, H) };
-    const int x1 { std::clamp((int)std::ceil(bounds.right()), 0, W) };
-    const int y1 { std::clamp((int)std::ceil(bounds.bottom()), 0, H) };
-    scissor.offset = { x0, y0 };
-    scissor.extent = { (UInt32)std::max(0, x1 - x0), (UInt32)std::max(0, y1 - y0) };
-    vkCmdSetScissor(m_cmd, 0, 1, &scissor);
-
     RVKPushConstants pc {};
     pc.factor[0] = (effect == VibrancyH)
         ? imageInfo.srcScale / (float)imageInfo.src.width()
         : imageInfo.srcScale / (float)imageInfo.src.height(); // pixelSize
-    vkCmdPushConstants(m_cmd, pm->imageLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pc), &pc);
 
-    vkCmdDraw(m_cmd, quadCount * 6, 1, firstVertex, 0);
+    // BT.709 limited range levels, 10 bit codes in the upper bits of 16 bit samples for P010 planes
+    if (effect == YUVLuma || effect == YUVChroma)
+    {
+        const bool tenBit { m_format == VK_FORMAT_R16_UNORM || m_format == VK_FORMAT_R16G16_UNORM };
+
+        if (effect == YUVLuma)
+        {
+            pc.factor[1] = tenBit ? 64.f * 64.f / 65535.f : 16.f / 255.f;
+            pc.factor[2] = tenBit ? 876.f * 64.f / 65535.f : 219.f / 255.f;
+        }
+        else
+        {
+            pc.factor[1] = tenBit ? 512.f * 64.f / 65535.f : 128.f / 255.f;
+            pc.factor[2] = tenBit ? 896.f * 64.f / 65535.f : 224.f / 255.f;
+        }
+    }
+    vkCmdPushConstants(m_cmd, pm->imageLayout(), VK_SHADER_STAGE_FRAGMENT_BIT, 0, RVKPushConstantsBaseSize, &pc);
+
+    drawRegion(region, vi, scissorRects, firstVertex, quadCount);
     return true;
 }
@@ -18,6 +18,7 @@ class CZ::RVKPainter final : public RPainter
 public:
     bool drawImage(const RDrawImageInfo &image, const SkRegion *region = nullptr, const RDrawImageInfo *mask = nullptr) noexcept override;
     bool drawColor(const SkRegion &region) noexcept override;
+    bool drawShadow(const SkRRect &rrect, SkScalar sigma, SkColor color, SkScalar spread = 0.f, const SkRegion *region = nullptr) noexcept override;
     bool drawImageEffect(const RDrawImageInfo &image, ImageEffect effect, const SkRegion *region = nullptr) noexcept override;
     bool setGeometry(const RSurfaceGeometry &geometry) noexcept override;
 
@@ -30,11 +31,27 @@ private:
     RVKPainter(std::shared_ptr<RSurface> surface, RVKDevice *device) noexcept;
     RVKDevice *dev() const noexcept;
 
+    // RProfiler timestamps, each event takes two consecutive queries of m_queryPool
+    struct Timestamp
+    {
+        UInt64 event;
+        UInt32 query;
+        bool ended;
+    };
+
+    // Per-pass resources handed to RVKDevice::deferDestroy() after an async submission
+    struct PassGarbage;
+
+    void writeTimestamp(UInt64 event, bool end) noexcept override;
+    static void ResolveTimestamps(RVKDevice *device, VkQueryPool pool, const std::vector<Timestamp> &timestamps) noexcept;
+
     bool beginRecording() noexcept;              // begin cmd buffer + transition target
-    void ensureRenderPass() noexcept;            // begin render pass lazily (after source transitions)
+    void ensureRenderPass(const VkClearColorValue *clear = nullptr) noexcept; // begin render pass lazily (after source transitions), loadOp=CLEAR if clear
     void endRenderPassIfActive() noexcept;
     void transitionSource(const std::shared_ptr<RImage> &img) noexcept; // -> SHADER_READ_ONLY, outside render pass
     float *reserveVertices(UInt32 vertexCount, UInt32 &firstVertex) noexcept; // returns mapped write ptr
+    bool useScissorRects(const SkRegion &region, const SkMatrix &vi) const noexcept; // RegionStrategy::Scissor and pixel exact
+    void drawRegion(const SkRegion &region, const SkMatrix &vi, bool scissorRects, UInt32 firstVertex, UInt32 quadCount) noexcept; // scissor + vkCmdDraw
 
     RVKImage *m_target { nullptr };
     VkFormat m_format { VK_FORMAT_UNDEFINED };
@@ -43,12 +60,17 @@ private:
     VkCommandPool m_pool { VK_NULL_HANDLE };
     VkCommandBuffer m_cmd { VK_NULL_HANDLE };
     VkDescriptorPool m_descPool { VK_NULL_HANDLE };
+    VkQueryPool m_queryPool { VK_NULL_HANDLE };
+    std::vector<Timestamp> m_timestamps;
     bool m_recording { false };
     bool m_renderPassActive { false };
 
     // Source images read during this pass; assigned a read sync at flush.
     std::vector<std::shared_ptr<RImage>> m_readImages;
 
+    // Mipmap generations recorded during this pass (image, writeSerial), published after the submission
+    std::vector<std::pair<std::shared_ptr<RImage>, UInt32>> m_mipImages;
+
     VkBuffer m_vbo { VK_NULL_HANDLE };
     VkDeviceMemory m_vboMem { VK_NULL_HANDLE };
     void *m_vboMapped { nullptr };
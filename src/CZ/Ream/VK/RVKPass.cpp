@@ -29,7 +29,10 @@ RVKPass::~RVKPass() noexcept
 {
     // Submit any recorded painter work first (ordered before the base ~RPass write-sync submit).
     if (m_painter)
+    {
+        m_painter->flushDeferredDraws();
         static_cast<RVKPainter*>(m_painter.get())->flush();
+    }
 
     // Realize deferred Skia work on the queue so it is ordered before the write-sync submit
     // that the base ~RPass issues, then reconcile the image's tracked layout with Skia's.
@@ -50,7 +53,12 @@ SkCanvas *RVKPass::getCanvas(bool sync) const noexcept
         return nullptr;
 
     if (sync)
+    {
+        if (m_painter)
+            m_painter->flushDeferredDraws();
+
         m_lastUsage = RPassCap_SkCanvas;
+    }
 
     return m_skSurface->getCanvas();
 }
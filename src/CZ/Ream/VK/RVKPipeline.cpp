@@ -1,5 +1,6 @@
 #include <CZ/Ream/VK/RVKPipeline.h>
 #include <CZ/Ream/VK/RVKDevice.h>
+#include <CZ/Ream/RProfiler.h>
 #include <CZ/Ream/RLog.h>
 #include <cstdint>
 
@@ -75,10 +76,10 @@ bool RVKPipeline::init() noexcept
             return false;
     }
 
-    // Image descriptor set layout: image + mask combined image samplers.
+    // Image descriptor set layout: image + mask + gamma LUT combined image samplers.
     {
-        VkDescriptorSetLayoutBinding bindings[2] {};
-        for (UInt32 i = 0; i < 2; i++)
+        VkDescriptorSetLayoutBinding bindings[3] {};
+        for (UInt32 i = 0; i < 3; i++)
         {
             bindings[i].binding = i;
             bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -87,7 +88,7 @@ bool RVKPipeline::init() noexcept
         }
         VkDescriptorSetLayoutCreateInfo si {};
         si.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        si.bindingCount = 2;
+        si.bindingCount = 3;
         si.pBindings = bindings;
         if (vkCreateDescriptorSetLayout(dev, &si, nullptr, &m_imageSetLayout) != VK_SUCCESS)
             return false;
@@ -105,16 +106,17 @@ bool RVKPipeline::init() noexcept
     return true;
 }
 
-VkRenderPass RVKPipeline::renderPass(VkFormat format) noexcept
+VkRenderPass RVKPipeline::renderPass(VkFormat format, bool clear) noexcept
 {
-    const auto it { m_renderPasses.find(format) };
+    const UInt64 key { UInt64(format) | (UInt64(clear) << 32) };
+    const auto it { m_renderPasses.find(key) };
     if (it != m_renderPasses.end())
         return it->second;
 
     VkAttachmentDescription color {};
     color.format = format;
     color.samples = VK_SAMPLE_COUNT_1_BIT;
-    color.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;   // preserve existing content
+    color.loadOp = clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD; // LOAD preserves existing content
     color.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -159,13 +161,13 @@ VkRenderPass RVKPipeline::renderPass(VkFormat format) noexcept
         RLog(CZError, CZLN, "RVKPipeline: vkCreateRenderPass failed");
         return VK_NULL_HANDLE;
     }
-    m_renderPasses.emplace(format, out);
+    m_renderPasses.emplace(key, out);
     return out;
 }
 
 VkPipeline RVKPipeline::buildPipeline(VkRenderPass rp, int frag, const RVKBlend &blend, const void *specData, UInt32 specCount) noexcept
 {
-    VkSpecializationMapEntry specEntries[4] {};
+    VkSpecializationMapEntry specEntries[7] {};
     VkSpecializationInfo specInfo {};
     if (specData && specCount > 0)
     {
@@ -271,18 +273,21 @@ VkPipeline RVKPipeline::buildPipeline(VkRenderPass rp, int frag, const RVKBlend
     VkPipeline out { VK_NULL_HANDLE };
     if (vkCreateGraphicsPipelines(m_dev->device(), m_cache, 1, &pi, nullptr, &out) != VK_SUCCESS)
         RLog(CZError, CZLN, "RVKPipeline: vkCreateGraphicsPipelines failed");
+    else
+        RProfiler::Count(RProfiler::PipelineCreations);
     return out;
 }
 
-VkPipeline RVKPipeline::colorPipeline(VkRenderPass rp, VkFormat format, const RVKBlend &blend) noexcept
+VkPipeline RVKPipeline::colorPipeline(VkRenderPass rp, VkFormat format, const RVKBlend &blend, bool clip, bool shadow) noexcept
 {
-    // key layout: [0..31]=format  [32..33]=mode  [34..39]=payload  [40..]=blendHash
-    const UInt64 key { UInt64(format) | (UInt64(0) << 32) | (BlendHash(blend) << 40) };
+    // key layout: [0..31]=format  [32..33]=mode  [34..40]=payload  [41..]=blendHash
+    const UInt64 key { UInt64(format) | (UInt64(0) << 32) | (UInt64(clip) << 34) | (UInt64(shadow) << 35) | (BlendHash(blend) << 41) };
     const auto it { m_pipelines.find(key) };
     if (it != m_pipelines.end())
         return it->second;
 
-    VkPipeline p { buildPipeline(rp, 0, blend, nullptr, 0) };
+    const UInt32 specData[2] { clip ? 1u : 0u, shadow ? 1u : 0u };
+    VkPipeline p { buildPipeline(rp, 0, blend, specData, 2) };
     if (p != VK_NULL_HANDLE)
         m_pipelines.emplace(key, p);
     return p;
@@ -290,13 +295,13 @@ VkPipeline RVKPipeline::colorPipeline(VkRenderPass rp, VkFormat format, const RV
 
 VkPipeline RVKPipeline::imagePipeline(VkRenderPass rp, VkFormat format, const RVKBlend &blend, const RVKImageSpec &spec) noexcept
 {
-    const UInt64 key { UInt64(format) | (UInt64(1) << 32) | (UInt64(spec.pack()) << 34) | (BlendHash(blend) << 40) };
+    const UInt64 key { UInt64(format) | (UInt64(1) << 32) | (UInt64(spec.pack()) << 34) | (BlendHash(blend) << 41) };
     const auto it { m_pipelines.find(key) };
     if (it != m_pipelines.end())
         return it->second;
 
-    const UInt32 specData[4] { spec.hasMask, spec.replaceImageColor, spec.premultSrc, spec.blendDstIn };
-    VkPipeline p { buildPipeline(rp, 1, blend, specData, 4) };
+    const UInt32 specData[7] { spec.hasMask, spec.replaceImageColor, spec.premultSrc, spec.blendDstIn, spec.hasClip, spec.hasGammaLUT, spec.hasColorTransform };
+    VkPipeline p { buildPipeline(rp, 1, blend, specData, 7) };
     if (p != VK_NULL_HANDLE)
         m_pipelines.emplace(key, p);
     return p;
@@ -317,7 +322,7 @@ VkPipeline RVKPipeline::effectPipeline(VkRenderPass rp, VkFormat format, UInt32
     return p;
 }
 
-VkSampler RVKPipeline::sampler(RImageFilter min, RImageFilter mag, RImageWrap wrapS, RImageWrap wrapT) noexcept
+VkSampler RVKPipeline::sampler(RImageFilter min, RImageFilter mag, RImageWrap wrapS, RImageWrap wrapT, bool mipmaps) noexcept
 {
     const auto toAddr = [](RImageWrap w) -> VkSamplerAddressMode
     {
@@ -330,7 +335,7 @@ VkSampler RVKPipeline::sampler(RImageFilter min, RImageFilter mag, RImageWrap wr
         }
     };
 
-    const UInt32 key { UInt32(min) | (UInt32(mag) << 1) | (UInt32(wrapS) << 2) | (UInt32(wrapT) << 4) };
+    const UInt32 key { UInt32(min) | (UInt32(mag) << 1) | (UInt32(wrapS) << 2) | (UInt32(wrapT) << 4) | (UInt32(mipmaps) << 6) };
     const auto it { m_samplers.find(key) };
     if (it != m_samplers.end())
         return it->second;
@@ -339,12 +344,12 @@ VkSampler RVKPipeline::sampler(RImageFilter min, RImageFilter mag, RImageWrap wr
     si.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
     si.minFilter = (min == RImageFilter::Linear) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
     si.magFilter = (mag == RImageFilter::Linear) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
-    si.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    si.mipmapMode = mipmaps ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
     si.addressModeU = toAddr(wrapS);
     si.addressModeV = toAddr(wrapT);
     si.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
     si.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
-    si.maxLod = 0.f;
+    si.maxLod = mipmaps ? VK_LOD_CLAMP_NONE : 0.f;
 
     VkSampler s { VK_NULL_HANDLE };
     if (vkCreateSampler(m_dev->device(), &si, nullptr, &s) != VK_SUCCESS)
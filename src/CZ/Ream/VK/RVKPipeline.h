@@ -10,13 +10,27 @@
 
 namespace CZ
 {
-    // Push constants shared by the painter shaders (fragment stage). 32 bytes.
+    // Push constants shared by the painter shaders (fragment stage). 128 bytes (the minimum
+    // maxPushConstantsSize), the fields after factor are only pushed by pipelines with HAS_CLIP
+    // or HAS_SHADOW (the first 32 bytes otherwise).
     struct RVKPushConstants
     {
-        float color[4];  // premultiplied (drawColor)
-        float factor[4]; // rgb: per-channel factor, a: final alpha (drawImage)
+        float color[4];  // premultiplied (drawColor, drawShadow), xyz: src/dst RTransferFunction and gamut (drawImage)
+        float factor[4]; // rgb: per-channel factor, a: final alpha (drawImage), shadow corner radii (drawShadow)
+
+        // Rounded clip, in viewport coordinates
+        float clipRect[4];   // LTRB
+        float clipRadiiX[4]; // UL, UR, LR, LL
+        float clipRadiiY[4];
+        float clipMapX[4];   // xyz: gl_FragCoord -> viewport x, w: anti-aliasing width
+        float clipMapY[4];   // xyz: gl_FragCoord -> viewport y, w: shadow sigma
+
+        float shadowRect[4]; // LTRB, viewport coordinates
     };
 
+    // Size of RVKPushConstants without the clip fields
+    static constexpr UInt32 RVKPushConstantsBaseSize { 8 * sizeof(float) };
+
     // Fixed-function blend configuration (matches the GL painter's glBlendFunc choices).
     struct RVKBlend
     {
@@ -31,9 +45,12 @@ namespace CZ
         UInt32 replaceImageColor; ///< 1 to replace the image RGB with the push-constant color.
         UInt32 premultSrc;        ///< 1 if the source is premultiplied alpha.
         UInt32 blendDstIn;        ///< 1 for the DstIn blend path.
+        UInt32 hasClip;           ///< 1 to apply the rounded clip coverage.
+        UInt32 hasGammaLUT;       ///< 1 to map the color through the gamma LUT sampler.
+        UInt32 hasColorTransform; ///< 1 to convert the samples between color descriptions (see RVKPushConstants::color).
 
-        /** @brief Packs the four flags into a single bitfield (used as a pipeline cache key). */
-        UInt32 pack() const noexcept { return hasMask | (replaceImageColor << 1) | (premultSrc << 2) | (blendDstIn << 3); }
+        /** @brief Packs the seven flags into a single bitfield (used as a pipeline cache key). */
+        UInt32 pack() const noexcept { return hasMask | (replaceImageColor << 1) | (premultSrc << 2) | (blendDstIn << 3) | (hasClip << 4) | (hasGammaLUT << 5) | (hasColorTransform << 6); }
     };
 }
 
@@ -53,12 +70,14 @@ public:
     /** @brief Destroys all cached pipelines, render passes, samplers, layouts and shader modules. */
     ~RVKPipeline() noexcept;
 
-    // A single-color-attachment render pass with loadOp=LOAD for the given format.
-    VkRenderPass renderPass(VkFormat format) noexcept;
+    // A single-color-attachment render pass with loadOp=LOAD for the given format, or loadOp=CLEAR if
+    // @p clear. Both are compatible, so they share the pipelines.
+    VkRenderPass renderPass(VkFormat format, bool clear = false) noexcept;
 
     /** @brief Returns (creating and caching if needed) the drawColor pipeline for the given
-     *         render pass/format and blend state. */
-    VkPipeline colorPipeline(VkRenderPass rp, VkFormat format, const RVKBlend &blend) noexcept;
+     *         render pass/format and blend state, with the rounded clip coverage if @p clip and
+     *         the blurred rounded rect coverage (drawShadow) if @p shadow. */
+    VkPipeline colorPipeline(VkRenderPass rp, VkFormat format, const RVKBlend &blend, bool clip = false, bool shadow = false) noexcept;
 
     /** @brief Returns (creating and caching if needed) the drawImage pipeline for the given render
      *         pass/format, blend state, and fragment specialization (@p spec). */
@@ -66,16 +85,16 @@ public:
     // Vibrancy effect pipeline; fx = 1 (H), 2 (V light), 3 (V dark). Blending disabled.
     VkPipeline effectPipeline(VkRenderPass rp, VkFormat format, UInt32 fx) noexcept;
 
-    /** @brief Returns (creating and caching if needed) a sampler for the given filter/wrap modes. */
-    VkSampler sampler(RImageFilter min, RImageFilter mag, RImageWrap wrapS, RImageWrap wrapT) noexcept;
+    /** @brief Returns (creating and caching if needed) a sampler for the given filter/wrap modes (trilinear if mipmaps). */
+    VkSampler sampler(RImageFilter min, RImageFilter mag, RImageWrap wrapS, RImageWrap wrapT, bool mipmaps = false) noexcept;
 
     /** @brief Pipeline layout for the color pipeline (push constants only). */
     VkPipelineLayout colorLayout() const noexcept { return m_colorLayout; }
 
-    /** @brief Pipeline layout for the image/effect pipelines (image+mask sampler set + push constants). */
+    /** @brief Pipeline layout for the image/effect pipelines (image+mask+LUT sampler set + push constants). */
     VkPipelineLayout imageLayout() const noexcept { return m_imageLayout; }
 
-    /** @brief Descriptor set layout of the image+mask combined image samplers. */
+    /** @brief Descriptor set layout of the image, mask and gamma LUT combined image samplers. */
     VkDescriptorSetLayout imageSetLayout() const noexcept { return m_imageSetLayout; }
 private:
     RVKPipeline(RVKDevice *device) noexcept : m_dev(device) {}
@@ -94,7 +113,7 @@ private:
     VkPipelineLayout m_colorLayout { VK_NULL_HANDLE };
     VkPipelineLayout m_imageLayout { VK_NULL_HANDLE };
 
-    std::unordered_map<UInt32, VkRenderPass> m_renderPasses;   // key: VkFormat
+    std::unordered_map<UInt64, VkRenderPass> m_renderPasses;   // key: VkFormat | clear << 32
     std::unordered_map<UInt64, VkPipeline> m_pipelines;        // key: composed
     std::unordered_map<UInt32, VkSampler> m_samplers;          // key: filter/wrap bits
 };
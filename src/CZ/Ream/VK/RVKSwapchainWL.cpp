@@ -7,13 +7,37 @@
 #include <CZ/Ream/VK/RVKDevice.h>
 #include <CZ/Ream/VK/RVKImage.h>
 #include <CZ/Ream/WL/RWLPlatformHandle.h>
+#include <CZ/Ream/RDamageTracker.h>
 #include <CZ/Ream/RCore.h>
+#include <CZ/Ream/RProfiler.h>
 #include <CZ/Ream/RLog.h>
 
 #include <algorithm>
+#include <memory>
 
 using namespace CZ;
 
+// Present damage rects forwarded to the compositor, more are merged
+static constexpr UInt32 MaxPresentRects { 16 };
+
+// Acquire/present transition command buffer, freed once its submission completes
+struct TransitionGarbage final : public RVKDevice::Garbage
+{
+    RVKDevice *device { nullptr };
+    VkCommandPool pool { VK_NULL_HANDLE };
+    VkCommandBuffer cmd { VK_NULL_HANDLE };
+    std::vector<VkSemaphore> ownedWaits;
+
+    ~TransitionGarbage() noexcept override
+    {
+        if (cmd != VK_NULL_HANDLE)
+            vkFreeCommandBuffers(device->device(), pool, 1, &cmd);
+
+        for (VkSemaphore s : ownedWaits)
+            vkDestroySemaphore(device->device(), s, nullptr);
+    }
+};
+
 RVKSwapchainWL::RVKSwapchainWL(std::shared_ptr<RVKCore> core, RVKDevice *device, wl_surface *surface, SkISize size) noexcept :
     RWLSwapchain(size, surface),
     m_core(core),
@@ -61,11 +85,6 @@ std::shared_ptr<RVKSwapchainWL> RVKSwapchainWL::Make(wl_surface *surface, SkISiz
         return {};
     }
 
-    VkFenceCreateInfo fi {};
-    fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    if (vkCreateFence(device->device(), &fi, nullptr, &sc->m_acquireFence) != VK_SUCCESS)
-        return {};
-
     if (!sc->createSwapchain(size, VK_NULL_HANDLE))
         return {};
 
@@ -106,9 +125,9 @@ bool RVKSwapchainWL::createSwapchain(SkISize size, VkSwapchainKHR oldSwapchain)
         : std::clamp((UInt32)size.height(), caps.minImageExtent.height, caps.maxImageExtent.height);
 
     // Triple-buffer: with only 2 images under FIFO, the single free image stays held by the
-    // compositor until the next vblank, so the per-frame blocking acquire (vkWaitForFences below)
-    // stalls the client's event loop every frame. A third image means acquire almost always finds
-    // a free image and returns immediately, keeping the loop responsive.
+    // compositor until the next vblank, so vkAcquireNextImageKHR stalls the client's event loop
+    // every frame. A third image means acquire almost always finds a free image and returns
+    // immediately, keeping the loop responsive (Mailbox needs it to replace queued presents).
     UInt32 minCount { std::max(caps.minImageCount, 3u) };
     if (caps.maxImageCount > 0)
         minCount = std::min(minCount, caps.maxImageCount);
@@ -140,7 +159,7 @@ bool RVKSwapchainWL::createSwapchain(SkISize size, VkSwapchainKHR oldSwapchain)
         if (caps.supportedCompositeAlpha & a) { ci.compositeAlpha = a; break; }
     RLog(CZDebug, CZLN, "RVKSwapchainWL: compositeAlpha=0x{:x} (supported=0x{:x})",
          (unsigned)ci.compositeAlpha, (unsigned)caps.supportedCompositeAlpha);
-    ci.presentMode = VK_PRESENT_MODE_FIFO_KHR; // always supported
+    ci.presentMode = pickPresentMode();
     ci.clipped = VK_TRUE;
     ci.oldSwapchain = oldSwapchain;
 
@@ -155,6 +174,8 @@ bool RVKSwapchainWL::createSwapchain(SkISize size, VkSwapchainKHR oldSwapchain)
     std::vector<VkImage> images { imgCount };
     vkGetSwapchainImagesKHR(m_device->device(), m_swapchain, &imgCount, images.data());
 
+    m_swapchainPresentMode = m_presentMode;
+
     if (m_presentPool == VK_NULL_HANDLE)
     {
         VkCommandPoolCreateInfo pci {};
@@ -182,9 +203,21 @@ bool RVKSwapchainWL::createSwapchain(SkISize size, VkSwapchainKHR oldSwapchain)
 
         VkSemaphoreCreateInfo sci {};
         sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        if (vkCreateSemaphore(m_device->device(), &sci, nullptr, &m_buffers[i].presentSem) != VK_SUCCESS)
+        if (vkCreateSemaphore(m_device->device(), &sci, nullptr, &m_buffers[i].presentSem) != VK_SUCCESS ||
+            vkCreateSemaphore(m_device->device(), &sci, nullptr, &m_buffers[i].acquireSem) != VK_SUCCESS)
         {
-            RLog(CZError, CZLN, "RVKSwapchainWL: failed to create present semaphore");
+            RLog(CZError, CZLN, "RVKSwapchainWL: failed to create swapchain semaphores");
+            return false;
+        }
+    }
+
+    if (m_spareAcquireSem == VK_NULL_HANDLE)
+    {
+        VkSemaphoreCreateInfo sci {};
+        sci.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        if (vkCreateSemaphore(m_device->device(), &sci, nullptr, &m_spareAcquireSem) != VK_SUCCESS)
+        {
+            RLog(CZError, CZLN, "RVKSwapchainWL: failed to create acquire semaphore");
             return false;
         }
     }
@@ -193,14 +226,57 @@ bool RVKSwapchainWL::createSwapchain(SkISize size, VkSwapchainKHR oldSwapchain)
     return true;
 }
 
-void RVKSwapchainWL::destroySwapchain() noexcept
+VkPresentModeKHR RVKSwapchainWL::pickPresentMode() const noexcept
+{
+    if (m_presentMode == RPresentMode::FIFO)
+        return VK_PRESENT_MODE_FIFO_KHR;
+
+    UInt32 count { 0 };
+    vkGetPhysicalDeviceSurfacePresentModesKHR(m_device->physicalDevice(), m_vkSurface, &count, nullptr);
+    std::vector<VkPresentModeKHR> modes { count };
+    vkGetPhysicalDeviceSurfacePresentModesKHR(m_device->physicalDevice(), m_vkSurface, &count, modes.data());
+
+    const auto supported = [&modes](VkPresentModeKHR mode)
+    {
+        return std::find(modes.begin(), modes.end(), mode) != modes.end();
+    };
+
+    if (m_presentMode == RPresentMode::Immediate && supported(VK_PRESENT_MODE_IMMEDIATE_KHR))
+        return VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+    if (supported(VK_PRESENT_MODE_MAILBOX_KHR))
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+
+    RLog(CZDebug, CZLN, "RVKSwapchainWL: requested present mode unsupported, using FIFO");
+    return VK_PRESENT_MODE_FIFO_KHR; // always supported
+}
+
+void RVKSwapchainWL::destroyBuffers() noexcept
 {
     m_device->wait();
-    m_device->clearGarbage(); // free any deferred present-transition command buffers
+    m_device->clearGarbage(); // free deferred transition command buffers
+
     for (auto &buf : m_buffers)
+    {
         if (buf.presentSem != VK_NULL_HANDLE)
             vkDestroySemaphore(m_device->device(), buf.presentSem, nullptr);
+        if (buf.acquireSem != VK_NULL_HANDLE)
+            vkDestroySemaphore(m_device->device(), buf.acquireSem, nullptr);
+    }
+
     m_buffers.clear(); // destroys wrapped RVKImages (views)
+}
+
+void RVKSwapchainWL::destroySwapchain() noexcept
+{
+    destroyBuffers();
+
+    if (m_spareAcquireSem != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(m_device->device(), m_spareAcquireSem, nullptr);
+        m_spareAcquireSem = VK_NULL_HANDLE;
+    }
+
     if (m_presentPool != VK_NULL_HANDLE)
     {
         vkDestroyCommandPool(m_device->device(), m_presentPool, nullptr);
@@ -213,6 +289,64 @@ void RVKSwapchainWL::destroySwapchain() noexcept
     }
 }
 
+bool RVKSwapchainWL::submitTransition(const Buffer &buf, VkImageLayout layout, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                      VkSemaphore wait, VkSemaphore signal) noexcept
+{
+    const VkDevice dev { m_device->device() };
+    const VkImageLayout prevLayout { buf.image->layout() };
+    const VkPipelineStageFlags dstStage { dstAccess ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT };
+
+    // The transition command buffer is reclaimed by the fence-tracked GC (clearGarbage), so the
+    // CPU never stalls on the frame's GPU work
+    VkCommandBuffer cmd { VK_NULL_HANDLE };
+    VkCommandBufferAllocateInfo ai {};
+    ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    ai.commandPool = m_presentPool;
+    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    ai.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(dev, &ai, &cmd) == VK_SUCCESS)
+    {
+        VkCommandBufferBeginInfo bi {};
+        bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(cmd, &bi);
+        buf.image->transitionLayout(cmd, layout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, dstStage, srcAccess, dstAccess);
+        vkEndCommandBuffer(cmd);
+
+        const VkFence fence { m_device->acquireFence() };
+
+        if (fence != VK_NULL_HANDLE)
+        {
+            auto garbage { std::make_unique<TransitionGarbage>() };
+            garbage->device = m_device;
+            garbage->pool = m_presentPool;
+            garbage->cmd = cmd;
+
+            if (m_device->submitCommandAsync(cmd, fence, garbage->ownedWaits, signal, wait))
+            {
+                m_device->deferDestroy(fence, std::move(garbage));
+                return true;
+            }
+
+            // Freed below, owned waits were not consumed
+            garbage->cmd = VK_NULL_HANDLE;
+            m_device->recycleFence(fence);
+        }
+
+        vkFreeCommandBuffers(dev, m_presentPool, 1, &cmd);
+        buf.image->setLayout(prevLayout);
+    }
+
+    // Fallback: blocking transition, consuming the wait as a pending one
+    m_device->queueWait(wait, false);
+    m_device->immediateSubmit([&](VkCommandBuffer c)
+    {
+        buf.image->transitionLayout(c, layout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, dstStage, srcAccess, dstAccess);
+    });
+    return false;
+}
+
 std::optional<const RSwapchainImage> RVKSwapchainWL::acquire() noexcept
 {
     if (m_acquired)
@@ -221,32 +355,42 @@ std::optional<const RSwapchainImage> RVKSwapchainWL::acquire() noexcept
         return std::nullopt;
     }
 
+    if (m_presentMode != m_swapchainPresentMode && !resize(m_size))
+        return std::nullopt;
+
     UInt32 index { 0 };
-    VkResult r { vkAcquireNextImageKHR(m_device->device(), m_swapchain, UINT64_MAX, VK_NULL_HANDLE, m_acquireFence, &index) };
+    VkResult r { vkAcquireNextImageKHR(m_device->device(), m_swapchain, UINT64_MAX, m_spareAcquireSem, VK_NULL_HANDLE, &index) };
 
     if (r == VK_ERROR_OUT_OF_DATE_KHR)
     {
         // Recreate at the current size and retry once.
         if (!resize(m_size))
             return std::nullopt;
-        r = vkAcquireNextImageKHR(m_device->device(), m_swapchain, UINT64_MAX, VK_NULL_HANDLE, m_acquireFence, &index);
+        r = vkAcquireNextImageKHR(m_device->device(), m_swapchain, UINT64_MAX, m_spareAcquireSem, VK_NULL_HANDLE, &index);
     }
 
     if (r != VK_SUCCESS && r != VK_SUBOPTIMAL_KHR)
         return std::nullopt;
 
-    // Blocking wait so the image is ready for either the painter or Skia to render into.
-    vkWaitForFences(m_device->device(), 1, &m_acquireFence, VK_TRUE, UINT64_MAX);
-    vkResetFences(m_device->device(), 1, &m_acquireFence);
-
     auto &buf { m_buffers[index] };
+    std::swap(m_spareAcquireSem, buf.acquireSem);
     const UInt32 age { buf.used ? (m_frame - buf.lastFrame) : 0 };
 
-    // A freshly acquired swapchain image has undefined content.
-    buf.image->setLayout(VK_IMAGE_LAYOUT_UNDEFINED);
+    // A never presented swapchain image has undefined content. Presented ones stay in PRESENT_SRC,
+    // transitioning from it preserves the content reported by age (damage tracking).
+    if (!buf.used)
+        buf.image->setLayout(VK_IMAGE_LAYOUT_UNDEFINED);
+
+    // Instead of waiting for the image on the CPU, the painter and Skia submissions are queue-ordered
+    // after this transition, which waits for the compositor to release it
+    submitTransition(buf, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, 0,
+        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,
+        buf.acquireSem, VK_NULL_HANDLE);
 
     m_acquired = true;
     m_currentIndex = index;
+    acquireDamage(buf.image->size());
 
     RSwapchainImage out {};
     out.image = buf.image;
@@ -256,81 +400,63 @@ std::optional<const RSwapchainImage> RVKSwapchainWL::acquire() noexcept
     return out;
 }
 
-bool RVKSwapchainWL::present(const RSwapchainImage &image, SkRegion *) noexcept
+bool RVKSwapchainWL::present(const RSwapchainImage &image, SkRegion *damage) noexcept
 {
     if (!m_acquired)
         return false;
 
+    RProfiler::EndFrame();
+
+    SkRegion trackedDamage;
+    damage = commitDamage(image, damage, trackedDamage);
     auto &buf { m_buffers[m_currentIndex] };
-    const VkDevice dev { m_device->device() };
 
-    // Transition the rendered image into PRESENT_SRC and submit it WITHOUT blocking: the submit is
-    // queue-ordered after the render work and signals buf.presentSem, which vkQueuePresentKHR waits
-    // on. The transition command buffer is reclaimed by the fence-tracked GC (clearGarbage), so the
-    // CPU never stalls on the frame's GPU work and can run ahead into the next frame.
-    VkCommandBuffer cmd { VK_NULL_HANDLE };
-    VkCommandBufferAllocateInfo ai {};
-    ai.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    ai.commandPool = m_presentPool;
-    ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    ai.commandBufferCount = 1;
+    // Transition the rendered image into PRESENT_SRC without blocking: the submit is queue-ordered
+    // after the render work and signals buf.presentSem, which vkQueuePresentKHR waits on
+    const bool async { submitTransition(buf, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, 0, VK_NULL_HANDLE, buf.presentSem) };
 
-    VkResult r { VK_SUCCESS };
-    bool async { false };
-    VkFence fence { VK_NULL_HANDLE };
+    VkPresentInfoKHR pi {};
+    pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    pi.waitSemaphoreCount = async ? 1 : 0;
+    pi.pWaitSemaphores = async ? &buf.presentSem : nullptr;
+    pi.swapchainCount = 1;
+    pi.pSwapchains = &m_swapchain;
+    pi.pImageIndices = &m_currentIndex;
 
-    if (vkAllocateCommandBuffers(dev, &ai, &cmd) == VK_SUCCESS)
+    // Forwarded as the wl_surface buffer damage. Without rects (or damage) the whole image is damaged
+    VkPresentRegionKHR region {};
+    VkPresentRegionsKHR regions {};
+
+    if (damage && m_device->extensions().KHR_incremental_present)
     {
-        VkCommandBufferBeginInfo bi {};
-        bi.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-        vkBeginCommandBuffer(cmd, &bi);
-        buf.image->transitionLayout(cmd, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, 0);
-        vkEndCommandBuffer(cmd);
+        SkRegion clipped { *damage };
+        clipped.op(SkIRect::MakeWH(m_extent.width, m_extent.height), SkRegion::kIntersect_Op);
+        RDamageTracker::Simplify(clipped, MaxPresentRects);
+        m_presentRects.clear();
 
-        VkFenceCreateInfo fi {};
-        fi.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        if (vkCreateFence(dev, &fi, nullptr, &fence) == VK_SUCCESS)
+        for (SkRegion::Iterator it(clipped); !it.done(); it.next())
         {
-            std::vector<VkSemaphore> ownedWaits;
-            if (m_device->submitCommandAsync(cmd, fence, ownedWaits, buf.presentSem))
-            {
-                async = true;
-                RVKDevice *device { m_device };
-                VkCommandPool pool { m_presentPool };
-                device->deferDestroy(fence, [device, pool, cmd, ow = std::move(ownedWaits)]()
-                {
-                    vkFreeCommandBuffers(device->device(), pool, 1, &cmd);
-                    for (VkSemaphore s : ow) vkDestroySemaphore(device->device(), s, nullptr);
-                });
-            }
-            else
-                vkDestroyFence(dev, fence, nullptr);
+            const SkIRect &r { it.rect() };
+            m_presentRects.emplace_back(VkRectLayerKHR {
+                .offset = { r.x(), r.y() },
+                .extent = { UInt32(r.width()), UInt32(r.height()) },
+                .layer = 0 });
         }
-    }
 
-    if (!async)
-    {
-        // Fallback: blocking transition (also frees cmd if it was allocated).
-        m_device->immediateSubmit([&](VkCommandBuffer c)
-        {
-            buf.image->transitionLayout(c, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, 0);
-        });
-        if (cmd != VK_NULL_HANDLE)
-            vkFreeCommandBuffers(dev, m_presentPool, 1, &cmd);
+        // An empty damage still has to present, a single pixel is the smallest valid damage
+        if (m_presentRects.empty())
+            m_presentRects.emplace_back(VkRectLayerKHR { .offset = { 0, 0 }, .extent = { 1, 1 }, .layer = 0 });
+
+        region.rectangleCount = m_presentRects.size();
+        region.pRectangles = m_presentRects.data();
+        regions.sType = VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR;
+        regions.swapchainCount = 1;
+        regions.pRegions = &region;
+        pi.pNext = &regions;
     }
 
-    VkPresentInfoKHR pi {};
-    pi.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    pi.waitSemaphoreCount = async ? 1 : 0;
-    pi.pWaitSemaphores = async ? &buf.presentSem : nullptr;
-    pi.swapchainCount = 1;
-    pi.pSwapchains = &m_swapchain;
-    pi.pImageIndices = &m_currentIndex;
+    VkResult r { VK_SUCCESS };
 
     {
         std::lock_guard<std::mutex> lock { m_device->queueMutex() };
@@ -354,12 +480,7 @@ bool RVKSwapchainWL::present(const RSwapchainImage &image, SkRegion *) noexcept
 bool RVKSwapchainWL::resize(SkISize size) noexcept
 {
     VkSwapchainKHR old { m_swapchain };
-    m_device->wait();
-    m_device->clearGarbage(); // free deferred present-transition command buffers
-    for (auto &buf : m_buffers)
-        if (buf.presentSem != VK_NULL_HANDLE)
-            vkDestroySemaphore(m_device->device(), buf.presentSem, nullptr);
-    m_buffers.clear();
+    destroyBuffers();
     m_swapchain = VK_NULL_HANDLE;
 
     const bool ok { createSwapchain(size, old) };
@@ -375,8 +496,6 @@ RVKSwapchainWL::~RVKSwapchainWL() noexcept
 {
     destroySwapchain();
 
-    if (m_acquireFence != VK_NULL_HANDLE)
-        vkDestroyFence(m_device->device(), m_acquireFence, nullptr);
     if (m_vkSurface != VK_NULL_HANDLE)
         vkDestroySurfaceKHR(m_core->instance(), m_vkSurface, nullptr);
 }
@@ -9,10 +9,13 @@
 /**
  * @brief Wayland-client Vulkan swapchain (VK_KHR_wayland_surface + VkSwapchainKHR).
  *
- * Acquire blocks on a fence (the image must be ready before either the painter or Skia renders
- * into it, and it doubles as frame pacing). Present is asynchronous: the PRESENT_SRC transition
- * is submitted without a CPU wait, signalling a per-image semaphore that vkQueuePresentKHR waits
- * on, so the CPU can run ahead into the next frame (one-frame-deep CPU/GPU pipelining).
+ * Neither acquire nor present wait on the GPU. Acquire signals a semaphore that the transition into
+ * COLOR_ATTACHMENT_OPTIMAL waits on, so the painter and Skia work submitted after it is queue-ordered
+ * behind the compositor releasing the image. Present submits the PRESENT_SRC transition signalling a
+ * per-image semaphore that vkQueuePresentKHR waits on, so the CPU can run ahead into the next frame.
+ *
+ * The present damage is forwarded to the compositor with VK_KHR_incremental_present when available,
+ * and the presentation mode follows RSwapchain::presentMode().
  */
 class CZ::RVKSwapchainWL final : public RWLSwapchain
 {
@@ -22,12 +25,28 @@ public:
     bool present(const RSwapchainImage &image, SkRegion *damage = nullptr) noexcept override;
     bool resize(SkISize size) noexcept override;
 private:
+    struct Buffer
+    {
+        std::shared_ptr<RVKImage> image;
+        VkSemaphore acquireSem { VK_NULL_HANDLE }; // signalled by the acquire, waited by the first transition
+        VkSemaphore presentSem { VK_NULL_HANDLE }; // signalled by the transition, waited by present
+        UInt32 lastFrame { 0 };
+        bool used { false };
+    };
+
     friend class RWLSwapchain;
     static std::shared_ptr<RVKSwapchainWL> Make(wl_surface *surface, SkISize size) noexcept;
     RVKSwapchainWL(std::shared_ptr<RVKCore> core, RVKDevice *device, wl_surface *surface, SkISize size) noexcept;
 
     bool createSwapchain(SkISize size, VkSwapchainKHR oldSwapchain) noexcept;
     void destroySwapchain() noexcept;
+    void destroyBuffers() noexcept;
+    VkPresentModeKHR pickPresentMode() const noexcept;
+
+    /* Transitions the image of buf to layout, waiting on wait and signalling signal. Returns false if it
+     * had to be submitted synchronously, in which case signal is not signalled */
+    bool submitTransition(const Buffer &buf, VkImageLayout layout, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                          VkSemaphore wait, VkSemaphore signal) noexcept;
 
     std::shared_ptr<RVKCore> m_core;
     RVKDevice *m_device { nullptr };
@@ -37,16 +56,14 @@ private:
     VkFormat m_format { VK_FORMAT_UNDEFINED };
     VkColorSpaceKHR m_colorSpace { VK_COLOR_SPACE_SRGB_NONLINEAR_KHR };
     VkExtent2D m_extent {};
-    VkFence m_acquireFence { VK_NULL_HANDLE };
-    VkCommandPool m_presentPool { VK_NULL_HANDLE }; // for async PRESENT_SRC transitions
+    VkCommandPool m_presentPool { VK_NULL_HANDLE }; // for async acquire/present transitions
+    RPresentMode m_swapchainPresentMode { RPresentMode::FIFO }; // requested mode when created
 
-    struct Buffer
-    {
-        std::shared_ptr<RVKImage> image;
-        VkSemaphore presentSem { VK_NULL_HANDLE }; // signalled by the transition, waited by present
-        UInt32 lastFrame { 0 };
-        bool used { false };
-    };
+    // Acquire semaphores rotate: the spare one is passed to vkAcquireNextImageKHR, then swapped
+    // with the one of the acquired image, whose previous wait has already been submitted
+    VkSemaphore m_spareAcquireSem { VK_NULL_HANDLE };
+
+    std::vector<VkRectLayerKHR> m_presentRects;
     std::vector<Buffer> m_buffers;
 
     bool m_acquired { false };
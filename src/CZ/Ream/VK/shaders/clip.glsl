@@ -0,0 +1,33 @@
+// Rounded clip coverage shared by color.frag and image.frag (included by glslc), the SPIR-V analog of
+// the GL uber-shader's HAS_CLIP. gl_FragCoord is mapped back to viewport coordinates, where the clip is
+// defined, by the inverse of the geometry matrix (pc.clipMapX/Y).
+
+vec2 viewportPos()
+{
+    return vec2(dot(pc.clipMapX.xyz, vec3(gl_FragCoord.xy, 1.0)),
+                dot(pc.clipMapY.xyz, vec3(gl_FragCoord.xy, 1.0)));
+}
+
+float clipCoverage()
+{
+    const vec2 pos = viewportPos();
+    const vec2 halfSize = 0.5 * (pc.clipRect.zw - pc.clipRect.xy);
+    const vec2 p = pos - 0.5 * (pc.clipRect.xy + pc.clipRect.zw);
+    vec2 r;
+
+    if (p.y < 0.0)
+        r = p.x < 0.0 ? vec2(pc.clipRadiiX.x, pc.clipRadiiY.x) : vec2(pc.clipRadiiX.y, pc.clipRadiiY.y);
+    else
+        r = p.x < 0.0 ? vec2(pc.clipRadiiX.w, pc.clipRadiiY.w) : vec2(pc.clipRadiiX.z, pc.clipRadiiY.z);
+
+    // Position relative to the corner's ellipse center
+    const vec2 q = abs(p) - halfSize + r;
+    float d;
+
+    if (q.x > 0.0 && q.y > 0.0 && r.x > 0.0 && r.y > 0.0)
+        d = (length(q / r) - 1.0) * min(r.x, r.y); // exact for circular corners
+    else
+        d = max(q.x - r.x, q.y - r.y);
+
+    return clamp(0.5 - d / pc.clipMapX.w, 0.0, 1.0);
+}
@@ -7,12 +7,71 @@ layout(location = 1) in vec2 vMaskUV;
 
 layout(location = 0) out vec4 outColor;
 
+layout(constant_id = 0) const int HAS_CLIP = 0;
+layout(constant_id = 1) const int HAS_SHADOW = 0;
+
 layout(push_constant) uniform PushConstants {
     vec4 color;   // premultiplied
-    vec4 factor;  // unused by color mode
+    vec4 factor;  // shadow corner radii (UL, UR, LR, LL)
+    vec4 clipRect;
+    vec4 clipRadiiX;
+    vec4 clipRadiiY;
+    vec4 clipMapX;
+    vec4 clipMapY; // w: shadow sigma
+    vec4 shadowRect;
 } pc;
 
+#include "clip.glsl"
+
+// drawShadow: the GL uber-shader's HAS_SHADOW. Abramowitz and Stegun 7.1.27, max error 5e-4
+vec2 erf(vec2 x)
+{
+    const vec2 s = sign(x);
+    const vec2 a = abs(x);
+    x = 1.0 + (0.278393 + (0.230389 + 0.078108 * (a * a)) * a) * a;
+    x *= x;
+    return s - s / (x * x);
+}
+
+// Horizontal integral of the blurred row at height y (relative to the center)
+float shadowRow(float x, float y, float radius, vec2 halfSize, float sigma)
+{
+    const float delta = min(halfSize.y - radius - abs(y), 0.0);
+    const float curved = halfSize.x - radius + sqrt(max(0.0, radius * radius - delta * delta));
+    const vec2 integral = 0.5 + 0.5 * erf((x + vec2(-curved, curved)) * (0.70710678 / sigma));
+    return integral.y - integral.x;
+}
+
+// The vertical integral is approximated with 4 samples within 3 sigma
+float shadowCoverage()
+{
+    const float sigma = pc.clipMapY.w;
+    const vec2 halfSize = 0.5 * (pc.shadowRect.zw - pc.shadowRect.xy);
+    const vec2 p = viewportPos() - 0.5 * (pc.shadowRect.xy + pc.shadowRect.zw);
+    const float radius = p.y < 0.0 ? (p.x < 0.0 ? pc.factor.x : pc.factor.y) : (p.x < 0.0 ? pc.factor.w : pc.factor.z);
+    const float start = clamp(-3.0 * sigma, p.y - halfSize.y, p.y + halfSize.y);
+    const float end = clamp(3.0 * sigma, p.y - halfSize.y, p.y + halfSize.y);
+    const float step = (end - start) * 0.25;
+    float y = start + step * 0.5;
+    float value = 0.0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        value += shadowRow(p.x, p.y - y, radius, halfSize, sigma) * exp(-(y * y) / (2.0 * sigma * sigma)) * step;
+        y += step;
+    }
+
+    return value / (2.50662827 * sigma); // sqrt(2 * PI) * sigma
+}
+
 void main()
 {
     outColor = pc.color;
+
+    if (HAS_SHADOW != 0)
+        outColor *= shadowCoverage();
+
+    // Premultiplied, applied like a mask
+    if (HAS_CLIP != 0)
+        outColor *= clipCoverage();
 }
@@ -2,7 +2,8 @@
 
 // drawImageEffect: Gaussian blur passes with optional YUV saturation, ported from the GL
 // uber-shader's vibrancy effects. FX selects the pass (1=horizontal, 2=vertical light,
-// 3=vertical dark). pixelSize (push constant factor.x) is the per-tap texel step.
+// 3=vertical dark, 4=YUV luma, 5=YUV chroma). pixelSize (push constant factor.x) is the
+// per-tap texel step, the YUV passes take their levels (offset, scale) from factor.yz.
 layout(location = 0) in vec2 vImageUV;
 layout(location = 1) in vec2 vMaskUV;
 
@@ -15,7 +16,7 @@ layout(set = 0, binding = 1) uniform sampler2D maskTex; // unused
 
 layout(push_constant) uniform PushConstants {
     vec4 color;
-    vec4 factor; // factor.x = pixelSize
+    vec4 factor; // factor.x = pixelSize, factor.yz = YUV offset and scale
 } pc;
 
 const float kH[17] = float[](0.0399, 0.0397, 0.0391, 0.0382, 0.0368, 0.0352, 0.0333, 0.0312,
@@ -23,10 +24,26 @@ const float kH[17] = float[](0.0399, 0.0397, 0.0391, 0.0382, 0.0368, 0.0352, 0.0
 const float kV[14] = float[](0.0797, 0.0781, 0.0736, 0.0666, 0.0579, 0.0484, 0.0389, 0.0300,
                              0.0223, 0.0159, 0.0109, 0.0071, 0.0045, 0.0027);
 
+// BT.709 limited range (RYUVConverter), rows
+const mat3 rgbToYCbCr = mat3( 0.2126,  0.7152,  0.0722,
+                             -0.1146, -0.3854,  0.5,
+                              0.5,    -0.4542, -0.0458);
+
 void main()
 {
     const float ps = pc.factor.x;
 
+    if (FX == 4 || FX == 5) // YUV luma (R) or chroma (RG), the 2x2 average is the bilinear tap at the block corner
+    {
+        vec3 c = texture(imageTex, vImageUV).rgb * rgbToYCbCr;
+
+        if (FX == 4)
+            outColor = vec4(pc.factor.y + c.x * pc.factor.z, 0.0, 0.0, 1.0);
+        else
+            outColor = vec4(pc.factor.y + c.yz * pc.factor.z, 0.0, 1.0);
+        return;
+    }
+
     if (FX == 1) // horizontal blur
     {
         vec3 c = kH[0] * texture(imageTex, vImageUV).xyz;
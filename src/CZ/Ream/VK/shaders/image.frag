@@ -13,15 +13,97 @@ layout(constant_id = 0) const int HAS_MASK = 0;
 layout(constant_id = 1) const int REPLACE_IMAGE_COLOR = 0;
 layout(constant_id = 2) const int PREMULT_SRC = 0;
 layout(constant_id = 3) const int BLEND_DSTIN = 0;
+layout(constant_id = 4) const int HAS_CLIP = 0;
+layout(constant_id = 5) const int HAS_GAMMA_LUT = 0;
+layout(constant_id = 6) const int HAS_COLOR_TRANSFORM = 0;
 
 layout(set = 0, binding = 0) uniform sampler2D imageTex;
 layout(set = 0, binding = 1) uniform sampler2D maskTex;
+layout(set = 0, binding = 2) uniform sampler2D gammaLUTTex; // RGammaLUT::image(), the curves in RGB
 
 layout(push_constant) uniform PushConstants {
-    vec4 color;   // unused by image mode
+    vec4 color;   // xyz: src/dst RTransferFunction and gamut (0 none, 1 BT.709 to BT.2020, 2 BT.2020 to BT.709)
     vec4 factor;  // rgb: per-channel factor, a: final alpha (opacity * factor.a)
+    vec4 clipRect;
+    vec4 clipRadiiX;
+    vec4 clipRadiiY;
+    vec4 clipMapX;
+    vec4 clipMapY;
 } pc;
 
+#include "clip.glsl"
+
+// Maps an unpremultiplied color, entry i is at texel center i
+vec3 gammaLUTMap(vec3 c)
+{
+    const float size = float(textureSize(gammaLUTTex, 0).x);
+    c = clamp(c, 0.0, 1.0) * ((size - 1.0) / size) + (0.5 / size);
+    return vec3(texture(gammaLUTTex, vec2(c.r, 0.5)).r,
+                texture(gammaLUTTex, vec2(c.g, 0.5)).g,
+                texture(gammaLUTTex, vec2(c.b, 0.5)).b);
+}
+
+// Same as RColorDescription::Decode(), linear 1.0 = 203 nits
+vec3 decodeTF(vec3 c, int tf)
+{
+    if (tf == 0) // sRGB
+    {
+        vec3 a = abs(c);
+        return sign(c) * mix(a / 12.92, pow((a + 0.055) / 1.055, vec3(2.4)), step(0.04045, a));
+    }
+    else if (tf == 2) // PQ
+    {
+        vec3 e = pow(clamp(c, 0.0, 1.0), vec3(1.0 / 78.84375));
+        return pow(max(e - 0.8359375, 0.0) / (18.8515625 - 18.6875 * e), vec3(1.0 / 0.1593017578125)) * (10000.0 / 203.0);
+    }
+    else if (tf == 3) // HLG
+    {
+        vec3 x = clamp(c, 0.0, 1.0);
+        return mix(x * x / 3.0, (exp((x - 0.55991073) / 0.17883277) + 0.28466892) / 12.0, step(0.5, x)) / 0.26496256;
+    }
+
+    return c; // Linear
+}
+
+// Same as RColorDescription::Encode()
+vec3 encodeTF(vec3 c, int tf)
+{
+    if (tf == 0) // sRGB
+    {
+        vec3 a = abs(c);
+        return sign(c) * mix(a * 12.92, 1.055 * pow(a, vec3(1.0 / 2.4)) - 0.055, step(0.0031308, a));
+    }
+    else if (tf == 2) // PQ
+    {
+        vec3 y = pow(clamp(c * (203.0 / 10000.0), 0.0, 1.0), vec3(0.1593017578125));
+        return pow((0.8359375 + 18.8515625 * y) / (1.0 + 18.6875 * y), vec3(78.84375));
+    }
+    else if (tf == 3) // HLG
+    {
+        vec3 x = clamp(c * 0.26496256, 0.0, 1.0);
+        return mix(sqrt(3.0 * x), 0.17883277 * log(max(12.0 * x - 0.28466892, 1e-6)) + 0.55991073, step(1.0 / 12.0, x));
+    }
+
+    return c; // Linear
+}
+
+// Unpremultiplied, the push constants are uniform so the branches are too
+vec3 colorTransform(vec3 c)
+{
+    c = decodeTF(c, int(pc.color.x));
+
+    if (int(pc.color.z) == 1) // BT.709 to BT.2020 (rows)
+        c = c * mat3(0.6274040, 0.3292820, 0.0433136,
+                     0.0690970, 0.9195400, 0.0113612,
+                     0.0163916, 0.0880132, 0.8955950);
+    else if (int(pc.color.z) == 2) // BT.2020 to BT.709 (rows)
+        c = c * mat3( 1.6604910, -0.5876411, -0.0728499,
+                     -0.1245505,  1.1328999, -0.0083494,
+                     -0.0181508, -0.1005789,  1.1187297);
+
+    return encodeTF(c, int(pc.color.y));
+}
+
 void main()
 {
     if (BLEND_DSTIN != 0)
@@ -31,6 +113,8 @@ void main()
         if (HAS_MASK != 0)
             a *= texture(maskTex, vMaskUV).a;
         a *= pc.factor.a;
+        if (HAS_CLIP != 0)
+            a *= clipCoverage();
         outColor = vec4(0.0, 0.0, 0.0, a);
         return;
     }
@@ -42,18 +126,39 @@ void main()
         if (HAS_MASK != 0)
             a *= texture(maskTex, vMaskUV).a;
         a *= pc.factor.a;
-        outColor = vec4(pc.factor.rgb, a);
+        if (HAS_CLIP != 0)
+            a *= clipCoverage();
+        outColor = vec4(HAS_GAMMA_LUT != 0 ? gammaLUTMap(pc.factor.rgb) : pc.factor.rgb, a);
         return;
     }
 
     vec4 c = texture(imageTex, vImageUV);
+
+    if (HAS_COLOR_TRANSFORM != 0)
+    {
+        if (PREMULT_SRC == 0)
+            c.rgb = colorTransform(c.rgb);
+        else if (c.a > 0.0)
+            c.rgb = colorTransform(c.rgb / c.a) * c.a;
+    }
+
     c.rgb *= pc.factor.rgb;
 
+    if (HAS_GAMMA_LUT != 0)
+    {
+        if (PREMULT_SRC == 0)
+            c.rgb = gammaLUTMap(c.rgb);
+        else if (c.a > 0.0)
+            c.rgb = gammaLUTMap(c.rgb / c.a) * c.a;
+    }
+
     if (PREMULT_SRC != 0)
     {
         float m = pc.factor.a;
         if (HAS_MASK != 0)
             m *= texture(maskTex, vMaskUV).a;
+        if (HAS_CLIP != 0)
+            m *= clipCoverage();
         c *= m;
     }
     else
@@ -61,6 +166,8 @@ void main()
         c.a *= pc.factor.a;
         if (HAS_MASK != 0)
             c.a *= texture(maskTex, vMaskUV).a;
+        if (HAS_CLIP != 0)
+            c.a *= clipCoverage();
     }
 
     outColor = c;
@@ -0,0 +1,847 @@
+#include <OF/ROFPlatformHandle.h>
+#include <RSurface.h>
+#include <RPainter.h>
+#include <RDevice.h>
+#include <RImage.h>
+#include <RSync.h>
+#include <RPass.h>
+#include <RCore.h>
+#include <RLog.h>
+
+#include <drm_fourcc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace CZ;
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Offscreen benchmark suite.
+ *
+ * Runs the same reproducible scenarios on each graphics API using the Offscreen platform, so it
+ * works on headless machines with software drivers (llvmpipe for GL, lavapipe for VK):
+ *
+ * - windows:  Wallpaper + N overlapping translucent windows, full repaint.
+ * - damage:   Same scene clipped to a fragmented region of many small rects.
+ * - blur:     Two-pass vibrancy blur (VibrancyH + VibrancyLightV).
+ * - shadow:   Windows scene with an analytic drawShadow() below each window.
+ * - shadow-ninepatch: Same with a pre-blurred nine-patch (8 drawImage() per window) instead.
+ * - hdr:      Windows scene decoded from sRGB and composed in a linear ABGR16161616F image, then encoded
+ *             as PQ BT.2020 into an ABGR2101010 image. Compare with windows (8 bit, no color transform).
+ * - upload:   writePixels() throughput.
+ * - readback: readPixels() throughput.
+ * - sync:     RSync creation rate (skipped on Raster).
+ *
+ * Each API runs in its own process since there can only be one RCore. Results are printed one per
+ * line in a key=value format, the same format read back by baseline=, so a previous run can be
+ * stored with save= and later compared against. Exits with status 2 if any scenario regressed by
+ * more than threshold percent.
+ *
+ * Usage: cz-ream-bench [api=all|RS|GL|VK] [frames=200] [windows=32] [save=file] [baseline=file] [threshold=10]
+ */
+
+struct Options
+{
+    std::vector<std::string> apis { "RS", "GL", "VK" };
+    int frames { 200 };
+    int windows { 32 };
+    std::string save;
+    std::string baseline;
+    double threshold { 10.0 };
+};
+
+struct Result
+{
+    std::string api;
+    std::string scenario;
+    std::string unit;
+    double value;
+    double p50;
+    double p99;
+
+    std::string key() const noexcept { return api + "/" + scenario; }
+    bool higherIsBetter() const noexcept { return unit != "ms"; }
+};
+
+struct Bench
+{
+    const char *api;
+    const Options *opts;
+    std::shared_ptr<RCore> core;
+    std::shared_ptr<RSurface> surface;
+    std::shared_ptr<RImage> wallpaper;
+    std::vector<std::shared_ptr<RImage>> windows;
+};
+
+static constexpr SkISize SurfaceSize { 1920, 1080 };
+static constexpr SkISize WindowSize { 512, 384 };
+static constexpr int Warmup { 10 };
+
+/* Fixed seed LCG so every run and every API draws the same content */
+struct Random
+{
+    UInt32 state;
+    UInt32 next() noexcept { return state = state * 1664525u + 1013904223u; }
+    int range(int min, int max) noexcept { return min + int(next() >> 8) % (max - min + 1); }
+};
+
+static double Ms(Clock::duration d) noexcept
+{
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+static void Print(const Result &r) noexcept
+{
+    printf("api=%s scenario=%s value=%.3f unit=%s p50=%.3f p99=%.3f\n",
+           r.api.c_str(), r.scenario.c_str(), r.value, r.unit.c_str(), r.p50, r.p99);
+    fflush(stdout);
+}
+
+static Result Summarize(const Bench &b, const char *scenario, std::vector<double> &ms) noexcept
+{
+    std::sort(ms.begin(), ms.end());
+    double sum { 0.0 };
+    for (auto v : ms) sum += v;
+    return { b.api, scenario, "ms", sum / ms.size(), ms[ms.size() / 2], ms[(ms.size() * 99) / 100] };
+}
+
+static std::shared_ptr<RImage> MakePattern(SkISize size, UInt32 seed, UInt8 alpha) noexcept
+{
+    Random rand { seed };
+    std::vector<UInt8> pixels(size.width() * size.height() * 4);
+    const UInt8 r { UInt8(rand.next() >> 24) }, g { UInt8(rand.next() >> 24) }, b { UInt8(rand.next() >> 24) };
+
+    for (int y = 0; y < size.height(); y++)
+    {
+        for (int x = 0; x < size.width(); x++)
+        {
+            UInt8 *p { &pixels[(y * size.width() + x) * 4] };
+            // Premultiplied ARGB8888 (little-endian BGRA)
+            p[0] = UInt8(((b ^ (x >> 2)) * alpha) / 255);
+            p[1] = UInt8(((g ^ (y >> 2)) * alpha) / 255);
+            p[2] = UInt8(((r + x + y) & 0xFF) * alpha / 255);
+            p[3] = alpha;
+        }
+    }
+
+    const RPixelBufferInfo info
+    {
+        .size = size,
+        .stride = static_cast<UInt32>(size.width() * 4),
+        .format = DRM_FORMAT_ARGB8888,
+        .pixels = pixels.data(),
+        .alphaType = kPremul_SkAlphaType
+    };
+
+    return RImage::MakeFromPixels(info, { DRM_FORMAT_ARGB8888, { DRM_FORMAT_MOD_INVALID } });
+}
+
+static SkIRect WindowRect(int i) noexcept
+{
+    return SkIRect::MakeXYWH(
+        (i * 53) % (SurfaceSize.width() - WindowSize.width()),
+        (i * 37) % (SurfaceSize.height() - WindowSize.height()),
+        WindowSize.width(), WindowSize.height());
+}
+
+static void DrawScene(Bench &b, RPainter *painter, const SkRegion *clip) noexcept
+{
+    RDrawImageInfo info {};
+    info.image = b.wallpaper;
+    info.src = SkRect::Make(SurfaceSize);
+    info.dst = SkIRect::MakeSize(SurfaceSize);
+    painter->setBlendMode(RBlendMode::Src);
+    painter->drawImage(info, clip);
+    painter->setBlendMode(RBlendMode::SrcOver);
+
+    for (size_t i = 0; i < b.windows.size(); i++)
+    {
+        info.image = b.windows[i];
+        info.src = SkRect::Make(WindowSize);
+        info.dst = WindowRect(i);
+        painter->drawImage(info, clip);
+    }
+}
+
+/* Frame time includes waiting for the GPU to finish */
+static void EndFrame(Bench &b) noexcept
+{
+    b.core->mainDevice()->wait();
+    b.core->clearGarbage();
+}
+
+static Result RunWindows(Bench &b) noexcept
+{
+    std::vector<double> ms;
+
+    for (int i = -Warmup; i < b.opts->frames; i++)
+    {
+        const auto start { Clock::now() };
+        auto pass { b.surface->beginPass(RPassCap_Painter) };
+        DrawScene(b, pass->getPainter(), nullptr);
+        pass.reset();
+        EndFrame(b);
+
+        if (i >= 0)
+            ms.emplace_back(Ms(Clock::now() - start));
+    }
+
+    return Summarize(b, "windows", ms);
+}
+
+static Result RunDamage(Bench &b) noexcept
+{
+    Random rand { 7 };
+    SkRegion damage;
+
+    for (int i = 0; i < 256; i++)
+        damage.op(SkIRect::MakeXYWH(
+            rand.range(0, SurfaceSize.width() - 64),
+            rand.range(0, SurfaceSize.height() - 64),
+            rand.range(4, 64), rand.range(4, 64)), SkRegion::kUnion_Op);
+
+    std::vector<double> ms;
+
+    for (int i = -Warmup; i < b.opts->frames; i++)
+    {
+        const auto start { Clock::now() };
+        auto pass { b.surface->beginPass(RPassCap_Painter) };
+        DrawScene(b, pass->getPainter(), &damage);
+        pass.reset();
+        EndFrame(b);
+
+        if (i >= 0)
+            ms.emplace_back(Ms(Clock::now() - start));
+    }
+
+    return Summarize(b, "damage", ms);
+}
+
+static Result RunBlur(Bench &b) noexcept
+{
+    // Vibrancy is usually applied at a quarter of the resolution
+    const SkISize blurSize { SurfaceSize.width() / 4, SurfaceSize.height() / 4 };
+    auto blurSurface { RSurface::Make(blurSize, 1.f, true) };
+    std::vector<double> ms;
+
+    for (int i = -Warmup; i < b.opts->frames; i++)
+    {
+        const auto start { Clock::now() };
+
+        {
+            auto pass { blurSurface->beginPass(RPassCap_Painter) };
+            RDrawImageInfo info {};
+            info.image = b.wallpaper;
+            info.src = SkRect::Make(SurfaceSize);
+            info.dst = SkIRect::MakeSize(blurSize);
+            pass->getPainter()->drawImageEffect(info, RPainter::VibrancyH);
+        }
+
+        {
+            auto pass { b.surface->beginPass(RPassCap_Painter) };
+            RDrawImageInfo info {};
+            info.image = blurSurface->image();
+            info.src = SkRect::Make(blurSize);
+            info.dst = SkIRect::MakeSize(SurfaceSize);
+            pass->getPainter()->drawImageEffect(info, RPainter::VibrancyLightV);
+        }
+
+        EndFrame(b);
+
+        if (i >= 0)
+            ms.emplace_back(Ms(Clock::now() - start));
+    }
+
+    return Summarize(b, "blur", ms);
+}
+
+static constexpr SkScalar ShadowSigma { 16.f };
+static constexpr SkScalar ShadowRadius { 12.f };
+static constexpr SkColor ShadowColor { SkColorSetARGB(90, 0, 0, 0) };
+
+static SkRect ShadowRect(int i) noexcept
+{
+    return SkRect::Make(WindowRect(i).makeOffset(0, 8));
+}
+
+/* Pre-blurred rounded rect used by the nine-patch baseline, corner patches of C + 1 + C pixels */
+static std::shared_ptr<RImage> MakeShadowNinePatch(int &C) noexcept
+{
+    const int E { int(std::ceil(3.f * ShadowSigma)) };
+    C = int(ShadowRadius) + 2 * E;
+    const int N { 2 * C + 1 };
+
+    SkRRect rrect;
+    rrect.setRectXY(SkRect::MakeLTRB(E, E, N - E, N - E), ShadowRadius, ShadowRadius);
+    std::vector<float> mask(N * N), tmp(N * N);
+
+    for (int y = 0; y < N; y++)
+        for (int x = 0; x < N; x++)
+            mask[y * N + x] = rrect.contains(SkRect::MakeXYWH(x + 0.25f, y + 0.25f, 0.5f, 0.5f)) ? 1.f : 0.f;
+
+    std::vector<float> kernel(2 * E + 1);
+    float sum { 0.f };
+    for (int i = -E; i <= E; i++)
+        sum += kernel[i + E] = std::exp(-(i * i) / (2.f * ShadowSigma * ShadowSigma));
+    for (auto &k : kernel) k /= sum;
+
+    // Separable gaussian, horizontal then vertical
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int y = 0; y < N; y++)
+        {
+            for (int x = 0; x < N; x++)
+            {
+                float v { 0.f };
+
+                for (int i = -E; i <= E; i++)
+                {
+                    const int sx { pass == 0 ? x + i : x }, sy { pass == 0 ? y : y + i };
+                    if (sx >= 0 && sx < N && sy >= 0 && sy < N)
+                        v += kernel[i + E] * mask[sy * N + sx];
+                }
+
+                tmp[y * N + x] = v;
+            }
+        }
+
+        std::swap(mask, tmp);
+    }
+
+    std::vector<UInt8> pixels(N * N * 4, 0);
+    for (int i = 0; i < N * N; i++)
+        pixels[i * 4 + 3] = UInt8(std::clamp(mask[i], 0.f, 1.f) * SkColorGetA(ShadowColor) + 0.5f);
+
+    const RPixelBufferInfo info
+    {
+        .size = { N, N },
+        .stride = static_cast<UInt32>(N * 4),
+        .format = DRM_FORMAT_ARGB8888,
+        .pixels = pixels.data(),
+        .alphaType = kPremul_SkAlphaType
+    };
+
+    return RImage::MakeFromPixels(info, { DRM_FORMAT_ARGB8888, { DRM_FORMAT_MOD_INVALID } });
+}
+
+/* Window shadows below every window: analytic drawShadow() or the usual 8 drawImage() nine-patch */
+static bool RunShadow(Bench &b, bool ninePatch, Result &result) noexcept
+{
+    int C { 0 };
+    std::shared_ptr<RImage> patch;
+
+    if (ninePatch)
+    {
+        patch = MakeShadowNinePatch(C);
+
+        if (!patch)
+            return false;
+    }
+
+    const int E { int(std::ceil(3.f * ShadowSigma)) };
+    const SkScalar N { SkScalar(2 * C + 1) };
+    std::vector<double> ms;
+
+    for (int i = -Warmup; i < b.opts->frames; i++)
+    {
+        const auto start { Clock::now() };
+        auto pass { b.surface->beginPass(RPassCap_Painter) };
+        auto *painter { pass->getPainter() };
+
+        RDrawImageInfo info {};
+        info.image = b.wallpaper;
+        info.src = SkRect::Make(SurfaceSize);
+        info.dst = SkIRect::MakeSize(SurfaceSize);
+        painter->setBlendMode(RBlendMode::Src);
+        painter->drawImage(info);
+        painter->setBlendMode(RBlendMode::SrcOver);
+
+        for (size_t w = 0; w < b.windows.size(); w++)
+        {
+            if (ninePatch)
+            {
+                const SkIRect o { ShadowRect(w).roundOut().makeOutset(E, E) };
+                const SkScalar c { SkScalar(C) };
+                info.image = patch;
+
+                const std::pair<SkRect, SkIRect> patches[8]
+                {
+                    { SkRect::MakeLTRB(0, 0, c, c),             SkIRect::MakeLTRB(o.left(), o.top(), o.left() + C, o.top() + C) },
+                    { SkRect::MakeLTRB(c + 1, 0, N, c),         SkIRect::MakeLTRB(o.right() - C, o.top(), o.right(), o.top() + C) },
+                    { SkRect::MakeLTRB(c + 1, c + 1, N, N),     SkIRect::MakeLTRB(o.right() - C, o.bottom() - C, o.right(), o.bottom()) },
+                    { SkRect::MakeLTRB(0, c + 1, c, N),         SkIRect::MakeLTRB(o.left(), o.bottom() - C, o.left() + C, o.bottom()) },
+                    { SkRect::MakeLTRB(c, 0, c + 1, c),         SkIRect::MakeLTRB(o.left() + C, o.top(), o.right() - C, o.top() + C) },
+                    { SkRect::MakeLTRB(c, c + 1, c + 1, N),     SkIRect::MakeLTRB(o.left() + C, o.bottom() - C, o.right() - C, o.bottom()) },
+                    { SkRect::MakeLTRB(0, c, c, c + 1),         SkIRect::MakeLTRB(o.left(), o.top() + C, o.left() + C, o.bottom() - C) },
+                    { SkRect::MakeLTRB(c + 1, c, N, c + 1),     SkIRect::MakeLTRB(o.right() - C, o.top() + C, o.right(), o.bottom() - C) }
+                };
+
+                for (const auto &p : patches)
+                {
+                    info.src = p.first;
+                    info.dst = p.second;
+                    painter->drawImage(info);
+                }
+            }
+            else
+                painter->drawShadow(SkRRect::MakeRectXY(ShadowRect(w), ShadowRadius, ShadowRadius), ShadowSigma, ShadowColor);
+
+            info.image = b.windows[w];
+            info.src = SkRect::Make(WindowSize);
+            info.dst = WindowRect(w);
+            painter->drawImage(info);
+        }
+
+        pass.reset();
+        EndFrame(b);
+
+        if (i >= 0)
+            ms.emplace_back(Ms(Clock::now() - start));
+    }
+
+    result = Summarize(b, ninePatch ? "shadow-ninepatch" : "shadow", ms);
+    return true;
+}
+
+static std::shared_ptr<RImage> MakeTarget(Bench &b, RFormat format, RTransferFunction transfer, RPrimaries primaries) noexcept
+{
+    RImageConstraints cons {};
+    cons.allocator = b.core->mainDevice();
+    cons.caps[cons.allocator] = RImageCap_Dst | RImageCap_Src | RImageCap_SkImage | RImageCap_SkSurface;
+    auto image { RImage::Make(SurfaceSize, { format, { DRM_FORMAT_MOD_INVALID } }, &cons) };
+
+    if (image)
+        image->setColorDescription({ .transfer = transfer, .primaries = primaries });
+
+    return image;
+}
+
+/* HDR output: linear FP16 composition + a PQ encoding pass, the cost on top of windows */
+static bool RunHDR(Bench &b, Result &result) noexcept
+{
+    const auto linear { MakeTarget(b, DRM_FORMAT_ABGR16161616F, RTransferFunction::Linear, RPrimaries::SRGB) };
+    const auto output { MakeTarget(b, DRM_FORMAT_ABGR2101010, RTransferFunction::PQ, RPrimaries::BT2020) };
+
+    if (!linear || !output)
+        return false;
+
+    const auto composition { RSurface::WrapImage(linear) };
+    const auto scanout { RSurface::WrapImage(output) };
+
+    if (!composition || !scanout)
+        return false;
+
+    std::vector<double> ms;
+
+    for (int i = -Warmup; i < b.opts->frames; i++)
+    {
+        const auto start { Clock::now() };
+        auto pass { composition->beginPass(RPassCap_Painter) };
+        DrawScene(b, pass->getPainter(), nullptr);
+        pass.reset();
+
+        pass = scanout->beginPass(RPassCap_Painter);
+        auto *painter { pass->getPainter() };
+        RDrawImageInfo info {};
+        info.image = linear;
+        info.src = SkRect::Make(SurfaceSize);
+        info.dst = SkIRect::MakeSize(SurfaceSize);
+        painter->setBlendMode(RBlendMode::Src);
+        painter->drawImage(info);
+        pass.reset();
+        EndFrame(b);
+
+        if (i >= 0)
+            ms.emplace_back(Ms(Clock::now() - start));
+    }
+
+    result = Summarize(b, "hdr", ms);
+    return true;
+}
+
+static Result Throughput(const Bench &b, const char *scenario, std::vector<double> &ms, Clock::duration total, double bytes) noexcept
+{
+    auto r { Summarize(b, scenario, ms) };
+    r.unit = "MiB/s";
+    r.value = bytes / (1024.0 * 1024.0) / std::chrono::duration<double>(total).count();
+    return r;
+}
+
+static bool RunUpload(Bench &b, Result &result) noexcept
+{
+    const SkISize size { 1024, 1024 };
+    auto *dev { b.core->mainDevice() };
+    RImageConstraints constraints {};
+    constraints.allocator = dev;
+    constraints.caps[dev] = RImageCap_Src;
+    constraints.writeFormats.emplace(DRM_FORMAT_ARGB8888);
+
+    auto image { RImage::Make(size, { DRM_FORMAT_ARGB8888, { DRM_FORMAT_MOD_INVALID } }, &constraints) };
+
+    if (!image)
+        return false;
+
+    std::vector<UInt8> pixels(size.width() * size.height() * 4);
+    std::vector<double> ms;
+    Clock::duration total {};
+
+    for (int i = -Warmup; i < b.opts->frames; i++)
+    {
+        std::fill(pixels.begin(), pixels.end(), static_cast<UInt8>(i));
+
+        const RPixelBufferRegion region
+        {
+            .offset = { 0, 0 },
+            .stride = static_cast<UInt32>(size.width() * 4),
+            .pixels = pixels.data(),
+            .region = SkRegion(SkIRect::MakeSize(size)),
+            .format = DRM_FORMAT_ARGB8888
+        };
+
+        const auto start { Clock::now() };
+
+        if (!image->writePixels(region))
+            return false;
+
+        const auto elapsed { Clock::now() - start };
+
+        if (i >= 0)
+        {
+            ms.emplace_back(Ms(elapsed));
+            total += elapsed;
+        }
+    }
+
+    // Account for uploads still in flight
+    const auto start { Clock::now() };
+    EndFrame(b);
+    total += Clock::now() - start;
+
+    result = Throughput(b, "upload", ms, total, double(size.width()) * size.height() * 4 * b.opts->frames);
+    return true;
+}
+
+static bool RunReadback(Bench &b, Result &result) noexcept
+{
+    auto image { b.surface->image() };
+    const auto &formats { image->readFormats() };
+
+    if (formats.empty())
+        return false;
+
+    const RFormat format { formats.contains(DRM_FORMAT_ARGB8888) ? DRM_FORMAT_ARGB8888 : *formats.begin() };
+
+    {
+        auto pass { b.surface->beginPass(RPassCap_Painter) };
+        DrawScene(b, pass->getPainter(), nullptr);
+    }
+
+    std::vector<UInt8> pixels(SurfaceSize.width() * SurfaceSize.height() * 4);
+    std::vector<double> ms;
+    Clock::duration total {};
+
+    for (int i = -Warmup; i < b.opts->frames; i++)
+    {
+        const RPixelBufferRegion region
+        {
+            .offset = { 0, 0 },
+            .stride = static_cast<UInt32>(SurfaceSize.width() * 4),
+            .pixels = pixels.data(),
+            .region = SkRegion(SkIRect::MakeSize(SurfaceSize)),
+            .format = format
+        };
+
+        const auto start { Clock::now() };
+
+        if (!image->readPixels(region))
+            return false;
+
+        const auto elapsed { Clock::now() - start };
+
+        if (i >= 0)
+        {
+            ms.emplace_back(Ms(elapsed));
+            total += elapsed;
+        }
+    }
+
+    result = Throughput(b, "readback", ms, total, double(SurfaceSize.width()) * SurfaceSize.height() * 4 * b.opts->frames);
+    return true;
+}
+
+static bool RunSync(Bench &b, Result &result) noexcept
+{
+    if (!RSync::Make())
+        return false;
+
+    constexpr int batch { 100 };
+    std::vector<double> ms;
+    Clock::duration total {};
+
+    for (int i = -Warmup; i < b.opts->frames; i++)
+    {
+        const auto start { Clock::now() };
+
+        for (int j = 0; j < batch; j++)
+            if (!RSync::Make())
+                return false;
+
+        const auto elapsed { Clock::now() - start };
+
+        if (i >= 0)
+        {
+            ms.emplace_back(Ms(elapsed) / batch);
+            total += elapsed;
+        }
+
+        b.core->clearGarbage();
+    }
+
+    result = Summarize(b, "sync", ms);
+    result.unit = "ops/s";
+    result.value = double(batch) * b.opts->frames / std::chrono::duration<double>(total).count();
+    return true;
+}
+
+static void Skip(const char *api, const char *scenario) noexcept
+{
+    printf("api=%s scenario=%s skipped=1\n", api, scenario);
+    fflush(stdout);
+}
+
+static int RunAPI(const char *api, const Options &opts) noexcept
+{
+    Bench b { .api = api, .opts = &opts };
+
+    RCore::Options options {};
+    options.platformHandle = ROFPlatformHandle::Make();
+    options.graphicsAPI = strcmp(api, "GL") == 0 ? RGraphicsAPI::GL : strcmp(api, "VK") == 0 ? RGraphicsAPI::VK : RGraphicsAPI::RS;
+    b.core = RCore::Make(options);
+
+    if (!b.core)
+    {
+        Skip(api, "all");
+        return 1;
+    }
+
+    b.surface = RSurface::Make(SurfaceSize, 1.f, true);
+    b.wallpaper = MakePattern(SurfaceSize, 1, 255);
+
+    for (int i = 0; i < opts.windows; i++)
+        b.windows.emplace_back(MakePattern(WindowSize, 100 + i, i % 2 ? 255 : 200));
+
+    if (!b.surface || !b.wallpaper || std::find(b.windows.begin(), b.windows.end(), nullptr) != b.windows.end())
+    {
+        RLog(CZFatal, "Failed to create the benchmark resources");
+        return 1;
+    }
+
+    Print(RunWindows(b));
+    Print(RunDamage(b));
+    Print(RunBlur(b));
+
+    Result r;
+    if (RunShadow(b, false, r)) Print(r); else Skip(api, "shadow");
+    if (RunShadow(b, true, r)) Print(r); else Skip(api, "shadow-ninepatch");
+    if (RunHDR(b, r)) Print(r); else Skip(api, "hdr");
+    if (RunUpload(b, r)) Print(r); else Skip(api, "upload");
+    if (RunReadback(b, r)) Print(r); else Skip(api, "readback");
+    if (RunSync(b, r)) Print(r); else Skip(api, "sync");
+
+    b.windows.clear();
+    b.wallpaper.reset();
+    b.surface.reset();
+    b.core.reset();
+    return 0;
+}
+
+static bool ParseResult(const std::string &line, Result &r) noexcept
+{
+    std::map<std::string, std::string> kv;
+    std::istringstream stream { line };
+    std::string token;
+
+    while (stream >> token)
+    {
+        const auto eq { token.find('=') };
+        if (eq != std::string::npos)
+            kv[token.substr(0, eq)] = token.substr(eq + 1);
+    }
+
+    if (!kv.contains("api") || !kv.contains("scenario") || !kv.contains("value") || !kv.contains("unit"))
+        return false;
+
+    r.api = kv["api"];
+    r.scenario = kv["scenario"];
+    r.unit = kv["unit"];
+    r.value = atof(kv["value"].c_str());
+    r.p50 = atof(kv["p50"].c_str());
+    r.p99 = atof(kv["p99"].c_str());
+    return true;
+}
+
+/* Runs each API in a child process and collects its results from a pipe */
+static std::vector<std::string> Spawn(const char *api, const Options &opts) noexcept
+{
+    std::vector<std::string> lines;
+    int fds[2];
+
+    if (pipe(fds) != 0)
+        return lines;
+
+    const pid_t pid { fork() };
+
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return lines;
+    }
+
+    if (pid == 0)
+    {
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[1]);
+        _exit(RunAPI(api, opts));
+    }
+
+    close(fds[1]);
+    FILE *in { fdopen(fds[0], "r") };
+    char buf[512];
+
+    while (fgets(buf, sizeof(buf), in))
+    {
+        fputs(buf, stdout);
+        fflush(stdout);
+        lines.emplace_back(buf);
+    }
+
+    fclose(in);
+    waitpid(pid, nullptr, 0);
+    return lines;
+}
+
+static int Compare(const std::vector<Result> &results, const Options &opts) noexcept
+{
+    std::ifstream file { opts.baseline };
+
+    if (!file)
+    {
+        RLog(CZFatal, "Failed to open baseline {}", opts.baseline);
+        return 1;
+    }
+
+    std::map<std::string, Result> baseline;
+    std::string line;
+    Result r;
+
+    while (std::getline(file, line))
+        if (ParseResult(line, r))
+            baseline[r.key()] = r;
+
+    int regressions { 0 };
+
+    for (const auto &cur : results)
+    {
+        auto it { baseline.find(cur.key()) };
+
+        if (it == baseline.end() || it->second.value <= 0.0 || it->second.unit != cur.unit)
+        {
+            printf("compare api=%s scenario=%s status=new\n", cur.api.c_str(), cur.scenario.c_str());
+            continue;
+        }
+
+        const double delta { (cur.value - it->second.value) / it->second.value * 100.0 };
+        const double worse { cur.higherIsBetter() ? -delta : delta };
+        const char *status { "ok" };
+
+        if (worse > opts.threshold)
+        {
+            status = "regression";
+            regressions++;
+        }
+        else if (worse < -opts.threshold)
+            status = "improvement";
+
+        printf("compare api=%s scenario=%s baseline=%.3f current=%.3f unit=%s delta_pct=%+.2f status=%s\n",
+               cur.api.c_str(), cur.scenario.c_str(), it->second.value, cur.value, cur.unit.c_str(), delta, status);
+    }
+
+    printf("compare regressions=%d threshold_pct=%.1f\n", regressions, opts.threshold);
+    return regressions > 0 ? 2 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    Options opts;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg { argv[i] };
+        const auto eq { arg.find('=') };
+        const std::string key { arg.substr(0, eq) };
+        const std::string val { eq == std::string::npos ? "" : arg.substr(eq + 1) };
+
+        if (key == "api")
+            opts.apis = val == "all" ? opts.apis : std::vector<std::string> { val };
+        else if (key == "frames")
+            opts.frames = std::max(1, atoi(val.c_str()));
+        else if (key == "windows")
+            opts.windows = std::max(0, atoi(val.c_str()));
+        else if (key == "save")
+            opts.save = val;
+        else if (key == "baseline")
+            opts.baseline = val;
+        else if (key == "threshold")
+            opts.threshold = std::max(0.0, atof(val.c_str()));
+        else
+        {
+            RLog(CZFatal, "Unknown argument {}", arg);
+            return 1;
+        }
+    }
+
+    std::vector<std::string> lines;
+    std::vector<Result> results;
+
+    for (const auto &api : opts.apis)
+    {
+        for (auto &line : Spawn(api.c_str(), opts))
+        {
+            Result r;
+            if (ParseResult(line, r))
+                results.emplace_back(r);
+            lines.emplace_back(std::move(line));
+        }
+    }
+
+    if (!opts.save.empty())
+    {
+        std::ofstream file { opts.save };
+
+        for (const auto &line : lines)
+            file << line;
+
+        if (!file)
+        {
+            RLog(CZFatal, "Failed to save results to {}", opts.save);
+            return 1;
+        }
+    }
+
+    if (!opts.baseline.empty())
+        return Compare(results, opts);
+
+    return 0;
+}
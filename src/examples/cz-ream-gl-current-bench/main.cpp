@@ -0,0 +1,102 @@
+#include <OF/ROFPlatformHandle.h>
+#include <RProfiler.h>
+#include <RSurface.h>
+#include <RPainter.h>
+#include <RDevice.h>
+#include <RPass.h>
+#include <RCore.h>
+#include <RLog.h>
+
+#include <CZ/skia/core/SkCanvas.h>
+#include <CZ/skia/core/SkPaint.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace CZ;
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Counts eglMakeCurrent() calls per frame on the GL backend (Offscreen platform).
+ *
+ * Each frame is a single pass with a number of RPainter draws, optionally interleaved with SkCanvas
+ * draws (switches=1), mimicking a UI that mixes window blits and text. Calls are counted through
+ * RProfiler's MakeCurrentCalls counter. Prints one key=value line per run.
+ *
+ * Usage: cz-ream-gl-current-bench [frames=500] [draws=64] [switches=0|1]
+ */
+
+int main(int argc, char **argv)
+{
+    const int frames   { argc > 1 ? std::max(1, atoi(argv[1])) : 500 };
+    const int draws    { argc > 2 ? std::max(1, atoi(argv[2])) : 64 };
+    const bool switches { argc > 3 ? atoi(argv[3]) != 0 : false };
+
+    RCore::Options options {};
+    options.platformHandle = ROFPlatformHandle::Make();
+    options.graphicsAPI = RGraphicsAPI::GL;
+    auto core { RCore::Make(options) };
+
+    if (!core)
+        return 1;
+
+    const SkISize size { 1024, 1024 };
+    auto surface { RSurface::Make(size, 1.f, true) };
+
+    if (!surface)
+        return 1;
+
+    std::vector<UInt64> calls;
+    calls.reserve(frames);
+
+    RProfiler::SetFrameCallback([&calls](const RProfiler::FrameStats &stats, const std::vector<RProfiler::Event> &)
+    {
+        calls.emplace_back(stats.counters[RProfiler::MakeCurrentCalls]);
+    });
+    RProfiler::SetEnabled(true);
+
+    SkPaint paint;
+    paint.setColor(SK_ColorRED);
+    const auto start { Clock::now() };
+
+    for (int f = 0; f < frames; f++)
+    {
+        auto pass { surface->beginPass() };
+
+        for (int i = 0; i < draws; i++)
+        {
+            const SkIRect rect { SkIRect::MakeXYWH((i * 37) % 960, (i * 53) % 960, 64, 64) };
+            auto *painter { pass->getPainter() };
+            painter->setColor(SkColorSetARGB(255, i * 4, 255 - i * 4, f % 256));
+            painter->drawColor(SkRegion(rect));
+
+            if (switches)
+                pass->getCanvas()->drawRect(SkRect::Make(rect.makeOffset(32, 32)), paint);
+        }
+
+        pass.reset();
+        core->clearGarbage();
+        RProfiler::EndFrame();
+    }
+
+    core->mainDevice()->wait();
+    const auto totalMs { std::chrono::duration<double, std::milli>(Clock::now() - start).count() };
+
+    RProfiler::SetEnabled(false);
+    RProfiler::SetFrameCallback({});
+
+    if (calls.empty())
+        return 1;
+
+    std::sort(calls.begin(), calls.end());
+    double sum { 0.0 };
+    for (auto c : calls) sum += c;
+
+    printf("frames=%zu draws=%d switches=%d make_current_avg=%.2f make_current_max=%llu frame_ms=%.3f\n",
+           calls.size(), draws, switches, sum / calls.size(), (unsigned long long)calls.back(), totalMs / frames);
+
+    surface.reset();
+    core.reset();
+    return 0;
+}
@@ -0,0 +1,395 @@
+#include <WL/RWLPlatformHandle.h>
+#include <WL/RWLSwapchain.h>
+#include <RDamageTracker.h>
+#include <RSurface.h>
+#include <RPainter.h>
+#include <RPass.h>
+#include <RCore.h>
+#include <RLog.h>
+
+#include <wayland-client.h>
+#include "../cz-ream-wl-swapchain/xdg-shell.h"
+#include "presentation-time-client-protocol.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <poll.h>
+#include <vector>
+
+using namespace CZ;
+
+/*
+ * Input-to-present latency benchmark (Wayland platform, intended for a headless compositor).
+ *
+ * Each frame simulates an input event that moves a small cursor: the input timestamp is taken, the
+ * cursor is redrawn (only the damaged area when the image age allows it) and the image presented
+ * with the frame damage. The time from the input to present() returning and to the compositor
+ * reporting the frame as presented (wp_presentation) is measured. Under FIFO frames are paced by
+ * frame callbacks, Mailbox and Immediate render unthrottled. Prints one key=value line.
+ *
+ * Usage: cz-ream-present-latency-bench [frames=600] [mode=fifo|mailbox|immediate] [api=VK|GL|RS]
+ */
+
+static Int64 NowNs(clockid_t clock = CLOCK_MONOTONIC) noexcept
+{
+    timespec ts {};
+    clock_gettime(clock, &ts);
+    return Int64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+struct Frame
+{
+    Int64 inputNs;
+    Int64 presentReturnNs { 0 };
+    Int64 presentedNs { 0 };
+    bool discarded { false };
+};
+
+struct App
+{
+    struct
+    {
+        wl_display      *display;
+        wl_registry     *registry;
+        wl_compositor   *compositor;
+        xdg_wm_base     *xdgWmBase;
+        wp_presentation *presentation;
+        wl_callback     *callback;
+        wl_surface      *surface;
+        xdg_surface     *xdgSurface;
+        xdg_toplevel    *xdgToplevel;
+    } wl {};
+
+    std::shared_ptr<RCore> core;
+    std::shared_ptr<RWLSwapchain> swapchain;
+    std::shared_ptr<RDamageTracker> tracker;
+    RPresentMode mode { RPresentMode::FIFO };
+    clockid_t clock { CLOCK_MONOTONIC };
+
+    SkISize size { 512, 512 };
+    SkIRect cursor { SkIRect::MakeXYWH(0, 0, 16, 16) };
+    std::vector<Frame> frames;
+    int maxFrames { 600 };
+    int pendingFeedbacks { 0 };
+    bool configured { false };
+    bool running { true };
+
+    void render() noexcept;
+};
+
+struct Feedback
+{
+    App *app;
+    size_t frame;
+};
+
+static wp_presentation_feedback_listener FeedbackListener
+{
+    .sync_output = [](auto, auto, auto) {},
+    .presented = [](void *data, wp_presentation_feedback *feedback, UInt32 secHi, UInt32 secLo, UInt32 nsec, auto, auto, auto, auto)
+    {
+        auto *fb = static_cast<Feedback*>(data);
+        fb->app->frames[fb->frame].presentedNs = Int64((UInt64(secHi) << 32) | secLo) * 1000000000 + nsec;
+        fb->app->pendingFeedbacks--;
+        wp_presentation_feedback_destroy(feedback);
+        delete fb;
+    },
+    .discarded = [](void *data, wp_presentation_feedback *feedback)
+    {
+        auto *fb = static_cast<Feedback*>(data);
+        fb->app->frames[fb->frame].discarded = true;
+        fb->app->pendingFeedbacks--;
+        wp_presentation_feedback_destroy(feedback);
+        delete fb;
+    }
+};
+
+static wp_presentation_listener PresentationListener
+{
+    .clock_id = [](void *data, auto, UInt32 clock)
+    {
+        static_cast<App*>(data)->clock = clockid_t(clock);
+    }
+};
+
+static xdg_surface_listener XDGSurfaceListener
+{
+    .configure = [](void *data, xdg_surface *xdgSurface, UInt32 serial)
+    {
+        auto *app = static_cast<App*>(data);
+        xdg_surface_ack_configure(xdgSurface, serial);
+
+        if (app->configured)
+            return;
+
+        app->configured = true;
+        app->render();
+    }
+};
+
+static xdg_toplevel_listener XDGToplevelListener
+{
+    .configure = [](auto, auto, auto, auto, auto) {},
+    .close = [](void *data, auto)
+    {
+        static_cast<App*>(data)->running = false;
+    },
+    .configure_bounds = [](auto, auto, auto, auto) {},
+    .wm_capabilities  = [](auto, auto, auto) {}
+};
+
+static wl_callback_listener WLCallbackListener
+{
+    .done = [](void *data, wl_callback *callback, auto)
+    {
+        auto *app = static_cast<App*>(data);
+        app->wl.callback = nullptr;
+        wl_callback_destroy(callback);
+        app->render();
+    }
+};
+
+static xdg_wm_base_listener XDGWmBaseListener
+{
+    .ping = [](auto, xdg_wm_base *xdgWmBase, UInt32 serial)
+    {
+        xdg_wm_base_pong(xdgWmBase, serial);
+    }
+};
+
+static wl_registry_listener WLRegistryListener
+{
+    .global = [](void *data, wl_registry *registry, UInt32 name, const char *interface, UInt32 version)
+    {
+        auto *app = static_cast<App*>(data);
+
+        if (!app->wl.compositor && strcmp(interface, wl_compositor_interface.name) == 0 && version >= 4)
+            app->wl.compositor = static_cast<wl_compositor*>(wl_registry_bind(registry, name, &wl_compositor_interface, 4));
+        else if (!app->wl.xdgWmBase && strcmp(interface, xdg_wm_base_interface.name) == 0)
+        {
+            app->wl.xdgWmBase = static_cast<xdg_wm_base*>(wl_registry_bind(registry, name, &xdg_wm_base_interface, 1));
+            xdg_wm_base_add_listener(app->wl.xdgWmBase, &XDGWmBaseListener, app);
+        }
+        else if (!app->wl.presentation && strcmp(interface, wp_presentation_interface.name) == 0)
+        {
+            app->wl.presentation = static_cast<wp_presentation*>(wl_registry_bind(registry, name, &wp_presentation_interface, 1));
+            wp_presentation_add_listener(app->wl.presentation, &PresentationListener, app);
+        }
+    },
+    .global_remove = [](auto, auto, auto) {}
+};
+
+void App::render() noexcept
+{
+    if (!configured || !running)
+        return;
+
+    if ((int)frames.size() >= maxFrames)
+    {
+        running = false;
+        return;
+    }
+
+    if (!swapchain)
+    {
+        swapchain = RWLSwapchain::Make(wl.surface, size);
+
+        if (!swapchain)
+        {
+            running = false;
+            return;
+        }
+
+        tracker = RDamageTracker::Make();
+        tracker->resize(size);
+        tracker->damageAll();
+        swapchain->setDamageTracker(tracker);
+        swapchain->setPresentMode(mode);
+    }
+
+    // Simulated input: the cursor moves right after it is read
+    Frame &frame { frames.emplace_back(Frame { .inputNs = NowNs(clock) }) };
+    const SkIRect prevCursor { cursor };
+    cursor.offsetTo((cursor.x() + 7) % (size.width() - cursor.width()), (cursor.y() + 3) % (size.height() - cursor.height()));
+    tracker->addDamage(prevCursor);
+    tracker->addDamage(cursor);
+
+    auto image { swapchain->acquire() };
+
+    if (!image)
+    {
+        running = false;
+        return;
+    }
+
+    // Declared to the swapchain too, so partial updates skip loading the rest of the image
+    const SkRegion repaint { swapchain->repaintRegion(*image) };
+    swapchain->setRepaintRegion(*image, repaint);
+    auto surface { RSurface::WrapImage(image->image) };
+    surface->setRepaintRegion(repaint);
+
+    {
+        auto pass { surface->beginPass(RPassCap_Painter) };
+        auto *painter { pass->getPainter() };
+        painter->setColor(SK_ColorWHITE);
+        painter->clear();
+        painter->setColor(SK_ColorBLACK);
+        painter->drawColor(SkRegion(cursor));
+    }
+
+    if (wl.presentation)
+    {
+        auto *feedback { wp_presentation_feedback(wl.presentation, wl.surface) };
+        wp_presentation_feedback_add_listener(feedback, &FeedbackListener, new Feedback { this, frames.size() - 1 });
+        pendingFeedbacks++;
+    }
+
+    if (mode == RPresentMode::FIFO && !wl.callback)
+    {
+        wl.callback = wl_surface_frame(wl.surface);
+        wl_callback_add_listener(wl.callback, &WLCallbackListener, this);
+    }
+
+    // The cursor damage is already in the tracker, nullptr would damage the whole image
+    SkRegion noDamage;
+    swapchain->present(*image, &noDamage);
+    frame.presentReturnNs = NowNs(clock);
+}
+
+static void Report(const App &app, const char *modeName) noexcept
+{
+    std::vector<double> toReturn, toPresented;
+    int discarded { 0 };
+
+    for (const auto &f : app.frames)
+    {
+        if (f.presentReturnNs)
+            toReturn.emplace_back((f.presentReturnNs - f.inputNs) / 1000.0);
+
+        if (f.presentedNs)
+            toPresented.emplace_back((f.presentedNs - f.inputNs) / 1000.0);
+
+        discarded += f.discarded;
+    }
+
+    const auto stats = [](std::vector<double> &v, double &avg, double &p50, double &p99)
+    {
+        avg = p50 = p99 = 0.0;
+
+        if (v.empty())
+            return;
+
+        std::sort(v.begin(), v.end());
+        for (auto x : v) avg += x;
+        avg /= v.size();
+        p50 = v[v.size() / 2];
+        p99 = v[(v.size() * 99) / 100];
+    };
+
+    double rAvg, rP50, rP99, pAvg, pP50, pP99;
+    stats(toReturn, rAvg, rP50, rP99);
+    stats(toPresented, pAvg, pP50, pP99);
+
+    printf("api=%s mode=%s frames=%zu input_to_present_return_avg_us=%.1f p50=%.1f p99=%.1f "
+           "input_to_presented_avg_us=%.1f p50=%.1f p99=%.1f presented=%zu discarded=%d\n",
+           RGraphicsAPIString(app.core->graphicsAPI()).data(), modeName, app.frames.size(),
+           rAvg, rP50, rP99, pAvg, pP50, pP99, toPresented.size(), discarded);
+}
+
+int main(int argc, char **argv)
+{
+    App app {};
+    app.maxFrames = argc > 1 ? std::max(1, atoi(argv[1])) : 600;
+    const char *modeName { argc > 2 ? argv[2] : "fifo" };
+
+    if (strcmp(modeName, "mailbox") == 0)
+        app.mode = RPresentMode::Mailbox;
+    else if (strcmp(modeName, "immediate") == 0)
+        app.mode = RPresentMode::Immediate;
+    else
+        modeName = "fifo";
+
+    setenv("CZ_REAM_GAPI", argc > 3 ? argv[3] : "VK", 1);
+
+    app.wl.display = wl_display_connect(nullptr);
+
+    if (!app.wl.display)
+    {
+        fprintf(stderr, "wl_display_connect failed\n");
+        return 1;
+    }
+
+    app.wl.registry = wl_display_get_registry(app.wl.display);
+    wl_registry_add_listener(app.wl.registry, &WLRegistryListener, &app);
+    wl_display_roundtrip(app.wl.display);
+    wl_display_roundtrip(app.wl.display); // wp_presentation.clock_id
+
+    if (!app.wl.compositor || !app.wl.xdgWmBase)
+    {
+        fprintf(stderr, "wl_compositor v4 or xdg_wm_base not found\n");
+        return 1;
+    }
+
+    if (!app.wl.presentation)
+        fprintf(stderr, "wp_presentation not found, only input_to_present_return is measured\n");
+
+    RCore::Options options {};
+    options.graphicsAPI = RGraphicsAPI::Auto;
+    options.platformHandle = RWLPlatformHandle::Make(app.wl.display, CZOwn::Borrow);
+    app.core = RCore::Make(options);
+
+    if (!app.core)
+        return 1;
+
+    app.wl.surface = wl_compositor_create_surface(app.wl.compositor);
+    app.wl.xdgSurface = xdg_wm_base_get_xdg_surface(app.wl.xdgWmBase, app.wl.surface);
+    xdg_surface_add_listener(app.wl.xdgSurface, &XDGSurfaceListener, &app);
+    app.wl.xdgToplevel = xdg_surface_get_toplevel(app.wl.xdgSurface);
+    xdg_toplevel_add_listener(app.wl.xdgToplevel, &XDGToplevelListener, &app);
+    wl_surface_commit(app.wl.surface);
+
+    while (app.running)
+    {
+        // Unthrottled modes render again as soon as pending events are handled
+        if (app.mode != RPresentMode::FIFO && app.configured)
+        {
+            while (wl_display_prepare_read(app.wl.display) != 0)
+                wl_display_dispatch_pending(app.wl.display);
+
+            wl_display_flush(app.wl.display);
+            pollfd fd { .fd = wl_display_get_fd(app.wl.display), .events = POLLIN, .revents = 0 };
+
+            if (poll(&fd, 1, 0) > 0)
+                wl_display_read_events(app.wl.display);
+            else
+                wl_display_cancel_read(app.wl.display);
+
+            if (wl_display_dispatch_pending(app.wl.display) < 0)
+                break;
+
+            app.render();
+        }
+        else if (wl_display_dispatch(app.wl.display) < 0)
+            break;
+
+        app.core->clearGarbage();
+    }
+
+    // Collect the remaining presentation feedback
+    while (app.pendingFeedbacks > 0 && wl_display_dispatch(app.wl.display) >= 0) {}
+
+    Report(app, modeName);
+
+    app.swapchain.reset();
+    xdg_toplevel_destroy(app.wl.xdgToplevel);
+    xdg_surface_destroy(app.wl.xdgSurface);
+    wl_surface_destroy(app.wl.surface);
+
+    if (app.wl.callback)
+        wl_callback_destroy(app.wl.callback);
+
+    app.core.reset();
+    wl_display_disconnect(app.wl.display);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <OF/ROFPlatformHandle.h>
+#include <RSurface.h>
+#include <RPainter.h>
+#include <RDevice.h>
+#include <RPass.h>
+#include <RCore.h>
+#include <RLog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace CZ;
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Vulkan queue submission contention benchmark (Offscreen platform).
+ *
+ * Each render thread mimics an output: it owns a surface and renders a few painter draws per frame, so the
+ * submission at the end of every pass competes with the other threads for the graphics queue. The time spent
+ * ending the pass (recording end + submission) is measured per frame. Runs once per output count and prints
+ * one key=value line per run.
+ *
+ * Usage: cz-ream-submit-bench [frames=1000] [draws=16] [outputs=1,2,4,8 (0)]
+ */
+
+struct Output
+{
+    std::shared_ptr<RSurface> surface;
+    std::vector<double> submitUs;
+};
+
+static void Render(Output &out, int frames, int draws, std::atomic<int> &ready, int outputs) noexcept
+{
+    out.submitUs.reserve(frames);
+
+    // Start all threads together so they actually contend
+    ready++;
+    while (ready.load() < outputs)
+        std::this_thread::yield();
+
+    for (int f = 0; f < frames; f++)
+    {
+        auto pass { out.surface->beginPass(RPassCap_Painter) };
+        auto *painter { pass->getPainter() };
+
+        for (int i = 0; i < draws; i++)
+        {
+            painter->setColor(SkColorSetARGB(255, i * 16, 255 - i * 16, f % 256));
+            painter->drawColor(SkRegion(SkIRect::MakeXYWH((i * 37) % 448, (i * 53) % 448, 64, 64)));
+        }
+
+        const auto start { Clock::now() };
+        pass.reset();
+        out.submitUs.emplace_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+        RCore::Get()->clearGarbage();
+    }
+}
+
+static bool Run(int outputs, int frames, int draws) noexcept
+{
+    std::vector<Output> outs(outputs);
+
+    for (auto &out : outs)
+    {
+        out.surface = RSurface::Make({ 512, 512 }, 1.f, true);
+
+        if (!out.surface)
+            return false;
+    }
+
+    std::atomic<int> ready { 0 };
+    std::vector<std::thread> threads;
+    const auto start { Clock::now() };
+
+    for (auto &out : outs)
+        threads.emplace_back([&out, &ready, frames, draws, outputs]{ Render(out, frames, draws, ready, outputs); });
+
+    for (auto &t : threads)
+        t.join();
+
+    RCore::Get()->mainDevice()->wait();
+    const auto totalSec { std::chrono::duration<double>(Clock::now() - start).count() };
+
+    std::vector<double> all;
+
+    for (auto &out : outs)
+        all.insert(all.end(), out.submitUs.begin(), out.submitUs.end());
+
+    std::sort(all.begin(), all.end());
+    double sum { 0.0 };
+    for (auto v : all) sum += v;
+
+    printf("outputs=%d frames=%d draws=%d submit_avg_us=%.2f submit_p50_us=%.2f submit_p99_us=%.2f submit_max_us=%.2f fps_per_output=%.1f\n",
+           outputs, frames, draws, sum / all.size(), all[all.size() / 2], all[(all.size() * 99) / 100], all.back(),
+           frames / totalSec);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const int frames  { argc > 1 ? std::max(1, atoi(argv[1])) : 1000 };
+    const int draws   { argc > 2 ? std::max(1, atoi(argv[2])) : 16 };
+    const int outputs { argc > 3 ? std::max(0, atoi(argv[3])) : 0 };
+
+    RCore::Options options {};
+    options.platformHandle = ROFPlatformHandle::Make();
+    options.graphicsAPI = RGraphicsAPI::VK;
+    auto core { RCore::Make(options) };
+
+    if (!core)
+        return 1;
+
+    if (outputs > 0)
+        return Run(outputs, frames, draws) ? 0 : 1;
+
+    for (int n : { 1, 2, 4, 8 })
+        if (!Run(n, frames, draws))
+            return 1;
+
+    core.reset();
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <DRM/RDRMPlatformHandle.h>
+#include <RSurface.h>
+#include <RPainter.h>
+#include <RImage.h>
+#include <RPass.h>
+#include <RCore.h>
+#include <RLog.h>
+
+#include <drm_fourcc.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace CZ;
+using Clock = std::chrono::steady_clock;
+
+/*
+ * Multi-threaded writePixels() benchmark for GBM-backed images.
+ *
+ * Each upload thread owns an image and rewrites it in a loop (e.g. cursors or shm client buffers),
+ * while the main thread keeps sampling all of them with the painter so their read syncs are
+ * usually pending. Prints one line per thread plus a total, in a key=value format.
+ *
+ * Usage: cz-ream-upload-bench [threads=4] [iterations=500] [size=256] [drm-node=/dev/dri/renderD128]
+ */
+
+struct Uploader
+{
+    std::shared_ptr<RImage> image;
+    std::vector<UInt8> pixels;
+    std::vector<double> latenciesUs;
+};
+
+static bool MakeUploader(Uploader &up, SkISize size) noexcept
+{
+    auto *dev { RCore::Get()->mainDevice() };
+    RImageConstraints constraints {};
+    constraints.allocator = dev;
+    constraints.caps[dev] = RImageCap_Src | RImageCap_GBMBo;
+    constraints.writeFormats.emplace(DRM_FORMAT_ARGB8888);
+    constraints.gbmWriteDoubleBuffer = true;
+
+    up.image = RImage::Make(size, { DRM_FORMAT_ARGB8888, { DRM_FORMAT_MOD_LINEAR } }, &constraints);
+
+    if (!up.image)
+        return false;
+
+    up.pixels.resize(size.width() * size.height() * 4);
+    return true;
+}
+
+static void Upload(Uploader &up, int iterations) noexcept
+{
+    const auto size { up.image->size() };
+    up.latenciesUs.reserve(iterations);
+
+    for (int i = 0; i < iterations; i++)
+    {
+        std::fill(up.pixels.begin(), up.pixels.end(), static_cast<UInt8>(i));
+
+        const RPixelBufferRegion region
+        {
+            .offset = { 0, 0 },
+            .stride = static_cast<UInt32>(size.width() * 4),
+            .pixels = up.pixels.data(),
+            .region = SkRegion(SkIRect::MakeSize(size)),
+            .format = DRM_FORMAT_ARGB8888
+        };
+
+        const auto start { Clock::now() };
+        up.image->writePixels(region);
+        up.latenciesUs.emplace_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    setenv("CZ_REAM_GAPI", "GL", 0);
+
+    const int threads    { argc > 1 ? std::max(1, atoi(argv[1])) : 4 };
+    const int iterations { argc > 2 ? std::max(1, atoi(argv[2])) : 500 };
+    const int side       { argc > 3 ? std::max(1, atoi(argv[3])) : 256 };
+    const char *node     { argc > 4 ? argv[4] : "/dev/dri/renderD128" };
+
+    const int fd { open(node, O_RDWR | O_CLOEXEC) };
+
+    if (fd < 0)
+    {
+        RLog(CZFatal, "Failed to open {}", node);
+        return 1;
+    }
+
+    RCore::Options options {};
+    options.platformHandle = RDRMPlatformHandle::Make({{ fd, nullptr }});
+    auto core { RCore::Make(options) };
+
+    if (!core)
+        return 1;
+
+    const SkISize size { side, side };
+    std::vector<Uploader> uploaders(threads);
+
+    for (auto &up : uploaders)
+    {
+        if (!MakeUploader(up, size))
+        {
+            RLog(CZFatal, "Failed to create a GBM-backed image");
+            return 1;
+        }
+    }
+
+    auto surface { RSurface::Make(size, 1.f, true) };
+
+    if (!surface)
+        return 1;
+
+    std::atomic<int> running { threads };
+    std::vector<std::thread> workers;
+    const auto start { Clock::now() };
+
+    for (auto &up : uploaders)
+        workers.emplace_back([&up, &running, iterations]{
+            Upload(up, iterations);
+            running--;
+        });
+
+    // Keep the images busy on the GPU while they are being uploaded
+    UInt32 frames { 0 };
+    while (running > 0)
+    {
+        auto pass { surface->beginPass(RPassCap_Painter) };
+        auto *painter { pass->getPainter() };
+
+        for (auto &up : uploaders)
+        {
+            RDrawImageInfo info {};
+            info.image = up.image;
+            info.src = SkRect::Make(size);
+            info.dst = SkIRect::MakeSize(size);
+            painter->drawImage(info);
+        }
+
+        pass.reset();
+        core->clearGarbage();
+        frames++;
+    }
+
+    for (auto &w : workers)
+        w.join();
+
+    const auto totalSec { std::chrono::duration<double>(Clock::now() - start).count() };
+    const double bytes { double(size.width()) * size.height() * 4 * iterations * threads };
+
+    for (size_t i = 0; i < uploaders.size(); i++)
+    {
+        auto &lat { uploaders[i].latenciesUs };
+        std::sort(lat.begin(), lat.end());
+        double sum { 0.0 };
+        for (auto v : lat) sum += v;
+
+        printf("thread=%zu avg_us=%.2f p50_us=%.2f p99_us=%.2f max_us=%.2f\n",
+               i, sum / lat.size(), lat[lat.size() / 2], lat[(lat.size() * 99) / 100], lat.back());
+    }
+
+    printf("total threads=%d iterations=%d size=%d seconds=%.3f mib_per_s=%.2f sampled_frames=%u\n",
+           threads, iterations, side, totalSec, bytes / (1024.0 * 1024.0) / totalSec, frames);
+
+    uploaders.clear();
+    surface.reset();
+    core.reset();
+    close(fd);
+    return 0;
+}